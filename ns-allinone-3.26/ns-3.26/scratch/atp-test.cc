@@ -5,6 +5,9 @@
 #include "ns3/point-to-point-module.h"
 #include "ns3/applications-module.h"
 #include "ns3/traffic-control-module.h"
+#ifdef NS3_MTP
+#include "ns3/mtp-module.h"
+#endif
 
 #include <sstream>
 #include <map>
@@ -23,6 +26,8 @@ std::string link_delay;
 uint32_t packet_size;
 uint32_t queue_size;
 uint32_t threhold;
+uint32_t shared_buffer;
+double shared_buffer_alpha;
 
 // The times
 double global_start_time;
@@ -158,6 +163,16 @@ BuildTopo (uint32_t clientNo, uint32_t serverNo)
   internet.Install (switchs);
   internet.Install (servers);
 
+  // the ports of a switch share its buffer, if enabled
+  if (shared_buffer > 0)
+    {
+      for (auto it = switchs.Begin (); it != switchs.End (); ++it)
+        {
+          (*it)->AggregateObject (CreateObjectWithAttributes<SharedBuffer> ("BufferSize", UintegerValue (shared_buffer),
+                                                                            "Alpha", DoubleValue (shared_buffer_alpha)));
+        }
+    }
+
   // 1-3、初始化TrafficContronHelper fifo和red两种队列
   TrafficControlHelper tchPfifo;
   // use default limit for pfifo (1000)
@@ -297,6 +312,7 @@ main (int argc, char *argv[])
   bool writePcap = 1;           // 输出pcap
   bool flowMonitor = 1;         // 流监控
   bool writeThroughput = 1;     // 直写
+  bool writeFct = 0;            // 流完成时间
 
   bool printRedStats = true;    // 输出Red状态
 
@@ -313,6 +329,8 @@ main (int argc, char *argv[])
     packet_size = 512;
     queue_size = 128;
     threhold = 20;
+    shared_buffer = 0;
+    shared_buffer_alpha = 1.0;
 
   // Will only save in the directory if enable opts below
   pathOut = "./atp_res"; // Current directory
@@ -324,9 +342,35 @@ main (int argc, char *argv[])
   cmd.AddValue ("writePcap", "<0/1> to write results in pcapfile", writePcap);
   cmd.AddValue ("writeFlowMonitor", "<0/1> to enable Flow Monitor and write their results", flowMonitor);
   cmd.AddValue ("writeThroughput", "<0/1> to write throughtput results", writeThroughput);
+  cmd.AddValue ("writeFct", "<0/1> to write the flow completion times by flow size", writeFct);
+  cmd.AddValue ("sharedBuffer", "Size in bytes of the buffer shared by the ports of a switch, 0 to disable", shared_buffer);
+  cmd.AddValue ("sharedBufferAlpha", "Dynamic threshold factor of the shared buffer", shared_buffer_alpha);
+#ifdef NS3_MTP
+  uint32_t threads = 1;
+  cmd.AddValue ("threads", "Number of simulation threads, 0 for one per core", threads);
+#endif
 
   cmd.Parse (argc, argv);
 
+#ifdef NS3_MTP
+  if (threads != 1)
+    {
+      // the flow monitor and the FCT monitor are shared by all nodes and
+      // are not thread-safe.
+      if (flowMonitor)
+        {
+          std::cerr << "Flow monitor disabled with more than one thread" << std::endl;
+          flowMonitor = false;
+        }
+      if (writeFct)
+        {
+          std::cerr << "FCT monitor disabled with more than one thread" << std::endl;
+          writeFct = false;
+        }
+      MtpInterface::Enable (threads);
+    }
+#endif
+
   SetConfig (useEcn, useAtp);
 
   // 1、构造拓扑
@@ -350,6 +394,14 @@ main (int argc, char *argv[])
       flowmon = flowmonHelper.InstallAll ();
     }
 
+  // the sockets report their flows when the applications start
+  FctMonitorHelper fctHelper;
+  if (writeFct)
+    {
+      fctHelper.SetMonitorAttribute ("LinkRate", StringValue (link_data_rate));
+      fctHelper.InstallAll ();
+    }
+
   if (writeForPlot)
     {
       filePlotQueue << pathOut << "/" << "red-queue.plotme";
@@ -358,7 +410,8 @@ main (int argc, char *argv[])
       remove (filePlotQueue.str ().c_str ());
       remove (filePlotQueueAvg.str ().c_str ());
       Ptr<QueueDisc> queue = queueDiscs.Get (0);
-      Simulator::ScheduleNow (&CheckQueueSize, queue);
+      // sample the queue from its switch, once the switch is initialized
+      Simulator::ScheduleWithContext (switchs.Get (0)->GetId (), Seconds (0), &CheckQueueSize, queue);
     }
 
   if (writeThroughput)
@@ -377,6 +430,13 @@ main (int argc, char *argv[])
 
       flowmon->SerializeToXmlFile (stmp.str (), false, false);
     }
+  if (writeFct)
+    {
+      std::ofstream out (pathOut + "/fct-summary.csv");
+      fctHelper.GetMonitor ()->WriteSummary (out);
+      std::ofstream flows (pathOut + "/fct-flows.csv");
+      fctHelper.GetMonitor ()->WriteFlows (flows);
+    }
   std::cout << "22222" << std::endl;
 
   if (printRedStats)
@@ -0,0 +1,85 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "flow-generator-helper.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/ipv4.h"
+#include "ns3/abort.h"
+#include "ns3/string.h"
+
+namespace ns3 {
+
+FlowGeneratorHelper::FlowGeneratorHelper (std::string protocol, std::string cdfFile, uint16_t port)
+  : m_cdf (FlowGeneratorApplication::ReadCdf (cdfFile)),
+    m_port (port)
+{
+  m_factory.SetTypeId ("ns3::FlowGeneratorApplication");
+  m_factory.Set ("Protocol", StringValue (protocol));
+}
+
+void
+FlowGeneratorHelper::SetAttribute (std::string name, const AttributeValue &value)
+{
+  m_factory.Set (name, value);
+}
+
+ApplicationContainer
+FlowGeneratorHelper::Install (NodeContainer hosts) const
+{
+  std::vector<Address> addresses;
+  for (NodeContainer::Iterator i = hosts.Begin (); i != hosts.End (); ++i)
+    {
+      Ptr<Ipv4> ipv4 = (*i)->GetObject<Ipv4> ();
+      NS_ABORT_MSG_IF (ipv4 == 0 || ipv4->GetNInterfaces () < 2,
+                       "FlowGeneratorHelper needs hosts with an IPv4 address");
+      addresses.push_back (InetSocketAddress (ipv4->GetAddress (1, 0).GetLocal (), m_port));
+    }
+
+  ApplicationContainer apps;
+  for (uint32_t i = 0; i < hosts.GetN (); i++)
+    {
+      std::vector<Address> peers (addresses);
+      peers.erase (peers.begin () + i);
+      Ptr<FlowGeneratorApplication> app = m_factory.Create<FlowGeneratorApplication> ();
+      app->SetFlowSizeCdf (m_cdf);
+      app->SetPeers (peers);
+      hosts.Get (i)->AddApplication (app);
+      apps.Add (app);
+    }
+  return apps;
+}
+
+int64_t
+FlowGeneratorHelper::AssignStreams (NodeContainer c, int64_t stream)
+{
+  int64_t currentStream = stream;
+  Ptr<Node> node;
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      node = (*i);
+      for (uint32_t j = 0; j < node->GetNApplications (); j++)
+        {
+          Ptr<FlowGeneratorApplication> app = DynamicCast<FlowGeneratorApplication> (node->GetApplication (j));
+          if (app)
+            {
+              currentStream += app->AssignStreams (currentStream);
+            }
+        }
+    }
+  return (currentStream - stream);
+}
+
+} // namespace ns3
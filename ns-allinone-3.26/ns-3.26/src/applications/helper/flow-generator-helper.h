@@ -0,0 +1,96 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLOW_GENERATOR_HELPER_H
+#define FLOW_GENERATOR_HELPER_H
+
+#include <stdint.h>
+#include <string>
+#include "ns3/object-factory.h"
+#include "ns3/attribute.h"
+#include "ns3/node-container.h"
+#include "ns3/application-container.h"
+#include "ns3/flow-generator-application.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup flowgenerator
+ * \brief A helper to make it easier to generate an all-to-all workload
+ * with ns3::FlowGeneratorApplication
+ *
+ * The helper installs an application on each host, which sends flows to
+ * all the other hosts. The hosts are addressed by the first address of
+ * their first non-loopback IPv4 interface. Install a PacketSink on the
+ * same port of each host to receive the flows.
+ */
+class FlowGeneratorHelper
+{
+public:
+  /**
+   * Create a FlowGeneratorHelper to make it easier to work with
+   * FlowGeneratorApplications
+   *
+   * \param protocol the name of the protocol to use to send traffic
+   *        by the applications. This string identifies the socket
+   *        factory type used to create sockets for the applications.
+   *        A typical value would be ns3::TcpSocketFactory.
+   * \param cdfFile the file of the CDF of the flow sizes, read once
+   *        (see FlowGeneratorApplication::ReadCdf)
+   * \param port the port of the sinks
+   */
+  FlowGeneratorHelper (std::string protocol, std::string cdfFile, uint16_t port);
+
+  /**
+   * Helper function used to set the underlying application attributes,
+   * _not_ the socket attributes.
+   *
+   * \param name the name of the application attribute to set
+   * \param value the value of the application attribute to set
+   */
+  void SetAttribute (std::string name, const AttributeValue &value);
+
+  /**
+   * Install an ns3::FlowGeneratorApplication on each host, sending to all
+   * the other hosts, configured with all the attributes set with
+   * SetAttribute.
+   *
+   * \param hosts the hosts
+   * \returns Container of Ptr to the applications installed.
+   */
+  ApplicationContainer Install (NodeContainer hosts) const;
+
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by the FlowGeneratorApplications installed on the nodes.
+   *
+   * \param c NodeContainer of the set of nodes for which the
+   *          FlowGeneratorApplication should be modified to use a fixed
+   *          stream
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned
+   */
+  int64_t AssignStreams (NodeContainer c, int64_t stream);
+
+private:
+  ObjectFactory m_factory;                 //!< Object factory.
+  FlowGeneratorApplication::Cdf m_cdf;     //!< CDF of the flow sizes
+  uint16_t m_port;                         //!< Port of the sinks
+};
+
+} // namespace ns3
+
+#endif /* FLOW_GENERATOR_HELPER_H */
@@ -0,0 +1,429 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/address.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/inet6-socket-address.h"
+#include "ns3/node.h"
+#include "ns3/nstime.h"
+#include "ns3/socket.h"
+#include "ns3/simulator.h"
+#include "ns3/socket-factory.h"
+#include "ns3/packet.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/tcp-socket-factory.h"
+#include "flow-generator-application.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FlowGeneratorApplication");
+
+NS_OBJECT_ENSURE_REGISTERED (FlowGeneratorApplication);
+
+TypeId
+FlowGeneratorApplication::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FlowGeneratorApplication")
+    .SetParent<Application> ()
+    .SetGroupName("Applications")
+    .AddConstructor<FlowGeneratorApplication> ()
+    .AddAttribute ("Load", "The offered load, relative to LinkRate.",
+                   DoubleValue (0.3),
+                   MakeDoubleAccessor (&FlowGeneratorApplication::m_load),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("LinkRate", "The rate of the access link of the node.",
+                   DataRateValue (DataRate ("10Gbps")),
+                   MakeDataRateAccessor (&FlowGeneratorApplication::m_linkRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("SendSize", "The amount of data to send each time.",
+                   UintegerValue (65536),
+                   MakeUintegerAccessor (&FlowGeneratorApplication::m_sendSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("MaxFlows",
+                   "The number of flows to start. The value zero means "
+                   "that there is no limit.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&FlowGeneratorApplication::m_maxFlows),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("ReuseConnections",
+                   "Whether a flow is sent on an idle connection to its peer, "
+                   "rather than on a new one.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&FlowGeneratorApplication::m_reuse),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Protocol", "The type of protocol to use.",
+                   TypeIdValue (TcpSocketFactory::GetTypeId ()),
+                   MakeTypeIdAccessor (&FlowGeneratorApplication::m_tid),
+                   MakeTypeIdChecker ())
+    .AddTraceSource ("FlowStart", "A new flow starts.",
+                     MakeTraceSourceAccessor (&FlowGeneratorApplication::m_flowStartTrace),
+                     "ns3::FlowGeneratorApplication::FlowStartTracedCallback")
+    .AddTraceSource ("FlowComplete", "All the data of a flow has been acknowledged.",
+                     MakeTraceSourceAccessor (&FlowGeneratorApplication::m_flowCompleteTrace),
+                     "ns3::FlowGeneratorApplication::FlowCompleteTracedCallback")
+  ;
+  return tid;
+}
+
+
+FlowGeneratorApplication::FlowGeneratorApplication ()
+  : m_meanSize (0),
+    m_active (false),
+    m_nFlows (0),
+    m_nConnections (0)
+{
+  NS_LOG_FUNCTION (this);
+  m_interArrival = CreateObject<ExponentialRandomVariable> ();
+  m_peerChooser = CreateObject<UniformRandomVariable> ();
+  m_flowSize = CreateObject<EmpiricalRandomVariable> ();
+}
+
+FlowGeneratorApplication::~FlowGeneratorApplication ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FlowGeneratorApplication::Cdf
+FlowGeneratorApplication::ReadCdf (std::string fileName)
+{
+  NS_LOG_FUNCTION (fileName);
+  std::ifstream in (fileName.c_str ());
+  NS_ABORT_MSG_IF (!in.is_open (), "Cannot open the flow size CDF " << fileName);
+
+  Cdf cdf;
+  std::string line;
+  while (std::getline (in, line))
+    {
+      std::istringstream is (line);
+      std::vector<double> columns;
+      double value;
+      while (is >> value)
+        {
+          columns.push_back (value);
+        }
+      if (columns.empty () && (is.eof () || line[line.find_first_not_of (" \t")] == '#'))
+        {
+          continue;
+        }
+      NS_ABORT_MSG_IF (columns.size () < 2 || !is.eof (),
+                       "Invalid line \"" << line << "\" in the flow size CDF " << fileName);
+      cdf.push_back (std::make_pair (columns.front (), columns.back ()));
+    }
+  NS_ABORT_MSG_IF (cdf.empty () || cdf.back ().second <= 0,
+                   "Empty flow size CDF " << fileName);
+
+  double total = cdf.back ().second;
+  for (Cdf::iterator it = cdf.begin (); it != cdf.end (); ++it)
+    {
+      it->second /= total;
+    }
+  return cdf;
+}
+
+void
+FlowGeneratorApplication::SetFlowSizeCdf (const Cdf &cdf)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ABORT_MSG_IF (!m_cdf.empty (), "The flow size CDF can only be set once");
+  NS_ABORT_MSG_IF (cdf.empty (), "Empty flow size CDF");
+  m_cdf = cdf;
+
+  // the variable returns the first size below its probability, and
+  // interpolates linearly between the points above it
+  m_meanSize = cdf[0].first * cdf[0].second;
+  m_flowSize->CDF (cdf[0].first, cdf[0].second);
+  for (uint32_t i = 1; i < cdf.size (); i++)
+    {
+      NS_ABORT_MSG_IF (cdf[i].first < cdf[i - 1].first || cdf[i].second < cdf[i - 1].second,
+                       "The flow size CDF must be non-decreasing");
+      m_meanSize += (cdf[i - 1].first + cdf[i].first) / 2 * (cdf[i].second - cdf[i - 1].second);
+      m_flowSize->CDF (cdf[i].first, cdf[i].second);
+    }
+}
+
+double
+FlowGeneratorApplication::GetMeanFlowSize (void) const
+{
+  return m_meanSize;
+}
+
+void
+FlowGeneratorApplication::SetPeers (const std::vector<Address> &peers)
+{
+  NS_LOG_FUNCTION (this);
+  m_peers = peers;
+  m_idleSockets.assign (peers.size (), std::vector<Ptr<Socket> > ());
+}
+
+uint32_t
+FlowGeneratorApplication::GetNFlows (void) const
+{
+  return m_nFlows;
+}
+
+uint32_t
+FlowGeneratorApplication::GetNConnections (void) const
+{
+  return m_nConnections;
+}
+
+int64_t
+FlowGeneratorApplication::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_interArrival->SetStream (stream);
+  m_peerChooser->SetStream (stream + 1);
+  m_flowSize->SetStream (stream + 2);
+  return 3;
+}
+
+void
+FlowGeneratorApplication::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_flows.clear ();
+  m_freeFlows.clear ();
+  m_socketFlows.clear ();
+  m_idleSockets.clear ();
+  // chain up
+  Application::DoDispose ();
+}
+
+// Application Methods
+void FlowGeneratorApplication::StartApplication (void) // Called at time specified by Start
+{
+  NS_LOG_FUNCTION (this);
+  NS_ABORT_MSG_IF (m_peers.empty (), "FlowGeneratorApplication has no peer");
+  NS_ABORT_MSG_IF (m_meanSize <= 0, "FlowGeneratorApplication has no flow size CDF");
+
+  m_active = true;
+  if (m_load <= 0)
+    {
+      return;
+    }
+  double rate = m_load * m_linkRate.GetBitRate () / (8 * m_meanSize);
+  m_interArrival->SetAttribute ("Mean", DoubleValue (1 / rate));
+  NS_LOG_LOGIC ("Mean flow size " << m_meanSize << " bytes, " << rate << " flows per second");
+  ScheduleNextFlow ();
+}
+
+void FlowGeneratorApplication::StopApplication (void) // Called at time specified by Stop
+{
+  NS_LOG_FUNCTION (this);
+
+  // the flows in progress complete, but no new flow starts
+  m_active = false;
+  Simulator::Cancel (m_nextFlowEvent);
+  for (uint32_t i = 0; i < m_idleSockets.size (); i++)
+    {
+      for (uint32_t j = 0; j < m_idleSockets[i].size (); j++)
+        {
+          m_idleSockets[i][j]->Close ();
+        }
+      m_idleSockets[i].clear ();
+    }
+}
+
+
+// Private helpers
+
+void FlowGeneratorApplication::ScheduleNextFlow (void)
+{
+  if (m_maxFlows == 0 || m_nFlows < m_maxFlows)
+    {
+      m_nextFlowEvent = Simulator::Schedule (Seconds (m_interArrival->GetValue ()),
+                                             &FlowGeneratorApplication::NewFlow, this);
+    }
+}
+
+void FlowGeneratorApplication::NewFlow (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  uint32_t id;
+  if (m_freeFlows.empty ())
+    {
+      id = m_flows.size ();
+      m_flows.push_back (Flow ());
+    }
+  else
+    {
+      id = m_freeFlows.back ();
+      m_freeFlows.pop_back ();
+    }
+  Flow &flow = m_flows[id];
+  flow.peer = m_peerChooser->GetInteger (0, m_peers.size () - 1);
+  flow.size = std::max (1.0, std::floor (m_flowSize->GetValue () + 0.5));
+  flow.remaining = flow.size;
+  flow.txCapacity = 0;
+  flow.start = Simulator::Now ();
+  m_nFlows++;
+  NS_LOG_LOGIC ("Flow " << id << " of " << flow.size << " bytes to peer " << flow.peer);
+  m_flowStartTrace (flow.size, m_peers[flow.peer]);
+
+  std::vector<Ptr<Socket> > &idle = m_idleSockets[flow.peer];
+  if (!idle.empty ())
+    {
+      flow.socket = idle.back ();
+      idle.pop_back ();
+      flow.txCapacity = flow.socket->GetTxAvailable ();
+      m_socketFlows[flow.socket] = id;
+      SendData (id);
+    }
+  else
+    {
+      flow.socket = Socket::CreateSocket (GetNode (), m_tid);
+      // Fatal error if socket type is not NS3_SOCK_STREAM or NS3_SOCK_SEQPACKET
+      if (flow.socket->GetSocketType () != Socket::NS3_SOCK_STREAM &&
+          flow.socket->GetSocketType () != Socket::NS3_SOCK_SEQPACKET)
+        {
+          NS_FATAL_ERROR ("Using FlowGenerator with an incompatible socket type. "
+                          "FlowGenerator requires SOCK_STREAM or SOCK_SEQPACKET. "
+                          "In other words, use TCP instead of UDP.");
+        }
+      m_nConnections++;
+      m_socketFlows[flow.socket] = id;
+
+      const Address &peer = m_peers[flow.peer];
+      if (Inet6SocketAddress::IsMatchingType (peer))
+        {
+          flow.socket->Bind6 ();
+        }
+      else if (InetSocketAddress::IsMatchingType (peer))
+        {
+          flow.socket->Bind ();
+        }
+      flow.socket->Connect (peer);
+      flow.socket->ShutdownRecv ();
+      flow.socket->SetConnectCallback (
+        MakeCallback (&FlowGeneratorApplication::ConnectionSucceeded, this),
+        MakeCallback (&FlowGeneratorApplication::ConnectionFailed, this));
+      flow.socket->SetSendCallback (
+        MakeCallback (&FlowGeneratorApplication::DataSend, this));
+    }
+
+  ScheduleNextFlow ();
+}
+
+void FlowGeneratorApplication::SendData (uint32_t id)
+{
+  NS_LOG_FUNCTION (this << id);
+
+  Flow &flow = m_flows[id];
+  while (flow.remaining > 0)
+    {
+      uint64_t toSend = std::min<uint64_t> (m_sendSize, flow.remaining);
+      toSend = std::min<uint64_t> (toSend, flow.socket->GetTxAvailable ());
+      if (toSend == 0)
+        {
+          // The "DataSent" callback will pop when some buffer space has
+          // freed up.
+          break;
+        }
+      int actual = flow.socket->Send (Create<Packet> (toSend));
+      if (actual <= 0)
+        {
+          break;
+        }
+      flow.remaining -= actual;
+    }
+  if (flow.remaining == 0 && !m_reuse)
+    {
+      flow.socket->Close ();
+    }
+}
+
+void FlowGeneratorApplication::CompleteFlow (uint32_t id)
+{
+  NS_LOG_FUNCTION (this << id);
+
+  Flow &flow = m_flows[id];
+  NS_LOG_LOGIC ("Flow " << id << " of " << flow.size << " bytes completed in "
+                        << (Simulator::Now () - flow.start).GetSeconds () << " s");
+  m_flowCompleteTrace (flow.size, Simulator::Now () - flow.start);
+  m_socketFlows.erase (flow.socket);
+  if (!m_reuse)
+    {
+      flow.socket->SetSendCallback (MakeNullCallback<void, Ptr<Socket>, uint32_t> ());
+    }
+  else if (!m_active)
+    {
+      flow.socket->Close ();
+    }
+  else
+    {
+      m_idleSockets[flow.peer].push_back (flow.socket);
+    }
+  flow.socket = 0;
+  m_freeFlows.push_back (id);
+}
+
+void FlowGeneratorApplication::ConnectionSucceeded (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  NS_LOG_LOGIC ("FlowGeneratorApplication Connection succeeded");
+  std::map<Ptr<Socket>, uint32_t>::iterator it = m_socketFlows.find (socket);
+  NS_ASSERT (it != m_socketFlows.end ());
+  m_flows[it->second].txCapacity = socket->GetTxAvailable ();
+  SendData (it->second);
+}
+
+void FlowGeneratorApplication::ConnectionFailed (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  NS_LOG_LOGIC ("FlowGeneratorApplication, Connection Failed");
+  std::map<Ptr<Socket>, uint32_t>::iterator it = m_socketFlows.find (socket);
+  if (it != m_socketFlows.end ())
+    {
+      m_flows[it->second].socket = 0;
+      m_freeFlows.push_back (it->second);
+      m_socketFlows.erase (it);
+    }
+}
+
+void FlowGeneratorApplication::DataSend (Ptr<Socket> socket, uint32_t)
+{
+  NS_LOG_FUNCTION (this);
+
+  std::map<Ptr<Socket>, uint32_t>::iterator it = m_socketFlows.find (socket);
+  if (it == m_socketFlows.end ())
+    {
+      return;
+    }
+  uint32_t id = it->second;
+  if (m_flows[id].remaining > 0)
+    {
+      SendData (id);
+    }
+  // the send callback follows the release of acknowledged data
+  if (m_flows[id].remaining == 0 && socket->GetTxAvailable () == m_flows[id].txCapacity)
+    {
+      CompleteFlow (id);
+    }
+}
+
+} // Namespace ns3
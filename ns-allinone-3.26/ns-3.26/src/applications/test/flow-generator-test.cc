@@ -0,0 +1,232 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <fstream>
+#include "ns3/log.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/data-rate.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/flow-generator-helper.h"
+#include "ns3/packet-sink-helper.h"
+#include "ns3/packet-sink.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+#include "ns3/mac48-address.h"
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+
+using namespace ns3;
+
+/**
+ * Test that a CDF file is read, normalized and averaged
+ */
+class FlowGeneratorCdfTestCase : public TestCase
+{
+public:
+  FlowGeneratorCdfTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+FlowGeneratorCdfTestCase::FlowGeneratorCdfTestCase ()
+  : TestCase ("Read a flow size CDF in percent and compute its mean")
+{
+}
+
+void
+FlowGeneratorCdfTestCase::DoRun (void)
+{
+  std::string fileName = CreateTempDirFilename ("flow-size.cdf");
+  std::ofstream out (fileName.c_str ());
+  out << "# size cdf\n"
+      << "\n"
+      << "1000 0\n"
+      << "2000 50\n"
+      << "3000   1 100\n";
+  out.close ();
+
+  FlowGeneratorApplication::Cdf cdf = FlowGeneratorApplication::ReadCdf (fileName);
+  NS_TEST_ASSERT_MSG_EQ (cdf.size (), 3, "Comments and empty lines should be skipped");
+  NS_TEST_EXPECT_MSG_EQ (cdf[1].first, 2000, "Wrong size");
+  NS_TEST_EXPECT_MSG_EQ_TOL (cdf[1].second, 0.5, 1e-9, "Percentages should be normalized");
+  NS_TEST_EXPECT_MSG_EQ (cdf[2].first, 3000, "The size is the first column");
+  NS_TEST_EXPECT_MSG_EQ_TOL (cdf[2].second, 1, 1e-9, "The probability is the last column");
+
+  Ptr<FlowGeneratorApplication> app = CreateObject<FlowGeneratorApplication> ();
+  app->SetFlowSizeCdf (cdf);
+  NS_TEST_EXPECT_MSG_EQ_TOL (app->GetMeanFlowSize (), 2000, 1e-9, "Wrong mean flow size");
+}
+
+/**
+ * Test that the flows of an all-to-all workload arrive at the expected
+ * rate and are all delivered
+ */
+class FlowGeneratorWorkloadTestCase : public TestCase
+{
+public:
+  /**
+   * \param reuse whether the connections are reused
+   */
+  FlowGeneratorWorkloadTestCase (bool reuse);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Count a started flow
+   * \param size the size of the flow
+   * \param peer the address of the peer
+   */
+  void FlowStart (uint64_t size, const Address &peer);
+
+  /**
+   * \brief Count a completed flow
+   * \param size the size of the flow
+   * \param fct the completion time of the flow
+   */
+  void FlowComplete (uint64_t size, Time fct);
+
+  bool m_reuse;          //!< whether the connections are reused
+  uint32_t m_started;    //!< flows started
+  uint32_t m_completed;  //!< flows completed
+  uint64_t m_bytes;      //!< bytes of the flows started
+};
+
+FlowGeneratorWorkloadTestCase::FlowGeneratorWorkloadTestCase (bool reuse)
+  : TestCase (reuse ? "Deliver an all-to-all workload on reused connections"
+              : "Deliver an all-to-all workload with one connection per flow"),
+    m_reuse (reuse),
+    m_started (0),
+    m_completed (0),
+    m_bytes (0)
+{
+}
+
+void
+FlowGeneratorWorkloadTestCase::FlowStart (uint64_t size, const Address &peer)
+{
+  m_started++;
+  m_bytes += size;
+}
+
+void
+FlowGeneratorWorkloadTestCase::FlowComplete (uint64_t size, Time fct)
+{
+  m_completed++;
+}
+
+void
+FlowGeneratorWorkloadTestCase::DoRun (void)
+{
+  // every flow is 10 kB
+  std::string fileName = CreateTempDirFilename ("fixed-size.cdf");
+  std::ofstream out (fileName.c_str ());
+  out << "10000 1\n";
+  out.close ();
+
+  NodeContainer hosts;
+  hosts.Create (3);
+  InternetStackHelper internet;
+  internet.Install (hosts);
+
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < hosts.GetN (); i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAttribute ("DataRate", DataRateValue (DataRate ("10Mbps")));
+      device->SetAddress (Mac48Address::Allocate ());
+      device->SetChannel (channel);
+      hosts.Get (i)->AddDevice (device);
+      devices.Add (device);
+    }
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  ipv4.Assign (devices);
+
+  uint16_t port = 5000;
+  PacketSinkHelper sink ("ns3::TcpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), port));
+  ApplicationContainer sinks = sink.Install (hosts);
+
+  // 40% of 10 Mb/s is 50 flows of 10 kB per second and per host
+  FlowGeneratorHelper generator ("ns3::TcpSocketFactory", fileName, port);
+  generator.SetAttribute ("Load", DoubleValue (0.4));
+  generator.SetAttribute ("LinkRate", DataRateValue (DataRate ("10Mbps")));
+  generator.SetAttribute ("ReuseConnections", BooleanValue (m_reuse));
+  ApplicationContainer apps = generator.Install (hosts);
+  generator.AssignStreams (hosts, 1);
+  apps.Start (Seconds (1));
+  apps.Stop (Seconds (3));
+  for (uint32_t i = 0; i < apps.GetN (); i++)
+    {
+      apps.Get (i)->TraceConnectWithoutContext ("FlowStart", MakeCallback (&FlowGeneratorWorkloadTestCase::FlowStart, this));
+      apps.Get (i)->TraceConnectWithoutContext ("FlowComplete", MakeCallback (&FlowGeneratorWorkloadTestCase::FlowComplete, this));
+    }
+
+  Simulator::Stop (Seconds (10));
+  Simulator::Run ();
+
+  uint64_t received = 0;
+  for (uint32_t i = 0; i < sinks.GetN (); i++)
+    {
+      received += DynamicCast<PacketSink> (sinks.Get (i))->GetTotalRx ();
+    }
+  uint32_t flows = 0;
+  uint32_t connections = 0;
+  for (uint32_t i = 0; i < apps.GetN (); i++)
+    {
+      Ptr<FlowGeneratorApplication> app = DynamicCast<FlowGeneratorApplication> (apps.Get (i));
+      flows += app->GetNFlows ();
+      connections += app->GetNConnections ();
+    }
+  Simulator::Destroy ();
+
+  // 300 flows are expected in 2 s, with a standard deviation of about 17
+  NS_TEST_EXPECT_MSG_GT (m_started, 240, "Too few flows started");
+  NS_TEST_EXPECT_MSG_LT (m_started, 360, "Too many flows started");
+  NS_TEST_EXPECT_MSG_EQ (flows, m_started, "Flow count mismatch");
+  NS_TEST_EXPECT_MSG_EQ (m_bytes, m_started * 10000, "Every flow is 10 kB");
+  NS_TEST_EXPECT_MSG_EQ (m_completed, m_started, "All the flows should complete");
+  NS_TEST_EXPECT_MSG_EQ (received, m_bytes, "All the bytes should be received");
+  if (m_reuse)
+    {
+      NS_TEST_EXPECT_MSG_LT (connections, flows, "The connections should be reused");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_EQ (connections, flows, "Each flow should have its connection");
+    }
+}
+
+class FlowGeneratorTestSuite : public TestSuite
+{
+public:
+  FlowGeneratorTestSuite ();
+};
+
+FlowGeneratorTestSuite::FlowGeneratorTestSuite ()
+  : TestSuite ("flow-generator", UNIT)
+{
+  AddTestCase (new FlowGeneratorCdfTestCase, TestCase::QUICK);
+  AddTestCase (new FlowGeneratorWorkloadTestCase (false), TestCase::QUICK);
+  AddTestCase (new FlowGeneratorWorkloadTestCase (true), TestCase::QUICK);
+}
+
+static FlowGeneratorTestSuite flowGeneratorTestSuite;
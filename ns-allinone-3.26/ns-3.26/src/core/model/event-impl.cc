@@ -31,6 +31,146 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("EventImpl");
 
+namespace {
+
+/**
+ * \ingroup events
+ * Per-thread free lists of event storage, indexed by size class.
+ *
+ * Events may be freed by a different thread than the one which
+ * allocated them (see Simulator::ScheduleWithContext): the storage then
+ * simply moves to the free list of the freeing thread.  Each free list
+ * is bounded so that such a flow cannot pin an unbounded amount of
+ * memory.
+ */
+class EventPool
+{
+public:
+  /** Size class granularity, in bytes. */
+  static const std::size_t GRANULARITY = 16;
+  /** Number of size classes: events up to 256 bytes are pooled. */
+  static const std::size_t N_CLASSES = 16;
+  /** Maximum number of free blocks kept per size class. */
+  static const uint32_t MAX_FREE = 4096;
+
+  EventPool ();
+  /** Release the free blocks to the global heap at thread exit. */
+  ~EventPool ();
+
+  /**
+   * \param [in] size The requested size.
+   * \returns A block of at least \p size bytes.
+   */
+  void * Allocate (std::size_t size);
+  /**
+   * \param [in] p The block.
+   * \param [in] size The size the block was allocated with.
+   */
+  void Free (void *p, std::size_t size);
+
+private:
+  /** A free block, linked through its first word. */
+  struct Block
+  {
+    Block *next;  //!< The next free block.
+  };
+  Block *m_free[N_CLASSES];      //!< Free list heads.
+  uint32_t m_nFree[N_CLASSES];   //!< Free list lengths.
+};
+
+/** The free lists of the current thread. */
+thread_local EventPool g_eventPool;
+/**
+ * Set once g_eventPool has been destroyed, for events freed later during
+ * the thread (or program) exit.
+ */
+thread_local bool g_eventPoolDestroyed = false;
+
+EventPool::EventPool ()
+{
+  for (std::size_t i = 0; i < N_CLASSES; i++)
+    {
+      m_free[i] = 0;
+      m_nFree[i] = 0;
+    }
+}
+
+EventPool::~EventPool ()
+{
+  for (std::size_t i = 0; i < N_CLASSES; i++)
+    {
+      while (m_free[i] != 0)
+        {
+          Block *block = m_free[i];
+          m_free[i] = block->next;
+          ::operator delete (block);
+        }
+      m_nFree[i] = 0;
+    }
+  g_eventPoolDestroyed = true;
+}
+
+void *
+EventPool::Allocate (std::size_t size)
+{
+  std::size_t index = (size - 1) / GRANULARITY;
+  if (index >= N_CLASSES)
+    {
+      return ::operator new (size);
+    }
+  Block *block = m_free[index];
+  if (block == 0)
+    {
+      return ::operator new ((index + 1) * GRANULARITY);
+    }
+  m_free[index] = block->next;
+  m_nFree[index]--;
+  return block;
+}
+
+void
+EventPool::Free (void *p, std::size_t size)
+{
+  std::size_t index = (size - 1) / GRANULARITY;
+  if (index >= N_CLASSES || m_nFree[index] >= MAX_FREE)
+    {
+      ::operator delete (p);
+      return;
+    }
+  Block *block = static_cast<Block *> (p);
+  block->next = m_free[index];
+  m_free[index] = block;
+  m_nFree[index]++;
+}
+
+} // unnamed namespace
+
+void *
+EventImpl::operator new (std::size_t size)
+{
+  if (g_eventPoolDestroyed)
+    {
+      // round up, as the block may be freed to the pool of another thread
+      return ::operator new (((size - 1) / EventPool::GRANULARITY + 1) * EventPool::GRANULARITY);
+    }
+  return g_eventPool.Allocate (size);
+}
+
+void
+EventImpl::operator delete (void *p, std::size_t size)
+{
+  if (p == 0)
+    {
+      return;
+    }
+  if (g_eventPoolDestroyed)
+    {
+      ::operator delete (p);
+      return;
+    }
+  g_eventPool.Free (p, size);
+}
+
 EventImpl::~EventImpl ()
 {
   NS_LOG_FUNCTION (this);
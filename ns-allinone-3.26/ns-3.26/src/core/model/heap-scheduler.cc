@@ -236,7 +236,24 @@ HeapScheduler::Remove (const Event &ev)
           NS_ASSERT (m_heap[i].impl == ev.impl);
           Exch (i, Last ());
           m_heap.pop_back ();
-          TopDown (i);
+          if (i == m_heap.size ())
+            {
+              return;
+            }
+          // the former last event may be earlier than the parent of
+          // the removed one, in which case it must move up.
+          if (!IsRoot (i) && IsLessStrictly (i, Parent (i)))
+            {
+              while (!IsRoot (i) && IsLessStrictly (i, Parent (i)))
+                {
+                  Exch (i, Parent (i));
+                  i = Parent (i);
+                }
+            }
+          else
+            {
+              TopDown (i);
+            }
           return;
         }
     }
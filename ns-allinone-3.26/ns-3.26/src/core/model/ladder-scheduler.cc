@@ -0,0 +1,297 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ladder-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+#include <algorithm>
+#include <functional>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Implementation of ns3::LadderScheduler class.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LadderScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (LadderScheduler);
+
+namespace {
+
+/**
+ * \ingroup scheduler
+ * Order events by decreasing key, so that a sorted Bottom can be
+ * consumed from its back.
+ */
+struct LaterEvent
+{
+  /**
+   * \param [in] a The first event.
+   * \param [in] b The second event.
+   * \returns \c true if \c a is later than \c b
+   */
+  bool operator () (const Scheduler::Event &a, const Scheduler::Event &b) const
+  {
+    return a.key > b.key;
+  }
+};
+
+} // unnamed namespace
+
+TypeId
+LadderScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<LadderScheduler> ()
+  ;
+  return tid;
+}
+
+LadderScheduler::LadderScheduler ()
+  : m_topMin (~(uint64_t)0),
+    m_topMax (0),
+    m_topStart (0),
+    m_rungs (MAX_RUNGS),
+    m_nRungs (0),
+    m_size (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LadderScheduler::~LadderScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint64_t
+LadderScheduler::CurrentStart (const Rung &rung) const
+{
+  return rung.start + rung.current * rung.width;
+}
+
+uint32_t
+LadderScheduler::FindRung (uint64_t ts) const
+{
+  uint32_t i = 0;
+  while (i < m_nRungs && ts < CurrentStart (m_rungs[i]))
+    {
+      i++;
+    }
+  return i;
+}
+
+void
+LadderScheduler::SpawnRung (Bucket &events, uint64_t start, uint64_t span)
+{
+  NS_LOG_FUNCTION (this << events.size () << start << span);
+  NS_ASSERT (m_nRungs < MAX_RUNGS && !events.empty ());
+  Rung &rung = m_rungs[m_nRungs];
+  rung.nBuckets = events.size ();
+  rung.width = std::max<uint64_t> (1, (span + rung.nBuckets - 1) / rung.nBuckets);
+  rung.start = start;
+  rung.current = 0;
+  if (rung.buckets.size () < rung.nBuckets)
+    {
+      rung.buckets.resize (rung.nBuckets);
+    }
+  for (Bucket::const_iterator i = events.begin (); i != events.end (); ++i)
+    {
+      uint64_t bucket = (i->key.m_ts - start) / rung.width;
+      NS_ASSERT (bucket < rung.nBuckets);
+      rung.buckets[bucket].push_back (*i);
+    }
+  events.clear ();
+  m_nRungs++;
+}
+
+void
+LadderScheduler::TransferTop (void)
+{
+  NS_LOG_FUNCTION (this << m_top.size ());
+  NS_ASSERT (m_nRungs == 0);
+  SpawnRung (m_top, m_topMin, m_topMax - m_topMin + 1);
+  const Rung &rung = m_rungs[0];
+  m_topStart = rung.start + rung.nBuckets * rung.width;
+  m_topMin = ~(uint64_t)0;
+  m_topMax = 0;
+}
+
+void
+LadderScheduler::InsertBottom (const Scheduler::Event &ev)
+{
+  m_bottom.insert (std::upper_bound (m_bottom.begin (), m_bottom.end (), ev, LaterEvent ()), ev);
+}
+
+void
+LadderScheduler::Refill (void)
+{
+  NS_LOG_FUNCTION (this);
+  while (m_bottom.empty () && m_size > 0)
+    {
+      if (m_nRungs == 0)
+        {
+          TransferTop ();
+        }
+      Rung &rung = m_rungs[m_nRungs - 1];
+      while (rung.current < rung.nBuckets && rung.buckets[rung.current].empty ())
+        {
+          rung.current++;
+        }
+      if (rung.current == rung.nBuckets)
+        {
+          m_nRungs--;
+          continue;
+        }
+      Bucket &bucket = rung.buckets[rung.current];
+      uint64_t bucketStart = CurrentStart (rung);
+      rung.current++;
+      if (bucket.size () > THRESHOLD && rung.width > 1 && m_nRungs < MAX_RUNGS)
+        {
+          SpawnRung (bucket, bucketStart, rung.width);
+        }
+      else
+        {
+          m_bottom.swap (bucket);
+          std::sort (m_bottom.begin (), m_bottom.end (), LaterEvent ());
+        }
+    }
+}
+
+void
+LadderScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  uint64_t ts = ev.key.m_ts;
+  m_size++;
+  if (ts >= m_topStart)
+    {
+      m_top.push_back (ev);
+      m_topMin = std::min (m_topMin, ts);
+      m_topMax = std::max (m_topMax, ts);
+      if (m_bottom.empty ())
+        {
+          Refill ();
+        }
+      return;
+    }
+  uint32_t i = FindRung (ts);
+  if (i < m_nRungs)
+    {
+      Rung &rung = m_rungs[i];
+      rung.buckets[(ts - rung.start) / rung.width].push_back (ev);
+      if (m_bottom.empty ())
+        {
+          Refill ();
+        }
+      return;
+    }
+  InsertBottom (ev);
+  if (m_bottom.size () > THRESHOLD && m_nRungs < MAX_RUNGS
+      && m_bottom.front ().key.m_ts > m_bottom.back ().key.m_ts)
+    {
+      // Bottom covers everything below the lowest rung (or Top): spread
+      // it over a new rung rather than paying for sorted inserts.
+      uint64_t end = m_nRungs > 0 ? CurrentStart (m_rungs[m_nRungs - 1]) : m_topStart;
+      uint64_t start = m_bottom.back ().key.m_ts;
+      SpawnRung (m_bottom, start, end - start);
+      Refill ();
+    }
+}
+
+bool
+LadderScheduler::IsEmpty (void) const
+{
+  return m_size == 0;
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  return m_bottom.back ();
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  Scheduler::Event ev = m_bottom.back ();
+  m_bottom.pop_back ();
+  m_size--;
+  if (m_bottom.empty ())
+    {
+      Refill ();
+    }
+  NS_LOG_DEBUG ("remove " << ev.impl << ", time " << ev.key.m_ts << ", uid " << ev.key.m_uid);
+  return ev;
+}
+
+void
+LadderScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  NS_ASSERT (!IsEmpty ());
+  uint64_t ts = ev.key.m_ts;
+  Bucket *events;
+  if (ts >= m_topStart)
+    {
+      events = &m_top;
+    }
+  else
+    {
+      uint32_t i = FindRung (ts);
+      if (i < m_nRungs)
+        {
+          Rung &rung = m_rungs[i];
+          events = &rung.buckets[(ts - rung.start) / rung.width];
+        }
+      else
+        {
+          Bucket::iterator it = std::lower_bound (m_bottom.begin (), m_bottom.end (), ev, LaterEvent ());
+          NS_ASSERT (it != m_bottom.end () && it->key.m_uid == ev.key.m_uid);
+          NS_ASSERT (it->impl == ev.impl);
+          m_bottom.erase (it);
+          m_size--;
+          if (m_bottom.empty ())
+            {
+              Refill ();
+            }
+          return;
+        }
+    }
+  for (Bucket::iterator it = events->begin (); it != events->end (); ++it)
+    {
+      if (it->key.m_uid == ev.key.m_uid)
+        {
+          NS_ASSERT (it->impl == ev.impl);
+          *it = events->back ();
+          events->pop_back ();
+          m_size--;
+          return;
+        }
+    }
+  NS_ASSERT (false);
+}
+
+} // namespace ns3
@@ -0,0 +1,170 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Declaration of ns3::LadderScheduler class.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler is an implementation of the Ladder Queue described in:
+ * W. T. Tang, R. S. M. Goh, and I. L.-J. Thng, "Ladder Queue: An O(1)
+ * priority queue structure for large-scale discrete event simulation",
+ * ACM TOMACS 15(3), 2005.
+ *
+ * Events are kept in three tiers:
+ *  - Top, an unsorted vector holding the events of the far future;
+ *  - a ladder of up to MAX_RUNGS rungs, each an array of unsorted buckets
+ *    which splits the time range of one bucket of the rung above;
+ *  - Bottom, a small sorted vector from which events are dequeued.
+ *
+ * When Bottom runs empty, the first non-empty bucket of the lowest rung is
+ * either sorted into Bottom or, if it holds more than THRESHOLD events,
+ * spread over a new, finer rung.  When the ladder runs empty, Top is spread
+ * over a new first rung whose bucket width is derived from the event
+ * density of Top.  Every event is thus moved a bounded number of times and
+ * only ever sorted in groups of at most THRESHOLD events, which gives O(1)
+ * amortized Insert and RemoveNext for the event time distributions of
+ * packet-level network simulations, whether the pending event set is small
+ * or holds millions of timers.
+ *
+ * Remove is not O(1): events move between tiers and within their
+ * unsorted buckets, so their position is not tracked.  Remove finds the
+ * tier of the event from its time stamp, in O(number of rungs), then
+ * - erases it from Bottom in O(THRESHOLD), Bottom being sorted;
+ * - or scans the bucket holding it, like the CalendarScheduler.  The
+ *   buckets of the ladder hold about THRESHOLD events, but they are not
+ *   split further once MAX_RUNGS rungs are in use;
+ * - or scans Top, in O(size of Top), up to O(n) when most of the
+ *   pending events are in the far future.
+ *
+ * DefaultSimulatorImpl only calls Remove for Simulator::Remove unless
+ * its RemoveCancelledEvents attribute is set, so cancelled events do
+ * not pay for this scan.
+ */
+class LadderScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  LadderScheduler ();
+  /** Destructor. */
+  virtual ~LadderScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+private:
+  /** Unsorted container of events. */
+  typedef std::vector<Scheduler::Event> Bucket;
+
+  /** A rung of the ladder. */
+  struct Rung
+  {
+    uint64_t start;                /**< Time stamp of the start of bucket 0. */
+    uint64_t width;                /**< Time span of each bucket. */
+    uint32_t nBuckets;             /**< Number of buckets in use. */
+    uint32_t current;              /**< First bucket not yet moved down. */
+    std::vector<Bucket> buckets;   /**< The buckets. */
+  };
+
+  /** Maximum number of events sorted into Bottom at once. */
+  static const uint32_t THRESHOLD = 50;
+  /** Maximum number of rungs. */
+  static const uint32_t MAX_RUNGS = 8;
+
+  /**
+   * Get the time stamp of the first bucket of a rung which may still
+   * receive events.
+   *
+   * \param [in] rung The rung.
+   * \returns The start of the current bucket of \p rung.
+   */
+  inline uint64_t CurrentStart (const Rung &rung) const;
+  /**
+   * Find the rung whose current range holds a time stamp.
+   *
+   * \param [in] ts The time stamp.
+   * \returns The index of the rung, or m_nRungs if \p ts belongs to Bottom.
+   */
+  uint32_t FindRung (uint64_t ts) const;
+  /**
+   * Append a new rung below the lowest one and spread events over it.
+   *
+   * \param [in,out] events The events to spread, cleared on return.
+   * \param [in] start The start of the time range of the new rung.
+   * \param [in] span The length of the time range of the new rung.
+   */
+  void SpawnRung (Bucket &events, uint64_t start, uint64_t span);
+  /**
+   * Move the events of Top to a new first rung.
+   */
+  void TransferTop (void);
+  /**
+   * Insert an event in Bottom, keeping it sorted.
+   *
+   * \param [in] ev The event.
+   */
+  void InsertBottom (const Scheduler::Event &ev);
+  /**
+   * Refill Bottom from the ladder and Top until it holds the next event,
+   * unless the scheduler is empty.
+   */
+  void Refill (void);
+
+  /** Events of the far future, not sorted. */
+  Bucket m_top;
+  /** Smallest time stamp in Top. */
+  uint64_t m_topMin;
+  /** Largest time stamp in Top. */
+  uint64_t m_topMax;
+  /** Events with time stamps from m_topStart on are inserted in Top. */
+  uint64_t m_topStart;
+  /** The rungs, of which the first m_nRungs are in use. */
+  std::vector<Rung> m_rungs;
+  /** Number of rungs in use. */
+  uint32_t m_nRungs;
+  /** Next events, sorted by decreasing key so the earliest is at the back. */
+  Bucket m_bottom;
+  /** Total number of events. */
+  uint32_t m_size;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
@@ -27,6 +27,9 @@
 #include "assert.h"
 #include <stdint.h>
 #include <limits>
+#ifdef NS3_MTP
+#include <atomic>
+#endif
 
 /**
  * \file
@@ -67,6 +70,10 @@ namespace ns3 {
  *      to the object it manages exist anymore.
  *
  * Interesting users of this class include ns3::Object as well as ns3::Packet.
+ *
+ * When ns-3 is configured with --enable-mtp, the reference count is
+ * atomic, so that objects such as packets can be handed over between
+ * the threads of the MultithreadedSimulatorImpl.
  */
 template <typename T, typename PARENT = empty, typename DELETER = DefaultDeleter<T> >
 class SimpleRefCount : public PARENT
@@ -110,8 +117,7 @@ public:
    */
   inline void Unref (void) const
   {
-    m_count--;
-    if (m_count == 0)
+    if (--m_count == 0)
       {
         DELETER::Delete (static_cast<T*> (const_cast<SimpleRefCount *> (this)));
       }
@@ -140,7 +146,11 @@ private:
    * Note we make this mutable so that the const methods can still
    * change it.
    */
+#ifdef NS3_MTP
+  mutable std::atomic<uint32_t> m_count;
+#else
   mutable uint32_t m_count;
+#endif
 };
 
 } // namespace ns3
@@ -77,6 +77,10 @@ public:
   virtual void Cancel (const EventId &id) = 0;
   /** \copydoc Simulator::IsExpired */
   virtual bool IsExpired (const EventId &id) const = 0;
+  /** \copydoc Simulator::GetLiveEventCount */
+  virtual uint32_t GetLiveEventCount (void) const = 0;
+  /** \copydoc Simulator::GetCancelledEventCount */
+  virtual uint32_t GetCancelledEventCount (void) const = 0;
   /** \copydoc Simulator::Run */
   virtual void Run (void) = 0;
   /** \copydoc Simulator::Now */
@@ -23,6 +23,14 @@
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/make-event.h"
+#include "ns3/event-impl.h"
+#include "ns3/simulator-impl.h"
+#include "ns3/boolean.h"
+#include <set>
+#include <vector>
 
 using namespace ns3;
 
@@ -459,6 +467,154 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * Check that a scheduler hands out events in key order under a random mix
+ * of inserts, removals and dequeues with small and large time spreads.
+ */
+class SchedulerOrderTestCase : public TestCase
+{
+public:
+  SchedulerOrderTestCase (ObjectFactory schedulerFactory);
+  virtual void DoRun (void);
+  ObjectFactory m_schedulerFactory;
+};
+
+SchedulerOrderTestCase::SchedulerOrderTestCase (ObjectFactory schedulerFactory)
+  : TestCase ("Check event ordering under random operations with " +
+              schedulerFactory.GetTypeId ().GetName ()),
+    m_schedulerFactory (schedulerFactory)
+{
+}
+
+void
+SchedulerOrderTestCase::DoRun (void)
+{
+  Ptr<Scheduler> scheduler = m_schedulerFactory.Create<Scheduler> ();
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  std::set<std::pair<uint64_t, uint32_t> > expected;
+  std::vector<Scheduler::Event> pending;
+  uint64_t now = 0;
+  uint32_t uid = 0;
+
+  for (uint32_t op = 0; op < 20000 || !pending.empty (); op++)
+    {
+      double choice = op < 20000 ? rand->GetValue () : 1.0;
+      if (choice < 0.55)
+        {
+          // mix of simultaneous, near and far events
+          double spread = rand->GetValue ();
+          uint64_t delay = spread < 0.2 ? 0
+            : spread < 0.7 ? rand->GetInteger (1, 1000)
+            : rand->GetInteger (1, 100000000);
+          Scheduler::Event ev;
+          ev.impl = 0;
+          ev.key.m_ts = now + delay;
+          ev.key.m_uid = uid++;
+          ev.key.m_context = 0;
+          scheduler->Insert (ev);
+          expected.insert (std::make_pair (ev.key.m_ts, ev.key.m_uid));
+          pending.push_back (ev);
+        }
+      else if (choice < 0.6 && !pending.empty ())
+        {
+          uint32_t i = rand->GetInteger (0, pending.size () - 1);
+          scheduler->Remove (pending[i]);
+          expected.erase (std::make_pair (pending[i].key.m_ts, pending[i].key.m_uid));
+          pending[i] = pending.back ();
+          pending.pop_back ();
+        }
+      else if (!pending.empty ())
+        {
+          NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), false, "scheduler lost events");
+          Scheduler::Event next = scheduler->PeekNext ();
+          Scheduler::Event ev = scheduler->RemoveNext ();
+          NS_TEST_ASSERT_MSG_EQ (next.key.m_uid, ev.key.m_uid, "PeekNext and RemoveNext disagree");
+          NS_TEST_ASSERT_MSG_EQ (ev.key.m_ts, expected.begin ()->first, "wrong event time");
+          NS_TEST_ASSERT_MSG_EQ (ev.key.m_uid, expected.begin ()->second, "wrong event uid");
+          expected.erase (expected.begin ());
+          now = ev.key.m_ts;
+          for (uint32_t i = 0; i < pending.size (); i++)
+            {
+              if (pending[i].key.m_uid == ev.key.m_uid)
+                {
+                  pending[i] = pending.back ();
+                  pending.pop_back ();
+                  break;
+                }
+            }
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), true, "scheduler not empty");
+}
+
+/**
+ * Check that cancelled events are removed from the event list, the live
+ * and cancelled event counters, and the recycling of event storage.
+ */
+class SimulatorCancelTestCase : public TestCase
+{
+public:
+  SimulatorCancelTestCase ();
+  virtual void DoRun (void);
+  void Event (void);
+  uint32_t m_count;
+};
+
+SimulatorCancelTestCase::SimulatorCancelTestCase ()
+  : TestCase ("Check removal and counting of cancelled events")
+{
+}
+
+void
+SimulatorCancelTestCase::Event (void)
+{
+  m_count++;
+}
+
+void
+SimulatorCancelTestCase::DoRun (void)
+{
+  m_count = 0;
+  std::vector<EventId> ids;
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      ids.push_back (Simulator::Schedule (MicroSeconds (i), &SimulatorCancelTestCase::Event, this));
+    }
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetLiveEventCount (), 10, "wrong number of live events");
+  for (uint32_t i = 0; i < 10; i += 3)
+    {
+      ids[i].Cancel ();
+      NS_TEST_EXPECT_MSG_EQ (ids[i].IsExpired (), true, "cancelled event has not expired");
+    }
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetLiveEventCount (), 6, "cancelled events still live");
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetCancelledEventCount (), 4, "wrong number of cancelled events");
+
+  // remove cancelled events from the event list
+  Ptr<SimulatorImpl> impl = Simulator::GetImplementation ();
+  impl->SetAttribute ("RemoveCancelledEvents", BooleanValue (true));
+  EventId id = Simulator::Schedule (MicroSeconds (20), &SimulatorCancelTestCase::Event, this);
+  Simulator::Schedule (MicroSeconds (21), &SimulatorCancelTestCase::Event, this);
+  id.Cancel ();
+  NS_TEST_EXPECT_MSG_EQ (id.IsExpired (), true, "cancelled event has not expired");
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetLiveEventCount (), 7, "wrong number of live events");
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetCancelledEventCount (), 4, "cancelled event not removed");
+
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_count, 7, "wrong number of events run");
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetLiveEventCount (), 0, "live events left");
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetCancelledEventCount (), 0, "cancelled events left");
+  impl->SetAttribute ("RemoveCancelledEvents", BooleanValue (false));
+
+  // event storage is recycled
+  EventImpl *first = MakeEvent (&SimulatorCancelTestCase::Event, this);
+  first->Unref ();
+  EventImpl *second = MakeEvent (&SimulatorCancelTestCase::Event, this);
+  NS_TEST_EXPECT_MSG_EQ (second, first, "event storage was not recycled");
+  second->Unref ();
+
+  Simulator::Destroy ();
+}
+
 class SimulatorTestSuite : public TestSuite
 {
 public:
@@ -475,5 +631,21 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+
+    const char *schedulers[] = {
+      "ns3::ListScheduler",
+      "ns3::MapScheduler",
+      "ns3::HeapScheduler",
+      "ns3::CalendarScheduler",
+      "ns3::LadderScheduler"
+    };
+    for (uint32_t i = 0; i < sizeof (schedulers) / sizeof (schedulers[0]); i++)
+      {
+        factory.SetTypeId (schedulers[i]);
+        AddTestCase (new SchedulerOrderTestCase (factory), TestCase::QUICK);
+      }
+    AddTestCase (new SimulatorCancelTestCase (), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
@@ -0,0 +1,329 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation;
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#ifndef FLOW_HASH_TABLE_H
+#define FLOW_HASH_TABLE_H
+
+#include <vector>
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup flow-monitor
+ * \brief A flat hash table keyed by 64-bit integers
+ *
+ * The entries are stored by value in a single array, with linear
+ * probing and backward shift deletion, so that lookups touch
+ * contiguous memory and erasing an entry leaves no tombstone. The
+ * table doubles when half full and halves when less than one eighth
+ * full, so its memory follows the number of entries.
+ *
+ * Inserting or erasing an entry invalidates the pointers and slot
+ * indices previously obtained.
+ *
+ * \tparam T the type of the values, default constructible
+ */
+template <typename T>
+class FlowHashTable
+{
+public:
+  FlowHashTable ();
+
+  /**
+   * \param key the key
+   * \return the value stored under key, or zero if there is none
+   */
+  T * Find (uint64_t key);
+  /**
+   * \param key the key
+   * \return the value stored under key, or zero if there is none
+   */
+  const T * Find (uint64_t key) const;
+  /**
+   * \param key the key
+   * \return the value stored under key, default constructed if there was none
+   */
+  T & operator [] (uint64_t key);
+  /**
+   * \param key the key
+   * \return true if an entry was erased
+   */
+  bool Erase (uint64_t key);
+  /// Remove all the entries and release the memory
+  void Clear (void);
+  /// \return the number of entries
+  uint32_t GetSize (void) const;
+
+  /**
+   * The slots are numbered from 0 to GetNSlots () - 1; iterate over
+   * them and skip the slots that are not used to visit every entry.
+   *
+   * \return the number of slots
+   */
+  uint32_t GetNSlots (void) const;
+  /**
+   * \param slot the slot index
+   * \return true if the slot holds an entry
+   */
+  bool IsUsed (uint32_t slot) const;
+  /**
+   * \param slot the index of a used slot
+   * \return the key of the entry
+   */
+  uint64_t GetKey (uint32_t slot) const;
+  /**
+   * \param slot the index of a used slot
+   * \return the value of the entry
+   */
+  T & GetValue (uint32_t slot);
+  /**
+   * \param slot the index of a used slot
+   * \return the value of the entry
+   */
+  const T & GetValue (uint32_t slot) const;
+
+private:
+  /// A slot of the table
+  struct Slot
+  {
+    Slot () : key (0), used (false) {}
+    uint64_t key;  //!< the key of the entry
+    bool used;     //!< whether the slot holds an entry
+    T value;       //!< the value of the entry
+  };
+
+  /**
+   * \param key the key
+   * \return the slot the key hashes to
+   */
+  uint32_t Home (uint64_t key) const;
+  /**
+   * \param key the key
+   * \return the slot holding key, or the first free slot of its cluster
+   */
+  uint32_t Probe (uint64_t key) const;
+  /**
+   * Move the entries to a table of a new size
+   * \param nSlots the new number of slots, a power of two
+   */
+  void Resize (uint32_t nSlots);
+
+  static const uint32_t MIN_SLOTS = 16; //!< initial and minimum size
+
+  std::vector<Slot> m_slots; //!< the slots, a power of two of them
+  uint32_t m_mask;           //!< number of slots minus one
+  uint32_t m_shift;          //!< 64 minus log2 of the number of slots
+  uint32_t m_size;           //!< number of entries
+};
+
+template <typename T>
+FlowHashTable<T>::FlowHashTable ()
+  : m_mask (0),
+    m_shift (64),
+    m_size (0)
+{
+}
+
+template <typename T>
+uint32_t
+FlowHashTable<T>::Home (uint64_t key) const
+{
+  // Fibonacci hashing spreads the consecutive flow and packet ids
+  return (key * 0x9E3779B97F4A7C15ULL) >> m_shift;
+}
+
+template <typename T>
+uint32_t
+FlowHashTable<T>::Probe (uint64_t key) const
+{
+  uint32_t i = Home (key);
+  while (m_slots[i].used && m_slots[i].key != key)
+    {
+      i = (i + 1) & m_mask;
+    }
+  return i;
+}
+
+template <typename T>
+T *
+FlowHashTable<T>::Find (uint64_t key)
+{
+  if (m_size == 0)
+    {
+      return 0;
+    }
+  Slot &slot = m_slots[Probe (key)];
+  return slot.used ? &slot.value : 0;
+}
+
+template <typename T>
+const T *
+FlowHashTable<T>::Find (uint64_t key) const
+{
+  if (m_size == 0)
+    {
+      return 0;
+    }
+  const Slot &slot = m_slots[Probe (key)];
+  return slot.used ? &slot.value : 0;
+}
+
+template <typename T>
+T &
+FlowHashTable<T>::operator [] (uint64_t key)
+{
+  if (m_slots.empty ())
+    {
+      Resize (MIN_SLOTS);
+    }
+  uint32_t i = Probe (key);
+  if (m_slots[i].used)
+    {
+      return m_slots[i].value;
+    }
+  if (2 * (m_size + 1) > m_slots.size ())
+    {
+      Resize (2 * m_slots.size ());
+      i = Probe (key);
+    }
+  m_slots[i].used = true;
+  m_slots[i].key = key;
+  m_size++;
+  return m_slots[i].value;
+}
+
+template <typename T>
+bool
+FlowHashTable<T>::Erase (uint64_t key)
+{
+  if (m_size == 0)
+    {
+      return false;
+    }
+  uint32_t hole = Probe (key);
+  if (!m_slots[hole].used)
+    {
+      return false;
+    }
+  // shift back the following entries of the cluster which may not be
+  // stored before the hole, so that no lookup stops early
+  uint32_t i = hole;
+  for (;;)
+    {
+      i = (i + 1) & m_mask;
+      if (!m_slots[i].used)
+        {
+          break;
+        }
+      uint32_t home = Home (m_slots[i].key);
+      if (((i - home) & m_mask) >= ((i - hole) & m_mask))
+        {
+          m_slots[hole].key = m_slots[i].key;
+          m_slots[hole].value = m_slots[i].value;
+          hole = i;
+        }
+    }
+  m_slots[hole].used = false;
+  m_slots[hole].value = T ();
+  m_size--;
+  if (m_slots.size () > MIN_SLOTS && 8 * m_size < m_slots.size ())
+    {
+      Resize (m_slots.size () / 2);
+    }
+  return true;
+}
+
+template <typename T>
+void
+FlowHashTable<T>::Clear (void)
+{
+  std::vector<Slot> ().swap (m_slots);
+  m_mask = 0;
+  m_shift = 64;
+  m_size = 0;
+}
+
+template <typename T>
+uint32_t
+FlowHashTable<T>::GetSize (void) const
+{
+  return m_size;
+}
+
+template <typename T>
+uint32_t
+FlowHashTable<T>::GetNSlots (void) const
+{
+  return m_slots.size ();
+}
+
+template <typename T>
+bool
+FlowHashTable<T>::IsUsed (uint32_t slot) const
+{
+  return m_slots[slot].used;
+}
+
+template <typename T>
+uint64_t
+FlowHashTable<T>::GetKey (uint32_t slot) const
+{
+  return m_slots[slot].key;
+}
+
+template <typename T>
+T &
+FlowHashTable<T>::GetValue (uint32_t slot)
+{
+  return m_slots[slot].value;
+}
+
+template <typename T>
+const T &
+FlowHashTable<T>::GetValue (uint32_t slot) const
+{
+  return m_slots[slot].value;
+}
+
+template <typename T>
+void
+FlowHashTable<T>::Resize (uint32_t nSlots)
+{
+  std::vector<Slot> old;
+  old.swap (m_slots);
+  m_slots.resize (nSlots);
+  m_mask = nSlots - 1;
+  m_shift = 64;
+  for (uint32_t n = nSlots; n > 1; n >>= 1)
+    {
+      m_shift--;
+    }
+  for (typename std::vector<Slot>::iterator it = old.begin (); it != old.end (); ++it)
+    {
+      if (it->used)
+        {
+          Slot &slot = m_slots[Probe (it->key)];
+          slot.used = true;
+          slot.key = it->key;
+          slot.value = it->value;
+        }
+    }
+}
+
+} // namespace ns3
+
+#endif /* FLOW_HASH_TABLE_H */
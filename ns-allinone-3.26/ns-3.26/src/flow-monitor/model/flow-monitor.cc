@@ -22,7 +22,9 @@
 #include "ns3/simulator.h"
 #include "ns3/log.h"
 #include "ns3/double.h"
-#include <fstream>
+#include "ns3/string.h"
+#include "ns3/enum.h"
+#include <algorithm>
 #include <sstream>
 
 #define INDENT(level) for (int __xpto = 0; __xpto < level; __xpto++) os << ' ';
@@ -35,6 +37,20 @@ NS_LOG_COMPONENT_DEFINE ("FlowMonitor");
 
 NS_OBJECT_ENSURE_REGISTERED (FlowMonitor);
 
+/// \return the key of a tracked packet
+static inline uint64_t
+PacketKey (FlowId flowId, FlowPacketId packetId)
+{
+  return (uint64_t (flowId) << 32) | packetId;
+}
+
+/// Write a value to a binary stream, in host byte order
+template <typename T>
+static inline void
+WriteBinary (std::ostream &os, T value)
+{
+  os.write (reinterpret_cast<const char *> (&value), sizeof (value));
+}
 
 TypeId 
 FlowMonitor::GetTypeId (void)
@@ -72,6 +88,21 @@ FlowMonitor::GetTypeId (void)
                    TimeValue (Seconds (0.5)),
                    MakeTimeAccessor (&FlowMonitor::m_flowInterruptionsMinTime),
                    MakeTimeChecker ())
+    .AddAttribute ("StreamFile", ("If not empty, the statistics of the completed flows are written to this file "
+                                  "and their state is freed, instead of being kept until the end."),
+                   StringValue (""),
+                   MakeStringAccessor (&FlowMonitor::m_streamFileName),
+                   MakeStringChecker ())
+    .AddAttribute ("StreamFormat", ("The format of the stream file."),
+                   EnumValue (STREAM_CSV),
+                   MakeEnumAccessor (&FlowMonitor::m_streamFormat),
+                   MakeEnumChecker (STREAM_CSV, "Csv",
+                                    STREAM_BINARY, "Binary"))
+    .AddAttribute ("FlowIdleTimeout", ("When streaming, the time after which a flow with no packet in flight "
+                                       "and no activity is finalized."),
+                   TimeValue (Seconds (1.0)),
+                   MakeTimeAccessor (&FlowMonitor::m_flowIdleTimeout),
+                   MakeTimeChecker ())
   ;
   return tid;
 }
@@ -83,7 +114,8 @@ FlowMonitor::GetInstanceTypeId (void) const
 }
 
 FlowMonitor::FlowMonitor ()
-  : m_enabled (false)
+  : m_enabled (false),
+    m_streamFormat (STREAM_CSV)
 {
   // m_histogramBinWidth=DEFAULT_BIN_WIDTH;
 }
@@ -91,6 +123,15 @@ FlowMonitor::FlowMonitor ()
 void
 FlowMonitor::DoDispose (void)
 {
+  Simulator::Cancel (m_finalizeEvent);
+  FlushStream ();
+  if (m_stream.is_open ())
+    {
+      m_stream.close ();
+    }
+  m_flows.Clear ();
+  m_trackedPackets.Clear ();
+  m_flowStats.clear ();
   for (std::list<Ptr<FlowClassifier> >::iterator iter = m_classifiers.begin ();
       iter != m_classifiers.end ();
       iter ++)
@@ -105,14 +146,15 @@ FlowMonitor::DoDispose (void)
   Object::DoDispose ();
 }
 
-inline FlowMonitor::FlowStats&
-FlowMonitor::GetStatsForFlow (FlowId flowId)
+inline FlowMonitor::FlowState&
+FlowMonitor::GetStateForFlow (FlowId flowId)
 {
-  FlowStatsContainerI iter;
-  iter = m_flowStats.find (flowId);
-  if (iter == m_flowStats.end ())
+  FlowState *state = m_flows.Find (flowId);
+  if (state == 0)
     {
-      FlowMonitor::FlowStats &ref = m_flowStats[flowId];
+      state = &m_flows[flowId];
+      state->packetsInFlight = 0;
+      FlowMonitor::FlowStats &ref = state->stats;
       ref.delaySum = Seconds (0);
       ref.jitterSum = Seconds (0);
       ref.lastDelay = Seconds (0);
@@ -126,12 +168,8 @@ FlowMonitor::GetStatsForFlow (FlowId flowId)
       ref.jitterHistogram.SetDefaultBinWidth (m_jitterBinWidth);
       ref.packetSizeHistogram.SetDefaultBinWidth (m_packetSizeBinWidth);
       ref.flowInterruptionsHistogram.SetDefaultBinWidth (m_flowInterruptionsBinWidth);
-      return ref;
-    }
-  else
-    {
-      return iter->second;
     }
+  return *state;
 }
 
 
@@ -143,16 +181,23 @@ FlowMonitor::ReportFirstTx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t pack
       return;
     }
   Time now = Simulator::Now ();
-  TrackedPacket &tracked = m_trackedPackets[std::make_pair (flowId, packetId)];
-  tracked.firstSeenTime = now;
-  tracked.lastSeenTime = tracked.firstSeenTime;
-  tracked.timesForwarded = 0;
+  FlowState &state = GetStateForFlow (flowId);
+  uint64_t key = PacketKey (flowId, packetId);
+  TrackedPacket *tracked = m_trackedPackets.Find (key);
+  if (tracked == 0)
+    {
+      tracked = &m_trackedPackets[key];
+      state.packetsInFlight++;
+    }
+  tracked->firstSeenTime = now;
+  tracked->lastSeenTime = tracked->firstSeenTime;
+  tracked->timesForwarded = 0;
   NS_LOG_DEBUG ("ReportFirstTx: adding tracked packet (flowId=" << flowId << ", packetId=" << packetId
                                                                 << ").");
 
   probe->AddPacketStats (flowId, packetSize, Seconds (0));
 
-  FlowStats &stats = GetStatsForFlow (flowId);
+  FlowStats &stats = state.stats;
   stats.txBytes += packetSize;
   stats.txPackets++;
   if (stats.txPackets == 1)
@@ -170,19 +215,18 @@ FlowMonitor::ReportForwarding (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t p
     {
       return;
     }
-  std::pair<FlowId, FlowPacketId> key (flowId, packetId);
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (key);
-  if (tracked == m_trackedPackets.end ())
+  TrackedPacket *tracked = m_trackedPackets.Find (PacketKey (flowId, packetId));
+  if (tracked == 0)
     {
       NS_LOG_WARN ("Received packet forward report (flowId=" << flowId << ", packetId=" << packetId
                                                              << ") but not known to be transmitted.");
       return;
     }
 
-  tracked->second.timesForwarded++;
-  tracked->second.lastSeenTime = Simulator::Now ();
+  tracked->timesForwarded++;
+  tracked->lastSeenTime = Simulator::Now ();
 
-  Time delay = (Simulator::Now () - tracked->second.firstSeenTime);
+  Time delay = (Simulator::Now () - tracked->firstSeenTime);
   probe->AddPacketStats (flowId, packetSize, delay);
 }
 
@@ -194,8 +238,9 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
     {
       return;
     }
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (std::make_pair (flowId, packetId));
-  if (tracked == m_trackedPackets.end ())
+  uint64_t key = PacketKey (flowId, packetId);
+  TrackedPacket *tracked = m_trackedPackets.Find (key);
+  if (tracked == 0)
     {
       NS_LOG_WARN ("Received packet last-tx report (flowId=" << flowId << ", packetId=" << packetId
                                                              << ") but not known to be transmitted.");
@@ -203,30 +248,38 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
     }
 
   Time now = Simulator::Now ();
-  Time delay = (now - tracked->second.firstSeenTime);
+  Time delay = (now - tracked->firstSeenTime);
   probe->AddPacketStats (flowId, packetSize, delay);
 
-  FlowStats &stats = GetStatsForFlow (flowId);
+  // the histograms are not collected when streaming
+  bool histograms = !IsStreaming ();
+  FlowState &state = GetStateForFlow (flowId);
+  FlowStats &stats = state.stats;
   stats.delaySum += delay;
-  stats.delayHistogram.AddValue (delay.GetSeconds ());
+  if (histograms)
+    {
+      stats.delayHistogram.AddValue (delay.GetSeconds ());
+    }
   if (stats.rxPackets > 0 )
     {
       Time jitter = stats.lastDelay - delay;
-      if (jitter > Seconds (0))
+      if (jitter < Seconds (0))
         {
-          stats.jitterSum += jitter;
-          stats.jitterHistogram.AddValue (jitter.GetSeconds ());
+          jitter = delay - stats.lastDelay;
         }
-      else 
+      stats.jitterSum += jitter;
+      if (histograms)
         {
-          stats.jitterSum -= jitter;
-          stats.jitterHistogram.AddValue (-jitter.GetSeconds ());
+          stats.jitterHistogram.AddValue (jitter.GetSeconds ());
         }
     }
   stats.lastDelay = delay;
 
   stats.rxBytes += packetSize;
-  stats.packetSizeHistogram.AddValue ((double) packetSize);
+  if (histograms)
+    {
+      stats.packetSizeHistogram.AddValue ((double) packetSize);
+    }
   stats.rxPackets++;
   if (stats.rxPackets == 1)
     {
@@ -236,18 +289,19 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
     {
       // measure possible flow interruptions
       Time interArrivalTime = now - stats.timeLastRxPacket;
-      if (interArrivalTime > m_flowInterruptionsMinTime)
+      if (histograms && interArrivalTime > m_flowInterruptionsMinTime)
         {
           stats.flowInterruptionsHistogram.AddValue (interArrivalTime.GetSeconds ());
         }
     }
   stats.timeLastRxPacket = now;
-  stats.timesForwarded += tracked->second.timesForwarded;
+  stats.timesForwarded += tracked->timesForwarded;
 
   NS_LOG_DEBUG ("ReportLastTx: removing tracked packet (flowId="
                 << flowId << ", packetId=" << packetId << ").");
 
-  m_trackedPackets.erase (tracked); // we don't need to track this packet anymore
+  state.packetsInFlight--;
+  m_trackedPackets.Erase (key); // we don't need to track this packet anymore
 }
 
 void
@@ -261,7 +315,8 @@ FlowMonitor::ReportDrop (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetI
 
   probe->AddPacketDropStats (flowId, packetSize, reasonCode);
 
-  FlowStats &stats = GetStatsForFlow (flowId);
+  FlowState &state = GetStateForFlow (flowId);
+  FlowStats &stats = state.stats;
   stats.lostPackets++;
   if (stats.packetsDropped.size () < reasonCode + 1)
     {
@@ -272,20 +327,27 @@ FlowMonitor::ReportDrop (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetI
   stats.bytesDropped[reasonCode] += packetSize;
   NS_LOG_DEBUG ("++stats.packetsDropped[" << reasonCode<< "]; // becomes: " << stats.packetsDropped[reasonCode]);
 
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (std::make_pair (flowId, packetId));
-  if (tracked != m_trackedPackets.end ())
+  if (m_trackedPackets.Erase (PacketKey (flowId, packetId)))
     {
       // we don't need to track this packet anymore
       // FIXME: this will not necessarily be true with broadcast/multicast
-      NS_LOG_DEBUG ("ReportDrop: removing tracked packet (flowId="
+      NS_LOG_DEBUG ("ReportDrop: removed tracked packet (flowId="
                     << flowId << ", packetId=" << packetId << ").");
-      m_trackedPackets.erase (tracked);
+      state.packetsInFlight--;
     }
 }
 
 const FlowMonitor::FlowStatsContainer&
 FlowMonitor::GetFlowStats () const
 {
+  m_flowStats.clear ();
+  for (uint32_t i = 0; i < m_flows.GetNSlots (); i++)
+    {
+      if (m_flows.IsUsed (i))
+        {
+          m_flowStats.insert (std::make_pair (FlowId (m_flows.GetKey (i)), m_flows.GetValue (i).stats));
+        }
+    }
   return m_flowStats;
 }
 
@@ -295,24 +357,25 @@ FlowMonitor::CheckForLostPackets (Time maxDelay)
 {
   Time now = Simulator::Now ();
 
-  for (TrackedPacketMap::iterator iter = m_trackedPackets.begin ();
-       iter != m_trackedPackets.end (); )
+  std::vector<uint64_t> lost;
+  for (uint32_t i = 0; i < m_trackedPackets.GetNSlots (); i++)
     {
-      if (now - iter->second.lastSeenTime >= maxDelay)
-        {
-          // packet is considered lost, add it to the loss statistics
-          FlowStatsContainerI flow = m_flowStats.find (iter->first.first);
-          NS_ASSERT (flow != m_flowStats.end ());
-          flow->second.lostPackets++;
-
-          // we won't track it anymore
-          m_trackedPackets.erase (iter++);
-        }
-      else
+      if (m_trackedPackets.IsUsed (i) && now - m_trackedPackets.GetValue (i).lastSeenTime >= maxDelay)
         {
-          iter++;
+          lost.push_back (m_trackedPackets.GetKey (i));
         }
     }
+  for (std::vector<uint64_t>::const_iterator iter = lost.begin (); iter != lost.end (); iter++)
+    {
+      // packet is considered lost, add it to the loss statistics
+      FlowState *flow = m_flows.Find (*iter >> 32);
+      NS_ASSERT (flow != 0);
+      flow->stats.lostPackets++;
+      flow->packetsInFlight--;
+
+      // we won't track it anymore
+      m_trackedPackets.Erase (*iter);
+    }
 }
 
 void
@@ -328,6 +391,150 @@ FlowMonitor::PeriodicCheckForLostPackets ()
   Simulator::Schedule (PERIODIC_CHECK_INTERVAL, &FlowMonitor::PeriodicCheckForLostPackets, this);
 }
 
+bool
+FlowMonitor::IsStreaming () const
+{
+  return !m_streamFileName.empty ();
+}
+
+void
+FlowMonitor::FinalizeIdleFlows (Time idleTime)
+{
+  if (!IsStreaming ())
+    {
+      return;
+    }
+  Time now = Simulator::Now ();
+  std::vector<FlowId> idle;
+  for (uint32_t i = 0; i < m_flows.GetNSlots (); i++)
+    {
+      if (!m_flows.IsUsed (i))
+        {
+          continue;
+        }
+      const FlowState &state = m_flows.GetValue (i);
+      Time lastSeen = std::max (state.stats.timeLastTxPacket, state.stats.timeLastRxPacket);
+      if (state.packetsInFlight == 0 && now - lastSeen >= idleTime)
+        {
+          idle.push_back (m_flows.GetKey (i));
+        }
+    }
+  NS_LOG_DEBUG ("Finalizing " << idle.size () << " of " << m_flows.GetSize () << " flows");
+  for (std::vector<FlowId>::const_iterator iter = idle.begin (); iter != idle.end (); iter++)
+    {
+      FinalizeFlow (*iter);
+    }
+}
+
+void
+FlowMonitor::FlushStream ()
+{
+  if (!IsStreaming ())
+    {
+      return;
+    }
+  OpenStream ();
+  // the packets in flight will not be accounted anymore
+  m_trackedPackets.Clear ();
+  std::vector<FlowId> flows;
+  for (uint32_t i = 0; i < m_flows.GetNSlots (); i++)
+    {
+      if (m_flows.IsUsed (i))
+        {
+          flows.push_back (m_flows.GetKey (i));
+        }
+    }
+  // finalize the flows in the order of their ids, as in the XML output
+  std::sort (flows.begin (), flows.end ());
+  for (std::vector<FlowId>::const_iterator iter = flows.begin (); iter != flows.end (); iter++)
+    {
+      FinalizeFlow (*iter);
+    }
+  m_stream.flush ();
+}
+
+void
+FlowMonitor::PeriodicFinalizeIdleFlows ()
+{
+  FinalizeIdleFlows (m_flowIdleTimeout);
+  m_finalizeEvent = Simulator::Schedule (m_flowIdleTimeout, &FlowMonitor::PeriodicFinalizeIdleFlows, this);
+}
+
+void
+FlowMonitor::FinalizeFlow (FlowId flowId)
+{
+  FlowState *state = m_flows.Find (flowId);
+  NS_ASSERT (state != 0);
+  WriteStreamRecord (flowId, state->stats);
+  for (uint32_t i = 0; i < m_flowProbes.size (); i++)
+    {
+      m_flowProbes[i]->RemoveFlowStats (flowId);
+    }
+  m_flows.Erase (flowId);
+}
+
+void
+FlowMonitor::OpenStream ()
+{
+  if (m_stream.is_open ())
+    {
+      return;
+    }
+  m_stream.open (m_streamFileName.c_str (), std::ios::out|std::ios::binary);
+  if (!m_stream.is_open ())
+    {
+      NS_FATAL_ERROR ("Cannot open the flow monitor stream " << m_streamFileName);
+    }
+  if (m_streamFormat == STREAM_BINARY)
+    {
+      m_stream.write ("FMONBIN1", 8);
+    }
+  else
+    {
+      m_stream << "flowId,timeFirstTxPacket,timeFirstRxPacket,timeLastTxPacket,timeLastRxPacket,"
+               << "delaySum,jitterSum,txBytes,rxBytes,txPackets,rxPackets,lostPackets,timesForwarded\n";
+    }
+}
+
+void
+FlowMonitor::WriteStreamRecord (FlowId flowId, const FlowStats &stats)
+{
+  OpenStream ();
+  if (m_streamFormat == STREAM_BINARY)
+    {
+      WriteBinary<uint32_t> (m_stream, flowId);
+      WriteBinary<int64_t> (m_stream, stats.timeFirstTxPacket.GetNanoSeconds ());
+      WriteBinary<int64_t> (m_stream, stats.timeFirstRxPacket.GetNanoSeconds ());
+      WriteBinary<int64_t> (m_stream, stats.timeLastTxPacket.GetNanoSeconds ());
+      WriteBinary<int64_t> (m_stream, stats.timeLastRxPacket.GetNanoSeconds ());
+      WriteBinary<int64_t> (m_stream, stats.delaySum.GetNanoSeconds ());
+      WriteBinary<int64_t> (m_stream, stats.jitterSum.GetNanoSeconds ());
+      WriteBinary<uint64_t> (m_stream, stats.txBytes);
+      WriteBinary<uint64_t> (m_stream, stats.rxBytes);
+      WriteBinary<uint32_t> (m_stream, stats.txPackets);
+      WriteBinary<uint32_t> (m_stream, stats.rxPackets);
+      WriteBinary<uint32_t> (m_stream, stats.lostPackets);
+      WriteBinary<uint32_t> (m_stream, stats.timesForwarded);
+    }
+  else
+    {
+      m_stream << flowId
+               << ',' << stats.timeFirstTxPacket.GetNanoSeconds ()
+               << ',' << stats.timeFirstRxPacket.GetNanoSeconds ()
+               << ',' << stats.timeLastTxPacket.GetNanoSeconds ()
+               << ',' << stats.timeLastRxPacket.GetNanoSeconds ()
+               << ',' << stats.delaySum.GetNanoSeconds ()
+               << ',' << stats.jitterSum.GetNanoSeconds ()
+               << ',' << stats.txBytes
+               << ',' << stats.rxBytes
+               << ',' << stats.txPackets
+               << ',' << stats.rxPackets
+               << ',' << stats.lostPackets
+               << ',' << stats.timesForwarded
+               << '\n';
+    }
+}
+
 void
 FlowMonitor::NotifyConstructionCompleted ()
 {
@@ -380,6 +587,10 @@ FlowMonitor::StartRightNow ()
       return;
     }
   m_enabled = true;
+  if (IsStreaming () && m_flowIdleTimeout > Seconds (0))
+    {
+      m_finalizeEvent = Simulator::Schedule (m_flowIdleTimeout, &FlowMonitor::PeriodicFinalizeIdleFlows, this);
+    }
 }
 
 
@@ -392,6 +603,8 @@ FlowMonitor::StopRightNow ()
     }
   m_enabled = false;
   CheckForLostPackets ();
+  Simulator::Cancel (m_finalizeEvent);
+  FlushStream ();
 }
 
 void
@@ -404,6 +617,7 @@ void
 FlowMonitor::SerializeToXmlStream (std::ostream &os, int indent, bool enableHistograms, bool enableProbes)
 {
   CheckForLostPackets ();
+  GetFlowStats ();
 
   INDENT (indent); os << "<FlowMonitor>\n";
   indent += 2;
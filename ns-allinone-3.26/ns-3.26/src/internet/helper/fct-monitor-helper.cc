@@ -0,0 +1,81 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "fct-monitor-helper.h"
+
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/tcp-l4-protocol.h"
+
+namespace ns3 {
+
+FctMonitorHelper::FctMonitorHelper ()
+{
+  m_monitorFactory.SetTypeId ("ns3::FctMonitor");
+}
+
+void
+FctMonitorHelper::SetMonitorAttribute (std::string n1, const AttributeValue &v1)
+{
+  m_monitorFactory.Set (n1, v1);
+}
+
+Ptr<FctMonitor>
+FctMonitorHelper::GetMonitor (void)
+{
+  if (!m_monitor)
+    {
+      m_monitor = m_monitorFactory.Create<FctMonitor> ();
+    }
+  return m_monitor;
+}
+
+Ptr<FctMonitor>
+FctMonitorHelper::Install (Ptr<Node> node)
+{
+  Ptr<TcpL4Protocol> tcp = node->GetObject<TcpL4Protocol> ();
+  NS_ASSERT_MSG (tcp, "FctMonitorHelper::Install: node " << node->GetId () << " has no TCP");
+  tcp->SetFctMonitor (GetMonitor ());
+  return m_monitor;
+}
+
+Ptr<FctMonitor>
+FctMonitorHelper::Install (NodeContainer nodes)
+{
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      if ((*i)->GetObject<TcpL4Protocol> ())
+        {
+          Install (*i);
+        }
+    }
+  return GetMonitor ();
+}
+
+Ptr<FctMonitor>
+FctMonitorHelper::InstallAll (void)
+{
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); ++i)
+    {
+      if ((*i)->GetObject<TcpL4Protocol> ())
+        {
+          Install (*i);
+        }
+    }
+  return GetMonitor ();
+}
+
+} // namespace ns3
@@ -0,0 +1,80 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FCT_MONITOR_HELPER_H
+#define FCT_MONITOR_HELPER_H
+
+#include "ns3/node-container.h"
+#include "ns3/object-factory.h"
+#include "ns3/fct-monitor.h"
+#include <string>
+
+namespace ns3 {
+
+class AttributeValue;
+
+/**
+ * \ingroup tcp
+ * \brief Helper to collect the flow completion times of TCP connections
+ *
+ * The monitor is attached to the TcpL4Protocol of the nodes, and
+ * records the flows of the sockets they create afterwards. Install it
+ * before the applications start.
+ */
+class FctMonitorHelper
+{
+public:
+  FctMonitorHelper ();
+
+  /**
+   * \brief Set an attribute for the to-be-created FctMonitor object
+   * \param n1 attribute name
+   * \param v1 attribute value
+   */
+  void SetMonitorAttribute (std::string n1, const AttributeValue &v1);
+
+  /**
+   * \brief Record the flows sent by a set of nodes
+   * \param nodes the nodes
+   * \returns the FctMonitor object
+   */
+  Ptr<FctMonitor> Install (NodeContainer nodes);
+  /**
+   * \brief Record the flows sent by a node
+   * \param node the node
+   * \returns the FctMonitor object
+   */
+  Ptr<FctMonitor> Install (Ptr<Node> node);
+  /**
+   * \brief Record the flows sent by all the nodes
+   * \returns the FctMonitor object
+   */
+  Ptr<FctMonitor> InstallAll (void);
+
+  /**
+   * \brief Retrieve the FctMonitor object created by the Install* methods
+   * \returns the FctMonitor object
+   */
+  Ptr<FctMonitor> GetMonitor (void);
+
+private:
+  ObjectFactory m_monitorFactory; //!< Object factory
+  Ptr<FctMonitor> m_monitor;      //!< the monitor
+};
+
+} // namespace ns3
+
+#endif /* FCT_MONITOR_HELPER_H */
@@ -0,0 +1,240 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include "atp-loss-budget.h"
+#include "ns3/log.h"
+#include "ns3/assert.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AtpLossBudget");
+
+/// The span a window of 0, the whole flow, is capped to, so that the
+/// sequence numbers it counts still compare correctly
+static const uint32_t WHOLE_FLOW_SPAN = 1u << 30;
+
+AtpLossBudget::AtpLossBudget ()
+  : m_budget (0.0),
+    m_window (0),
+    m_sent (false),
+    m_firstSeq (0),
+    m_highSeq (0)
+{
+}
+
+void
+AtpLossBudget::SetBudget (double budget)
+{
+  NS_ASSERT (budget >= 0.0 && budget <= 1.0);
+  m_budget = budget;
+}
+
+double
+AtpLossBudget::GetBudget (void) const
+{
+  return m_budget;
+}
+
+void
+AtpLossBudget::SetWindow (uint32_t window)
+{
+  m_window = window;
+}
+
+uint32_t
+AtpLossBudget::GetWindow (void) const
+{
+  return m_window;
+}
+
+void
+AtpLossBudget::AddMessage (const SequenceNumber32 &head, const SequenceNumber32 &tail, double budget)
+{
+  NS_LOG_FUNCTION (this << head << tail << budget);
+  NS_ASSERT (head < tail);
+  NS_ASSERT (budget >= 0.0 && budget <= 1.0);
+  NS_ASSERT (m_messages.empty () || m_messages.back ().tail <= head);
+
+  Message message;
+  message.head = head;
+  message.tail = tail;
+  message.budget = budget;
+  m_messages.push_back (message);
+}
+
+void
+AtpLossBudget::Sent (const SequenceNumber32 &seq, uint32_t size)
+{
+  if (size == 0)
+    {
+      return;
+    }
+  if (!m_sent)
+    {
+      m_sent = true;
+      m_firstSeq = seq;
+      m_highSeq = seq + size;
+    }
+  else
+    {
+      m_highSeq = std::max (m_highSeq, seq + size);
+    }
+}
+
+bool
+AtpLossBudget::Abandon (const SequenceNumber32 &seq, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << seq << size);
+
+  SequenceNumber32 tail = seq + size;
+  uint32_t fresh = size - GetAbandonedBytes (seq, tail);
+  if (fresh == 0)
+    {
+      NS_LOG_LOGIC ("[" << seq << ";" << tail << ") abandoned already");
+      return true;
+    }
+  if (!m_sent)
+    {
+      return false;
+    }
+
+  // The message holding the first byte has its own budget; the rest of the
+  // stream is counted over the last window bytes sent
+  uint32_t window = m_window > 0 ? m_window : WHOLE_FLOW_SPAN;
+  double budget = m_budget;
+  SequenceNumber32 head = m_firstSeq;
+  SequenceNumber32 end = std::max (m_highSeq, tail);
+  std::deque<Message>::const_iterator it;
+  for (it = m_messages.begin (); it != m_messages.end () && it->head <= seq; ++it)
+    {
+      if (seq < it->tail)
+        {
+          budget = it->budget;
+          head = it->head;
+          end = it->tail;
+          break;
+        }
+    }
+  if (it == m_messages.end () || it->head > seq)
+    {
+      if (static_cast<uint32_t> (end - head) > window)
+        {
+          head = end - window;
+        }
+    }
+
+  uint32_t lost = GetAbandonedBytes (head, end) + fresh;
+  if (lost > budget * static_cast<uint32_t> (end - head))
+    {
+      NS_LOG_LOGIC ("Losing [" << seq << ";" << tail << ") would lose " << lost <<
+                    " bytes of [" << head << ";" << end << "), beyond the budget " << budget);
+      return false;
+    }
+
+  // Record the range, merged with the ones it touches
+  SequenceNumber32 first = seq;
+  SequenceNumber32 last = tail;
+  std::map<SequenceNumber32, SequenceNumber32>::iterator range = m_abandoned.upper_bound (seq);
+  if (range != m_abandoned.begin ())
+    {
+      std::map<SequenceNumber32, SequenceNumber32>::iterator previous = range;
+      --previous;
+      if (previous->second >= seq)
+        {
+          first = previous->first;
+          range = previous;
+        }
+    }
+  while (range != m_abandoned.end () && range->first <= last)
+    {
+      last = std::max (last, range->second);
+      m_abandoned.erase (range++);
+    }
+  m_abandoned[first] = last;
+  NS_LOG_LOGIC ("Abandoned [" << seq << ";" << tail << "), " << lost <<
+                " bytes lost of [" << head << ";" << end << ")");
+  return true;
+}
+
+uint32_t
+AtpLossBudget::GetAbandonedBytes (const SequenceNumber32 &head, const SequenceNumber32 &tail) const
+{
+  uint32_t bytes = 0;
+  std::map<SequenceNumber32, SequenceNumber32>::const_iterator it = m_abandoned.upper_bound (head);
+  if (it != m_abandoned.begin ())
+    {
+      --it;
+    }
+  for (; it != m_abandoned.end () && it->first < tail; ++it)
+    {
+      SequenceNumber32 first = std::max (it->first, head);
+      SequenceNumber32 last = std::min (it->second, tail);
+      if (first < last)
+        {
+          bytes += last - first;
+        }
+    }
+  return bytes;
+}
+
+std::vector<AtpLossBudget::Range>
+AtpLossBudget::GetAbandonedRanges (const SequenceNumber32 &seq, uint32_t maxRanges) const
+{
+  std::vector<Range> ranges;
+  std::map<SequenceNumber32, SequenceNumber32>::const_iterator it = m_abandoned.upper_bound (seq);
+  if (it != m_abandoned.begin ())
+    {
+      --it;
+    }
+  for (; it != m_abandoned.end () && ranges.size () < maxRanges; ++it)
+    {
+      if (it->second > seq)
+        {
+          ranges.push_back (Range (std::max (it->first, seq), it->second));
+        }
+    }
+  return ranges;
+}
+
+void
+AtpLossBudget::DiscardUpTo (const SequenceNumber32 &ack)
+{
+  NS_LOG_FUNCTION (this << ack);
+
+  while (!m_messages.empty () && m_messages.front ().tail <= ack)
+    {
+      m_messages.pop_front ();
+    }
+  // The ranges below the ACK still count while in the window or in a message
+  uint32_t window = m_window > 0 ? m_window : WHOLE_FLOW_SPAN;
+  SequenceNumber32 low = m_firstSeq;
+  if (static_cast<uint32_t> (m_highSeq - m_firstSeq) > window)
+    {
+      low = m_highSeq - window;
+    }
+  low = std::min (low, ack);
+  if (!m_messages.empty ())
+    {
+      low = std::min (low, m_messages.front ().head);
+    }
+  while (!m_abandoned.empty () && m_abandoned.begin ()->second <= low)
+    {
+      m_abandoned.erase (m_abandoned.begin ());
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,148 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ATP_LOSS_BUDGET_H
+#define ATP_LOSS_BUDGET_H
+
+#include <deque>
+#include <map>
+#include <vector>
+#include <utility>
+#include "ns3/sequence-number.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ *
+ * \brief The loss budget of an ATP sender: which losses it may leave
+ * unrepaired
+ *
+ * The budget is a fraction of the bytes sent.  A message, registered with
+ * its own budget, may lose that fraction of its bytes; the data outside
+ * the messages shares the budget of the flow, counted over the last
+ * window bytes sent, or over the whole flow by default.  A lost range is abandoned, instead of retransmitted,
+ * while the abandoned bytes stay within the budget.  The ranges abandoned
+ * are kept, merged, as long as a message or the window counts them, or
+ * the peer did not acknowledge them.
+ */
+class AtpLossBudget
+{
+public:
+  /// A range of the stream, [first, second)
+  typedef std::pair<SequenceNumber32, SequenceNumber32> Range;
+
+  AtpLossBudget ();
+
+  /**
+   * \brief Set the budget of the flow
+   * \param budget the fraction of the bytes sent which may be lost
+   */
+  void SetBudget (double budget);
+
+  /**
+   * \brief Get the budget of the flow
+   * \returns the fraction of the bytes sent which may be lost
+   */
+  double GetBudget (void) const;
+
+  /**
+   * \brief Set the window the budget of the flow is counted over
+   * \param window the number of bytes, the last ones sent; 0 for the
+   * whole flow, up to its last 2^30 bytes
+   */
+  void SetWindow (uint32_t window);
+
+  /**
+   * \brief Get the window the budget of the flow is counted over
+   * \returns the number of bytes
+   */
+  uint32_t GetWindow (void) const;
+
+  /**
+   * \brief Register a message with its own budget
+   *
+   * The messages are registered in the order of the stream.
+   *
+   * \param head sequence number of the first byte of the message
+   * \param tail sequence number following the message
+   * \param budget the fraction of the bytes of the message which may be lost
+   */
+  void AddMessage (const SequenceNumber32 &head, const SequenceNumber32 &tail, double budget);
+
+  /**
+   * \brief Account for data sent
+   * \param seq sequence number of the first byte
+   * \param size number of bytes
+   */
+  void Sent (const SequenceNumber32 &seq, uint32_t size);
+
+  /**
+   * \brief Decide whether a lost range is abandoned, and record it if so
+   *
+   * A range abandoned already is abandoned again without being counted
+   * twice.
+   *
+   * \param seq sequence number of the first byte lost
+   * \param size number of bytes lost
+   * \returns true if the range is abandoned, false if it has to be
+   * retransmitted
+   */
+  bool Abandon (const SequenceNumber32 &seq, uint32_t size);
+
+  /**
+   * \brief Get the bytes abandoned within a range
+   * \param head first sequence number of the range
+   * \param tail sequence number following the range
+   * \returns the number of bytes
+   */
+  uint32_t GetAbandonedBytes (const SequenceNumber32 &head, const SequenceNumber32 &tail) const;
+
+  /**
+   * \brief Get the ranges abandoned beyond a sequence number
+   * \param seq the sequence number, usually the cumulative ACK
+   * \param maxRanges maximum number of ranges to return, the lowest ones
+   * \returns the ranges, clipped at seq, in sequence order
+   */
+  std::vector<Range> GetAbandonedRanges (const SequenceNumber32 &seq, uint32_t maxRanges) const;
+
+  /**
+   * \brief Forget the messages and the ranges nothing counts any more
+   * \param ack the cumulative ACK of the peer
+   */
+  void DiscardUpTo (const SequenceNumber32 &ack);
+
+private:
+  /// A message with its own budget
+  struct Message
+  {
+    SequenceNumber32 head;   //!< Sequence number of the first byte
+    SequenceNumber32 tail;   //!< Sequence number following the message
+    double budget;           //!< Fraction of its bytes which may be lost
+  };
+
+  double m_budget;                  //!< Budget of the flow
+  uint32_t m_window;                //!< Bytes the budget of the flow is counted over
+  bool m_sent;                      //!< Some data was sent
+  SequenceNumber32 m_firstSeq;      //!< First byte sent
+  SequenceNumber32 m_highSeq;       //!< Sequence number following the highest byte sent
+  std::deque<Message> m_messages;   //!< Messages not acknowledged yet, in sequence order
+  std::map<SequenceNumber32, SequenceNumber32> m_abandoned; //!< Abandoned ranges, head to tail, disjoint
+};
+
+} // namespace ns3
+
+#endif /* ATP_LOSS_BUDGET_H */
@@ -22,7 +22,8 @@
 #define CANDIDATE_QUEUE_H
 
 #include <stdint.h>
-#include <list>
+#include <map>
+#include <vector>
 #include "ns3/ipv4-address.h"
 
 namespace ns3 {
@@ -47,6 +48,14 @@ class SPFVertex;
  * for a Find () operation, the dynamic nature of the data and the derived
  * requirement for a Reorder () operation led us to implement this simple 
  * enhanced priority queue.
+ *
+ * The queue is a binary heap which knows the position of each of its
+ * vertices, so that Push (), Pop () and DecreaseKey () take a logarithmic
+ * time and Find () a map lookup.  Vertices of equal distance and type are
+ * popped in the order in which they took their current rank, as if they
+ * were kept in a sorted list where a vertex is inserted after the vertices
+ * of equal rank: the order of the ECMP next hops does not depend on the
+ * heap layout.
  */
 class CandidateQueue
 {
@@ -133,12 +142,27 @@ public:
  * @brief Searches the Candidate Queue for a Shortest Path First Vertex 
  * pointer that points to a vertex having the given IP address.
  *
+ * The vertex IDs are expected to be unique in the queue; if they are not,
+ * the first vertex pushed with the ID is returned.
+ *
  * @see SPFVertex
  * @param addr The IP address to search for.
  * @returns The SPFVertex* pointer corresponding to the given IP address.
  */
   SPFVertex* Find (const Ipv4Address addr) const;
 
+/**
+ * @brief Restores the priority order after the value of m_distanceFromRoot
+ * of a vertex in the queue has decreased.
+ *
+ * The vertex is moved ahead of the vertices of larger distance and behind
+ * those of equal rank, as Reorder () would, in a logarithmic time.
+ *
+ * @see SPFVertex
+ * @param v The Shortest Path First Vertex whose distance has decreased.
+ */
+  void DecreaseKey (SPFVertex *v);
+
 /**
  * @brief Reorders the Candidate Queue according to the priority scheme.
  * 
@@ -148,7 +172,8 @@ public:
  * increasing distance.
  *
  * This method is provided in case the values of m_distanceFromRoot change
- * during the routing calculations.
+ * during the routing calculations.  When a single vertex got closer to the
+ * root, DecreaseKey () does the same in a logarithmic time.
  *
  * @see SPFVertex
  */
@@ -171,21 +196,59 @@ private:
  * \return copied object
  */
   CandidateQueue& operator= (CandidateQueue& sr);
-/**
- * \brief return true if v1 < v2
- *
- * SPFVertexes are added into the queue according to the ordering
- * defined by this method. If v1 should be popped before v2, this 
- * method return true; false otherwise
- *
- * \param v1 first operand
- * \param v2 second operand
- * \return True if v1 should be popped before v2; false otherwise
- */
-  static bool CompareSPFVertex (const SPFVertex* v1, const SPFVertex* v2);
 
-  typedef std::list<SPFVertex*> CandidateList_t; //!< container of SPFVertex pointers
-  CandidateList_t m_candidates;  //!< SPFVertex candidates
+  /**
+   * \brief A vertex in the heap, with the rank it was placed at
+   */
+  struct Candidate
+  {
+    SPFVertex *vertex;  //!< the vertex
+    uint32_t distance;  //!< distance from root of the vertex when it was placed
+    bool network;       //!< whether the vertex is a network vertex
+    uint64_t sequence;  //!< order in which the vertex was placed
+
+    /**
+     * \brief return true if this candidate should be popped first
+     *
+     * SPFVertexes are ordered by increasing distance from the root; in
+     * case of a tie, network vertices come before router vertices, which
+     * is necessary for implementing ECMP, and then the vertices placed
+     * first come first.
+     *
+     * \param other the other candidate
+     * \return True if this candidate should be popped before the other
+     */
+    bool operator< (const Candidate &other) const;
+  };
+
+  /**
+   * \brief Rank a candidate behind the candidates of equal distance and type
+   * \param c the candidate, whose rank is set from its vertex
+   */
+  void Place (Candidate &c);
+
+  /**
+   * \brief Store a candidate in a slot of the heap
+   * \param index the slot
+   * \param c the candidate
+   */
+  void Store (uint32_t index, const Candidate &c);
+
+  /**
+   * \brief Move the candidate of a slot up the heap to its place
+   * \param index the slot
+   */
+  void SiftUp (uint32_t index);
+
+  /**
+   * \brief Move the candidate of a slot down the heap to its place
+   * \param index the slot
+   */
+  void SiftDown (uint32_t index);
+
+  std::vector<Candidate> m_heap;  //!< SPFVertex candidates, as a binary heap
+  std::map<Ipv4Address, SPFVertex*> m_index;  //!< SPFVertex candidates, by vertex ID
+  uint64_t m_sequence;  //!< sequence number of the next placement
 
   /**
    * \brief Stream insertion operator.
@@ -44,6 +44,7 @@ protected:
                                  bool isRetransmission);
   virtual Ptr<TcpSocketBase> Fork (void);
   virtual uint32_t GetSsThresh (void);
+  virtual Time GetFlowDeadline (void) const;
 
   /**
    * @brief Check Deadline before sending a packet;
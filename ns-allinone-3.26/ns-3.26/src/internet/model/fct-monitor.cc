@@ -0,0 +1,274 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "fct-monitor.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FctMonitor");
+
+NS_OBJECT_ENSURE_REGISTERED (FctMonitor);
+
+/**
+ * \param sorted the sorted values
+ * \param p the percentile, in (0, 1]
+ * \return the nearest-rank percentile of the values
+ */
+template <typename T>
+static T
+Percentile (const std::vector<T> &sorted, double p)
+{
+  uint32_t rank = std::ceil (p * sorted.size ());
+  return sorted[std::max (rank, 1u) - 1];
+}
+
+TypeId FctMonitor::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FctMonitor")
+    .SetParent<Object> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<FctMonitor> ()
+    .AddAttribute ("SizeBuckets",
+                   "Upper bounds of the flow size buckets, in bytes, separated by spaces; "
+                   "the last bucket holds the larger flows",
+                   StringValue ("100000 10000000"),
+                   MakeStringAccessor (&FctMonitor::SetSizeBucketsString),
+                   MakeStringChecker ())
+    .AddAttribute ("LinkRate",
+                   "Link rate of the ideal flows the slowdown is relative to",
+                   DataRateValue (DataRate ("10Gbps")),
+                   MakeDataRateAccessor (&FctMonitor::m_linkRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("BaseRtt",
+                   "Round trip time of the ideal flows the slowdown is relative to",
+                   TimeValue (MicroSeconds (100)),
+                   MakeTimeAccessor (&FctMonitor::m_baseRtt),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+FctMonitor::FctMonitor ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FctMonitor::~FctMonitor ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+FctMonitor::SetSizeBuckets (const std::vector<uint64_t> &bounds)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t i = 1; i < bounds.size (); i++)
+    {
+      NS_ABORT_MSG_IF (bounds[i] <= bounds[i - 1], "The size bucket bounds must be increasing");
+    }
+  m_buckets = bounds;
+}
+
+void
+FctMonitor::SetSizeBucketsString (std::string bounds)
+{
+  std::istringstream is (bounds);
+  std::vector<uint64_t> values;
+  uint64_t value;
+  while (is >> value)
+    {
+      values.push_back (value);
+    }
+  NS_ABORT_MSG_IF (!is.eof (), "Invalid size bucket bounds \"" << bounds << "\"");
+  SetSizeBuckets (values);
+}
+
+uint32_t
+FctMonitor::StartFlow (Time deadline)
+{
+  NS_LOG_FUNCTION (this << deadline);
+  FlowRecord record;
+  record.bytes = 0;
+  record.start = Simulator::Now ();
+  record.end = Time (0);
+  record.deadline = deadline;
+  record.completed = false;
+  m_flows.push_back (record);
+  return m_flows.size () - 1;
+}
+
+void
+FctMonitor::AddBytes (uint32_t flowId, uint32_t bytes)
+{
+  NS_ASSERT (flowId < m_flows.size ());
+  m_flows[flowId].bytes += bytes;
+}
+
+void
+FctMonitor::CompleteFlow (uint32_t flowId)
+{
+  NS_LOG_FUNCTION (this << flowId);
+  NS_ASSERT (flowId < m_flows.size ());
+  FlowRecord &record = m_flows[flowId];
+  NS_ASSERT (!record.completed);
+  record.end = Simulator::Now ();
+  record.completed = true;
+  NS_LOG_DEBUG ("Flow " << flowId << " of " << record.bytes << " bytes completed in "
+                        << (record.end - record.start).GetSeconds () << " s");
+}
+
+uint32_t
+FctMonitor::GetNFlows (void) const
+{
+  return m_flows.size ();
+}
+
+const FctMonitor::FlowRecord &
+FctMonitor::GetFlow (uint32_t flowId) const
+{
+  NS_ASSERT (flowId < m_flows.size ());
+  return m_flows[flowId];
+}
+
+double
+FctMonitor::GetSlowdown (const FlowRecord &record) const
+{
+  if (!record.completed)
+    {
+      return 0;
+    }
+  Time ideal = m_baseRtt + m_baseRtt + m_linkRate.CalculateBytesTxTime (record.bytes);
+  if (ideal.IsZero ())
+    {
+      return 0;
+    }
+  return (record.end - record.start).GetSeconds () / ideal.GetSeconds ();
+}
+
+std::vector<FctMonitor::BucketSummary>
+FctMonitor::GetSummary (void) const
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t nBuckets = m_buckets.size () + 1;
+  std::vector<std::vector<Time> > fcts (nBuckets);
+  std::vector<std::vector<double> > slowdowns (nBuckets);
+  std::vector<BucketSummary> summary (nBuckets);
+  for (uint32_t b = 0; b < nBuckets; b++)
+    {
+      BucketSummary &s = summary[b];
+      s.minBytes = b == 0 ? 0 : m_buckets[b - 1] + 1;
+      s.maxBytes = b < m_buckets.size () ? m_buckets[b] : UINT64_MAX;
+      s.flows = 0;
+      s.completed = 0;
+      s.slowdownP50 = s.slowdownP99 = s.slowdownP999 = 0;
+      s.deadlineFlows = 0;
+      s.deadlinesMet = 0;
+    }
+
+  for (std::vector<FlowRecord>::const_iterator it = m_flows.begin (); it != m_flows.end (); ++it)
+    {
+      uint32_t b = std::lower_bound (m_buckets.begin (), m_buckets.end (), it->bytes) - m_buckets.begin ();
+      BucketSummary &s = summary[b];
+      s.flows++;
+      if (it->completed)
+        {
+          s.completed++;
+          fcts[b].push_back (it->end - it->start);
+          slowdowns[b].push_back (GetSlowdown (*it));
+        }
+      if (!it->deadline.IsZero ())
+        {
+          s.deadlineFlows++;
+          if (it->completed && it->end - it->start <= it->deadline)
+            {
+              s.deadlinesMet++;
+            }
+        }
+    }
+
+  for (uint32_t b = 0; b < nBuckets; b++)
+    {
+      if (fcts[b].empty ())
+        {
+          continue;
+        }
+      std::sort (fcts[b].begin (), fcts[b].end ());
+      std::sort (slowdowns[b].begin (), slowdowns[b].end ());
+      BucketSummary &s = summary[b];
+      s.fctP50 = Percentile (fcts[b], 0.5);
+      s.fctP99 = Percentile (fcts[b], 0.99);
+      s.fctP999 = Percentile (fcts[b], 0.999);
+      s.slowdownP50 = Percentile (slowdowns[b], 0.5);
+      s.slowdownP99 = Percentile (slowdowns[b], 0.99);
+      s.slowdownP999 = Percentile (slowdowns[b], 0.999);
+    }
+  return summary;
+}
+
+void
+FctMonitor::WriteSummary (std::ostream &os) const
+{
+  os << "minBytes,maxBytes,flows,completed,fctP50,fctP99,fctP999,"
+     << "slowdownP50,slowdownP99,slowdownP999,deadlineFlows,deadlinesMet\n";
+  std::vector<BucketSummary> summary = GetSummary ();
+  for (std::vector<BucketSummary>::const_iterator it = summary.begin (); it != summary.end (); ++it)
+    {
+      os << it->minBytes << ',' << it->maxBytes
+         << ',' << it->flows << ',' << it->completed
+         << ',' << it->fctP50.GetSeconds ()
+         << ',' << it->fctP99.GetSeconds ()
+         << ',' << it->fctP999.GetSeconds ()
+         << ',' << it->slowdownP50
+         << ',' << it->slowdownP99
+         << ',' << it->slowdownP999
+         << ',' << it->deadlineFlows << ',' << it->deadlinesMet
+         << '\n';
+    }
+}
+
+void
+FctMonitor::WriteFlows (std::ostream &os) const
+{
+  os << "flowId,bytes,start,end,fct,slowdown,deadline,deadlineMet\n";
+  for (uint32_t i = 0; i < m_flows.size (); i++)
+    {
+      const FlowRecord &record = m_flows[i];
+      bool met = record.completed && !record.deadline.IsZero ()
+        && record.end - record.start <= record.deadline;
+      os << i << ',' << record.bytes
+         << ',' << record.start.GetSeconds ();
+      if (record.completed)
+        {
+          os << ',' << record.end.GetSeconds ()
+             << ',' << (record.end - record.start).GetSeconds ()
+             << ',' << GetSlowdown (record);
+        }
+      else
+        {
+          os << ",,,";
+        }
+      os << ',' << record.deadline.GetSeconds () << ',' << met << '\n';
+    }
+}
+
+} // namespace ns3
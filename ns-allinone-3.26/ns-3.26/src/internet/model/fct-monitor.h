@@ -0,0 +1,176 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FCT_MONITOR_H
+#define FCT_MONITOR_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ * \brief Collects the flow completion times of TCP connections
+ *
+ * A flow is the data sent by the active side of a TCP connection. It
+ * starts when the socket connects, its size is the number of bytes the
+ * application passed to Send, and it completes when the application has
+ * closed the socket (or shut down sending) and all its data has been
+ * acknowledged. Sockets report these events themselves, once
+ * FctMonitorHelper has attached the monitor to the TcpL4Protocol of
+ * their node, so the monitor schedules no event.
+ *
+ * Each flow is one fixed-size record in a vector. The summaries are
+ * computed on request: the flows are grouped by size in the buckets
+ * given by the SizeBuckets attribute, and for each bucket the monitor
+ * reports the 50th, 99th and 99.9th percentiles of the completion time
+ * and of the slowdown, and the ratio of deadlines met.
+ *
+ * The slowdown is the completion time over the ideal one, 2 * BaseRtt +
+ * size / LinkRate: a round trip for the handshake, one for the data and
+ * its acknowledgment, and the transmission time. A flow has a deadline
+ * if its socket has one (see D2tcpSocket); it is met if the flow
+ * completes within the deadline.
+ *
+ * The monitor is shared by the sockets of all the nodes it is installed
+ * on and is not thread-safe.
+ */
+class FctMonitor : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  FctMonitor ();
+  virtual ~FctMonitor ();
+
+  /// The id of no flow
+  static const uint32_t NO_FLOW = 0xffffffff;
+
+  /// The record of a flow
+  struct FlowRecord
+  {
+    uint64_t bytes;   //!< bytes sent by the application
+    Time start;       //!< time of the connection
+    Time end;         //!< time of the completion
+    Time deadline;    //!< deadline, relative to the start, zero if none
+    bool completed;   //!< whether the flow has completed
+  };
+
+  /// The summary of the flows of a size bucket
+  struct BucketSummary
+  {
+    uint64_t minBytes;      //!< smallest flow size of the bucket
+    uint64_t maxBytes;      //!< largest flow size of the bucket
+    uint32_t flows;         //!< number of flows
+    uint32_t completed;     //!< number of completed flows
+    Time fctP50;            //!< median completion time
+    Time fctP99;            //!< 99th percentile of the completion time
+    Time fctP999;           //!< 99.9th percentile of the completion time
+    double slowdownP50;     //!< median slowdown
+    double slowdownP99;     //!< 99th percentile of the slowdown
+    double slowdownP999;    //!< 99.9th percentile of the slowdown
+    uint32_t deadlineFlows; //!< number of flows with a deadline
+    uint32_t deadlinesMet;  //!< number of deadlines met
+  };
+
+  /**
+   * \brief Set the upper bounds of the size buckets
+   *
+   * The last bucket holds the flows larger than the last bound.
+   *
+   * \param bounds the bounds, in bytes, in increasing order
+   */
+  void SetSizeBuckets (const std::vector<uint64_t> &bounds);
+
+  /**
+   * \brief Start a flow
+   * \param deadline the deadline of the flow, relative to now, zero if none
+   * \return the id of the flow
+   */
+  uint32_t StartFlow (Time deadline);
+
+  /**
+   * \brief Account bytes sent by the application of a flow
+   * \param flowId the id of the flow
+   * \param bytes the number of bytes
+   */
+  void AddBytes (uint32_t flowId, uint32_t bytes);
+
+  /**
+   * \brief Complete a flow now
+   * \param flowId the id of the flow
+   */
+  void CompleteFlow (uint32_t flowId);
+
+  /**
+   * \return the number of flows started
+   */
+  uint32_t GetNFlows (void) const;
+
+  /**
+   * \param flowId the id of the flow
+   * \return the record of the flow
+   */
+  const FlowRecord & GetFlow (uint32_t flowId) const;
+
+  /**
+   * \param record the record of a flow
+   * \return the slowdown of the flow, zero if not completed
+   */
+  double GetSlowdown (const FlowRecord &record) const;
+
+  /**
+   * \return the summaries of the size buckets
+   */
+  std::vector<BucketSummary> GetSummary (void) const;
+
+  /**
+   * \brief Write the summaries of the size buckets, one CSV line each
+   * \param os the output stream
+   */
+  void WriteSummary (std::ostream &os) const;
+
+  /**
+   * \brief Write the records of the flows, one CSV line each
+   * \param os the output stream
+   */
+  void WriteFlows (std::ostream &os) const;
+
+private:
+  /**
+   * \brief Set the size buckets from a list of bounds separated by spaces
+   * \param bounds the bounds
+   */
+  void SetSizeBucketsString (std::string bounds);
+
+  std::vector<FlowRecord> m_flows;   //!< the flows, by id
+  std::vector<uint64_t> m_buckets;   //!< upper bounds of the size buckets
+  DataRate m_linkRate;               //!< link rate of the ideal flows
+  Time m_baseRtt;                    //!< round trip time of the ideal flows
+};
+
+} // namespace ns3
+
+#endif /* FCT_MONITOR_H */
@@ -494,6 +494,23 @@ public:
  */
   void SetNode (Ptr<Node> node);
 
+/**
+ * @brief Get the position of the advertisement in the Link State Database
+ *
+ * The LSAs of a database are numbered from zero in insertion order, so
+ * that the SPF computations can keep their state in vectors.
+ *
+ * @see GlobalRouteManagerLSDB
+ * @returns The index of the LSA in its database.
+ */
+  uint32_t GetIndex (void) const;
+
+/**
+ * @brief Set the position of the advertisement in the Link State Database
+ * @param index The index of the LSA in its database.
+ */
+  void SetIndex (uint32_t index);
+
 private:
 /**
  * The type of the LSA.  Each LSA type has a separate advertisement
@@ -563,6 +580,7 @@ private:
  */
   SPFStatus m_status;
   uint32_t m_node_id; //!< node ID
+  uint32_t m_index; //!< position in the Link State Database
 };
 
 /**
@@ -18,6 +18,8 @@
 
 #include <vector>
 #include <iomanip>
+#include <cstring>
+#include <algorithm>
 #include "ns3/names.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
@@ -29,10 +31,13 @@
 #include "ns3/boolean.h"
 #include "ns3/node.h"
 #include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/pointer.h"
+#include "ns3/queue.h"
+#include "ns3/queue-disc.h"
+#include "ns3/traffic-control-layer.h"
 #include "ipv4-global-routing.h"
 #include "global-route-manager.h"
-#include "udp-header.h"
-#include "tcp-header.h"
 
 namespace ns3 {
 
@@ -63,7 +68,24 @@ Ipv4GlobalRouting::GetTypeId (void)
                    MakeEnumChecker(ECMP_NONE, "ECMP_NONE",         // NO ECMP
                                    ECMP_HASH, "ECMP_HASH",         // Per-Flow ECMP
                                    ECMP_RANDOM, "ECMP_RANDOM",     // Per-Packet ECMP
-                                   ECMP_FLOWCELL, "ECMP_FLOWCELL"))// Per-Hop ECMP with flowcell
+                                   ECMP_FLOWCELL, "ECMP_FLOWCELL", // Per-Hop ECMP with flowcell
+                                   ECMP_FLOWLET, "ECMP_FLOWLET",   // Per-Flowlet ECMP
+                                   ECMP_CONGA, "ECMP_CONGA"))      // Per-Flowlet ECMP on the least occupied queue
+    .AddAttribute ("EcmpHashSalt",
+                   "Salt mixed into the ECMP five-tuple hash; 0 derives a per-node salt from the node id",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&Ipv4GlobalRouting::m_ecmpHashSalt),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("FlowletTimeout",
+                   "Inactivity gap after which the next packet of a flow starts a new flowlet (ECMP_FLOWLET and ECMP_CONGA)",
+                   TimeValue (MicroSeconds (500)),
+                   MakeTimeAccessor (&Ipv4GlobalRouting::m_flowletTimeout),
+                   MakeTimeChecker ())
+    .AddAttribute ("FlowletTableSize",
+                   "Number of entries of the flowlet table; flows whose hashes collide share a flowlet",
+                   UintegerValue (4096),
+                   MakeUintegerAccessor (&Ipv4GlobalRouting::m_flowletTableSize),
+                   MakeUintegerChecker<uint32_t> (1))
     .AddAttribute ("RespondToInterfaceEvents",
                    "Set to true if you want to dynamically recompute the global routes upon Interface notification events (up/down, or add/remove address)",
                    BooleanValue (false),
@@ -75,7 +97,11 @@ Ipv4GlobalRouting::GetTypeId (void)
 
 Ipv4GlobalRouting::Ipv4GlobalRouting () 
   : //m_randomEcmpRouting (false),
-    m_respondToInterfaceEvents (false)
+    m_ecmpHashSalt (0),
+    m_hashSalt (0),
+    m_hashSaltSet (false),
+    m_respondToInterfaceEvents (false),
+    m_routeIndexValid (false)
 {
   NS_LOG_FUNCTION (this);
 
@@ -97,6 +123,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, nextHop, interface);
   m_hostRoutes.push_back (route);
+  m_routeIndexValid = false;
 }
 
 void 
@@ -107,6 +134,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, interface);
   m_hostRoutes.push_back (route);
+  m_routeIndexValid = false;
 }
 
 void 
@@ -122,6 +150,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_routeIndexValid = false;
 }
 
 void 
@@ -135,6 +164,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_routeIndexValid = false;
 }
 
 void 
@@ -150,6 +180,42 @@ Ipv4GlobalRouting::AddASExternalRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_ASexternalRoutes.push_back (route);
+  m_routeIndexValid = false;
+}
+
+/**
+ * \brief Write a 32-bit value in network byte order into a tuple buffer.
+ * \param buffer the buffer to write to
+ * \param value the value to write
+ * \return the number of bytes written
+ */
+static uint32_t
+WriteTupleU32 (uint8_t *buffer, uint32_t value)
+{
+  buffer[0] = (value >> 24) & 0xff;
+  buffer[1] = (value >> 16) & 0xff;
+  buffer[2] = (value >> 8) & 0xff;
+  buffer[3] = value & 0xff;
+  return 4;
+}
+
+uint32_t
+Ipv4GlobalRouting::GetHashSalt (void)
+{
+  if (!m_hashSaltSet)
+    {
+      if (m_ecmpHashSalt != 0)
+        {
+          m_hashSalt = m_ecmpHashSalt;
+        }
+      else
+        {
+          uint32_t nodeId = m_ipv4->GetObject<Node> ()->GetId ();
+          m_hashSalt = Hasher ().GetHash32 (reinterpret_cast<const char *> (&nodeId), sizeof (nodeId));
+        }
+      m_hashSaltSet = true;
+    }
+  return m_hashSalt;
 }
 
 uint64_t
@@ -157,80 +223,134 @@ Ipv4GlobalRouting::GetTupleValue(const Ipv4Header &header, Ptr<const Packet> ipP
 {
   NS_LOG_FUNCTION(this << header);
 
-  hasher.clear();
-  std::ostringstream oss;
-  oss << header.GetSource()
-      << header.GetDestination()
-      << header.GetProtocol();
-
-  switch (header.GetProtocol())
-  {
-    case UDP_PROT_NUMBER:
-    {
-      UdpHeader udpHeader;
-      ipPayload->PeekHeader(udpHeader);
-      NS_LOG_DEBUG ("FiveTuple() -> UDP: (src, dst, protN, sPort, dPort) - "
-          << header.GetSource() << ", "
-          << header.GetDestination() << ", "
-          << (int)header.GetProtocol() << ", "
-          << (int)udpHeader.GetSourcePort() << ", "
-          << (int)udpHeader.GetDestinationPort());
-
-      oss << udpHeader.GetSourcePort()
-          << udpHeader.GetDestinationPort();
-
-      break;
-    }
-    case TCP_PROT_NUMBER:
-    {
-      TcpHeader tcpHeader;
-      ipPayload->PeekHeader(tcpHeader);
-      NS_LOG_DEBUG ("FiveTuple() -> TCP: (src, dst, protN, sPort, dPort) - "
-          << header.GetSource() << ", "
-          << header.GetDestination() << ", "
-          << (int)header.GetProtocol() << ", "
-          << (int)tcpHeader.GetSourcePort() << ", "
-          << (int)tcpHeader.GetDestinationPort());
-      
-      oss << tcpHeader.GetSourcePort()
-          << tcpHeader.GetDestinationPort();
-
-      if (flowcell) // flowcell ecmp
-      {
-        SequenceNumber32 seq = tcpHeader.GetSequenceNumber();
-        oss << (seq.GetValue() >> 16);
-      }
-      break;
+  // salt (4) | source (4) | destination (4) | protocol (1) | ports (4) | cell (2)
+  uint8_t protocol = header.GetProtocol ();
+  uint8_t tuple[19];
+  uint32_t size = 0;
+  size += WriteTupleU32 (tuple + size, GetHashSalt ());
+  size += WriteTupleU32 (tuple + size, header.GetSource ().Get ());
+  size += WriteTupleU32 (tuple + size, header.GetDestination ().Get ());
+  tuple[size++] = protocol;
+
+  if (ipPayload != 0 && (protocol == UDP_PROT_NUMBER || protocol == TCP_PROT_NUMBER))
+    {
+      // Source and destination ports are the first four bytes of both the
+      // UDP and the TCP header, and the TCP sequence number the next four.
+      // Copy them raw instead of deserializing the whole L4 header.
+      uint8_t l4[8];
+      uint32_t l4Size = (protocol == TCP_PROT_NUMBER && flowcell) ? 8 : 4;
+      if (ipPayload->CopyData (l4, l4Size) == l4Size)
+        {
+          NS_LOG_DEBUG ("FiveTuple() -> (src, dst, protN, sPort, dPort) - "
+                        << header.GetSource () << ", "
+                        << header.GetDestination () << ", "
+                        << (int)protocol << ", "
+                        << ((l4[0] << 8) | l4[1]) << ", "
+                        << ((l4[2] << 8) | l4[3]));
+          memcpy (tuple + size, l4, 4);
+          size += 4;
+          if (l4Size == 8) // flowcell ecmp
+            {
+              // the upper half of the sequence number, i.e., seq >> 16
+              tuple[size++] = l4[4];
+              tuple[size++] = l4[5];
+            }
+        }
     }
-    default:
-      break;
-  }
 
-  std::string data = oss.str();
-  uint32_t hash = hasher.GetHash32(data);
-  hash /= (m_ipv4->GetObject<Node>()->GetId() + 1);
-  oss.str("");
-  return hash;  
+  return hasher.clear ().GetHash32 (reinterpret_cast<const char *> (tuple), size);
 }
 
-Ptr<Ipv4Route>
-//Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
-Ipv4GlobalRouting::LookupGlobal (const Ipv4Header &header, Ptr<const Packet> ipPayload, Ptr<NetDevice> oif, bool host)
+/**
+ * \brief Order network route indexes by decreasing prefix length.
+ * \param a the first index
+ * \param b the second index
+ * \return true if a has a longer prefix than b
+ */
+template <typename T>
+static bool
+LongerPrefixFirst (const T &a, const T &b)
 {
-  NS_LOG_FUNCTION (this << header.GetDestination() << oif);
-  NS_LOG_LOGIC ("Looking for route for destination " << header.GetDestination());
-  Ptr<Ipv4Route> rtentry = 0;
-  // store all available routes that bring packets to their destination
-  typedef std::vector<Ipv4RoutingTableEntry*> RouteVec_t;
-  RouteVec_t allRoutes;
+  return a.mask.GetPrefixLength () > b.mask.GetPrefixLength ();
+}
+
+void
+Ipv4GlobalRouting::BuildRouteIndex (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_hostIndex.clear ();
+  m_networkIndex.clear ();
+  m_egressQueues.clear ();
+  for (HostRoutesCI i = m_hostRoutes.begin (); 
+       i != m_hostRoutes.end (); 
+       i++) 
+    {
+      NS_ASSERT ((*i)->IsHost ());
+      m_hostIndex[(*i)->GetDest ()].push_back (NextHop (*i));
+    }
+  for (NetworkRoutesCI j = m_networkRoutes.begin (); 
+       j != m_networkRoutes.end (); 
+       j++) 
+    {
+      Ipv4Mask mask = (*j)->GetDestNetworkMask ();
+      std::vector<NetworkRouteIndex>::iterator index = m_networkIndex.begin ();
+      while (index != m_networkIndex.end () && index->mask != mask)
+        {
+          index++;
+        }
+      if (index == m_networkIndex.end ())
+        {
+          index = m_networkIndex.insert (m_networkIndex.end (), NetworkRouteIndex ());
+          index->mask = mask;
+        }
+      index->groups[(*j)->GetDestNetwork ().CombineMask (mask)].push_back (NextHop (*j));
+    }
+  std::stable_sort (m_networkIndex.begin (), m_networkIndex.end (),
+                    &LongerPrefixFirst<NetworkRouteIndex>);
+  m_routeIndexValid = true;
+  NS_LOG_LOGIC ("Indexed " << m_hostIndex.size () << " host destinations and "
+                << m_networkIndex.size () << " network prefix lengths");
+}
+
+Ipv4GlobalRouting::RouteGroup *
+Ipv4GlobalRouting::FindRouteGroup (Ipv4Address dest)
+{
+  NS_LOG_FUNCTION (this << dest);
+  if (!m_routeIndexValid)
+    {
+      BuildRouteIndex ();
+    }
+  RouteGroupMap::iterator found = m_hostIndex.find (dest);
+  if (found != m_hostIndex.end ())
+    {
+      NS_LOG_LOGIC ("Found " << found->second.size () << " global host routes");
+      return &found->second;
+    }
+  for (std::vector<NetworkRouteIndex>::iterator index = m_networkIndex.begin ();
+       index != m_networkIndex.end ();
+       index++)
+    {
+      found = index->groups.find (dest.CombineMask (index->mask));
+      if (found != index->groups.end ())
+        {
+          NS_LOG_LOGIC ("Found " << found->second.size () << " global network routes");
+          return &found->second;
+        }
+    }
+  return 0;
+}
 
+void
+Ipv4GlobalRouting::CollectRoutes (Ipv4Address dest, Ptr<NetDevice> oif, RouteGroup &routes) const
+{
+  NS_LOG_FUNCTION (this << dest << oif);
   NS_LOG_LOGIC ("Number of m_hostRoutes = " << m_hostRoutes.size ());
   for (HostRoutesCI i = m_hostRoutes.begin (); 
        i != m_hostRoutes.end (); 
        i++) 
     {
       NS_ASSERT ((*i)->IsHost ());
-      if ((*i)->GetDest ().IsEqual (header.GetDestination())) 
+      if ((*i)->GetDest ().IsEqual (dest)) 
         {
           if (oif != 0)
             {
@@ -240,20 +360,21 @@ Ipv4GlobalRouting::LookupGlobal (const Ipv4Header &header, Ptr<const Packet> ipP
                   continue;
                 }
             }
-          allRoutes.push_back (*i);
-          NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << *i); 
+          routes.push_back (NextHop (*i));
+          NS_LOG_LOGIC (routes.size () << "Found global host route" << *i); 
         }
     }
-  if (allRoutes.size () == 0) // if no host route is found
+  if (routes.size () == 0) // if no host route is found
     {
       NS_LOG_LOGIC ("Number of m_networkRoutes" << m_networkRoutes.size ());
-      for (NetworkRoutesI j = m_networkRoutes.begin (); 
+      int32_t longest = -1;
+      for (NetworkRoutesCI j = m_networkRoutes.begin (); 
            j != m_networkRoutes.end (); 
            j++) 
         {
           Ipv4Mask mask = (*j)->GetDestNetworkMask ();
           Ipv4Address entry = (*j)->GetDestNetwork ();
-          if (mask.IsMatch (header.GetDestination(), entry)) 
+          if (mask.IsMatch (dest, entry)) 
             {
               if (oif != 0)
                 {
@@ -263,12 +384,149 @@ Ipv4GlobalRouting::LookupGlobal (const Ipv4Header &header, Ptr<const Packet> ipP
                       continue;
                     }
                 }
-              allRoutes.push_back (*j);
-              NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << *j);
+              // keep the equal-cost routes of the longest matching prefix
+              int32_t length = mask.GetPrefixLength ();
+              if (length > longest)
+                {
+                  routes.clear ();
+                  longest = length;
+                }
+              if (length == longest)
+                {
+                  routes.push_back (NextHop (*j));
+                  NS_LOG_LOGIC (routes.size () << "Found global network route" << *j);
+                }
+            }
+        }
+    }
+}
+
+uint32_t
+Ipv4GlobalRouting::SelectFlowletNextHop (const Ipv4Header &header, Ptr<const Packet> ipPayload,
+                                         const RouteGroup &group)
+{
+  NS_LOG_FUNCTION (this << header << group.size ());
+  if (m_flowlets.empty ())
+    {
+      m_flowlets.resize (m_flowletTableSize);
+    }
+  Flowlet &flowlet = m_flowlets[GetTupleValue (header, ipPayload) % m_flowlets.size ()];
+  Time now = Simulator::Now ();
+  if (flowlet.lastSeen.IsNegative () || now - flowlet.lastSeen > m_flowletTimeout)
+    {
+      if (m_ecmpMode == ECMP_CONGA)
+        {
+          flowlet.nextHop = SelectLeastCongestedNextHop (group);
+        }
+      else
+        {
+          flowlet.nextHop = m_rand->GetInteger (0, group.size () - 1);
+        }
+      NS_LOG_LOGIC ("New flowlet on next hop " << flowlet.nextHop);
+    }
+  flowlet.lastSeen = now;
+  // the group may have shrunk since the flowlet started
+  return flowlet.nextHop % group.size ();
+}
+
+uint32_t
+Ipv4GlobalRouting::SelectLeastCongestedNextHop (const RouteGroup &group)
+{
+  NS_LOG_FUNCTION (this << group.size ());
+  uint32_t start = m_rand->GetInteger (0, group.size () - 1);
+  uint32_t best = start;
+  uint32_t bestBacklog = GetEgressBacklog (group[start].entry->GetInterface ());
+  for (uint32_t i = 1; i < group.size () && bestBacklog > 0; i++)
+    {
+      uint32_t index = (start + i) % group.size ();
+      uint32_t backlog = GetEgressBacklog (group[index].entry->GetInterface ());
+      if (backlog < bestBacklog)
+        {
+          best = index;
+          bestBacklog = backlog;
+        }
+    }
+  return best;
+}
+
+uint32_t
+Ipv4GlobalRouting::GetEgressBacklog (uint32_t interface)
+{
+  NS_LOG_FUNCTION (this << interface);
+  if (m_egressQueues.empty ())
+    {
+      Ptr<TrafficControlLayer> tc = m_ipv4->GetObject<TrafficControlLayer> ();
+      m_egressQueues.resize (m_ipv4->GetNInterfaces ());
+      for (uint32_t i = 0; i < m_egressQueues.size (); i++)
+        {
+          Ptr<NetDevice> device = m_ipv4->GetNetDevice (i);
+          if (tc != 0)
+            {
+              m_egressQueues[i].queueDisc = tc->GetRootQueueDiscOnDevice (device);
+            }
+          PointerValue queue;
+          if (device->GetAttributeFailSafe ("TxQueue", queue))
+            {
+              m_egressQueues[i].deviceQueue = queue.Get<Queue> ();
             }
         }
     }
-  if (allRoutes.size () == 0)  // consider external if no host/network found
+  if (interface >= m_egressQueues.size ())
+    {
+      return 0;
+    }
+  const EgressQueues &queues = m_egressQueues[interface];
+  uint32_t backlog = 0;
+  if (queues.queueDisc != 0)
+    {
+      backlog += queues.queueDisc->GetNBytes ();
+    }
+  if (queues.deviceQueue != 0)
+    {
+      backlog += queues.deviceQueue->GetNBytes ();
+    }
+  return backlog;
+}
+
+Ptr<Ipv4Route>
+Ipv4GlobalRouting::CreateRoute (Ipv4RoutingTableEntry *route) const
+{
+  NS_LOG_FUNCTION (this << route);
+  // create a Ipv4Route object from the selected routing table entry
+  Ptr<Ipv4Route> rtentry = Create<Ipv4Route> ();
+  rtentry->SetDestination (route->GetDest ());
+  /// \todo handle multi-address case
+  rtentry->SetSource (m_ipv4->GetAddress (route->GetInterface (), 0).GetLocal ());
+  rtentry->SetGateway (route->GetGateway ());
+  uint32_t interfaceIdx = route->GetInterface ();
+  rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
+  return rtentry;
+}
+
+Ptr<Ipv4Route>
+//Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
+Ipv4GlobalRouting::LookupGlobal (const Ipv4Header &header, Ptr<const Packet> ipPayload, Ptr<NetDevice> oif, bool host)
+{
+  NS_LOG_FUNCTION (this << header.GetDestination() << oif);
+  NS_LOG_LOGIC ("Looking for route for destination " << header.GetDestination());
+  Ptr<Ipv4Route> rtentry = 0;
+  // routes restricted to an output device (e.g., bound sockets) are
+  // collected by scanning the table, all others come from the index
+  RouteGroup *group = 0;
+  RouteGroup allRoutes;
+  if (oif == 0)
+    {
+      group = FindRouteGroup (header.GetDestination ());
+    }
+  else
+    {
+      CollectRoutes (header.GetDestination (), oif, allRoutes);
+      if (allRoutes.size () > 0)
+        {
+          group = &allRoutes;
+        }
+    }
+  if (group == 0)  // consider external if no host/network found
     {
       for (ASExternalRoutesI k = m_ASexternalRoutes.begin ();
            k != m_ASexternalRoutes.end ();
@@ -287,12 +545,13 @@ Ipv4GlobalRouting::LookupGlobal (const Ipv4Header &header, Ptr<const Packet> ipP
                       continue;
                     }
                 }
-              allRoutes.push_back (*k);
+              allRoutes.push_back (NextHop (*k));
+              group = &allRoutes;
               break;
             }
         }
     }
-  if (allRoutes.size () > 0 ) // if route(s) is found
+  if (group != 0) // if route(s) is found
     {
       // pick up one of the routes uniformly at random if random
       // ECMP routing is enabled, or always select the first route
@@ -314,27 +573,28 @@ Ipv4GlobalRouting::LookupGlobal (const Ipv4Header &header, Ptr<const Packet> ipP
           selectIndex = 0;
           break;
         case ECMP_HASH:
-          selectIndex = GetTupleValue(header,ipPayload) % (allRoutes.size());
+          selectIndex = group->size () == 1 ? 0 : GetTupleValue (header, ipPayload) % group->size ();
           break;
         case ECMP_RANDOM:
-          selectIndex = m_rand->GetInteger (0, allRoutes.size()-1);
+          selectIndex = m_rand->GetInteger (0, group->size ()-1);
           break;
         case ECMP_FLOWCELL:
-          selectIndex = GetTupleValue(header,ipPayload, true) % (allRoutes.size());
+          selectIndex = group->size () == 1 ? 0 : GetTupleValue (header, ipPayload, true) % group->size ();
+          break;
+        case ECMP_FLOWLET:
+        case ECMP_CONGA:
+          selectIndex = group->size () == 1 ? 0 : SelectFlowletNextHop (header, ipPayload, *group);
           break;
         default:
           selectIndex = 0;
           break;
       }
-      Ipv4RoutingTableEntry* route = allRoutes.at (selectIndex); 
-      // create a Ipv4Route object from the selected routing table entry
-      rtentry = Create<Ipv4Route> ();
-      rtentry->SetDestination (route->GetDest ());
-      /// \todo handle multi-address case
-      rtentry->SetSource (m_ipv4->GetAddress (route->GetInterface (), 0).GetLocal ());
-      rtentry->SetGateway (route->GetGateway ());
-      uint32_t interfaceIdx = route->GetInterface ();
-      rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
+      NextHop &nextHop = group->at (selectIndex);
+      if (nextHop.route == 0)
+        {
+          nextHop.route = CreateRoute (nextHop.entry);
+        }
+      rtentry = nextHop.route;
       return rtentry;
     }
   else 
@@ -419,6 +679,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
               NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_hostRoutes.size ());
               delete *i;
               m_hostRoutes.erase (i);
+              m_routeIndexValid = false;
               NS_LOG_LOGIC ("Done removing host route " << index << "; host route remaining size = " << m_hostRoutes.size ());
               return;
             }
@@ -436,6 +697,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_networkRoutes.size ());
           delete *j;
           m_networkRoutes.erase (j);
+          m_routeIndexValid = false;
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
           return;
         }
@@ -452,6 +714,7 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
           NS_LOG_LOGIC ("Removing route " << index << "; size = " << m_ASexternalRoutes.size ());
           delete *k;
           m_ASexternalRoutes.erase (k);
+          m_routeIndexValid = false;
           NS_LOG_LOGIC ("Done removing network route " << index << "; network route remaining size = " << m_networkRoutes.size ());
           return;
         }
@@ -490,6 +753,10 @@ Ipv4GlobalRouting::DoDispose (void)
     {
       delete (*l);
     }
+  m_hostIndex.clear ();
+  m_networkIndex.clear ();
+  m_routeIndexValid = false;
+  m_egressQueues.clear ();
 
   Ipv4RoutingProtocol::DoDispose ();
 }
@@ -635,6 +902,8 @@ void
 Ipv4GlobalRouting::NotifyInterfaceUp (uint32_t i)
 {
   NS_LOG_FUNCTION (this << i);
+  // cached routes carry the interface address and device
+  m_routeIndexValid = false;
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
       GlobalRouteManager::DeleteGlobalRoutes ();
@@ -647,6 +916,8 @@ void
 Ipv4GlobalRouting::NotifyInterfaceDown (uint32_t i)
 {
   NS_LOG_FUNCTION (this << i);
+  // cached routes carry the interface address and device
+  m_routeIndexValid = false;
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
       GlobalRouteManager::DeleteGlobalRoutes ();
@@ -659,6 +930,8 @@ void
 Ipv4GlobalRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
   NS_LOG_FUNCTION (this << interface << address);
+  // cached routes carry the interface address and device
+  m_routeIndexValid = false;
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
       GlobalRouteManager::DeleteGlobalRoutes ();
@@ -671,6 +944,8 @@ void
 Ipv4GlobalRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
   NS_LOG_FUNCTION (this << interface << address);
+  // cached routes carry the interface address and device
+  m_routeIndexValid = false;
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
       GlobalRouteManager::DeleteGlobalRoutes ();
@@ -21,10 +21,13 @@
 #define IPV4_GLOBAL_ROUTING_H
 
 #include <list>
+#include <vector>
 #include <stdint.h>
 #include "ns3/ipv4-address.h"
+#include "ns3/sgi-hashmap.h"
 #include "ns3/ipv4-header.h"
 #include "ns3/ptr.h"
+#include "ns3/nstime.h"
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/random-variable-stream.h"
@@ -39,6 +42,8 @@ class Ipv4Header;
 class Ipv4RoutingTableEntry;
 class Ipv4MulticastRoutingTableEntry;
 class Node;
+class Queue;
+class QueueDisc;
 
 typedef enum
 {
@@ -46,6 +51,8 @@ typedef enum
   ECMP_HASH,   // per-flow hash, five tuple
   ECMP_RANDOM,  // per-packet random
   ECMP_FLOWCELL, // per-hop with flowcell 64KB each change
+  ECMP_FLOWLET, // per-flowlet random, new flowlet after an inactivity gap
+  ECMP_CONGA,   // per-flowlet, new flowlets on the least occupied egress queue
 }EcmpMode_t;
 
 /**
@@ -235,13 +242,40 @@ public:
    */
   int64_t AssignStreams (int64_t stream);
 
+  /**
+   * \brief Hash the five tuple of a packet for ECMP next-hop selection.
+   *
+   * The tuple (source, destination, protocol, source port, destination
+   * port) is packed in binary form together with a per-node salt and hashed
+   * with a fixed-width hash, so that no memory is allocated per packet and
+   * consecutive hops do not polarize onto the same path.
+   *
+   * \param header the IPv4 header of the packet
+   * \param ipPayload the IPv4 payload, starting with the L4 header
+   * \param flowcell if true, the TCP sequence number divided by 64KB is
+   * appended to the tuple (ECMP_FLOWCELL)
+   * \return the hash value
+   */
   uint64_t GetTupleValue (const Ipv4Header &header, Ptr<const Packet> ipPayload, bool flowcell = false);
 
 protected:
   void DoDispose (void);
 
 private:
+  /**
+   * \brief Get the salt mixed into the five-tuple hash.
+   *
+   * Unless set through the EcmpHashSalt attribute, the salt is derived
+   * from the node id on first use and cached.
+   *
+   * \return the salt
+   */
+  uint32_t GetHashSalt (void);
+
   EcmpMode_t m_ecmpMode;
+  uint32_t m_ecmpHashSalt;  //!< user-provided salt, 0 to derive it from the node id
+  uint32_t m_hashSalt;      //!< salt in use, valid if m_hashSaltSet
+  bool m_hashSaltSet;       //!< true once m_hashSalt has been computed
   /// Set to true if packets are randomly routed among ECMP; set to false for using only one route consistently
   // bool m_randomEcmpRouting;
   /// Set to true if this interface should respond to interface events by globallly recomputing routes 
@@ -270,6 +304,37 @@ private:
   /// iterator of container of Ipv4RoutingTableEntry (routes to external AS)
   typedef std::list<Ipv4RoutingTableEntry *>::iterator ASExternalRoutesI;
 
+  /**
+   * \brief One next hop of an ECMP group.
+   *
+   * The Ipv4Route handed out for the next hop is built on first use and
+   * shared by all the packets that are routed through it afterwards.
+   */
+  struct NextHop
+  {
+    /**
+     * \brief Constructor.
+     * \param e the routing table entry of the next hop
+     */
+    NextHop (Ipv4RoutingTableEntry *e) : entry (e) {}
+    Ipv4RoutingTableEntry *entry;  //!< the routing table entry
+    Ptr<Ipv4Route> route;          //!< cached route, 0 until first used
+  };
+
+  /// ECMP next-hop group: the equal-cost routes to one destination
+  typedef std::vector<NextHop> RouteGroup;
+  /// ECMP next-hop groups indexed by destination address
+  typedef sgi::hash_map<Ipv4Address, RouteGroup, Ipv4AddressHash> RouteGroupMap;
+
+  /**
+   * \brief Network routes sharing one prefix length, indexed by network.
+   */
+  struct NetworkRouteIndex
+  {
+    Ipv4Mask mask;         //!< the common network mask
+    RouteGroupMap groups;  //!< ECMP next-hop groups indexed by network address
+  };
+
   /**
    * \brief Lookup in the forwarding table for destination.
    * \param dest destination address
@@ -279,11 +344,104 @@ private:
   // Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif = 0);
   Ptr<Ipv4Route> LookupGlobal (const Ipv4Header &header, Ptr<const Packet> ipPayload, Ptr<NetDevice> oif = 0, bool host = false);
 
+  /**
+   * \brief Find the ECMP next-hop group for a destination in the forwarding
+   * index, rebuilding the index first if the routes have changed.
+   *
+   * Host routes are matched first, then network routes by longest prefix.
+   *
+   * \param dest destination address
+   * \return the group, or 0 if neither a host nor a network route matches
+   */
+  RouteGroup * FindRouteGroup (Ipv4Address dest);
+
+  /**
+   * \brief Collect the routes to a destination by scanning the routing
+   * table, keeping only the routes through a given output device.
+   * \param dest destination address
+   * \param oif output interface if any (put 0 otherwise)
+   * \param routes the container to fill
+   */
+  void CollectRoutes (Ipv4Address dest, Ptr<NetDevice> oif, RouteGroup &routes) const;
+
+  /**
+   * \brief Rebuild the forwarding index from the routing table.
+   */
+  void BuildRouteIndex (void);
+
+  /**
+   * \brief Select a next hop for ECMP_FLOWLET and ECMP_CONGA.
+   *
+   * Packets of a flow stay on the next hop of their flowlet as long as the
+   * flow does not pause for more than FlowletTimeout. A new flowlet picks a
+   * next hop uniformly at random (ECMP_FLOWLET) or the next hop with the
+   * least bytes queued on its egress interface (ECMP_CONGA).
+   *
+   * \param header the IPv4 header of the packet
+   * \param ipPayload the IPv4 payload, starting with the L4 header
+   * \param group the ECMP next-hop group, with more than one next hop
+   * \return the index of the selected next hop in the group
+   */
+  uint32_t SelectFlowletNextHop (const Ipv4Header &header, Ptr<const Packet> ipPayload,
+                                 const RouteGroup &group);
+
+  /**
+   * \brief Find the next hop whose egress interface has the least bytes
+   * queued, breaking ties from a random starting point.
+   * \param group the ECMP next-hop group
+   * \return the index of the selected next hop in the group
+   */
+  uint32_t SelectLeastCongestedNextHop (const RouteGroup &group);
+
+  /**
+   * \brief Get the bytes queued for transmission on an interface, in its
+   * root queue disc and in the transmit queue of its device.
+   * \param interface the interface index
+   * \return the number of bytes queued
+   */
+  uint32_t GetEgressBacklog (uint32_t interface);
+
+  /**
+   * \brief Create the Ipv4Route for a routing table entry.
+   * \param route the routing table entry
+   * \return the route
+   */
+  Ptr<Ipv4Route> CreateRoute (Ipv4RoutingTableEntry *route) const;
+
   Hasher hasher;                       //!< Used for hashing five tuple
   HostRoutes m_hostRoutes;             //!< Routes to hosts
   NetworkRoutes m_networkRoutes;       //!< Routes to networks
   ASExternalRoutes m_ASexternalRoutes; //!< External routes imported
 
+  RouteGroupMap m_hostIndex;                      //!< host routes indexed by destination
+  std::vector<NetworkRouteIndex> m_networkIndex;  //!< network routes, longest prefix first
+  bool m_routeIndexValid;                         //!< false if the routes changed since the last rebuild
+
+  /**
+   * \brief An entry of the flowlet table.
+   */
+  struct Flowlet
+  {
+    /// Constructor, for a flowlet that has never been seen
+    Flowlet () : lastSeen (Seconds (-1)), nextHop (0) {}
+    Time lastSeen;     //!< arrival time of the last packet of the flowlet
+    uint32_t nextHop;  //!< index of the next hop in the ECMP group
+  };
+
+  /**
+   * \brief The queues that hold the packets waiting on an egress interface.
+   */
+  struct EgressQueues
+  {
+    Ptr<QueueDisc> queueDisc;  //!< root queue disc of the device, if any
+    Ptr<Queue> deviceQueue;    //!< transmit queue of the device, if any
+  };
+
+  Time m_flowletTimeout;                  //!< inactivity gap that starts a new flowlet
+  uint32_t m_flowletTableSize;            //!< number of entries of the flowlet table
+  std::vector<Flowlet> m_flowlets;        //!< flowlet table, indexed by five-tuple hash
+  std::vector<EgressQueues> m_egressQueues; //!< egress queues, indexed by interface
+
   Ptr<Ipv4> m_ipv4; //!< associated IPv4 instance
 };
 
@@ -33,6 +33,7 @@
 #include "ns3/boolean.h"
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/traffic-control-layer.h"
+#include "ns3/segmentation-tag.h"
 
 #include "loopback-net-device.h"
 #include "arp-l3-protocol.h"
@@ -925,12 +926,17 @@ Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
   Ptr<Ipv4Interface> outInterface = GetInterface (interface);
   NS_LOG_LOGIC ("Send via NetDevice ifIndex " << outDev->GetIfIndex () << " ipv4InterfaceIndex " << interface);
 
+  // A TCP super-segment is segmented by the devices, not fragmented
+  SegmentationTag segmentationTag;
+  bool fragment = packet->GetSize () + ipHeader.GetSerializedSize () > outInterface->GetDevice ()->GetMtu ()
+    && !packet->PeekPacketTag (segmentationTag);
+
   if (!route->GetGateway ().IsEqual (Ipv4Address ("0.0.0.0")))
     {
       if (outInterface->IsUp ())
         {
           NS_LOG_LOGIC ("Send to gateway " << route->GetGateway ());
-          if ( packet->GetSize () + ipHeader.GetSerializedSize () > outInterface->GetDevice ()->GetMtu () )
+          if (fragment)
             {
               std::list<Ipv4PayloadHeaderPair> listFragments;
               DoFragmentation (packet, ipHeader, outInterface->GetDevice ()->GetMtu (), listFragments);
@@ -957,7 +963,7 @@ Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
       if (outInterface->IsUp ())
         {
           NS_LOG_LOGIC ("Send to destination " << ipHeader.GetDestination ());
-          if ( packet->GetSize () + ipHeader.GetSerializedSize () > outInterface->GetDevice ()->GetMtu () )
+          if (fragment)
             {
               std::list<Ipv4PayloadHeaderPair> listFragments;
               DoFragmentation (packet, ipHeader, outInterface->GetDevice ()->GetMtu (), listFragments);
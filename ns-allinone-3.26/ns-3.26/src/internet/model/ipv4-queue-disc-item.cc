@@ -17,6 +17,7 @@
  */
 
 #include "ns3/log.h"
+#include "ns3/segmentation-tag.h"
 #include "ipv4-queue-disc-item.h"
 
 namespace ns3 {
@@ -93,6 +94,24 @@ Ipv4QueueDiscItem::Mark (void)
 }
 
 
+bool
+Ipv4QueueDiscItem::MarkSegment (uint32_t segment)
+{
+  NS_LOG_FUNCTION (this << segment);
+  SegmentationTag tag;
+  if (GetSegmentCount () == 1 || !GetPacket ()->PeekPacketTag (tag))
+    {
+      return Mark ();
+    }
+  if (!m_headerAdded && (m_header.GetEcn () == Ipv4Header::ECN_ECT1 || m_header.GetEcn () == Ipv4Header::ECN_ECT0))
+    {
+      tag.MarkSegment (segment);
+      GetPacket ()->ReplacePacketTag (tag);
+      return true;
+    }
+  return false;
+}
+
 bool
 Ipv4QueueDiscItem::GetUint8Value (QueueItem::Uint8Values field, uint8_t& value) const
 {
@@ -160,6 +160,7 @@ TcpL4Protocol::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
   m_sockets.clear ();
+  m_fctMonitor = 0;
 
   if (m_endPoints != 0)
     {
@@ -205,11 +206,19 @@ TcpL4Protocol::CreateSocket (TypeId congestionTypeId, TypeId socketBaseTypeId)
   socket->SetTcp (this);
   socket->SetRtt (rtt);
   socket->SetCongestionControlAlgorithm (algo);
+  socket->SetFctMonitor (m_fctMonitor);
 
   m_sockets.push_back (socket);
   return socket;
 }
 
+void
+TcpL4Protocol::SetFctMonitor (Ptr<FctMonitor> monitor)
+{
+  NS_LOG_FUNCTION (this << monitor);
+  m_fctMonitor = monitor;
+}
+
 Ptr<Socket>
 TcpL4Protocol::CreateSocket (void)
 {
@@ -0,0 +1,95 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TCP_OPTION_SACK_H
+#define TCP_OPTION_SACK_H
+
+#include <vector>
+#include <utility>
+#include "ns3/tcp-option.h"
+#include "ns3/sequence-number.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Defines the TCP option of kind 5 (selective acknowledgment option) as in \RFC{2018}
+ *
+ * The receiver reports the blocks of data it holds beyond the cumulative
+ * ACK, each as the sequence number of its first byte and the one following
+ * its last byte.  An option holds at most 4 blocks; 3 when it shares the
+ * header with the timestamp option.
+ */
+class TcpOptionSack : public TcpOption
+{
+public:
+  /// A block of received data, [first, second)
+  typedef std::pair<SequenceNumber32, SequenceNumber32> SackBlock;
+  /// The blocks of an option
+  typedef std::vector<SackBlock> SackList;
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  TcpOptionSack ();
+  virtual ~TcpOptionSack ();
+
+  virtual void Print (std::ostream &os) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+  virtual uint8_t GetKind (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+
+  /**
+   * \brief Add a block at the end of the option
+   *
+   * \param block the block, which must not be empty
+   */
+  void AddSackBlock (SackBlock block);
+
+  /**
+   * \brief Get the number of blocks
+   * \return the number of blocks
+   */
+  uint32_t GetNumSackBlocks (void) const;
+
+  /**
+   * \brief Get the blocks, in the order of the option
+   * \return the blocks
+   */
+  const SackList & GetSackList (void) const;
+
+  /**
+   * \brief Remove all the blocks
+   */
+  void ClearSackList (void);
+
+  /// Maximum number of blocks of an option, bound by the 40 bytes of option space
+  static const uint32_t MAX_BLOCKS = 4;
+
+protected:
+  SackList m_sackList; //!< The blocks
+};
+
+} // namespace ns3
+
+#endif /* TCP_OPTION_SACK_H */
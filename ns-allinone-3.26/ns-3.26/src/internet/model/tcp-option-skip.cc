@@ -0,0 +1,137 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "tcp-option-skip.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpOptionSkip");
+
+NS_OBJECT_ENSURE_REGISTERED (TcpOptionSkip);
+
+const uint32_t TcpOptionSkip::MAX_BLOCKS;
+
+TcpOptionSkip::TcpOptionSkip ()
+  : TcpOption ()
+{
+}
+
+TcpOptionSkip::~TcpOptionSkip ()
+{
+}
+
+TypeId
+TcpOptionSkip::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpOptionSkip")
+    .SetParent<TcpOption> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<TcpOptionSkip> ()
+  ;
+  return tid;
+}
+
+TypeId
+TcpOptionSkip::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+TcpOptionSkip::Print (std::ostream &os) const
+{
+  os << "skipped: " << m_skipList.size () << ",";
+  for (SkipList::const_iterator it = m_skipList.begin (); it != m_skipList.end (); ++it)
+    {
+      os << " [" << it->first << ";" << it->second << "]";
+    }
+}
+
+uint32_t
+TcpOptionSkip::GetSerializedSize (void) const
+{
+  return 2 + m_skipList.size () * 8;
+}
+
+void
+TcpOptionSkip::Serialize (Buffer::Iterator start) const
+{
+  Buffer::Iterator i = start;
+  i.WriteU8 (GetKind ()); // Kind
+  i.WriteU8 (GetSerializedSize ()); // Length
+  for (SkipList::const_iterator it = m_skipList.begin (); it != m_skipList.end (); ++it)
+    {
+      i.WriteHtonU32 (it->first.GetValue ()); // First byte
+      i.WriteHtonU32 (it->second.GetValue ()); // Byte following the range
+    }
+}
+
+uint32_t
+TcpOptionSkip::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+
+  uint8_t readKind = i.ReadU8 ();
+  if (readKind != GetKind ())
+    {
+      NS_LOG_WARN ("Malformed Skip option");
+      return 0;
+    }
+  uint8_t size = i.ReadU8 ();
+  if (size < 2 || (size - 2) % 8 != 0 || size > 2 + MAX_BLOCKS * 8)
+    {
+      NS_LOG_WARN ("Malformed Skip option");
+      return 0;
+    }
+  m_skipList.clear ();
+  for (uint32_t n = (size - 2) / 8; n > 0; --n)
+    {
+      SequenceNumber32 first (i.ReadNtohU32 ());
+      SequenceNumber32 second (i.ReadNtohU32 ());
+      m_skipList.push_back (SkipBlock (first, second));
+    }
+  return GetSerializedSize ();
+}
+
+uint8_t
+TcpOptionSkip::GetKind (void) const
+{
+  return TcpOption::SKIP;
+}
+
+void
+TcpOptionSkip::AddSkipBlock (SkipBlock block)
+{
+  NS_ASSERT (block.first < block.second);
+  NS_ASSERT (m_skipList.size () < MAX_BLOCKS);
+
+  m_skipList.push_back (block);
+}
+
+uint32_t
+TcpOptionSkip::GetNumSkipBlocks (void) const
+{
+  return m_skipList.size ();
+}
+
+const TcpOptionSkip::SkipList &
+TcpOptionSkip::GetSkipList (void) const
+{
+  return m_skipList;
+}
+
+} // namespace ns3
@@ -21,7 +21,8 @@
 #ifndef TCP_RX_BUFFER_H
 #define TCP_RX_BUFFER_H
 
-#include <map>
+#include <vector>
+#include <utility>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/sequence-number.h"
@@ -36,10 +37,22 @@ class Packet;
  *
  * \brief class for the reordering buffer that keeps the data from lower layer, i.e.
  *        TcpL4Protocol, sent to the application
+ *
+ * The data is kept in two flat vectors sorted by sequence number: the
+ * pieces, which are byte ranges of the received packets, and the blocks,
+ * which are the maximal contiguous ranges they cover.  Both are found by
+ * binary search; the received packets are never fragmented inside the
+ * buffer, a piece only records which of their bytes it holds.  The
+ * blocks beyond NextRxSequence are the SACK blocks of RFC 2018.
  */
 class TcpRxBuffer : public Object
 {
 public:
+  /// A range of sequence numbers, [first, second)
+  typedef std::pair<SequenceNumber32, SequenceNumber32> SackBlock;
+  /// A list of ranges of sequence numbers
+  typedef std::vector<SackBlock> SackList;
+
   /**
    * \brief Get the type ID.
    * \return the object TypeId
@@ -50,6 +63,11 @@ public:
    * \param n initial Sequence number to be received
    */
   TcpRxBuffer (uint32_t n = 0);
+  /**
+   * \brief Copy constructor
+   * \param other the buffer to copy
+   */
+  TcpRxBuffer (const TcpRxBuffer &other);
   virtual ~TcpRxBuffer ();
 
   // Accessors
@@ -125,16 +143,73 @@ public:
    */
   Ptr<Packet> Extract (uint32_t maxSize);
 
+  /**
+   * Get the blocks of data received out of order, i.e. beyond
+   * NextRxSequence. As in RFC 2018, the block holding the most recently
+   * received data comes first, the others follow in sequence order.
+   *
+   * \param maxBlocks maximum number of blocks to return
+   * \returns the blocks
+   */
+  SackList GetSackList (uint32_t maxBlocks = 4) const;
+
+  /**
+   * \brief Get the number of blocks of data received out of order
+   * \returns the number of blocks beyond NextRxSequence
+   */
+  uint32_t GetSackListSize (void) const;
+
+  /**
+   * Fill the bytes of [head, tail) not received yet with zeros, as if
+   * they had been, so that the data beyond a range the sender abandoned
+   * reaches the application at its offset in the stream.
+   *
+   * \param head first sequence number of the range
+   * \param tail sequence number following the range
+   * \returns the number of bytes filled
+   */
+  uint32_t Fill (const SequenceNumber32& head, const SequenceNumber32& tail);
+
 private:
-  /// container for data stored in the buffer
-  typedef std::map<SequenceNumber32, Ptr<Packet> >::iterator BufIterator;
+  /**
+   * Bytes [head, tail) of the stream, held by packet from offset on.
+   *
+   * The piece holds a reference to the packet through a plain pointer,
+   * so that the vector moves pieces as plain memory when a segment is
+   * inserted before others.
+   */
+  struct RxPiece
+  {
+    SequenceNumber32 head;    //!< Sequence number of the first byte
+    SequenceNumber32 tail;    //!< Sequence number following the last byte
+    Packet *packet;           //!< The packet holding the data, referenced
+    uint32_t offset;          //!< Offset of the first byte in the packet
+  };
+
+  /**
+   * \brief Find the first piece ending after a sequence number
+   * \param seq the sequence number
+   * \returns its index in m_pieces, m_pieces.size () if none
+   */
+  uint32_t FindPiece (const SequenceNumber32& seq) const;
+
+  /**
+   * \brief Add a range to the blocks, merging the blocks it touches
+   * \param head first sequence number of the range
+   * \param tail sequence number following the range
+   */
+  void AddBlock (const SequenceNumber32& head, const SequenceNumber32& tail);
+
   TracedValue<SequenceNumber32> m_nextRxSeq; //!< Seqnum of the first missing byte in data (RCV.NXT)
   SequenceNumber32 m_finSeq;                 //!< Seqnum of the FIN packet
   bool m_gotFin;                             //!< Did I received FIN packet?
   uint32_t m_size;                           //!< Number of total data bytes in the buffer, not necessarily contiguous
   uint32_t m_maxBuffer;                      //!< Upper bound of the number of data bytes in buffer (RCV.WND)
   uint32_t m_availBytes;                     //!< Number of bytes available to read, i.e. contiguous block at head
-  std::map<SequenceNumber32, Ptr<Packet> > m_data; //!< Corresponding data (may be null)
+  std::vector<RxPiece> m_pieces;             //!< Buffered data, from m_firstPiece on, sorted and disjoint
+  uint32_t m_firstPiece;                     //!< Index of the first piece not yet extracted
+  std::vector<SackBlock> m_blocks;           //!< Contiguous ranges of buffered data, sorted
+  SequenceNumber32 m_lastHead;               //!< First sequence number of the last data added
 };
 
 } //namepsace ns3
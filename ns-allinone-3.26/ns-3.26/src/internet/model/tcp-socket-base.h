@@ -36,6 +36,7 @@
 #include "tcp-tx-buffer.h"
 #include "tcp-rx-buffer.h"
 #include "rtt-estimator.h"
+#include "fct-monitor.h"
 
 namespace ns3 {
 
@@ -317,6 +318,30 @@ public:
    */
   virtual void SetRtt (Ptr<RttEstimator> rtt);
 
+  /**
+   * \brief Set the monitor of the flow completion times.
+   *
+   * A socket which connects reports its flow to the monitor.
+   *
+   * \param monitor the monitor, or 0 to record no flow
+   */
+  void SetFctMonitor (Ptr<FctMonitor> monitor);
+
+  /**
+   * \brief Send the new data in super-segments, segmented by the devices
+   * \param offload true to turn segmentation offload on
+   *
+   * Turning it on also turns on the lookup of the SegmentationTag in the
+   * queues and devices of the simulation (see SegmentationTag::Enable).
+   */
+  void SetOffload (bool offload);
+
+  /**
+   * \brief Whether the new data is sent in super-segments
+   * \return true if segmentation offload is on
+   */
+  bool GetOffload (void) const;
+
   /**
    * \brief Sets the Minimum RTO.
    * \param minRto The minimum RTO.
@@ -575,6 +600,23 @@ protected:
   virtual void DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
                             const Address &toAddress);
 
+  /**
+   * \brief Called by TcpSocketBase::ForwardUp{,6}() to hand a packet to
+   * DoForwardUp
+   *
+   * A super-segment (see SegmentationTag) is split into runs of
+   * consecutive wire segments of the same CE state, and each run is
+   * handed to DoForwardUp as one segment: the in-order segments stay
+   * coalesced (GRO), while the ECN echo still follows every wire segment.
+   *
+   * \param packet the incoming packet, TCP header included
+   * \param ceReceived true if the IP header of the packet is CE
+   * \param fromAddress the address of the sender of packet
+   * \param toAddress the address of the receiver of packet
+   */
+  void ForwardUpSegments (Ptr<Packet> packet, bool ceReceived,
+                          const Address &fromAddress, const Address &toAddress);
+
   /**
    * \brief Called by the L3 protocol when it received an ICMP packet to pass on to TCP.
    *
@@ -602,6 +644,13 @@ protected:
    *
    * Note that this function did not implement the PSH flag.
    *
+   * With Pacing enabled, the new data leaves by quanta of PacingQuantum
+   * segments, and the next quantum waits for the pacing timer (see
+   * SchedulePacing). Retransmissions are not paced.
+   *
+   * With Offload enabled, the new data leaves in super-segments of up to
+   * OffloadMaxSize bytes, segmented by the devices (see SegmentationTag).
+   *
    * \param withAck forces an ACK to be sent
    * \returns true if some data have been sent
    */
@@ -904,6 +953,40 @@ protected:
    */
   virtual void DoRetransmit (void);
 
+  /**
+   * \brief Retransmit data of a hole of the SACK scoreboard
+   *
+   * \param seq the first sequence number of the data
+   * \param size the number of bytes, at most a segment
+   */
+  virtual void RetransmitHole (SequenceNumber32 seq, uint32_t size);
+
+  /**
+   * \brief Find the next hole of the SACK scoreboard deemed lost
+   *
+   * As in \RFC{6675}, data is deemed lost once more than
+   * (ReTxThreshold - 1) segments above it are SACKed.
+   *
+   * \param seq the sequence number to start from
+   * \param head set to the first sequence number of the hole
+   * \param tail set to the sequence number following the hole
+   * \returns false if no hole from seq on is deemed lost
+   */
+  bool NextLostHole (const SequenceNumber32 &seq, SequenceNumber32 &head,
+                     SequenceNumber32 &tail) const;
+
+  /**
+   * \brief Hold the new data back for the time the pacing rate takes to
+   * send the bytes just released
+   *
+   * The pacing rate is cWnd / SRTT times PacingSsGain in slow start and
+   * PacingCaGain afterwards. Nothing is held back before the first RTT
+   * sample.
+   *
+   * \param bytes the number of bytes just released
+   */
+  void SchedulePacing (uint32_t bytes);
+
   /** \brief Add options to TcpHeader
    *
    * Test each option, and if it is enabled on our side, add it
@@ -963,6 +1046,32 @@ protected:
    */
   void AddOptionTimestamp (TcpHeader& header);
 
+  /**
+   * \brief Process the SACK option from other side
+   *
+   * Add the blocks of the option to the scoreboard of the Tx buffer.
+   *
+   * \param option SACK option from the segment
+   */
+  void ProcessOptionSack (const Ptr<const TcpOption> option);
+
+  /**
+   * \brief Add the SACK permitted option to the header
+   *
+   * \param header TcpHeader of a SYN segment
+   */
+  void AddOptionSackPermitted (TcpHeader &header);
+
+  /**
+   * \brief Add the SACK option to the header
+   *
+   * The blocks are the data of the Rx buffer received out of order,
+   * as many as the option space left in the header holds.
+   *
+   * \param header TcpHeader to which add the option to
+   */
+  void AddOptionSack (TcpHeader& header);
+
   /**
    * @brief Send Ack packet; add ecn mark if needed
    */
@@ -993,6 +1102,26 @@ protected:
    */
   virtual bool MarkEmptyPacket (void) const;
 
+  /**
+   * \brief Get the deadline of the flow this socket sends
+   *
+   * Reported to the FctMonitor when the socket connects.
+   *
+   * \return the deadline, relative to the connection, zero if none
+   */
+  virtual Time GetFlowDeadline (void) const;
+
+  /**
+   * \brief Report a new flow to the FctMonitor, if any, when connecting
+   */
+  void StartFlow (void);
+
+  /**
+   * \brief Report the flow to the FctMonitor as completed if the
+   * application has closed the socket and all its data is acknowledged
+   */
+  void CheckFlowCompletion (void);
+
   /**
    * \brief Performs a safe subtraction between a and b (a-b)
    *
@@ -1069,13 +1198,27 @@ protected:
   bool     m_timestampEnabled;    //!< Timestamp option enabled
   uint32_t m_timestampToEcho;     //!< Timestamp to echo
 
+  bool     m_sackEnabled;         //!< SACK option enabled (RFC 2018)
+
   EventId m_sendPendingDataEvent; //!< micro-delay event to send pending data
 
+  // Pacing
+  bool     m_pacing;        //!< Pace the new data at cWnd / SRTT times the gain
+  double   m_pacingSsGain;  //!< Pacing gain in slow start
+  double   m_pacingCaGain;  //!< Pacing gain in congestion avoidance
+  uint32_t m_pacingQuantum; //!< Segments released at once by the pacing timer
+  EventId  m_pacingEvent;   //!< Release of the next pacing quantum
+
+  // Segmentation offload
+  bool     m_offload;        //!< Send the new data in super-segments
+  uint32_t m_offloadMaxSize; //!< Maximum payload size of a super-segment
+
   // Fast Retransmit and Recovery
   SequenceNumber32       m_recover;      //!< Previous highest Tx seqnum for fast recovery
   uint32_t               m_retxThresh;   //!< Fast Retransmit threshold
   bool                   m_limitedTx;    //!< perform limited transmit
   uint32_t               m_retransOut;   //!< Number of retransmission in this window
+  SequenceNumber32       m_highRxt;      //!< Highest seqnum retransmitted in fast recovery (HighRxt of RFC 6675)
 
   // Transmission Control Block
   Ptr<TcpSocketState>    m_tcb;               //!< Congestion control informations
@@ -1097,6 +1240,11 @@ protected:
   TracedValue<SequenceNumber32> m_ecnEchoSeq;      //!< Sequence number of the last received ECN Echo
   bool                          m_ceReceived;      //!< Flag indicating a received CE packet
 
+  // Flow completion time
+  Ptr<FctMonitor> m_fctMonitor;  //!< Monitor of the flow completion times
+  uint32_t        m_fctFlow;     //!< Id of the flow in the monitor, or FctMonitor::NO_FLOW
+  bool            m_fctClosed;   //!< The application has closed the flow
+
 };
 
 /**
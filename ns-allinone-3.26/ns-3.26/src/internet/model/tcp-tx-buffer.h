@@ -21,7 +21,8 @@
 #ifndef TCP_TX_BUFFER_H
 #define TCP_TX_BUFFER_H
 
-#include <list>
+#include <vector>
+#include <utility>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/object.h"
@@ -36,10 +37,26 @@ class Packet;
  *
  * \brief class for keeping the data sent by the application to the TCP socket, i.e.
  *        the sending buffer.
+ *
+ * The packets of the application are kept whole in a ring of segments,
+ * which is only reallocated when it grows, so that adding data and
+ * acknowledging it allocate nothing in the steady state.  Data sent on
+ * the network is a fragment of these packets: it shares their buffer
+ * and no packet is ever fragmented inside the ring, even when an ACK
+ * covers a packet only in part.
+ *
+ * The buffer also keeps the scoreboard of \RFC{6675}: the ranges of its
+ * data that the peer reported in SACK blocks, sorted and disjoint, so
+ * that the holes between them can be retransmitted alone.
  */
 class TcpTxBuffer : public Object
 {
 public:
+  /// A range of sequence numbers, [first, second)
+  typedef std::pair<SequenceNumber32, SequenceNumber32> SackBlock;
+  /// A list of ranges of sequence numbers
+  typedef std::vector<SackBlock> SackList;
+
   /**
    * \brief Get the type ID.
    * \return the object TypeId
@@ -127,14 +144,101 @@ public:
    */
   void DiscardUpTo (const SequenceNumber32& seq);
 
+  /**
+   * Mark the data of SACK blocks as received by the peer. The parts of
+   * the blocks outside [HeadSequence, highTx) are ignored, as blocks
+   * acknowledging data not sent or already acknowledged.
+   *
+   * \param list the blocks
+   * \param highTx the sequence number following the data sent
+   * \returns the number of bytes that were not SACKed yet
+   */
+  uint32_t Sack (const SackList &list, const SequenceNumber32 &highTx);
+
+  /**
+   * \brief Get the number of SACKed bytes
+   * \returns the number of bytes of the buffer SACKed by the peer
+   */
+  uint32_t GetSackedBytes (void) const;
+
+  /**
+   * \brief Get the number of SACKed bytes from a sequence number on
+   * \param seq the sequence number
+   * \returns the number of SACKed bytes in [seq, TailSequence)
+   */
+  uint32_t GetSackedBytesFrom (const SequenceNumber32 &seq) const;
+
+  /**
+   * \brief Get the first byte which is not SACKed, from a sequence number on
+   * \param seq the sequence number
+   * \returns seq, or the end of the SACKed range holding seq
+   */
+  SequenceNumber32 SkipSacked (const SequenceNumber32 &seq) const;
+
+  /**
+   * Find the first hole from a sequence number on: a range of data not
+   * SACKed and followed by SACKed data.
+   *
+   * \param seq the sequence number
+   * \param head set to the first byte of the hole
+   * \param tail set to the byte following the hole
+   * \returns false if no data is SACKed beyond seq
+   */
+  bool FindHole (const SequenceNumber32 &seq, SequenceNumber32 &head, SequenceNumber32 &tail) const;
+
 private:
-  /// container for data stored in the buffer
-  typedef std::list<Ptr<Packet> >::iterator BufIterator;
+  /**
+   * \brief A packet of the application data, as added to the buffer.
+   *
+   * The position of a byte in the stream is counted from the first byte
+   * ever added to the buffer, so that it never moves while the buffer
+   * is acknowledged, and 64 bits wide, so that it never wraps.
+   */
+  struct TxSegment
+  {
+    Ptr<Packet> packet;                         //!< The data
+    uint64_t end;                               //!< Stream position of the byte following the data
+  };
+
+  /**
+   * \param index Index of a segment, from the head of the buffer
+   * \returns the segment
+   */
+  TxSegment & GetSegment (uint32_t index);
+
+  /**
+   * \param index Index of a segment, from the head of the buffer
+   * \returns the stream position of the first byte of the segment
+   */
+  uint64_t GetSegmentStart (uint32_t index);
+
+  /**
+   * Find the segment holding a byte. The segment found by the last call
+   * and the next one are tried first, so that sending the buffer in
+   * order costs O(1) per segment; others are found by binary search.
+   *
+   * \param position Stream position of a byte in the buffer
+   * \returns the index of the segment holding this byte
+   */
+  uint32_t FindSegment (uint64_t position);
+
+  /**
+   * \brief Find the first SACKed range ending after a sequence number
+   * \param seq the sequence number
+   * \returns its index in m_sacked, m_sacked.size () if none
+   */
+  uint32_t FindSacked (const SequenceNumber32 &seq) const;
 
   TracedValue<SequenceNumber32> m_firstByteSeq; //!< Sequence number of the first byte in data (SND.UNA)
   uint32_t m_size;                              //!< Number of data bytes
   uint32_t m_maxBuffer;                         //!< Max number of data bytes in buffer (SND.WND)
-  std::list<Ptr<Packet> > m_data;               //!< Corresponding data (may be null)
+  uint64_t m_headPosition;                      //!< Stream position of the first byte in data
+  std::vector<TxSegment> m_ring;                //!< Ring of segments, its size is a power of two
+  uint32_t m_ringHead;                          //!< Index in m_ring of the first segment
+  uint32_t m_nSegments;                         //!< Number of segments in the ring
+  uint32_t m_lastFound;                         //!< Segment returned by the last FindSegment
+  SackList m_sacked;                            //!< Ranges SACKed by the peer, sorted and disjoint
+  uint32_t m_sackedBytes;                       //!< Number of bytes in m_sacked
 };
 
 } // namepsace ns3
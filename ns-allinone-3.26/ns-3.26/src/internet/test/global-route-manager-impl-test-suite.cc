@@ -27,6 +27,7 @@
 #include "ns3/candidate-queue.h"
 #include "ns3/simulator.h"
 #include <cstdlib> // for rand()
+#include <vector>
 
 using namespace ns3;
 
@@ -214,6 +215,120 @@ GlobalRouteManagerImplTestCase::DoRun (void)
 }
 
 
+/**
+ * \brief Checks the order in which the candidate queue pops the vertices,
+ * when their distance changes and between vertices of equal distance
+ */
+class CandidateQueueTestCase : public TestCase
+{
+public:
+  CandidateQueueTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Create a vertex
+   * \param type the type of the LSA of the vertex
+   * \param id the ID of the vertex
+   * \param distance the distance from the root of the vertex
+   * \returns the vertex
+   */
+  SPFVertex* CreateVertex (GlobalRoutingLSA::LSType type, const char *id, uint32_t distance);
+
+  std::vector<GlobalRoutingLSA*> m_lsas; //!< LSAs of the vertices
+};
+
+CandidateQueueTestCase::CandidateQueueTestCase ()
+  : TestCase ("CandidateQueue priority and tie order")
+{
+}
+
+SPFVertex*
+CandidateQueueTestCase::CreateVertex (GlobalRoutingLSA::LSType type, const char *id, uint32_t distance)
+{
+  GlobalRoutingLSA* lsa = new GlobalRoutingLSA ();
+  lsa->SetLSType (type);
+  lsa->SetLinkStateId (id);
+  m_lsas.push_back (lsa);
+  SPFVertex *v = new SPFVertex (lsa);
+  v->SetDistanceFromRoot (distance);
+  return v;
+}
+
+void
+CandidateQueueTestCase::DoRun (void)
+{
+  CandidateQueue candidate;
+
+  // The vertices are popped by distance
+  for (int i = 0; i < 100; ++i)
+    {
+      SPFVertex *v = new SPFVertex;
+      v->SetDistanceFromRoot (std::rand () % 100);
+      candidate.Push (v);
+    }
+  uint32_t last = 0;
+  for (int i = 0; i < 100; ++i)
+    {
+      SPFVertex *v = candidate.Pop ();
+      NS_TEST_ASSERT_MSG_GT_OR_EQ (v->GetDistanceFromRoot (), last, "Vertex popped out of order");
+      last = v->GetDistanceFromRoot ();
+      delete v;
+    }
+  NS_TEST_ASSERT_MSG_EQ (candidate.Empty (), true, "Queue not empty");
+
+  // Networks come before routers of equal distance, and the vertices of
+  // equal rank in the order they were pushed
+  SPFVertex *r1 = CreateVertex (GlobalRoutingLSA::RouterLSA, "0.0.0.1", 5);
+  SPFVertex *n1 = CreateVertex (GlobalRoutingLSA::NetworkLSA, "10.1.1.0", 5);
+  SPFVertex *r2 = CreateVertex (GlobalRoutingLSA::RouterLSA, "0.0.0.2", 5);
+  SPFVertex *r3 = CreateVertex (GlobalRoutingLSA::RouterLSA, "0.0.0.3", 3);
+  SPFVertex *r4 = CreateVertex (GlobalRoutingLSA::RouterLSA, "0.0.0.4", 9);
+  candidate.Push (r1);
+  candidate.Push (n1);
+  candidate.Push (r2);
+  candidate.Push (r3);
+  candidate.Push (r4);
+  NS_TEST_ASSERT_MSG_EQ (candidate.Find (Ipv4Address ("0.0.0.2")), r2, "Vertex not found");
+  NS_TEST_ASSERT_MSG_EQ (candidate.Find (Ipv4Address ("0.0.0.5")), 0, "Missing vertex found");
+
+  // A vertex getting closer goes behind the vertices of its new rank
+  r4->SetDistanceFromRoot (5);
+  candidate.DecreaseKey (r4);
+  NS_TEST_ASSERT_MSG_EQ (candidate.Top (), r3, "Wrong top vertex");
+
+  SPFVertex *expected[] = { r3, n1, r1, r2, r4 };
+  for (uint32_t i = 0; i < 5; i++)
+    {
+      SPFVertex *v = candidate.Pop ();
+      NS_TEST_ASSERT_MSG_EQ (v, expected[i], "Vertex " << i << " popped out of order");
+      delete v;
+    }
+  NS_TEST_ASSERT_MSG_EQ (candidate.Find (Ipv4Address ("0.0.0.2")), 0, "Popped vertex found");
+
+  // Reorder places the vertices whose distance changed in the same way
+  r1 = CreateVertex (GlobalRoutingLSA::RouterLSA, "0.0.0.1", 7);
+  r2 = CreateVertex (GlobalRoutingLSA::RouterLSA, "0.0.0.2", 4);
+  r3 = CreateVertex (GlobalRoutingLSA::RouterLSA, "0.0.0.3", 4);
+  candidate.Push (r1);
+  candidate.Push (r2);
+  candidate.Push (r3);
+  r1->SetDistanceFromRoot (4);
+  candidate.Reorder ();
+  SPFVertex *reordered[] = { r2, r3, r1 };
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      SPFVertex *v = candidate.Pop ();
+      NS_TEST_ASSERT_MSG_EQ (v, reordered[i], "Vertex " << i << " popped out of order after Reorder");
+      delete v;
+    }
+
+  for (uint32_t i = 0; i < m_lsas.size (); i++)
+    {
+      delete m_lsas[i];
+    }
+}
+
 static class GlobalRouteManagerImplTestSuite : public TestSuite
 {
 public:
@@ -221,5 +336,6 @@ public:
     : TestSuite ("global-route-manager-impl", UNIT)
   {
     AddTestCase (new GlobalRouteManagerImplTestCase (), TestCase::QUICK);
+    AddTestCase (new CandidateQueueTestCase (), TestCase::QUICK);
   }
 } g_globalRoutingManagerImplTestSuite;
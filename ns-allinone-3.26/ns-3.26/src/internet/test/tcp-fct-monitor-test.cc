@@ -0,0 +1,166 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "tcp-general-test.h"
+#include "ns3/fct-monitor.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/node.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpFctMonitorTest");
+
+/**
+ * \brief Check the size buckets, percentiles and deadlines of the summary
+ */
+class FctMonitorSummaryTestCase : public TestCase
+{
+public:
+  FctMonitorSummaryTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+FctMonitorSummaryTestCase::FctMonitorSummaryTestCase ()
+  : TestCase ("Summarize the flow completion times by size bucket")
+{
+}
+
+void
+FctMonitorSummaryTestCase::DoRun (void)
+{
+  Ptr<FctMonitor> monitor = CreateObject<FctMonitor> ();
+  monitor->SetAttribute ("SizeBuckets", StringValue ("1000 100000"));
+  // 500 bytes take 0.5 ms, so the ideal small flow takes 1 ms
+  monitor->SetAttribute ("LinkRate", DataRateValue (DataRate ("8Mbps")));
+  monitor->SetAttribute ("BaseRtt", TimeValue (MicroSeconds (250)));
+
+  // 100 small flows completing after 1, 2, ..., 100 ms, with a 75 ms deadline
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      uint32_t flow = monitor->StartFlow (MilliSeconds (75));
+      monitor->AddBytes (flow, 200);
+      monitor->AddBytes (flow, 300);
+      Simulator::Schedule (MilliSeconds (100 - i), &FctMonitor::CompleteFlow, monitor, flow);
+    }
+  // a large flow which does not complete
+  uint32_t large = monitor->StartFlow (Time (0));
+  monitor->AddBytes (large, 200000);
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (monitor->GetNFlows (), 101, "101 flows started");
+  std::vector<FctMonitor::BucketSummary> summary = monitor->GetSummary ();
+  NS_TEST_ASSERT_MSG_EQ (summary.size (), 3, "Two bounds make three buckets");
+
+  NS_TEST_EXPECT_MSG_EQ (summary[0].maxBytes, 1000, "Wrong bound of the small flows");
+  NS_TEST_EXPECT_MSG_EQ (summary[0].flows, 100, "Wrong number of small flows");
+  NS_TEST_EXPECT_MSG_EQ (summary[0].completed, 100, "All the small flows completed");
+  NS_TEST_EXPECT_MSG_EQ (summary[0].fctP50, MilliSeconds (50), "Wrong median FCT");
+  NS_TEST_EXPECT_MSG_EQ (summary[0].fctP99, MilliSeconds (99), "Wrong 99th percentile FCT");
+  NS_TEST_EXPECT_MSG_EQ (summary[0].fctP999, MilliSeconds (100), "Wrong 99.9th percentile FCT");
+  NS_TEST_EXPECT_MSG_EQ_TOL (summary[0].slowdownP50, 50, 1e-9, "Wrong median slowdown");
+  NS_TEST_EXPECT_MSG_EQ_TOL (summary[0].slowdownP99, 99, 1e-9, "Wrong 99th percentile slowdown");
+  NS_TEST_EXPECT_MSG_EQ (summary[0].deadlineFlows, 100, "All the small flows have a deadline");
+  NS_TEST_EXPECT_MSG_EQ (summary[0].deadlinesMet, 75, "The flows completing within 75 ms meet it");
+
+  NS_TEST_EXPECT_MSG_EQ (summary[1].minBytes, 1001, "Wrong lower bound of the medium flows");
+  NS_TEST_EXPECT_MSG_EQ (summary[1].flows, 0, "No medium flow");
+
+  NS_TEST_EXPECT_MSG_EQ (summary[2].flows, 1, "One large flow");
+  NS_TEST_EXPECT_MSG_EQ (summary[2].completed, 0, "The large flow did not complete");
+  NS_TEST_EXPECT_MSG_EQ (summary[2].deadlineFlows, 0, "The large flow has no deadline");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Check that a sender socket reports its flow
+ *
+ * The sender connects at 0 s and sends 10 packets of 500 bytes, one
+ * per millisecond from 10 s, then closes the socket. The flow should
+ * complete when the sender receives the acknowledgment of its last byte.
+ */
+class TcpFctMonitorTestCase : public TcpGeneralTest
+{
+public:
+  TcpFctMonitorTestCase ();
+
+protected:
+  virtual Ptr<TcpSocketMsgBase> CreateSenderSocket (Ptr<Node> node);
+  virtual void ProcessedAck (const Ptr<const TcpSocketState> tcb,
+                             const TcpHeader& h, SocketWho who);
+  virtual void FinalChecks ();
+
+private:
+  Ptr<FctMonitor> m_monitor; //!< the monitor
+  Time m_lastDataAck;        //!< time the last byte was acknowledged
+};
+
+TcpFctMonitorTestCase::TcpFctMonitorTestCase ()
+  : TcpGeneralTest ("Report the flow of a sender socket to the FCT monitor"),
+    m_monitor (CreateObject<FctMonitor> ()),
+    m_lastDataAck (Time (0))
+{
+}
+
+void
+TcpFctMonitorTestCase::ProcessedAck (const Ptr<const TcpSocketState> tcb,
+                                     const TcpHeader& h, SocketWho who)
+{
+  // the data starts after the SYN, at sequence number 1
+  SequenceNumber32 lastByte (1 + GetPktSize () * GetPktCount ());
+  if (who == SENDER && h.GetAckNumber () >= lastByte && m_lastDataAck.IsZero ())
+    {
+      m_lastDataAck = Simulator::Now ();
+    }
+}
+
+Ptr<TcpSocketMsgBase>
+TcpFctMonitorTestCase::CreateSenderSocket (Ptr<Node> node)
+{
+  Ptr<TcpSocketMsgBase> socket = TcpGeneralTest::CreateSenderSocket (node);
+  socket->SetFctMonitor (m_monitor);
+  return socket;
+}
+
+void
+TcpFctMonitorTestCase::FinalChecks ()
+{
+  NS_TEST_ASSERT_MSG_EQ (m_monitor->GetNFlows (), 1, "The sender should have started one flow");
+  const FctMonitor::FlowRecord &record = m_monitor->GetFlow (0);
+  NS_TEST_EXPECT_MSG_EQ (record.bytes, GetPktSize () * GetPktCount (), "Wrong flow size");
+  NS_TEST_EXPECT_MSG_EQ (record.start, Seconds (0), "The flow starts on connection");
+  NS_TEST_ASSERT_MSG_EQ (record.completed, true, "The flow should have completed");
+  NS_TEST_ASSERT_MSG_EQ (m_lastDataAck.IsZero (), false, "The last byte should have been acknowledged");
+  NS_TEST_EXPECT_MSG_EQ (record.end, m_lastDataAck, "The flow completes with the last acknowledgment");
+}
+
+static class TcpFctMonitorTestSuite : public TestSuite
+{
+public:
+  TcpFctMonitorTestSuite ()
+    : TestSuite ("tcp-fct-monitor", UNIT)
+  {
+    AddTestCase (new FctMonitorSummaryTestCase (), TestCase::QUICK);
+    AddTestCase (new TcpFctMonitorTestCase (), TestCase::QUICK);
+  }
+} g_tcpFctMonitorTestSuite;
+
+} // namespace ns3
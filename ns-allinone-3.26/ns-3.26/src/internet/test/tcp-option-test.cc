@@ -22,6 +22,9 @@
 #include "ns3/tcp-option.h"
 #include "ns3/private/tcp-option-winscale.h"
 #include "ns3/private/tcp-option-ts.h"
+#include "ns3/private/tcp-option-sack-permitted.h"
+#include "ns3/private/tcp-option-sack.h"
+#include "ns3/private/tcp-option-skip.h"
 
 #include <string.h>
 
@@ -164,6 +167,109 @@ TcpOptionTSTestCase::DoTeardown ()
 {
 }
 
+class TcpOptionSackTestCase : public TestCase
+{
+public:
+  TcpOptionSackTestCase (std::string name, uint32_t blocks);
+
+private:
+  virtual void DoRun (void);
+
+  uint32_t m_blocks;
+};
+
+TcpOptionSackTestCase::TcpOptionSackTestCase (std::string name, uint32_t blocks)
+  : TestCase (name),
+    m_blocks (blocks)
+{
+}
+
+void
+TcpOptionSackTestCase::DoRun ()
+{
+  Ptr<UniformRandomVariable> x = CreateObject<UniformRandomVariable> ();
+
+  for (uint32_t i = 0; i < 100; ++i)
+    {
+      TcpOptionSack opt;
+      for (uint32_t j = 0; j < m_blocks; ++j)
+        {
+          SequenceNumber32 head (x->GetInteger (0, 0x7fffffff));
+          opt.AddSackBlock (TcpOptionSack::SackBlock (head, head + x->GetInteger (1, 65535)));
+        }
+
+      Buffer buffer;
+      buffer.AddAtStart (opt.GetSerializedSize ());
+      opt.Serialize (buffer.Begin ());
+      NS_TEST_EXPECT_MSG_EQ (opt.GetSerializedSize (), 2 + 8 * m_blocks, "Wrong option size");
+      NS_TEST_EXPECT_MSG_EQ (buffer.Begin ().PeekU8 (), TcpOption::SACK, "Different kind found");
+
+      TcpOptionSack copy;
+      NS_TEST_EXPECT_MSG_EQ (copy.Deserialize (buffer.Begin ()), opt.GetSerializedSize (), "Option not read");
+      NS_TEST_ASSERT_MSG_EQ (copy.GetNumSackBlocks (), m_blocks, "Different number of blocks found");
+      for (uint32_t j = 0; j < m_blocks; ++j)
+        {
+          NS_TEST_EXPECT_MSG_EQ (copy.GetSackList ()[j].first, opt.GetSackList ()[j].first, "Different left edge found");
+          NS_TEST_EXPECT_MSG_EQ (copy.GetSackList ()[j].second, opt.GetSackList ()[j].second, "Different right edge found");
+        }
+    }
+
+  TcpOptionSackPermitted permitted;
+  Buffer buffer;
+  buffer.AddAtStart (permitted.GetSerializedSize ());
+  permitted.Serialize (buffer.Begin ());
+  NS_TEST_EXPECT_MSG_EQ (buffer.Begin ().PeekU8 (), TcpOption::SACKPERMITTED, "Different kind found");
+  NS_TEST_EXPECT_MSG_EQ (permitted.Deserialize (buffer.Begin ()), 2, "SACK permitted option not read");
+}
+
+class TcpOptionSkipTestCase : public TestCase
+{
+public:
+  TcpOptionSkipTestCase (std::string name, uint32_t blocks);
+
+private:
+  virtual void DoRun (void);
+
+  uint32_t m_blocks;
+};
+
+TcpOptionSkipTestCase::TcpOptionSkipTestCase (std::string name, uint32_t blocks)
+  : TestCase (name),
+    m_blocks (blocks)
+{
+}
+
+void
+TcpOptionSkipTestCase::DoRun ()
+{
+  Ptr<UniformRandomVariable> x = CreateObject<UniformRandomVariable> ();
+
+  for (uint32_t i = 0; i < 100; ++i)
+    {
+      TcpOptionSkip opt;
+      for (uint32_t j = 0; j < m_blocks; ++j)
+        {
+          SequenceNumber32 head (x->GetInteger (0, 0x7fffffff));
+          opt.AddSkipBlock (TcpOptionSkip::SkipBlock (head, head + x->GetInteger (1, 65535)));
+        }
+
+      Buffer buffer;
+      buffer.AddAtStart (opt.GetSerializedSize ());
+      opt.Serialize (buffer.Begin ());
+      NS_TEST_EXPECT_MSG_EQ (opt.GetSerializedSize (), 2 + 8 * m_blocks, "Wrong option size");
+      NS_TEST_EXPECT_MSG_EQ (buffer.Begin ().PeekU8 (), TcpOption::SKIP, "Different kind found");
+
+      TcpOptionSkip copy;
+      NS_TEST_EXPECT_MSG_EQ (copy.Deserialize (buffer.Begin ()), opt.GetSerializedSize (), "Option not read");
+      NS_TEST_ASSERT_MSG_EQ (copy.GetNumSkipBlocks (), m_blocks, "Different number of ranges found");
+      for (uint32_t j = 0; j < m_blocks; ++j)
+        {
+          NS_TEST_EXPECT_MSG_EQ (copy.GetSkipList ()[j].first, opt.GetSkipList ()[j].first, "Different first byte found");
+          NS_TEST_EXPECT_MSG_EQ (copy.GetSkipList ()[j].second, opt.GetSkipList ()[j].second, "Different range end found");
+        }
+    }
+}
+
 static class TcpOptionTestSuite : public TestSuite
 {
 public:
@@ -176,6 +282,14 @@ public:
                                               "scale value", i), TestCase::QUICK);
       }
     AddTestCase (new TcpOptionTSTestCase ("Testing serialization of random values for timestamp"), TestCase::QUICK);
+    for (uint32_t i = 1; i <= TcpOptionSack::MAX_BLOCKS; ++i)
+      {
+        AddTestCase (new TcpOptionSackTestCase ("Testing serialization of random SACK blocks", i), TestCase::QUICK);
+      }
+    for (uint32_t i = 0; i <= TcpOptionSkip::MAX_BLOCKS; ++i)
+      {
+        AddTestCase (new TcpOptionSkipTestCase ("Testing serialization of random Skip ranges", i), TestCase::QUICK);
+      }
   }
 
 } g_TcpOptionTestSuite;
@@ -0,0 +1,153 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "tcp-general-test.h"
+#include "ns3/node.h"
+#include "ns3/log.h"
+#include "ns3/rtt-estimator.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpPacingTestSuite");
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the bursts of new data of a sender with a full buffer
+ *
+ * The link has no serialization delay, so without pacing a whole window
+ * leaves at the same instant. With pacing, once the sender has an RTT
+ * sample, no more than PacingQuantum segments leave at the same instant.
+ */
+class TcpPacingTest : public TcpGeneralTest
+{
+public:
+  /**
+   * \brief Constructor
+   * \param desc Description
+   * \param pacing Enable pacing on the sender
+   * \param quantum Segments released at once by the pacing timer
+   */
+  TcpPacingTest (const std::string &desc, bool pacing, uint32_t quantum);
+
+protected:
+  virtual Ptr<TcpSocketMsgBase> CreateSenderSocket (Ptr<Node> node);
+  virtual void Tx (const Ptr<const Packet> p, const TcpHeader&h, SocketWho who);
+  virtual void ConfigureEnvironment ();
+  virtual void FinalChecks ();
+
+private:
+  bool m_pacing;              //!< Pacing enabled
+  uint32_t m_quantum;         //!< Pacing quantum
+  SequenceNumber32 m_highestTx; //!< Highest sequence number sent
+  Time m_burstStart;          //!< Time of the current burst
+  bool m_burstPaced;          //!< The current burst started with an RTT sample
+  uint32_t m_burst;           //!< Segments of the current burst
+  uint32_t m_maxPacedBurst;   //!< Largest burst after the first RTT sample
+};
+
+TcpPacingTest::TcpPacingTest (const std::string &desc, bool pacing, uint32_t quantum)
+  : TcpGeneralTest (desc),
+    m_pacing (pacing),
+    m_quantum (quantum),
+    m_highestTx (0),
+    m_burstStart (Seconds (-1.0)),
+    m_burstPaced (false),
+    m_burst (0),
+    m_maxPacedBurst (0)
+{
+}
+
+void
+TcpPacingTest::ConfigureEnvironment ()
+{
+  TcpGeneralTest::ConfigureEnvironment ();
+  SetAppPktCount (200);
+  SetAppPktInterval (Seconds (0));
+  SetPropagationDelay (MilliSeconds (50));
+  SetTransmitStart (Seconds (2.0));
+}
+
+Ptr<TcpSocketMsgBase>
+TcpPacingTest::CreateSenderSocket (Ptr<Node> node)
+{
+  Ptr<TcpSocketMsgBase> socket = TcpGeneralTest::CreateSenderSocket (node);
+  socket->SetAttribute ("Pacing", BooleanValue (m_pacing));
+  socket->SetAttribute ("PacingQuantum", UintegerValue (m_quantum));
+  return socket;
+}
+
+void
+TcpPacingTest::Tx (const Ptr<const Packet> p, const TcpHeader &h, SocketWho who)
+{
+  if (who != SENDER || p->GetSize () == 0 || h.GetSequenceNumber () < m_highestTx)
+    {
+      return;
+    }
+  m_highestTx = h.GetSequenceNumber ();
+
+  if (Simulator::Now () != m_burstStart)
+    {
+      m_burstStart = Simulator::Now ();
+      m_burstPaced = !GetRttEstimator (SENDER)->GetEstimate ().IsZero ();
+      m_burst = 0;
+    }
+  m_burst++;
+  if (m_burstPaced)
+    {
+      NS_LOG_DEBUG ("Burst of " << m_burst << " segments at " << m_burstStart.GetSeconds ());
+      m_maxPacedBurst = std::max (m_maxPacedBurst, m_burst);
+    }
+}
+
+void
+TcpPacingTest::FinalChecks ()
+{
+  NS_TEST_ASSERT_MSG_EQ (GetRxBuffer (RECEIVER)->NextRxSequence (),
+                         SequenceNumber32 (1 + GetPktCount () * GetPktSize () + 1),
+                         "Transfer not completed");
+  if (m_pacing)
+    {
+      NS_TEST_ASSERT_MSG_LT_OR_EQ (m_maxPacedBurst, m_quantum, "Burst larger than the pacing quantum");
+    }
+  else
+    {
+      NS_TEST_ASSERT_MSG_GT (m_maxPacedBurst, m_quantum, "Bursts without pacing expected");
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP pacing TestSuite
+ */
+static class TcpPacingTestSuite : public TestSuite
+{
+public:
+  TcpPacingTestSuite () : TestSuite ("tcp-pacing-test", UNIT)
+  {
+    AddTestCase (new TcpPacingTest ("No pacing", false, 2), TestCase::QUICK);
+    AddTestCase (new TcpPacingTest ("Pacing, quantum of 2 segments", true, 2), TestCase::QUICK);
+    AddTestCase (new TcpPacingTest ("Pacing, quantum of 4 segments", true, 4), TestCase::QUICK);
+  }
+} g_tcpPacingTestSuite;
+
+} // namespace ns3
@@ -117,6 +117,7 @@ DistributedSimulatorImpl::DistributedSimulatorImpl ()
   m_currentTs = 0;
   m_currentContext = Simulator::NO_CONTEXT;
   m_unscheduledEvents = 0;
+  m_cancelledEvents = 0;
   m_events = 0;
 }
 
@@ -322,6 +323,10 @@ DistributedSimulatorImpl::ProcessOneEvent (void)
 
   NS_ASSERT (next.key.m_ts >= m_currentTs);
   m_unscheduledEvents--;
+  if (m_cancelledEvents > 0 && next.impl->IsCancelled ())
+    {
+      m_cancelledEvents--;
+    }
 
   NS_LOG_LOGIC ("handle " << next.key.m_ts);
   m_currentTs = next.key.m_ts;
@@ -592,9 +597,25 @@ DistributedSimulatorImpl::Cancel (const EventId &id)
   if (!IsExpired (id))
     {
       id.PeekEventImpl ()->Cancel ();
+      if (id.GetUid () != 2)
+        {
+          m_cancelledEvents++;
+        }
     }
 }
 
+uint32_t
+DistributedSimulatorImpl::GetLiveEventCount (void) const
+{
+  return m_unscheduledEvents - m_cancelledEvents;
+}
+
+uint32_t
+DistributedSimulatorImpl::GetCancelledEventCount (void) const
+{
+  return m_cancelledEvents;
+}
+
 bool
 DistributedSimulatorImpl::IsExpired (const EventId &id) const
 {
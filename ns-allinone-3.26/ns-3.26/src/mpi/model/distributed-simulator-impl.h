@@ -118,6 +118,8 @@ public:
   virtual void Remove (const EventId &id);
   virtual void Cancel (const EventId &id);
   virtual bool IsExpired (const EventId &id) const;
+  virtual uint32_t GetLiveEventCount (void) const;
+  virtual uint32_t GetCancelledEventCount (void) const;
   virtual void Run (void);
   virtual Time Now (void) const;
   virtual Time GetDelayLeft (const EventId &id) const;
@@ -148,6 +150,11 @@ private:
   // number of events that have been inserted but not yet scheduled,
   // not counting the "destroy" events; this is used for validation
   int m_unscheduledEvents;
+  /**
+   * Number of events which have been cancelled but are still in the
+   * event list.
+   */
+  int m_cancelledEvents;
 
   LbtsMessage* m_pLBTS;       // Allocated once we know how many systems
   uint32_t     m_myId;        // MPI Rank
@@ -84,6 +84,7 @@ NullMessageSimulatorImpl::NullMessageSimulatorImpl ()
   m_currentTs = 0;
   m_currentContext = Simulator::NO_CONTEXT;
   m_unscheduledEvents = 0;
+  m_cancelledEvents = 0;
   m_events = 0;
 
   m_safeTime = Seconds (0);
@@ -235,6 +236,10 @@ NullMessageSimulatorImpl::ProcessOneEvent (void)
 
   NS_ASSERT (next.key.m_ts >= m_currentTs);
   m_unscheduledEvents--;
+  if (m_cancelledEvents > 0 && next.impl->IsCancelled ())
+    {
+      m_cancelledEvents--;
+    }
 
   NS_LOG_LOGIC ("handle " << next.key.m_ts);
   m_currentTs = next.key.m_ts;
@@ -524,9 +529,25 @@ NullMessageSimulatorImpl::Cancel (const EventId &id)
   if (!IsExpired (id))
     {
       id.PeekEventImpl ()->Cancel ();
+      if (id.GetUid () != 2)
+        {
+          m_cancelledEvents++;
+        }
     }
 }
 
+uint32_t
+NullMessageSimulatorImpl::GetLiveEventCount (void) const
+{
+  return m_unscheduledEvents - m_cancelledEvents;
+}
+
+uint32_t
+NullMessageSimulatorImpl::GetCancelledEventCount (void) const
+{
+  return m_cancelledEvents;
+}
+
 bool
 NullMessageSimulatorImpl::IsExpired (const EventId &id) const
 {
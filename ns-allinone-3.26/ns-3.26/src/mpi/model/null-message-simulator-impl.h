@@ -63,6 +63,8 @@ public:
   virtual void Remove (const EventId &id);
   virtual void Cancel (const EventId &id);
   virtual bool IsExpired (const EventId &id) const;
+  virtual uint32_t GetLiveEventCount (void) const;
+  virtual uint32_t GetCancelledEventCount (void) const;
   virtual void Run (void);
   virtual void RunOneEvent (void);
   virtual Time Now (void) const;
@@ -179,6 +181,11 @@ private:
   // number of events that have been inserted but not yet scheduled,
   // not counting the "destroy" events; this is used for validation
   int m_unscheduledEvents;
+  /**
+   * Number of events which have been cancelled but are still in the
+   * event list.
+   */
+  int m_cancelledEvents;
 
   uint32_t     m_myId;        // MPI Rank
   uint32_t     m_systemCount; // MPI Size
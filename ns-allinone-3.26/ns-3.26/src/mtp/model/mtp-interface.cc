@@ -0,0 +1,44 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "mtp-interface.h"
+
+#include "ns3/global-value.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/log.h"
+
+/**
+ * \file
+ * \ingroup mtp
+ * Implementation of class ns3::MtpInterface.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MtpInterface");
+
+void
+MtpInterface::Enable (uint32_t maxThreads)
+{
+  NS_LOG_FUNCTION (maxThreads);
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::MaxThreads", UintegerValue (maxThreads));
+  GlobalValue::Bind ("SimulatorImplementationType",
+                     StringValue ("ns3::MultithreadedSimulatorImpl"));
+}
+
+} // namespace ns3
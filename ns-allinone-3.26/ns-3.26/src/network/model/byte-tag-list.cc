@@ -21,6 +21,9 @@
 #include "ns3/log.h"
 #include <vector>
 #include <cstring>
+#ifdef NS3_MTP
+#include <atomic>
+#endif
 
 #define USE_FREE_LIST 1
 #define FREE_LIST_SIZE 1000
@@ -39,7 +42,11 @@ NS_LOG_COMPONENT_DEFINE ("ByteTagList");
  */
 struct ByteTagListData {
   uint32_t size;   //!< size of the data
+#ifdef NS3_MTP
+  std::atomic<uint32_t> count;  //!< use counter (for smart deallocation)
+#else
   uint32_t count;  //!< use counter (for smart deallocation)
+#endif
   uint32_t dirty;  //!< number of bytes actually in use
   uint8_t data[4]; //!< data
 };
@@ -52,12 +59,19 @@ struct ByteTagListData {
  *
  * Internal use only.
  */
-static class ByteTagListDataFreeList : public std::vector<struct ByteTagListData *>
+class ByteTagListDataFreeList : public std::vector<struct ByteTagListData *>
 {
 public:
   ~ByteTagListDataFreeList ();
-} g_freeList; //!< Container for struct ByteTagListData
+};
+#ifdef NS3_MTP
+// each thread of the MultithreadedSimulatorImpl recycles its own tag data
+static thread_local ByteTagListDataFreeList g_freeList; //!< Container for struct ByteTagListData
+static thread_local uint32_t g_maxSize = 0; //!< maximum data size (used for allocation)
+#else
+static ByteTagListDataFreeList g_freeList; //!< Container for struct ByteTagListData
 static uint32_t g_maxSize = 0; //!< maximum data size (used for allocation)
+#endif
 
 ByteTagListDataFreeList::~ByteTagListDataFreeList ()
 {
@@ -198,8 +212,13 @@ ByteTagList::Add (TypeId tid, uint32_t bufferSize, int32_t start, int32_t end)
       m_data = Allocate (spaceNeeded);
       m_used = 0;
     } 
+#ifdef NS3_MTP
+  // data shared with another thread is never appended to in place
+  else if (m_data->size < spaceNeeded || m_data->count != 1)
+#else
   else if (m_data->size < spaceNeeded ||
            (m_data->count != 1 && m_data->dirty != m_used))
+#endif
     {
       struct ByteTagListData *newData = Allocate (spaceNeeded);
       std::memcpy (&newData->data, &m_data->data, m_used);
@@ -375,8 +394,7 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
       return;
     }
   g_maxSize = std::max (g_maxSize, data->size);
-  data->count--;
-  if (data->count == 0)
+  if (--data->count == 0)
     {
       if (g_freeList.size () > FREE_LIST_SIZE ||
           data->size < g_maxSize)
@@ -413,8 +431,7 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
     {
       return;
     }
-  data->count--;
-  if (data->count == 0)
+  if (--data->count == 0)
     {
       uint8_t *buffer = (uint8_t *)data;
       delete [] buffer;
@@ -52,6 +52,11 @@ public:
    * the user has little reason to call it himself.
    */
   uint32_t Add (Ptr<Channel> channel);
+  /**
+   * \param old a channel of the list
+   * \param channel the channel created last, to put in place of old
+   */
+  void Replace (Ptr<Channel> old, Ptr<Channel> channel);
 
   /**
    * \returns a C++ iterator located at the beginning of this
@@ -180,6 +185,19 @@ ChannelListPriv::Add (Ptr<Channel> channel)
 
 }
 
+void
+ChannelListPriv::Replace (Ptr<Channel> old, Ptr<Channel> channel)
+{
+  NS_LOG_FUNCTION (this << old << channel);
+  NS_ASSERT_MSG (old->GetId () < m_channels.size () && m_channels[old->GetId ()] == old,
+                 "Channel " << old << " is not in the list");
+  NS_ASSERT_MSG (!m_channels.empty () && m_channels.back () == channel,
+                 "Only the channel created last can replace another one");
+  m_channels.pop_back ();
+  m_channels[old->GetId ()] = channel;
+  channel->m_id = old->GetId ();
+}
+
 ChannelList::Iterator 
 ChannelListPriv::Begin (void) const
 {
@@ -217,6 +235,13 @@ ChannelList::Add (Ptr<Channel> channel)
   return ChannelListPriv::Get ()->Add (channel);
 }
 
+void
+ChannelList::Replace (Ptr<Channel> old, Ptr<Channel> channel)
+{
+  NS_LOG_FUNCTION (old << channel);
+  ChannelListPriv::Get ()->Replace (old, channel);
+}
+
 ChannelList::Iterator 
 ChannelList::Begin (void)
 {
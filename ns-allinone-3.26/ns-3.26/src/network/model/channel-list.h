@@ -49,6 +49,16 @@ public:
    * the user has little reason to call it himself.
    */
   static uint32_t Add (Ptr<Channel> channel);
+  /**
+   * \param old a channel of the list
+   * \param channel the channel created last, to put in place of old
+   *
+   * The new channel takes the index, and thus the id, of the old one,
+   * which leaves the list.  A helper which moves the devices of a channel
+   * onto a channel of another type calls this method so that the list
+   * does not keep the old channel.
+   */
+  static void Replace (Ptr<Channel> old, Ptr<Channel> channel);
   /**
    * \returns a C++ iterator located at the beginning of this
    *          list.
@@ -75,6 +75,7 @@ public:
   virtual Ptr<NetDevice> GetDevice (uint32_t i) const = 0;
 
 private:
+  friend class ChannelListPriv;
   uint32_t m_id; //!< Channel id for this channel
 };
 
@@ -23,8 +23,10 @@
 #include "ns3/abort.h"
 #include "ns3/uinteger.h"
 #include "ns3/queue-limits.h"
+#include "ns3/segmentation-tag.h"
 #include "net-device.h"
 #include "packet.h"
+#include <algorithm>
 
 namespace ns3 {
 
@@ -33,6 +35,15 @@ NS_LOG_COMPONENT_DEFINE ("NetDevice");
 QueueItem::QueueItem (Ptr<Packet> p)
 {
   m_packet = p;
+  m_segments = 1;
+  if (SegmentationTag::IsEnabled ())
+    {
+      SegmentationTag tag;
+      if (p->PeekPacketTag (tag))
+        {
+          m_segments = tag.GetSegmentCount ();
+        }
+    }
 }
 
 QueueItem::~QueueItem()
@@ -54,6 +65,12 @@ QueueItem::GetPacketSize (void) const
   return m_packet->GetSize ();
 }
 
+uint32_t
+QueueItem::GetSegmentCount (void) const
+{
+  return m_segments;
+}
+
 bool
 QueueItem::GetUint8Value (QueueItem::Uint8Values field, uint8_t& value) const
 {
@@ -223,6 +240,7 @@ NetDeviceQueueInterface::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
   m_txQueuesVector.clear ();
+  m_txBudgetCallback.Nullify ();
   Object::DoDispose ();
 }
 
@@ -265,6 +283,27 @@ NetDeviceQueueInterface::GetSelectQueueCallback (void) const
   return m_selectQueueCallback;
 }
 
+void
+NetDeviceQueueInterface::SetTxBudgetCallback (TxBudgetCallback cb)
+{
+  m_txBudgetCallback = cb;
+}
+
+uint32_t
+NetDeviceQueueInterface::GetTxBudget (uint8_t i) const
+{
+  Ptr<NetDeviceQueue> txq = GetTxQueue (i);
+  if (txq->IsStopped ())
+    {
+      return 0;
+    }
+  if (m_txBudgetCallback.IsNull () || txq->GetQueueLimits ())
+    {
+      return 1;
+    }
+  return std::max<uint32_t> (m_txBudgetCallback (i), 1);
+}
+
 NS_OBJECT_ENSURE_REGISTERED (NetDevice);
 
 TypeId NetDevice::GetTypeId (void)
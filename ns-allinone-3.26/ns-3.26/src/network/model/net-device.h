@@ -79,6 +79,16 @@ public:
    */
   virtual uint32_t GetPacketSize (void) const;
 
+  /**
+   * \brief Get the number of wire segments of the packet
+   *
+   * A super-segment (see SegmentationTag) stands for several wire
+   * segments, and counts as that many packets in the queues.
+   *
+   * \return the number of wire segments of the packet included in this item.
+   */
+  uint32_t GetSegmentCount (void) const;
+
   /**
    * \enum Uint8Values
    * \brief 1-byte fields of the packet whose value can be retrieved, if present
@@ -135,6 +145,7 @@ private:
    * The packet contained in the queue item.
    */
   Ptr<Packet> m_packet;
+  uint32_t m_segments; //!< Number of wire segments of the packet
 };
 
 /**
@@ -332,6 +343,33 @@ public:
    */
   SelectQueueCallback GetSelectQueueCallback (void) const;
 
+  /// Callback invoked to determine how many packets a tx queue can accept
+  typedef Callback< uint32_t, uint8_t > TxBudgetCallback;
+
+  /**
+   * \brief Set the transmit budget callback.
+   * \param cb the callback to set.
+   *
+   * A device may call this method from within its NotifyNewAggregate method
+   * to advertise how many packets the given device transmission queue can
+   * accept before it is stopped. The traffic control layer uses the budget
+   * to dequeue a batch of packets from the queue disc in a single run.
+   * The callback must not underestimate the packets that can be sent before
+   * the queue stops; returning one is always safe.
+   */
+  void SetTxBudgetCallback (TxBudgetCallback cb);
+
+  /**
+   * \brief Get the transmit budget of a device transmission queue.
+   * \param i the index of the device transmission queue.
+   * \return the number of packets that can be sent to the device.
+   *
+   * Zero is returned if the queue is stopped. If the device did not set a
+   * transmit budget callback, or byte queue limits are enabled on the queue
+   * (they may stop the queue at any packet), at most one packet is allowed.
+   */
+  uint32_t GetTxBudget (uint8_t i) const;
+
 protected:
   /**
    * \brief Dispose of the object
@@ -341,6 +379,7 @@ protected:
 private:
   std::vector< Ptr<NetDeviceQueue> > m_txQueuesVector;   //!< Device transmission queues
   SelectQueueCallback m_selectQueueCallback;   //!< Select queue callback
+  TxBudgetCallback m_txBudgetCallback;   //!< Transmit budget callback
   uint8_t m_numTxQueues;   //!< Number of transmission queues to create
 };
 
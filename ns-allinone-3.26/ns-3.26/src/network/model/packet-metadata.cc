@@ -33,10 +33,17 @@ NS_LOG_COMPONENT_DEFINE ("PacketMetadata");
 
 bool PacketMetadata::m_enable = false;
 bool PacketMetadata::m_enableChecking = false;
+#ifdef NS3_MTP
+std::atomic<bool> PacketMetadata::m_metadataSkipped (false);
+thread_local uint32_t PacketMetadata::m_maxSize = 0;
+thread_local uint16_t PacketMetadata::m_chunkUid = 0;
+thread_local PacketMetadata::DataFreeList PacketMetadata::m_freeList;
+#else
 bool PacketMetadata::m_metadataSkipped = false;
 uint32_t PacketMetadata::m_maxSize = 0;
 uint16_t PacketMetadata::m_chunkUid = 0;
 PacketMetadata::DataFreeList PacketMetadata::m_freeList;
+#endif
 
 PacketMetadata::DataFreeList::~DataFreeList ()
 {
@@ -52,6 +59,10 @@ void
 PacketMetadata::Enable (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
+#ifdef NS3_LEAN_PACKET
+  NS_FATAL_ERROR ("Packet metadata was compiled out: reconfigure without --enable-lean-packets "
+                  "to print or check packets.");
+#endif
   NS_ASSERT_MSG (!m_metadataSkipped,
                  "Error: attempting to enable the packet metadata "
                  "subsystem too late in the simulation, which is not allowed.\n"
@@ -77,8 +88,7 @@ PacketMetadata::ReserveCopy (uint32_t size)
   struct PacketMetadata::Data *newData = PacketMetadata::Create (m_used + size);
   memcpy (newData->m_data, m_data->m_data, m_used);
   newData->m_dirtyEnd = m_used;
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
+  if (--m_data->m_count == 0) 
     {
       PacketMetadata::Recycle (m_data);
     }
@@ -100,10 +110,17 @@ PacketMetadata::Reserve (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
   NS_ASSERT (m_data != 0);
+#ifdef NS3_MTP
+  // data shared with another thread is never appended to in place
+  if (m_data->m_size >= m_used + size &&
+      (m_head == 0xffff ||
+       m_data->m_count == 1))
+#else
   if (m_data->m_size >= m_used + size &&
       (m_head == 0xffff ||
        m_data->m_count == 1 ||
        m_data->m_dirtyEnd == m_used))
+#endif
     {
       /* enough room, not dirty. */
     }
@@ -133,6 +150,10 @@ bool
 PacketMetadata::IsStateOk (void) const
 {
   NS_LOG_FUNCTION (this);
+  if (m_data == 0)
+    {
+      return m_head == 0xffff && m_tail == 0xffff && m_used == 0;
+    }
   bool ok = m_used <= m_data->m_size;
   ok &= IsPointerOk (m_head);
   ok &= IsPointerOk (m_tail);
@@ -375,15 +396,26 @@ uint16_t
 PacketMetadata::AddSmall (const struct PacketMetadata::SmallItem *item)
 {
   NS_LOG_FUNCTION (this << item->next << item->prev << item->typeUid << item->size << item->chunkUid);
-  NS_ASSERT (m_data != 0);
+  if (m_data == 0)
+    {
+      // created before the metadata was enabled
+      m_data = PacketMetadata::Create (10);
+      memset (m_data->m_data, 0xff, 4);
+    }
   NS_ASSERT (m_used != item->prev && m_used != item->next);
   uint32_t typeUidSize = GetUleb128Size (item->typeUid);
   uint32_t sizeSize = GetUleb128Size (item->size);
   uint32_t n =  2 + 2 + typeUidSize + sizeSize + 2;
+#ifdef NS3_MTP
+  if (m_used + n > m_data->m_size ||
+      (m_head != 0xffff &&
+       m_data->m_count != 1))
+#else
   if (m_used + n > m_data->m_size ||
       (m_head != 0xffff &&
        m_data->m_count != 1 &&
        m_used != m_data->m_dirtyEnd))
+#endif
     {
       ReserveCopy (n);
     }
@@ -408,7 +440,12 @@ PacketMetadata::AddBig (uint32_t next, uint32_t prev,
   NS_LOG_FUNCTION (this << next << prev <<
                    item->next << item->prev << item->typeUid << item->size << item->chunkUid <<
                    extraItem->fragmentStart << extraItem->fragmentEnd << extraItem->packetUid);
-  NS_ASSERT (m_data != 0);
+  if (m_data == 0)
+    {
+      // created before the metadata was enabled
+      m_data = PacketMetadata::Create (10);
+      memset (m_data->m_data, 0xff, 4);
+    }
   uint32_t typeUid = ((item->typeUid & 0x1) == 0x1) ? item->typeUid : item->typeUid+1;
   NS_ASSERT (m_used != prev && m_used != next);
 
@@ -418,10 +455,16 @@ PacketMetadata::AddBig (uint32_t next, uint32_t prev,
   uint32_t fragEndSize = GetUleb128Size (extraItem->fragmentEnd);
   uint32_t n = 2 + 2 + typeUidSize + sizeSize + 2 + fragStartSize + fragEndSize + 4;
 
+#ifdef NS3_MTP
+  if (m_used + n > m_data->m_size ||
+      (m_head != 0xffff &&
+       m_data->m_count != 1))
+#else
   if (m_used + n > m_data->m_size ||
       (m_head != 0xffff &&
        m_data->m_count != 1 &&
        m_used != m_data->m_dirtyEnd))
+#endif
     {
       ReserveCopy (n);
     }
@@ -666,7 +709,7 @@ PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size)
   NS_LOG_FUNCTION (this << uid << size);
   if (!m_enable)
     {
-      m_metadataSkipped = true;
+      SetMetadataSkipped ();
       return;
     }
 
@@ -688,7 +731,7 @@ PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
   NS_ASSERT (IsStateOk ());
   if (!m_enable) 
     {
-      m_metadataSkipped = true;
+      SetMetadataSkipped ();
       return;
     }
   struct PacketMetadata::SmallItem item;
@@ -736,7 +779,7 @@ PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
   NS_ASSERT (IsStateOk ());
   if (!m_enable)
     {
-      m_metadataSkipped = true;
+      SetMetadataSkipped ();
       return;
     }
   struct PacketMetadata::SmallItem item;
@@ -758,7 +801,7 @@ PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
   NS_ASSERT (IsStateOk ());
   if (!m_enable) 
     {
-      m_metadataSkipped = true;
+      SetMetadataSkipped ();
       return;
     }
   struct PacketMetadata::SmallItem item;
@@ -805,7 +848,7 @@ PacketMetadata::AddAtEnd (PacketMetadata const&o)
   NS_ASSERT (IsStateOk ());
   if (!m_enable) 
     {
-      m_metadataSkipped = true;
+      SetMetadataSkipped ();
       return;
     }
   if (m_tail == 0xffff)
@@ -882,7 +925,7 @@ PacketMetadata::AddPaddingAtEnd (uint32_t end)
   NS_LOG_FUNCTION (this << end);
   if (!m_enable)
     {
-      m_metadataSkipped = true;
+      SetMetadataSkipped ();
       return;
     }
 }
@@ -893,10 +936,10 @@ PacketMetadata::RemoveAtStart (uint32_t start)
   NS_ASSERT (IsStateOk ());
   if (!m_enable) 
     {
-      m_metadataSkipped = true;
+      SetMetadataSkipped ();
       return;
     }
-  NS_ASSERT (m_data != 0);
+  NS_ASSERT (m_data != 0 || m_head == 0xffff);
   uint32_t leftToRemove = start;
   uint16_t current = m_head;
   while (current != 0xffff && leftToRemove > 0)
@@ -956,10 +999,10 @@ PacketMetadata::RemoveAtEnd (uint32_t end)
   NS_ASSERT (IsStateOk ());
   if (!m_enable) 
     {
-      m_metadataSkipped = true;
+      SetMetadataSkipped ();
       return;
     }
-  NS_ASSERT (m_data != 0);
+  NS_ASSERT (m_data != 0 || m_head == 0xffff);
 
   uint32_t leftToRemove = end;
   uint16_t current = m_tail;
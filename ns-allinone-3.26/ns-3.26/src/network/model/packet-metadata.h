@@ -23,6 +23,9 @@
 #include <stdint.h>
 #include <vector>
 #include <limits>
+#ifdef NS3_MTP
+#include <atomic>
+#endif
 #include "ns3/callback.h"
 #include "ns3/assert.h"
 #include "ns3/type-id.h"
@@ -74,6 +77,12 @@ class Trailer;
  * integers, and some others as variable-size 32-bit integers.
  * The variable-size 32 bit integers are stored using the uleb128
  * encoding.
+ *
+ * While the metadata is not enabled, no byte buffer is allocated and
+ * copying the metadata of a packet costs a few words.  When ns-3 is
+ * configured with --enable-lean-packets (NS3_LEAN_PACKET), the Packet
+ * class does not record its operations at all and the metadata cannot
+ * be enabled.
  */
 class PacketMetadata 
 {
@@ -410,7 +419,11 @@ private:
    */
   struct Data {
     /** number of references to this struct Data instance. */
+#ifdef NS3_MTP
+    std::atomic<uint32_t> m_count;
+#else
     uint32_t m_count;
+#endif
     /** size (in bytes) of m_data buffer below */
     uint16_t m_size;
     /** max of the m_used field over all objects which
@@ -594,6 +607,12 @@ public:
    */
   void ReserveCopy (uint32_t n);
 
+  /**
+   * \brief Note that an operation was not recorded, so that the
+   * metadata cannot be enabled anymore
+   */
+  static inline void SetMetadataSkipped (void);
+
   /**
    * \brief Get the total size used by the metadata
    */
@@ -656,7 +675,12 @@ public:
    */
   static void Deallocate (struct PacketMetadata::Data *data);
 
+#ifdef NS3_MTP
+  // each thread of the MultithreadedSimulatorImpl recycles its own metadata
+  static thread_local DataFreeList m_freeList; //!< the metadata data storage
+#else
   static DataFreeList m_freeList; //!< the metadata data storage
+#endif
   static bool m_enable; //!< Enable the packet metadata
   static bool m_enableChecking; //!< Enable the packet metadata checking
 
@@ -665,10 +689,17 @@ public:
    * m_enable is false; used to detect enabling of metadata in the
    * middle of a simulation, which isn't allowed.
    */
+#ifdef NS3_MTP
+  static std::atomic<bool> m_metadataSkipped;
+
+  static thread_local uint32_t m_maxSize; //!< maximum metadata size
+  static thread_local uint16_t m_chunkUid; //!< Chunk Uid
+#else
   static bool m_metadataSkipped;
 
   static uint32_t m_maxSize; //!< maximum metadata size
   static uint16_t m_chunkUid; //!< Chunk Uid
+#endif
 
   struct Data *m_data; //!< Metadata storage
   /*
@@ -687,17 +718,18 @@ public:
 namespace ns3 {
 
 PacketMetadata::PacketMetadata (uint64_t uid, uint32_t size)
-  : m_data (PacketMetadata::Create (10)),
+  : m_data (0),
     m_head (0xffff),
     m_tail (0xffff),
     m_used (0),
     m_packetUid (uid)
 {
-  memset (m_data->m_data, 0xff, 4);
+#ifndef NS3_LEAN_PACKET
   if (size > 0)
     {
       DoAddHeader (0, size);
     }
+#endif
 }
 PacketMetadata::PacketMetadata (PacketMetadata const &o)
   : m_data (o.m_data),
@@ -706,9 +738,11 @@ PacketMetadata::PacketMetadata (PacketMetadata const &o)
     m_used (o.m_used),
     m_packetUid (o.m_packetUid)
 {
-  NS_ASSERT (m_data != 0);
-  NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
-  m_data->m_count++;
+  if (m_data != 0)
+    {
+      NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
+      m_data->m_count++;
+    }
 }
 PacketMetadata &
 PacketMetadata::operator = (PacketMetadata const& o)
@@ -716,15 +750,15 @@ PacketMetadata::operator = (PacketMetadata const& o)
   if (m_data != o.m_data) 
     {
       // not self assignment
-      NS_ASSERT (m_data != 0);
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      if (m_data != 0 && --m_data->m_count == 0)
         {
           PacketMetadata::Recycle (m_data);
         }
       m_data = o.m_data;
-      NS_ASSERT (m_data != 0);
-      m_data->m_count++;
+      if (m_data != 0)
+        {
+          m_data->m_count++;
+        }
     }
   m_head = o.m_head;
   m_tail = o.m_tail;
@@ -734,13 +768,20 @@ PacketMetadata::operator = (PacketMetadata const& o)
 }
 PacketMetadata::~PacketMetadata ()
 {
-  NS_ASSERT (m_data != 0);
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
+  if (m_data != 0 && --m_data->m_count == 0)
     {
       PacketMetadata::Recycle (m_data);
     }
 }
+void
+PacketMetadata::SetMetadataSkipped (void)
+{
+  // read first: the flag is shared by all the threads under NS3_MTP
+  if (!m_metadataSkipped)
+    {
+      m_metadataSkipped = true;
+    }
+}
 
 } // namespace ns3
 
@@ -27,6 +27,12 @@
 
 #include <stdint.h>
 #include <ostream>
+#ifdef NS3_LEAN_PACKET
+#include <cstring>
+#endif
+#ifdef NS3_MTP
+#include <atomic>
+#endif
 #include "ns3/type-id.h"
 
 namespace ns3 {
@@ -120,6 +126,18 @@ class Tag;
  *       shared. This portion is copied before the #Remove or #Replace is
  *       performed.
  *
+ * \par <b> Inline tags: </b>
+ * \n
+ * Most packets carry one or two tags.  When ns-3 is configured with
+ * --enable-lean-packets (NS3_LEAN_PACKET), up to #INLINE_TAGS tags are
+ * stored in the PacketTagList itself, in #m_inline, without allocating a
+ * TagData; #Add only prepends to the shared tree when the inline slots are
+ * full.  This makes every Packet larger by #INLINE_TAGS TagData (about 100
+ * bytes on 64-bit machines), and the inline tags are copied with the list
+ * instead of being shared.  #Head links them in front of the tree, so
+ * iterating lists the inline tags oldest first, then the others newest
+ * first; the default build lists all the tags newest first.
+ *
  * \par <b> Memory Management: </b>
  * \n
  * Packet tags must serialize to a finite maximum size, see TagData
@@ -164,7 +182,11 @@ public:
     uint8_t data[MAX_SIZE];   /**< Serialization buffer */
     struct TagData * next;   /**< Pointer to next in list */
     TypeId tid;               /**< Type of the tag serialized into #data */
+#ifdef NS3_MTP
+    std::atomic<uint32_t> count;  /**< Number of incoming links */
+#else
     uint32_t count;           /**< Number of incoming links */
+#endif
   };  /* struct TagData */
 
   /**
@@ -239,6 +261,24 @@ public:
   const struct PacketTagList::TagData *Head (void) const;
 
 private:
+#ifdef NS3_LEAN_PACKET
+  /// Number of tags stored in the list itself
+  enum
+  {
+    INLINE_TAGS = 2
+  };
+
+  /**
+   * Copy the inline tags of another list and link them to #m_next.
+   *
+   * \param [in] o The PacketTagList to copy the inline tags from.
+   */
+  inline void CopyInline (PacketTagList const &o);
+  /**
+   * Chain the inline tags together and to the first TagData of the tree.
+   */
+  inline void Relink (void);
+#endif
   /**
    * Typedef of method function pointer for copy-on-write operations
    *
@@ -291,6 +331,16 @@ private:
    * Pointer to first \ref TagData on the list
    */
   struct TagData *m_next;
+#ifdef NS3_LEAN_PACKET
+  /**
+   * Tags stored in the list itself, in the order they were added
+   */
+  struct TagData m_inline[INLINE_TAGS];
+  /**
+   * Number of tags in #m_inline
+   */
+  uint8_t m_nInline;
+#endif
 };
 
 } // namespace ns3
@@ -303,6 +353,9 @@ namespace ns3 {
 
 PacketTagList::PacketTagList ()
   : m_next ()
+#ifdef NS3_LEAN_PACKET
+  , m_nInline (0)
+#endif
 {
 }
 
@@ -313,8 +366,58 @@ PacketTagList::PacketTagList (PacketTagList const &o)
     {
       m_next->count++;
     }
+#ifdef NS3_LEAN_PACKET
+  CopyInline (o);
+#endif
+}
+
+#ifdef NS3_LEAN_PACKET
+PacketTagList &
+PacketTagList::operator = (PacketTagList const &o)
+{
+  // self assignment
+  if (this == &o)
+    {
+      return *this;
+    }
+  if (m_next != o.m_next)
+    {
+      RemoveAll ();
+      m_next = o.m_next;
+      if (m_next != 0) 
+        {
+          m_next->count++;
+        }
+    }
+  CopyInline (o);
+  return *this;
 }
 
+void
+PacketTagList::CopyInline (PacketTagList const &o)
+{
+  // the count is atomic with MTP, so copy the fields one by one
+  m_nInline = o.m_nInline;
+  for (uint8_t i = 0; i < m_nInline; i++)
+    {
+      std::memcpy (m_inline[i].data, o.m_inline[i].data, TagData::MAX_SIZE);
+      m_inline[i].tid = o.m_inline[i].tid;
+      m_inline[i].count = 1;
+    }
+  Relink ();
+}
+
+void
+PacketTagList::Relink (void)
+{
+  struct TagData *next = m_next;
+  for (uint8_t i = m_nInline; i > 0; i--)
+    {
+      m_inline[i - 1].next = next;
+      next = &m_inline[i - 1];
+    }
+}
+#else
 PacketTagList &
 PacketTagList::operator = (PacketTagList const &o)
 {
@@ -331,6 +434,7 @@ PacketTagList::operator = (PacketTagList const &o)
     }
   return *this;
 }
+#endif
 
 PacketTagList::~PacketTagList ()
 {
@@ -343,8 +447,7 @@ PacketTagList::RemoveAll (void)
   struct TagData *prev = 0;
   for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
     {
-      cur->count--;
-      if (cur->count > 0) 
+      if (--cur->count > 0) 
         {
           break;
         }
@@ -359,6 +462,9 @@ PacketTagList::RemoveAll (void)
       delete prev;
     }
   m_next = 0;
+#ifdef NS3_LEAN_PACKET
+  m_nInline = 0;
+#endif
 }
 
 } // namespace ns3
@@ -28,7 +28,35 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Packet");
 
+#ifdef NS3_MTP
+/**
+ * \brief The count of the packets of one system, alone on its cache line
+ */
+struct PacketUid
+{
+  alignas (64) uint32_t next; //!< The uid of the next packet
+};
+/**
+ * The counters of packets Uid, per system id: each thread of a
+ * multithreaded simulation counts its own packets, whatever the other
+ * threads do.
+ */
+static PacketUid g_globalUid[Simulator::MAX_SYSTEM_IDS];
+#else
 uint32_t Packet::m_globalUid = 0;
+#endif
+
+uint64_t
+Packet::AllocateUid (void)
+{
+  uint32_t systemId = Simulator::GetSystemId ();
+#ifdef NS3_MTP
+  NS_ASSERT (systemId < Simulator::MAX_SYSTEM_IDS);
+  return static_cast<uint64_t> (systemId) << 32 | g_globalUid[systemId].next++;
+#else
+  return static_cast<uint64_t> (systemId) << 32 | m_globalUid++;
+#endif
+}
 
 TypeId 
 ByteTagIterator::Item::GetTypeId (void) const
@@ -137,10 +165,9 @@ Packet::Packet ()
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, 0),
+    m_metadata (AllocateUid (), 0),
     m_nixVector (0)
 {
-  m_globalUid++;
 }
 
 Packet::Packet (const Packet &o)
@@ -179,10 +206,9 @@ Packet::Packet (uint32_t size)
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
+    m_metadata (AllocateUid (), size),
     m_nixVector (0)
 {
-  m_globalUid++;
 }
 Packet::Packet (uint8_t const *buffer, uint32_t size, bool magic)
   : m_buffer (0, false),
@@ -205,10 +231,9 @@ Packet::Packet (uint8_t const*buffer, uint32_t size)
      * zero.  The lower 32 bits are for the 
      * global UID
      */
-    m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
+    m_metadata (AllocateUid (), size),
     m_nixVector (0)
 {
-  m_globalUid++;
   m_buffer.AddAtStart (size);
   Buffer::Iterator i = m_buffer.Begin ();
   i.Write (buffer, size);
@@ -232,8 +257,12 @@ Packet::CreateFragment (uint32_t start, uint32_t length) const
   ByteTagList byteTagList = m_byteTagList;
   byteTagList.Adjust (-start);
   NS_ASSERT (m_buffer.GetSize () >= start + length);
+#ifdef NS3_LEAN_PACKET
+  PacketMetadata metadata = m_metadata;
+#else
   uint32_t end = m_buffer.GetSize () - (start + length);
   PacketMetadata metadata = m_metadata.CreateFragment (start, end);
+#endif
   // again, call the constructor directly rather than
   // through Create because it is private.
   Ptr<Packet> ret = Ptr<Packet> (new Packet (buffer, byteTagList, m_packetTagList, metadata), false);
@@ -262,7 +291,9 @@ Packet::AddHeader (const Header &header)
   m_byteTagList.Adjust (size);
   m_byteTagList.AddAtStart (size);
   header.Serialize (m_buffer.Begin ());
+#ifndef NS3_LEAN_PACKET
   m_metadata.AddHeader (header, size);
+#endif
 }
 uint32_t
 Packet::RemoveHeader (Header &header)
@@ -271,7 +302,9 @@ Packet::RemoveHeader (Header &header)
   NS_LOG_FUNCTION (this << header.GetInstanceTypeId ().GetName () << deserialized);
   m_buffer.RemoveAtStart (deserialized);
   m_byteTagList.Adjust (-deserialized);
+#ifndef NS3_LEAN_PACKET
   m_metadata.RemoveHeader (header, deserialized);
+#endif
   return deserialized;
 }
 uint32_t
@@ -290,7 +323,9 @@ Packet::AddTrailer (const Trailer &trailer)
   m_buffer.AddAtEnd (size);
   Buffer::Iterator end = m_buffer.End ();
   trailer.Serialize (end);
+#ifndef NS3_LEAN_PACKET
   m_metadata.AddTrailer (trailer, size);
+#endif
 }
 uint32_t
 Packet::RemoveTrailer (Trailer &trailer)
@@ -298,7 +333,9 @@ Packet::RemoveTrailer (Trailer &trailer)
   uint32_t deserialized = trailer.Deserialize (m_buffer.End ());
   NS_LOG_FUNCTION (this << trailer.GetInstanceTypeId ().GetName () << deserialized);
   m_buffer.RemoveAtEnd (deserialized);
+#ifndef NS3_LEAN_PACKET
   m_metadata.RemoveTrailer (trailer, deserialized);
+#endif
   return deserialized;
 }
 uint32_t
@@ -319,7 +356,9 @@ Packet::AddAtEnd (Ptr<const Packet> packet)
   copy.Adjust (GetSize ());
   m_byteTagList.Add (copy);
   m_buffer.AddAtEnd (packet->m_buffer);
+#ifndef NS3_LEAN_PACKET
   m_metadata.AddAtEnd (packet->m_metadata);
+#endif
 }
 void
 Packet::AddPaddingAtEnd (uint32_t size)
@@ -327,14 +366,18 @@ Packet::AddPaddingAtEnd (uint32_t size)
   NS_LOG_FUNCTION (this << size);
   m_byteTagList.AddAtEnd (GetSize ());
   m_buffer.AddAtEnd (size);
+#ifndef NS3_LEAN_PACKET
   m_metadata.AddPaddingAtEnd (size);
+#endif
 }
 void 
 Packet::RemoveAtEnd (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
   m_buffer.RemoveAtEnd (size);
+#ifndef NS3_LEAN_PACKET
   m_metadata.RemoveAtEnd (size);
+#endif
 }
 void 
 Packet::RemoveAtStart (uint32_t size)
@@ -342,7 +385,9 @@ Packet::RemoveAtStart (uint32_t size)
   NS_LOG_FUNCTION (this << size);
   m_buffer.RemoveAtStart (size);
   m_byteTagList.Adjust (-size);
+#ifndef NS3_LEAN_PACKET
   m_metadata.RemoveAtStart (size);
+#endif
 }
 
 void 
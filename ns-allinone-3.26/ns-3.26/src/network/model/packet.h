@@ -727,7 +727,16 @@ private:
   /* Please see comments above about nix-vector */
   Ptr<NixVector> m_nixVector; //!< the packet's Nix vector
 
+  /**
+   * \brief Allocates the uid of a new packet
+   * \returns the system id in the upper 32 bits, and the count of the
+   * packets of the system in the lower 32 bits
+   */
+  static uint64_t AllocateUid (void);
+
+#ifndef NS3_MTP
   static uint32_t m_globalUid; //!< Global counter of packets Uid
+#endif
 };
 
 /**
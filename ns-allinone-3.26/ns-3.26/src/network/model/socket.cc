@@ -784,6 +784,7 @@ SocketSetDontFragmentTag::Print (std::ostream &os) const
 
 
 SocketIpTosTag::SocketIpTosTag ()
+  : m_ipTos (0)
 {
 }
 
@@ -53,6 +53,7 @@ private:
   virtual Ptr<const QueueItem> DoPeek (void) const;
 
   std::queue<Ptr<QueueItem> > m_packets; //!< the items in the queue
+  uint32_t m_nSegments;                  //!< the wire segments of the items in the queue
 };
 
 } // namespace ns3
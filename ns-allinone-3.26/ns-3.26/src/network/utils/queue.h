@@ -84,7 +84,8 @@ public:
    */
   void DequeueAll (void);
   /**
-   * \return The number of packets currently stored in the Queue
+   * \return The number of packets currently stored in the Queue, a
+   * super-segment counting as its wire segments (see SegmentationTag)
    */
   uint32_t GetNPackets (void) const;
   /**
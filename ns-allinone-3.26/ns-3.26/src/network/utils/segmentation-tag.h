@@ -0,0 +1,130 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef SEGMENTATION_TAG_H
+#define SEGMENTATION_TAG_H
+
+#include "ns3/tag.h"
+#ifdef NS3_MTP
+#include <atomic>
+#endif
+
+namespace ns3 {
+
+/**
+ * \ingroup network
+ *
+ * \brief Packet tag of a super-segment
+ *
+ * A super-segment is a transport segment larger than the MTU that
+ * travels as a single packet in place of the wire segments a NIC would
+ * cut it into (segmentation offload). Each wire segment carries at
+ * most GetSegmentSize () bytes of the payload and repeats the headers
+ * of the packet. Queues count a super-segment as GetSegmentCount ()
+ * packets, and devices take the time of its wire segments to send it.
+ *
+ * Queue discs that mark ECN per packet mark the wire segments of a
+ * super-segment one by one, in the tag, so that the receiver knows
+ * which of its segments experienced congestion.
+ */
+class SegmentationTag : public Tag
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (TagBuffer buf) const;
+  virtual void Deserialize (TagBuffer buf);
+  virtual void Print (std::ostream &os) const;
+  SegmentationTag ();
+
+  /**
+   * \brief Constructs the tag of a super-segment
+   * \param segmentSize the payload size of a wire segment
+   * \param payloadSize the payload size of the super-segment
+   */
+  SegmentationTag (uint16_t segmentSize, uint32_t payloadSize);
+
+  static const uint32_t MAX_SEGMENTS = 64; //!< Maximum number of wire segments
+
+  /**
+   * \brief Turn offload on until the simulator is destroyed
+   *
+   * TcpSocketBase calls this method when its Offload attribute is set.
+   * Until then queues, devices and receivers do not look for the tag,
+   * so that packets pay nothing for offload when it is not used.  Code
+   * which builds super-segments by hand must call it as well.
+   */
+  static void Enable (void);
+
+  /**
+   * \brief Whether offload is on in this simulation
+   * \returns true once Enable was called, until Simulator::Destroy
+   */
+  static bool IsEnabled (void);
+
+  /**
+   * \returns the payload size of a wire segment
+   */
+  uint16_t GetSegmentSize (void) const;
+  /**
+   * \returns the payload size of the super-segment
+   */
+  uint32_t GetPayloadSize (void) const;
+  /**
+   * \returns the number of wire segments
+   */
+  uint32_t GetSegmentCount (void) const;
+  /**
+   * \brief Get the size of the wire segments of the super-segment
+   * \param packetSize the size of the super-segment, headers included
+   * \returns the sum of the sizes of the wire segments, headers included
+   */
+  uint32_t GetWireSize (uint32_t packetSize) const;
+  /**
+   * \brief Mark a wire segment as having experienced congestion
+   * \param segment the index of the wire segment
+   */
+  void MarkSegment (uint32_t segment);
+  /**
+   * \param segment the index of the wire segment
+   * \returns true if the wire segment is marked
+   */
+  bool IsSegmentMarked (uint32_t segment) const;
+
+private:
+  uint16_t m_segmentSize; //!< Payload size of a wire segment
+  uint32_t m_payloadSize; //!< Payload size of the super-segment
+  uint64_t m_marks;       //!< Marked wire segments, one bit each
+
+  /**
+   * \brief Turn offload off, when the simulator is destroyed
+   */
+  static void Disable (void);
+
+#ifdef NS3_MTP
+  static std::atomic<bool> m_enabled; //!< Whether offload is on
+#else
+  static bool m_enabled;  //!< Whether offload is on
+#endif
+};
+
+} // namespace ns3
+
+#endif /* SEGMENTATION_TAG_H */
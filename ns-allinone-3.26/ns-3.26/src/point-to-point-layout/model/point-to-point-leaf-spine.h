@@ -0,0 +1,148 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Define an object to create a leaf-spine topology.
+
+#ifndef POINT_TO_POINT_LEAF_SPINE_HELPER_H
+#define POINT_TO_POINT_LEAF_SPINE_HELPER_H
+
+#include <vector>
+
+#include "point-to-point-helper.h"
+#include "ipv4-address-helper.h"
+#include "internet-stack-helper.h"
+#include "ipv4-interface-container.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup point-to-point-layout
+ *
+ * \brief A helper to make it easier to create a leaf-spine topology
+ * with PointToPoint links, and to route it without SPF
+ *
+ * Every leaf (ToR) switch is linked to every spine switch and to its
+ * hosts, which are numbered leaf by leaf.  The hosts of leaf l are
+ * addressed from the /24 prefix base + 0.0.l.0, one /30 link per host.
+ * InstallRoutes writes the routes of every node into its
+ * Ipv4GlobalRouting directly: a default route on the hosts, the host
+ * links and an equal-cost default route towards the spines on the
+ * leaves, and the /24 prefix of every leaf on the spines.
+ */
+class PointToPointLeafSpineHelper
+{
+public:
+  /**
+   * Create a PointToPointLeafSpineHelper in order to easily create
+   * leaf-spine topologies using p2p links
+   *
+   * \param nLeaves the number of leaf switches, at most 256
+   *
+   * \param nSpines the number of spine switches
+   *
+   * \param hostsPerLeaf the number of hosts of each leaf, at most 64
+   *
+   * \param hostLink the link helper for the links between the hosts
+   *        and the leaves
+   *
+   * \param fabricLink the link helper for the links between the
+   *        leaves and the spines
+   */
+  PointToPointLeafSpineHelper (uint32_t nLeaves,
+                               uint32_t nSpines,
+                               uint32_t hostsPerLeaf,
+                               PointToPointHelper hostLink,
+                               PointToPointHelper fabricLink);
+
+  ~PointToPointLeafSpineHelper ();
+
+public:
+  /**
+   * \param i an index into the hosts
+   *
+   * \returns a node pointer to the indexed host
+   */
+  Ptr<Node> GetHost (uint32_t i) const;
+
+  /**
+   * \param i an index into the leaf switches
+   *
+   * \returns a node pointer to the indexed leaf switch
+   */
+  Ptr<Node> GetLeaf (uint32_t i) const;
+
+  /**
+   * \param i an index into the spine switches
+   *
+   * \returns a node pointer to the indexed spine switch
+   */
+  Ptr<Node> GetSpine (uint32_t i) const;
+
+  /**
+   * \returns the hosts of the topology
+   */
+  NodeContainer GetHosts () const;
+
+  /**
+   * \param i index into the host interfaces
+   *
+   * \returns Ipv4Address of the indexed host
+   */
+  Ipv4Address GetHostIpv4Address (uint32_t i) const;
+
+  /**
+   * \returns the total number of hosts in the topology
+   */
+  uint32_t HostCount () const;
+
+  /**
+   * \param stack an InternetStackHelper which is used to install
+   *              on every node in the topology; its routing must
+   *              include Ipv4GlobalRouting for InstallRoutes
+   */
+  void InstallStack (InternetStackHelper stack);
+
+  /**
+   * \param hostNetwork the /16 network the host prefixes are taken from
+   *
+   * \param fabricAddress an Ipv4AddressHelper which is used to address
+   *                      the links between the leaves and the spines,
+   *                      one network per link
+   */
+  void AssignIpv4Addresses (Ipv4Address hostNetwork,
+                            Ipv4AddressHelper fabricAddress);
+
+  /**
+   * Add the routes of every node to its Ipv4GlobalRouting, in place of
+   * Ipv4GlobalRoutingHelper::PopulateRoutingTables.  The routes reach
+   * the hosts only; they are removed by
+   * Ipv4GlobalRoutingHelper::RecomputeRoutingTables.
+   */
+  void InstallRoutes ();
+
+private:
+  uint32_t m_hostsPerLeaf;               //!< Number of hosts of each leaf
+  NodeContainer m_hosts;                 //!< Hosts
+  NodeContainer m_leaves;                //!< Leaf switches
+  NodeContainer m_spines;                //!< Spine switches
+  std::vector<NetDeviceContainer> m_hostLinks;    //!< Host and leaf devices, by host
+  std::vector<NetDeviceContainer> m_fabricLinks;  //!< Leaf and spine devices, by leaf then spine
+  Ipv4InterfaceContainer m_hostInterfaces;        //!< IPv4 host interfaces
+};
+
+} // namespace ns3
+
+#endif /* POINT_TO_POINT_LEAF_SPINE_HELPER_H */
@@ -0,0 +1,247 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <vector>
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/socket.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/global-router-interface.h"
+#include "ns3/point-to-point-fat-tree.h"
+#include "ns3/point-to-point-leaf-spine.h"
+
+using namespace ns3;
+
+/**
+ * \brief Base of the tests of the data center topologies: counts the
+ * routes of a node and checks that the hosts reach each other
+ */
+class ClosRoutingTestCase : public TestCase
+{
+public:
+  /**
+   * \param name the name of the test
+   */
+  ClosRoutingTestCase (std::string name);
+
+protected:
+  /**
+   * \param node the node
+   * \returns the number of routes in the global routing of the node
+   */
+  uint32_t CountRoutes (Ptr<Node> node);
+
+  /**
+   * \brief Send a packet from every host to every other host
+   * \param hosts the hosts
+   * \param addresses the addresses of the hosts
+   * \returns the number of packets received
+   */
+  uint32_t SendAllToAll (NodeContainer hosts, std::vector<Ipv4Address> addresses);
+
+private:
+  /**
+   * \brief Send a packet
+   * \param socket the sending socket
+   * \param to the destination
+   */
+  void Send (Ptr<Socket> socket, InetSocketAddress to);
+
+  /**
+   * \brief Count the packets received by a socket
+   * \param socket the socket
+   */
+  void Receive (Ptr<Socket> socket);
+
+  uint32_t m_received; //!< packets received
+};
+
+ClosRoutingTestCase::ClosRoutingTestCase (std::string name)
+  : TestCase (name),
+    m_received (0)
+{
+}
+
+uint32_t
+ClosRoutingTestCase::CountRoutes (Ptr<Node> node)
+{
+  return node->GetObject<GlobalRouter> ()->GetRoutingProtocol ()->GetNRoutes ();
+}
+
+void
+ClosRoutingTestCase::Send (Ptr<Socket> socket, InetSocketAddress to)
+{
+  socket->SendTo (Create<Packet> (100), 0, to);
+}
+
+void
+ClosRoutingTestCase::Receive (Ptr<Socket> socket)
+{
+  while (socket->Recv ())
+    {
+      m_received++;
+    }
+}
+
+uint32_t
+ClosRoutingTestCase::SendAllToAll (NodeContainer hosts, std::vector<Ipv4Address> addresses)
+{
+  uint16_t port = 9;
+  std::vector<Ptr<Socket> > sockets;
+  for (uint32_t i = 0; i < hosts.GetN (); i++)
+    {
+      Ptr<Socket> socket = Socket::CreateSocket (hosts.Get (i), UdpSocketFactory::GetTypeId ());
+      socket->Bind (InetSocketAddress (Ipv4Address::GetAny (), port));
+      socket->SetRecvCallback (MakeCallback (&ClosRoutingTestCase::Receive, this));
+      sockets.push_back (socket);
+    }
+  for (uint32_t i = 0; i < hosts.GetN (); i++)
+    {
+      for (uint32_t j = 0; j < hosts.GetN (); j++)
+        {
+          if (i != j)
+            {
+              Simulator::Schedule (MicroSeconds (j), &ClosRoutingTestCase::Send, this, sockets[i],
+                                   InetSocketAddress (addresses[j], port));
+            }
+        }
+    }
+  m_received = 0;
+  Simulator::Run ();
+  return m_received;
+}
+
+/**
+ * \brief Checks the routes of a k=4 fat-tree and that every host
+ * reaches every other one
+ */
+class FatTreeRoutingTestCase : public ClosRoutingTestCase
+{
+public:
+  FatTreeRoutingTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+FatTreeRoutingTestCase::FatTreeRoutingTestCase ()
+  : ClosRoutingTestCase ("Fat-tree routes installed without SPF")
+{
+}
+
+void
+FatTreeRoutingTestCase::DoRun (void)
+{
+  PointToPointHelper link;
+  PointToPointFatTreeHelper fatTree (4, link, link);
+  NS_TEST_ASSERT_MSG_EQ (fatTree.HostCount (), 16, "wrong number of hosts");
+
+  InternetStackHelper stack;
+  Ipv4GlobalRoutingHelper globalRouting;
+  stack.SetRoutingHelper (globalRouting);
+  fatTree.InstallStack (stack);
+  fatTree.AssignIpv4Addresses ("10.0.0.0", Ipv4AddressHelper ("172.16.0.0", "255.255.255.252"));
+  fatTree.InstallRoutes ();
+
+  NS_TEST_ASSERT_MSG_EQ (fatTree.GetHostIpv4Address (0), Ipv4Address ("10.0.0.1"), "wrong host address");
+  NS_TEST_ASSERT_MSG_EQ (fatTree.GetHostIpv4Address (3), Ipv4Address ("10.0.1.5"), "wrong host address");
+  NS_TEST_ASSERT_MSG_EQ (fatTree.GetHostIpv4Address (15), Ipv4Address ("10.3.1.5"), "wrong host address");
+
+  // k routes per switch, one per host
+  NS_TEST_ASSERT_MSG_EQ (CountRoutes (fatTree.GetHost (0)), 1, "wrong number of host routes");
+  NS_TEST_ASSERT_MSG_EQ (CountRoutes (fatTree.GetEdge (0)), 4, "wrong number of edge routes");
+  NS_TEST_ASSERT_MSG_EQ (CountRoutes (fatTree.GetAggregation (0)), 4, "wrong number of aggregation routes");
+  NS_TEST_ASSERT_MSG_EQ (CountRoutes (fatTree.GetCore (0)), 4, "wrong number of core routes");
+
+  std::vector<Ipv4Address> addresses;
+  for (uint32_t i = 0; i < fatTree.HostCount (); i++)
+    {
+      addresses.push_back (fatTree.GetHostIpv4Address (i));
+    }
+  NS_TEST_ASSERT_MSG_EQ (SendAllToAll (fatTree.GetHosts (), addresses), 16 * 15, "packets lost");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Checks the routes of a leaf-spine and that every host reaches
+ * every other one
+ */
+class LeafSpineRoutingTestCase : public ClosRoutingTestCase
+{
+public:
+  LeafSpineRoutingTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+LeafSpineRoutingTestCase::LeafSpineRoutingTestCase ()
+  : ClosRoutingTestCase ("Leaf-spine routes installed without SPF")
+{
+}
+
+void
+LeafSpineRoutingTestCase::DoRun (void)
+{
+  PointToPointHelper link;
+  PointToPointLeafSpineHelper leafSpine (3, 2, 4, link, link);
+  NS_TEST_ASSERT_MSG_EQ (leafSpine.HostCount (), 12, "wrong number of hosts");
+
+  InternetStackHelper stack;
+  Ipv4GlobalRoutingHelper globalRouting;
+  stack.SetRoutingHelper (globalRouting);
+  leafSpine.InstallStack (stack);
+  leafSpine.AssignIpv4Addresses ("10.1.0.0", Ipv4AddressHelper ("172.16.0.0", "255.255.255.252"));
+  leafSpine.InstallRoutes ();
+
+  NS_TEST_ASSERT_MSG_EQ (leafSpine.GetHostIpv4Address (5), Ipv4Address ("10.1.1.5"), "wrong host address");
+
+  NS_TEST_ASSERT_MSG_EQ (CountRoutes (leafSpine.GetHost (0)), 1, "wrong number of host routes");
+  NS_TEST_ASSERT_MSG_EQ (CountRoutes (leafSpine.GetLeaf (0)), 4 + 2, "wrong number of leaf routes");
+  NS_TEST_ASSERT_MSG_EQ (CountRoutes (leafSpine.GetSpine (0)), 3, "wrong number of spine routes");
+
+  std::vector<Ipv4Address> addresses;
+  for (uint32_t i = 0; i < leafSpine.HostCount (); i++)
+    {
+      addresses.push_back (leafSpine.GetHostIpv4Address (i));
+    }
+  NS_TEST_ASSERT_MSG_EQ (SendAllToAll (leafSpine.GetHosts (), addresses), 12 * 11, "packets lost");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Test suite of the data center topologies
+ */
+class PointToPointLayoutTestSuite : public TestSuite
+{
+public:
+  PointToPointLayoutTestSuite ();
+};
+
+PointToPointLayoutTestSuite::PointToPointLayoutTestSuite ()
+  : TestSuite ("point-to-point-layout", UNIT)
+{
+  AddTestCase (new FatTreeRoutingTestCase, TestCase::QUICK);
+  AddTestCase (new LeafSpineRoutingTestCase, TestCase::QUICK);
+}
+
+static PointToPointLayoutTestSuite g_pointToPointLayoutTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,127 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef TOPOLOGY_PARTITION_HELPER_H
+#define TOPOLOGY_PARTITION_HELPER_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include "ns3/channel.h"
+
+namespace ns3 {
+
+/**
+ * \brief Split the nodes of a simulation among parallel simulators.
+ *
+ * The helper looks at every node of the NodeList and every channel of
+ * the ChannelList.  Only a PointToPointChannel with a positive delay
+ * and no jitter may join two partitions; the nodes joined by any other
+ * channel stay together.  A node weighs one plus its number of devices.
+ *
+ * The partition first maximizes the lookahead, that is the smallest
+ * delay of a cut link: links slower than a threshold are kept whole,
+ * starting from the largest delay, until the nodes can be split within
+ * the allowed imbalance.  Among the partitions with this lookahead, the
+ * number of cut links is minimized by multilevel recursive bisection:
+ * the graph is coarsened by merging the nodes of heavy links, the
+ * coarsest graph is bisected by graph growing, and the bisection is
+ * refined by Fiduccia-Mattheyses passes while the graph is uncoarsened.
+ *
+ * The result only depends on the topology, so every rank of a
+ * distributed simulation computes the same partition:
+ * \code
+ *   // build the whole topology on every rank, then
+ *   TopologyPartitionHelper partitioner;
+ *   partitioner.Partition (MpiInterface::GetSize ());
+ *   partitioner.Apply ();
+ *   // install applications on the nodes with
+ *   // node->GetSystemId () == MpiInterface::GetSystemId ()
+ * \endcode
+ */
+class TopologyPartitionHelper
+{
+public:
+  TopologyPartitionHelper ();
+
+  /**
+   * \param [in] imbalance The largest accepted excess of the heaviest
+   *             partition over the average weight, 0.1 for 10%.
+   */
+  void SetMaxImbalance (double imbalance);
+
+  /**
+   * Compute the partition of the nodes created so far.
+   *
+   * \param [in] nParts The number of partitions wanted.  Fewer are used
+   *             if the nodes cannot be split that much.
+   */
+  void Partition (uint32_t nParts);
+
+  /**
+   * \return The number of partitions used by the last Partition call.
+   */
+  uint32_t GetNPartitions (void) const;
+
+  /**
+   * \param [in] nodeId A node id.
+   * \return The partition of this node, from 0 to GetNPartitions () - 1.
+   */
+  uint32_t GetPartition (uint32_t nodeId) const;
+
+  /**
+   * \return The smallest delay of a cut link, Time::Max () if no link
+   *         is cut.
+   */
+  Time GetLookahead (void) const;
+
+  /**
+   * \return The number of links joining two partitions.
+   */
+  uint32_t GetNCutLinks (void) const;
+
+  /**
+   * Set the SystemId of each node to its partition and, when MPI is
+   * enabled, move the point-to-point links which are not local to this
+   * rank onto a PointToPointRemoteChannel, as PointToPointHelper::Install
+   * would have done.  The remote channel replaces the old one in the
+   * ChannelList, with the same id.  Must be called before any event is
+   * scheduled on the nodes.
+   */
+  void Apply (void);
+
+private:
+  /** A link which may be cut. */
+  struct Link
+  {
+    uint32_t a;                          //!< Node id of one end.
+    uint32_t b;                          //!< Node id of the other end.
+    Time delay;                          //!< Delay of the link.
+    Ptr<Channel> channel;                //!< The channel.
+  };
+
+  double m_maxImbalance;               //!< Accepted imbalance.
+  std::vector<uint32_t> m_partition;   //!< Partition of each node.
+  uint32_t m_nPartitions;              //!< Number of partitions.
+  std::vector<Link> m_links;           //!< The links which may be cut.
+  Time m_lookahead;                    //!< Smallest delay of a cut link.
+  uint32_t m_nCutLinks;                //!< Number of cut links.
+};
+
+} // namespace ns3
+
+#endif /* TOPOLOGY_PARTITION_HELPER_H */
@@ -120,9 +120,17 @@ PointToPointChannel::TransmitStart (
                                                        m_maxJitter.GetNanoSeconds ()));
     }
 
+#ifdef NS3_MTP
+  // The receiver may run on another thread while the sending device still
+  // holds this packet until TransmitComplete, so hand it a packet of its own.
+  Simulator::ScheduleWithContext (m_link[wire].m_dst->GetNode ()->GetId (),
+                                  txTime + m_delay, &PointToPointNetDevice::Receive,
+                                  m_link[wire].m_dst, p->Copy ());
+#else
   Simulator::ScheduleWithContext (m_link[wire].m_dst->GetNode ()->GetId (),
                                   txTime + m_delay, &PointToPointNetDevice::Receive,
                                   m_link[wire].m_dst, p);
+#endif
 
   // Call the tx anim callback on the net device
   m_txrxPointToPoint (p, src, m_link[wire].m_dst, txTime, txTime + m_delay);
@@ -25,9 +25,11 @@
 #include "ns3/trace-source-accessor.h"
 #include "ns3/uinteger.h"
 #include "ns3/pointer.h"
+#include "ns3/segmentation-tag.h"
 #include "point-to-point-net-device.h"
 #include "point-to-point-channel.h"
 #include "ppp-header.h"
+#include <algorithm>
 
 namespace ns3 {
 
@@ -67,6 +69,12 @@ PointToPointNetDevice::GetTypeId (void)
                    TimeValue (Seconds (0.0)),
                    MakeTimeAccessor (&PointToPointNetDevice::m_tInterframeGap),
                    MakeTimeChecker ())
+    .AddAttribute ("MaxTxBurst",
+                   "The maximum number of packets sent back to back from the "
+                   "transmit queue with a single transmit complete event",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&PointToPointNetDevice::m_maxTxBurst),
+                   MakeUintegerChecker<uint32_t> (1))
 
     //
     // Transmit queueing discipline for the device which includes its own set
@@ -175,6 +183,7 @@ PointToPointNetDevice::GetTypeId (void)
 PointToPointNetDevice::PointToPointNetDevice () 
   :
     m_txMachineState (READY),
+    m_maxTxBurst (1),
     m_channel (0),
     m_linkUp (false),
     m_currentPkt (0)
@@ -218,6 +227,7 @@ PointToPointNetDevice::NotifyNewAggregate (void)
       if (ndqi != 0)
         {
           m_queueInterface = ndqi;
+          m_queueInterface->SetTxBudgetCallback (MakeCallback (&PointToPointNetDevice::GetTxBudget, this));
         }
     }
   NetDevice::NotifyNewAggregate ();
@@ -231,6 +241,9 @@ PointToPointNetDevice::DoDispose ()
   m_channel = 0;
   m_receiveErrorModel = 0;
   m_currentPkt = 0;
+  m_burst.clear ();
+  m_burstStart.clear ();
+  Simulator::Cancel (m_restartEvent);
   m_queue = 0;
   m_queueInterface = 0;
   NetDevice::DoDispose ();
@@ -266,20 +279,178 @@ PointToPointNetDevice::TransmitStart (Ptr<Packet> p)
   m_currentPkt = p;
   m_phyTxBeginTrace (m_currentPkt);
 
-  Time txTime = m_bps.CalculateBytesTxTime (p->GetSize ());
+  Time txTime = GetTxTime (p);
   Time txCompleteTime = txTime + m_tInterframeGap;
 
-  NS_LOG_LOGIC ("Schedule TransmitCompleteEvent in " << txCompleteTime.GetSeconds () << "sec");
-  Simulator::Schedule (txCompleteTime, &PointToPointNetDevice::TransmitComplete, this);
+  //
+  // If bursts are allowed, the packets waiting in the transmit queue follow
+  // this one on the wire. Their transmission is started now, and the channel
+  // is told when each of them would have ended, so that their reception is
+  // scheduled at the same time as if they were sent one by one. A single
+  // transmit complete event is scheduled, at the end of the burst. Until
+  // their transmission starts, the packets of the burst are still counted
+  // in the transmit queue (see GetNBurstWaiting).
+  //
+  NS_ASSERT (m_burst.empty ());
+  Ptr<NetDeviceQueue> txq;
+  if (m_queueInterface)
+    {
+      txq = m_queueInterface->GetTxQueue (0);
+    }
+  while (m_burst.size () + 1 < m_maxTxBurst && !m_queue->IsEmpty ())
+    {
+      Ptr<Packet> next = m_queue->Dequeue ()->GetPacket ();
+      m_burst.push_back (next);
+      m_burstStart.push_back (Simulator::Now () + txCompleteTime);
+      m_snifferTrace (next);
+      m_promiscSnifferTrace (next);
+      m_phyTxBeginTrace (next);
+      txCompleteTime += GetTxTime (next) + m_tInterframeGap;
+      if (txq)
+        {
+          // Inform BQL
+          txq->NotifyTransmittedBytes (next->GetSize ());
+        }
+    }
+  if (!m_burst.empty ())
+    {
+      NS_LOG_LOGIC ("Burst of " << m_burst.size () + 1 << " packets");
+      RestartTxQueue ();
+    }
 
-  bool result = m_channel->TransmitStart (p, this, txTime);
-  if (result == false)
+  bool result = true;
+  Time txStart = Seconds (0);
+  for (uint32_t i = 0; i <= m_burst.size (); i++)
     {
-      m_phyTxDropTrace (p);
+      Ptr<Packet> packet = i == 0 ? p : m_burst[i - 1];
+      if (i > 0)
+        {
+          txTime = GetTxTime (packet);
+        }
+      if (i == m_burst.size ())
+        {
+          NS_LOG_LOGIC ("Schedule TransmitCompleteEvent in " << txCompleteTime.GetSeconds () << "sec");
+          Simulator::Schedule (txCompleteTime, &PointToPointNetDevice::TransmitComplete, this);
+        }
+
+      if (m_channel->TransmitStart (packet, this, txStart + txTime) == false)
+        {
+          m_phyTxDropTrace (packet);
+          if (i == 0)
+            {
+              result = false;
+            }
+        }
+      txStart += txTime + m_tInterframeGap;
     }
   return result;
 }
 
+Time
+PointToPointNetDevice::GetTxTime (Ptr<const Packet> p) const
+{
+  SegmentationTag tag;
+  if (!SegmentationTag::IsEnabled () || !p->PeekPacketTag (tag))
+    {
+      return m_bps.CalculateBytesTxTime (p->GetSize ());
+    }
+  uint32_t segments = tag.GetSegmentCount ();
+  return m_bps.CalculateBytesTxTime (tag.GetWireSize (p->GetSize ()))
+         + m_tInterframeGap * (segments - 1);
+}
+
+uint32_t
+PointToPointNetDevice::GetNBurstWaiting (uint32_t &bytes) const
+{
+  uint32_t packets = 0;
+  bytes = 0;
+  Time now = Simulator::Now ();
+  for (uint32_t i = 0; i < m_burst.size (); i++)
+    {
+      if (m_burstStart[i] > now)
+        {
+          packets++;
+          bytes += m_burst[i]->GetSize ();
+        }
+    }
+  return packets;
+}
+
+bool
+PointToPointNetDevice::HasTxRoom (void) const
+{
+  uint32_t bytes;
+  uint32_t packets = GetNBurstWaiting (bytes);
+  if (m_queue->GetMode () == Queue::QUEUE_MODE_PACKETS)
+    {
+      return m_queue->GetNPackets () + packets < m_queue->GetMaxPackets ();
+    }
+  return m_queue->GetNBytes () + bytes + m_mtu <= m_queue->GetMaxBytes ();
+}
+
+void
+PointToPointNetDevice::RestartTxQueue (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_queueInterface)
+    {
+      return;
+    }
+  Ptr<NetDeviceQueue> txq = m_queueInterface->GetTxQueue (0);
+  if (txq->IsStopped ())
+    {
+      if (HasTxRoom ())
+        {
+          NS_LOG_DEBUG ("The device queue is being started (" << m_queue->GetNPackets () <<
+                        " packets and " << m_queue->GetNBytes () << " bytes inside)");
+          txq->Start ();
+        }
+      else if (!m_restartEvent.IsRunning ())
+        {
+          // a packet of the burst leaves the queue when its transmission
+          // starts, as it would have without bursts
+          Time now = Simulator::Now ();
+          for (uint32_t i = 0; i < m_burstStart.size (); i++)
+            {
+              if (m_burstStart[i] > now)
+                {
+                  m_restartEvent = Simulator::Schedule (m_burstStart[i] - now,
+                                                        &PointToPointNetDevice::RestartTxQueue, this);
+                  break;
+                }
+            }
+        }
+    }
+}
+
+uint32_t
+PointToPointNetDevice::GetTxBudget (uint8_t txq)
+{
+  NS_LOG_FUNCTION (this << (uint16_t) txq);
+  //
+  // Send transmits right away a packet received while the transmitter is
+  // ready, then stops the transmit queue as soon as it cannot be sure to
+  // hold one more packet. Hence, all the packets counted here are accepted
+  // and the queue is stopped, if ever, by the last one.
+  //
+  uint32_t budget = m_txMachineState == READY ? 1 : 0;
+  uint32_t waitingBytes;
+  uint32_t waiting = GetNBurstWaiting (waitingBytes);
+  if (m_queue->GetMode () == Queue::QUEUE_MODE_PACKETS)
+    {
+      uint32_t queued = m_queue->GetNPackets () + waiting;
+      budget += m_queue->GetMaxPackets () - std::min (queued, m_queue->GetMaxPackets ());
+    }
+  else
+    {
+      PppHeader ppp;
+      uint32_t queued = m_queue->GetNBytes () + waitingBytes;
+      budget += (m_queue->GetMaxBytes () - std::min (queued, m_queue->GetMaxBytes ()))
+        / (m_mtu + ppp.GetSerializedSize ());
+    }
+  return budget;
+}
+
 void
 PointToPointNetDevice::TransmitComplete (void)
 {
@@ -298,6 +469,12 @@ PointToPointNetDevice::TransmitComplete (void)
 
   m_phyTxEndTrace (m_currentPkt);
   m_currentPkt = 0;
+  for (std::vector<Ptr<Packet> >::const_iterator it = m_burst.begin (); it != m_burst.end (); ++it)
+    {
+      m_phyTxEndTrace (*it);
+    }
+  m_burst.clear ();
+  m_burstStart.clear ();
 
   Ptr<NetDeviceQueue> txq;
   if (m_queueInterface)
@@ -325,18 +502,7 @@ PointToPointNetDevice::TransmitComplete (void)
   // to the device while the machine state is busy, thus causing the assert in
   // TransmitStart to fail.
   //
-  if (txq && txq->IsStopped ())
-    {
-      if ((m_queue->GetMode () == Queue::QUEUE_MODE_PACKETS &&
-           m_queue->GetNPackets () < m_queue->GetMaxPackets ()) ||
-          (m_queue->GetMode () == Queue::QUEUE_MODE_BYTES &&
-           m_queue->GetNBytes () + m_mtu <= m_queue->GetMaxBytes ()))
-        {
-          NS_LOG_DEBUG ("The device queue is being started (" << m_queue->GetNPackets () <<
-                        " packets and " << m_queue->GetNBytes () << " bytes inside)");
-          txq->Start ();
-        }
-    }
+  RestartTxQueue ();
   Ptr<Packet> p = item->GetPacket ();
   m_snifferTrace (p);
   m_promiscSnifferTrace (p);
@@ -636,14 +802,14 @@ PointToPointNetDevice::Send (
       // we stop the queue
       if (txq)
         {
-          if ((m_queue->GetMode () == Queue::QUEUE_MODE_PACKETS &&
-               m_queue->GetNPackets () >= m_queue->GetMaxPackets ()) ||
-              (m_queue->GetMode () == Queue::QUEUE_MODE_BYTES &&
-               m_queue->GetNBytes () + m_mtu > m_queue->GetMaxBytes ()))
+          if (!HasTxRoom ())
             {
               NS_LOG_DEBUG ("The device queue is being stopped (" << m_queue->GetNPackets () <<
                             " packets and " << m_queue->GetNBytes () << " bytes inside)");
               txq->Stop ();
+              // started again when a packet of the current burst, if any,
+              // leaves the queue, or else by TransmitComplete
+              RestartTxQueue ();
             }
         }
       return true;
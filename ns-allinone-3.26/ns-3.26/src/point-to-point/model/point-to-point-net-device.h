@@ -20,6 +20,7 @@
 #define POINT_TO_POINT_NET_DEVICE_H
 
 #include <cstring>
+#include <vector>
 #include "ns3/address.h"
 #include "ns3/node.h"
 #include "ns3/net-device.h"
@@ -27,6 +28,7 @@
 #include "ns3/packet.h"
 #include "ns3/traced-callback.h"
 #include "ns3/nstime.h"
+#include "ns3/event-id.h"
 #include "ns3/data-rate.h"
 #include "ns3/ptr.h"
 #include "ns3/mac48-address.h"
@@ -262,6 +264,15 @@ private:
    * started sending signals.  An event is scheduled for the time at which
    * the bits have been completely transmitted.
    *
+   * If the MaxTxBurst attribute is larger than one, up to MaxTxBurst - 1
+   * packets waiting in the transmit queue are sent right after this one,
+   * back to back, and the event is scheduled at the end of the burst.  The
+   * channel schedules the reception of every packet of the burst at the
+   * same time as if they were sent one by one; the PhyTxBegin and sniffer
+   * traces of the burst are fired when it starts, the PhyTxEnd traces when
+   * it ends.  Since the transmit queue is drained earlier, the upper layers
+   * see it shorter, by at most one burst, than with MaxTxBurst set to one.
+   *
    * \see PointToPointChannel::TransmitStart ()
    * \see TransmitComplete()
    * \param p a reference to the packet to send
@@ -269,6 +280,54 @@ private:
    */
   bool TransmitStart (Ptr<Packet> p);
 
+  /**
+   * Get the time the bits of a packet take to be sent on the wire.
+   *
+   * A TCP super-segment, which carries a SegmentationTag, is sent as the
+   * segments it stands for: every segment carries the headers of the
+   * packet, and the segments are separated by the interframe gap.
+   *
+   * \param p the packet
+   * 
+eturns the transmission time of the packet
+   */
+  Time GetTxTime (Ptr<const Packet> p) const;
+
+  /**
+   * Start the device transmission queue if it was stopped and the transmit
+   * queue has room for another packet.  If the room is taken by packets of
+   * the current burst, try again when the next of them starts its
+   * transmission.
+   */
+  void RestartTxQueue (void);
+
+  /**
+   * Get the packets of the current burst whose transmission has not started
+   * yet.  They are still counted in the transmit queue, so that the upper
+   * layers see the same occupancy as if the burst was sent packet by packet.
+   *
+   * \param bytes the size of these packets
+   * \return the number of these packets
+   */
+  uint32_t GetNBurstWaiting (uint32_t &bytes) const;
+
+  /**
+   * \return true if the transmit queue, counting the packets of the current
+   *         burst whose transmission has not started, has room for another
+   *         packet
+   */
+  bool HasTxRoom (void) const;
+
+  /**
+   * Get the number of packets that can be sent to this device before the
+   * device transmission queue is stopped.
+   *
+   * \param txq the index of the device transmission queue
+   * \return the transmit budget of the device
+   * \see NetDeviceQueueInterface::SetTxBudgetCallback
+   */
+  uint32_t GetTxBudget (uint8_t txq);
+
   /**
    * Stop Sending a Packet Down the Wire and Begin the Interframe Gap.
    *
@@ -309,6 +368,12 @@ private:
    */
   Time           m_tInterframeGap;
 
+  /**
+   * The maximum number of packets sent back to back with a single transmit
+   * complete event
+   */
+  uint32_t       m_maxTxBurst;
+
   /**
    * The PointToPointChannel to which this PointToPointNetDevice has been
    * attached.
@@ -459,6 +524,9 @@ private:
   uint32_t m_mtu;
 
   Ptr<Packet> m_currentPkt; //!< Current packet processed
+  std::vector<Ptr<Packet> > m_burst; //!< Packets sent after the current one in the same burst
+  std::vector<Time> m_burstStart;    //!< Transmission start of the packets of the burst
+  EventId m_restartEvent;            //!< Restart of the transmission queue during a burst
 
   /**
    * \brief PPP to Ethernet protocol number mapping
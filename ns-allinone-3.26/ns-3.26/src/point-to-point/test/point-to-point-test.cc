@@ -23,6 +23,16 @@
 #include "ns3/simulator.h"
 #include "ns3/point-to-point-net-device.h"
 #include "ns3/point-to-point-channel.h"
+#include "ns3/point-to-point-remote-channel.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/topology-partition-helper.h"
+#include "ns3/node-container.h"
+#include "ns3/channel-list.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/data-rate.h"
+#include "ns3/segmentation-tag.h"
+#include <vector>
 
 using namespace ns3;
 
@@ -100,6 +110,550 @@ PointToPointTest::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \brief Test class for the transmit bursts of PointToPointNetDevice
+ *
+ * It sends packets of different sizes with MaxTxBurst set to one and to
+ * four, and checks that the packets are received at the same times while
+ * the bursts need fewer transmit complete events. It also checks the
+ * transmit budget advertised by the device.
+ */
+class PointToPointBurstTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointBurstTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send packets of different sizes to the device specified
+   *
+   * \param device NetDevice to send to
+   * \param iface the queue interface of the device
+   */
+  void SendPackets (Ptr<PointToPointNetDevice> device, Ptr<NetDeviceQueueInterface> iface);
+
+  /**
+   * \brief Record the reception time of a packet
+   *
+   * \param device the receiving device
+   * \param p the packet
+   * \param protocol the protocol number
+   * \param from the sender address
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+
+  /**
+   * \brief Record the time a packet has been completely transmitted
+   *
+   * \param p the packet
+   */
+  void TxEnd (Ptr<const Packet> p);
+
+  /**
+   * \brief Run a simulation sending the packets
+   *
+   * \param maxTxBurst the MaxTxBurst attribute of the sender
+   */
+  void RunOnce (uint32_t maxTxBurst);
+
+  std::vector<Time> m_rxTimes;  //!< Reception times of the packets
+  std::vector<Time> m_txEnds;   //!< Distinct times of the PhyTxEnd traces
+};
+
+PointToPointBurstTest::PointToPointBurstTest ()
+  : TestCase ("PointToPointBurst")
+{
+}
+
+void
+PointToPointBurstTest::SendPackets (Ptr<PointToPointNetDevice> device, Ptr<NetDeviceQueueInterface> iface)
+{
+  NS_TEST_EXPECT_MSG_EQ (iface->GetTxBudget (0), 101, "An idle device takes a full queue and one packet");
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (100 + 50 * i);
+      device->Send (p, device->GetBroadcast (), 0x800);
+    }
+  uint32_t queued = device->GetQueue ()->GetNPackets ();
+  NS_TEST_EXPECT_MSG_EQ (iface->GetTxBudget (0), 100 - queued, "A busy device takes the room left");
+}
+
+bool
+PointToPointBurstTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from)
+{
+  m_rxTimes.push_back (Simulator::Now ());
+  return true;
+}
+
+void
+PointToPointBurstTest::TxEnd (Ptr<const Packet> p)
+{
+  if (m_txEnds.empty () || m_txEnds.back () != Simulator::Now ())
+    {
+      m_txEnds.push_back (Simulator::Now ());
+    }
+}
+
+void
+PointToPointBurstTest::RunOnce (uint32_t maxTxBurst)
+{
+  m_rxTimes.clear ();
+  m_txEnds.clear ();
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+  channel->SetAttribute ("Delay", StringValue ("10us"));
+
+  devA->SetDataRate (DataRate ("1Gbps"));
+  devA->SetInterframeGap (NanoSeconds (96));
+  devA->SetAttribute ("MaxTxBurst", UintegerValue (maxTxBurst));
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue> ());
+  devB->Attach (channel);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue> ());
+
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+
+  Ptr<NetDeviceQueueInterface> ifaceA = CreateObject<NetDeviceQueueInterface> ();
+  devA->AggregateObject (ifaceA);
+  ifaceA->CreateTxQueues ();
+
+  devB->SetReceiveCallback (MakeCallback (&PointToPointBurstTest::Receive, this));
+  devA->TraceConnectWithoutContext ("PhyTxEnd", MakeCallback (&PointToPointBurstTest::TxEnd, this));
+
+  Simulator::Schedule (Seconds (1.0), &PointToPointBurstTest::SendPackets, this, devA, ifaceA);
+
+  Simulator::Run ();
+
+  Simulator::Destroy ();
+}
+
+void
+PointToPointBurstTest::DoRun (void)
+{
+  RunOnce (1);
+  std::vector<Time> rxTimes = m_rxTimes;
+  NS_TEST_ASSERT_MSG_EQ (rxTimes.size (), 10, "Packets lost without bursts");
+  NS_TEST_EXPECT_MSG_EQ (m_txEnds.size (), 10, "One transmit complete event per packet expected");
+
+  // the first packet is sent alone, the other nine in bursts of four
+  RunOnce (4);
+  NS_TEST_ASSERT_MSG_EQ (m_rxTimes.size (), 10, "Packets lost with bursts");
+  NS_TEST_EXPECT_MSG_EQ (m_txEnds.size (), 4, "One transmit complete event per burst expected");
+  for (uint32_t i = 0; i < rxTimes.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_rxTimes[i], rxTimes[i], "Packet " << i << " received at a different time");
+    }
+}
+
+/**
+ * \brief Test class for the occupancy of a device sending bursts
+ *
+ * A feeder stands for a queue disc: it holds packets and, at regular
+ * times, hands the device as many as its transmit budget allows while
+ * the device transmission queue is not stopped.  With a small transmit
+ * queue, the device queue is stopped most of the time.  The test checks
+ * that, with MaxTxBurst set to four, the feeder sees the same budget and
+ * keeps the same packets as with MaxTxBurst set to one, so that a queue
+ * disc marks and drops the same packets.
+ */
+class PointToPointBurstOccupancyTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointBurstOccupancyTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Hand packets to the device and record what the feeder sees
+   *
+   * \param device the device
+   * \param iface the queue interface of the device
+   */
+  void Feed (Ptr<PointToPointNetDevice> device, Ptr<NetDeviceQueueInterface> iface);
+
+  /**
+   * \brief Record the reception time of a packet
+   *
+   * \param device the receiving device
+   * \param p the packet
+   * \param protocol the protocol number
+   * \param from the sender address
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+
+  /**
+   * \brief Run a simulation feeding the packets
+   *
+   * \param maxTxBurst the MaxTxBurst attribute of the sender
+   */
+  void RunOnce (uint32_t maxTxBurst);
+
+  uint32_t m_held;                  //!< Packets held by the feeder
+  uint32_t m_sent;                  //!< Packets handed to the device
+  std::vector<uint32_t> m_samples;  //!< Budget and packets held at each feeding time
+  std::vector<Time> m_rxTimes;      //!< Reception times of the packets
+};
+
+PointToPointBurstOccupancyTest::PointToPointBurstOccupancyTest ()
+  : TestCase ("PointToPointBurstOccupancy"),
+    m_held (0),
+    m_sent (0)
+{
+}
+
+void
+PointToPointBurstOccupancyTest::Feed (Ptr<PointToPointNetDevice> device, Ptr<NetDeviceQueueInterface> iface)
+{
+  // two packets arrive at the feeder every time
+  m_held += 2;
+  Ptr<NetDeviceQueue> txq = iface->GetTxQueue (0);
+  uint32_t budget = txq->IsStopped () ? 0 : iface->GetTxBudget (0);
+  m_samples.push_back (budget);
+  for (uint32_t i = 0; i < budget && m_held > 0 && !txq->IsStopped (); i++)
+    {
+      device->Send (Create<Packet> (100 + 50 * (m_sent % 10)), device->GetBroadcast (), 0x800);
+      m_held--;
+      m_sent++;
+    }
+  m_samples.push_back (m_held);
+  if (m_sent < 60)
+    {
+      Simulator::Schedule (NanoSeconds (1117), &PointToPointBurstOccupancyTest::Feed, this, device, iface);
+    }
+}
+
+bool
+PointToPointBurstOccupancyTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from)
+{
+  m_rxTimes.push_back (Simulator::Now ());
+  return true;
+}
+
+void
+PointToPointBurstOccupancyTest::RunOnce (uint32_t maxTxBurst)
+{
+  m_held = 0;
+  m_sent = 0;
+  m_samples.clear ();
+  m_rxTimes.clear ();
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+  channel->SetAttribute ("Delay", StringValue ("10us"));
+
+  devA->SetDataRate (DataRate ("1Gbps"));
+  devA->SetInterframeGap (NanoSeconds (96));
+  devA->SetAttribute ("MaxTxBurst", UintegerValue (maxTxBurst));
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address::Allocate ());
+  Ptr<DropTailQueue> queue = CreateObject<DropTailQueue> ();
+  queue->SetAttribute ("MaxPackets", UintegerValue (4));
+  devA->SetQueue (queue);
+  devB->Attach (channel);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue> ());
+
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+
+  Ptr<NetDeviceQueueInterface> ifaceA = CreateObject<NetDeviceQueueInterface> ();
+  devA->AggregateObject (ifaceA);
+  ifaceA->CreateTxQueues ();
+
+  devB->SetReceiveCallback (MakeCallback (&PointToPointBurstOccupancyTest::Receive, this));
+
+  Simulator::Schedule (Seconds (1.0), &PointToPointBurstOccupancyTest::Feed, this, devA, ifaceA);
+
+  Simulator::Run ();
+
+  Simulator::Destroy ();
+}
+
+void
+PointToPointBurstOccupancyTest::DoRun (void)
+{
+  RunOnce (1);
+  std::vector<uint32_t> samples = m_samples;
+  std::vector<Time> rxTimes = m_rxTimes;
+  NS_TEST_ASSERT_MSG_EQ (rxTimes.size (), m_sent, "Packets lost without bursts");
+
+  RunOnce (4);
+  NS_TEST_ASSERT_MSG_EQ (m_rxTimes.size (), rxTimes.size (), "Packets lost with bursts");
+  NS_TEST_ASSERT_MSG_EQ (m_samples.size (), samples.size (), "Fed a different number of times");
+  for (uint32_t i = 0; i < samples.size (); i += 2)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_samples[i], samples[i], "Different budget at feeding " << i / 2);
+      NS_TEST_EXPECT_MSG_EQ (m_samples[i + 1], samples[i + 1], "Different packets held at feeding " << i / 2);
+    }
+  for (uint32_t i = 0; i < rxTimes.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_rxTimes[i], rxTimes[i], "Packet " << i << " received at a different time");
+    }
+}
+
+/**
+ * \brief Test class for the super-segments sent by PointToPointNetDevice
+ *
+ * It sends a super-segment of four segments, then the four segments one
+ * by one, and checks that the super-segment is received when the last
+ * segment would be, and that the transmit queue counts it as four packets.
+ */
+class PointToPointSuperSegmentTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  PointToPointSuperSegmentTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Send a busy packet, then the segments to the device specified
+   *
+   * \param device NetDevice to send to
+   * \param superSegment whether to send the segments as one super-segment
+   */
+  void SendSegments (Ptr<PointToPointNetDevice> device, bool superSegment);
+
+  /**
+   * \brief Record the reception time of a packet
+   *
+   * \param device the receiving device
+   * \param p the packet
+   * \param protocol the protocol number
+   * \param from the sender address
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from);
+
+  /**
+   * \brief Run a simulation sending the segments
+   *
+   * \param superSegment whether to send the segments as one super-segment
+   */
+  void RunOnce (bool superSegment);
+
+  std::vector<Time> m_rxTimes;  //!< Reception times of the packets
+  uint32_t m_queued;            //!< Packets in the transmit queue after the segments
+};
+
+PointToPointSuperSegmentTest::PointToPointSuperSegmentTest ()
+  : TestCase ("PointToPointSuperSegment"),
+    m_queued (0)
+{
+}
+
+void
+PointToPointSuperSegmentTest::SendSegments (Ptr<PointToPointNetDevice> device, bool superSegment)
+{
+  // 40 bytes of headers and 100 bytes of payload per segment
+  device->Send (Create<Packet> (140), device->GetBroadcast (), 0x800);
+  if (superSegment)
+    {
+      Ptr<Packet> p = Create<Packet> (40 + 4 * 100);
+      p->AddPacketTag (SegmentationTag (100, 4 * 100));
+      device->Send (p, device->GetBroadcast (), 0x800);
+    }
+  else
+    {
+      for (uint32_t i = 0; i < 4; i++)
+        {
+          device->Send (Create<Packet> (140), device->GetBroadcast (), 0x800);
+        }
+    }
+  m_queued = device->GetQueue ()->GetNPackets ();
+}
+
+bool
+PointToPointSuperSegmentTest::Receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from)
+{
+  m_rxTimes.push_back (Simulator::Now ());
+  return true;
+}
+
+void
+PointToPointSuperSegmentTest::RunOnce (bool superSegment)
+{
+  m_rxTimes.clear ();
+  Ptr<Node> a = CreateObject<Node> ();
+  Ptr<Node> b = CreateObject<Node> ();
+  Ptr<PointToPointNetDevice> devA = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointNetDevice> devB = CreateObject<PointToPointNetDevice> ();
+  Ptr<PointToPointChannel> channel = CreateObject<PointToPointChannel> ();
+  channel->SetAttribute ("Delay", StringValue ("10us"));
+
+  devA->SetDataRate (DataRate ("1Gbps"));
+  devA->SetInterframeGap (NanoSeconds (96));
+  devA->Attach (channel);
+  devA->SetAddress (Mac48Address::Allocate ());
+  devA->SetQueue (CreateObject<DropTailQueue> ());
+  devB->Attach (channel);
+  devB->SetAddress (Mac48Address::Allocate ());
+  devB->SetQueue (CreateObject<DropTailQueue> ());
+
+  a->AddDevice (devA);
+  b->AddDevice (devB);
+
+  devB->SetReceiveCallback (MakeCallback (&PointToPointSuperSegmentTest::Receive, this));
+  if (superSegment)
+    {
+      SegmentationTag::Enable ();
+    }
+
+  Simulator::Schedule (Seconds (1.0), &PointToPointSuperSegmentTest::SendSegments, this, devA, superSegment);
+
+  Simulator::Run ();
+
+  Simulator::Destroy ();
+}
+
+void
+PointToPointSuperSegmentTest::DoRun (void)
+{
+  RunOnce (false);
+  NS_TEST_ASSERT_MSG_EQ (m_rxTimes.size (), 5, "Segments lost");
+  NS_TEST_EXPECT_MSG_EQ (m_queued, 4, "The segments should wait in the queue");
+  Time lastSegment = m_rxTimes.back ();
+
+  RunOnce (true);
+  NS_TEST_ASSERT_MSG_EQ (m_rxTimes.size (), 2, "Super-segment lost");
+  NS_TEST_EXPECT_MSG_EQ (m_queued, 4, "The super-segment should count as four packets");
+  // the transmission times are rounded once per packet
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_rxTimes.back (), lastSegment, NanoSeconds (4),
+                             "The super-segment should take the time of its segments");
+  NS_TEST_EXPECT_MSG_EQ (SegmentationTag::IsEnabled (), false, "Offload should end with the simulation");
+}
+
+/**
+ * \brief Test class for TopologyPartitionHelper
+ *
+ * It partitions two rings joined by slow links, then a single ring,
+ * and checks the cut links, the lookahead and the rewiring of the cut
+ * links to PointToPointRemoteChannel.
+ */
+class TopologyPartitionTest : public TestCase
+{
+public:
+  /**
+   * \brief Create the test
+   */
+  TopologyPartitionTest ();
+
+  /**
+   * \brief Run the test
+   */
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \brief Join consecutive nodes, and the last one to the first
+   *
+   * \param nodes The nodes of the ring
+   * \param delay The delay of the links
+   * \return The devices, two per link
+   */
+  NetDeviceContainer MakeRing (NodeContainer nodes, std::string delay);
+};
+
+TopologyPartitionTest::TopologyPartitionTest ()
+  : TestCase ("TopologyPartition")
+{
+}
+
+NetDeviceContainer
+TopologyPartitionTest::MakeRing (NodeContainer nodes, std::string delay)
+{
+  PointToPointHelper p2p;
+  p2p.SetChannelAttribute ("Delay", StringValue (delay));
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < nodes.GetN (); ++i)
+    {
+      devices.Add (p2p.Install (nodes.Get (i), nodes.Get ((i + 1) % nodes.GetN ())));
+    }
+  return devices;
+}
+
+void
+TopologyPartitionTest::DoRun (void)
+{
+  NodeContainer left;
+  left.Create (8);
+  NodeContainer right;
+  right.Create (8);
+  MakeRing (left, "10us");
+  MakeRing (right, "10us");
+  PointToPointHelper p2p;
+  p2p.SetChannelAttribute ("Delay", StringValue ("5ms"));
+  NetDeviceContainer bridge = p2p.Install (left.Get (0), right.Get (0));
+  p2p.Install (left.Get (4), right.Get (4));
+
+  TopologyPartitionHelper partitioner;
+  partitioner.Partition (2);
+  NS_TEST_ASSERT_MSG_EQ (partitioner.GetNPartitions (), 2, "Wrong number of partitions");
+  NS_TEST_EXPECT_MSG_EQ (partitioner.GetNCutLinks (), 2, "Only the slow links should be cut");
+  NS_TEST_EXPECT_MSG_EQ (partitioner.GetLookahead (), MilliSeconds (5), "Wrong lookahead");
+  for (uint32_t i = 0; i < 8; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (partitioner.GetPartition (left.Get (i)->GetId ()), 0, "Left ring split");
+      NS_TEST_EXPECT_MSG_EQ (partitioner.GetPartition (right.Get (i)->GetId ()), 1, "Right ring split");
+    }
+
+  // splitting in four cannot keep the 5ms lookahead.
+  partitioner.Partition (4);
+  NS_TEST_EXPECT_MSG_EQ (partitioner.GetNPartitions (), 4, "Wrong number of partitions");
+  NS_TEST_EXPECT_MSG_EQ (partitioner.GetLookahead (), MicroSeconds (10), "Wrong lookahead");
+  NS_TEST_EXPECT_MSG_EQ (partitioner.GetNCutLinks (), 6, "Each ring should be cut in two arcs");
+
+  // without MPI, the cut links cannot be remote
+  partitioner.Partition (2);
+  uint32_t nChannels = ChannelList::GetNChannels ();
+  partitioner.Apply ();
+  NS_TEST_EXPECT_MSG_EQ (right.Get (3)->GetSystemId (), 1, "SystemId not set");
+  NS_TEST_EXPECT_MSG_EQ (DynamicCast<PointToPointRemoteChannel> (bridge.Get (0)->GetChannel ()), 0,
+                         "A cut link should stay local without MPI");
+  NS_TEST_EXPECT_MSG_EQ (ChannelList::GetNChannels (), nChannels, "Channels should not be added");
+
+  // what Apply does with MPI: the remote channel takes the place of the old one
+  Ptr<Channel> old = bridge.Get (0)->GetChannel ();
+  Ptr<Channel> remote = CreateObject<PointToPointRemoteChannel> ();
+  ChannelList::Replace (old, remote);
+  NS_TEST_EXPECT_MSG_EQ (ChannelList::GetNChannels (), nChannels, "The old channel should leave the list");
+  NS_TEST_EXPECT_MSG_EQ (remote->GetId (), old->GetId (), "The remote channel should take the old id");
+  NS_TEST_EXPECT_MSG_EQ (ChannelList::GetChannel (old->GetId ()), remote, "The remote channel is not in the list");
+
+  Simulator::Destroy ();
+}
+
 /**
  * \brief TestSuite for PointToPoint module
  */
@@ -116,6 +670,10 @@ PointToPointTestSuite::PointToPointTestSuite ()
   : TestSuite ("devices-point-to-point", UNIT)
 {
   AddTestCase (new PointToPointTest, TestCase::QUICK);
+  AddTestCase (new PointToPointBurstTest, TestCase::QUICK);
+  AddTestCase (new PointToPointBurstOccupancyTest, TestCase::QUICK);
+  AddTestCase (new PointToPointSuperSegmentTest, TestCase::QUICK);
+  AddTestCase (new TopologyPartitionTest, TestCase::QUICK);
 }
 
 static PointToPointTestSuite g_pointToPointTestSuite; //!< The testsuite
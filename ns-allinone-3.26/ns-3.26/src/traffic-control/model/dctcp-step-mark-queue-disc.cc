@@ -0,0 +1,301 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/object-factory.h"
+#include "ns3/drop-tail-queue.h"
+#include "dctcp-step-mark-queue-disc.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("DctcpStepMarkQueueDisc");
+
+NS_OBJECT_ENSURE_REGISTERED (DctcpStepMarkQueueDisc);
+
+TypeId DctcpStepMarkQueueDisc::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DctcpStepMarkQueueDisc")
+    .SetParent<QueueDisc> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<DctcpStepMarkQueueDisc> ()
+    .AddAttribute ("Mode",
+                   "Determines unit for QueueLimit and MarkThreshold",
+                   EnumValue (Queue::QUEUE_MODE_PACKETS),
+                   MakeEnumAccessor (&DctcpStepMarkQueueDisc::SetMode),
+                   MakeEnumChecker (Queue::QUEUE_MODE_BYTES, "QUEUE_MODE_BYTES",
+                                    Queue::QUEUE_MODE_PACKETS, "QUEUE_MODE_PACKETS"))
+    .AddAttribute ("QueueLimit",
+                   "Queue limit in bytes/packets",
+                   UintegerValue (100),
+                   MakeUintegerAccessor (&DctcpStepMarkQueueDisc::SetQueueLimit),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MarkThreshold",
+                   "Packets arriving when the queue holds this many bytes/packets or more are marked",
+                   UintegerValue (20),
+                   MakeUintegerAccessor (&DctcpStepMarkQueueDisc::m_markThreshold),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("MeanPktSize",
+                   "Average of packet size, to count the fluid backlog in packets",
+                   UintegerValue (500),
+                   MakeUintegerAccessor (&DctcpStepMarkQueueDisc::m_meanPktSize),
+                   MakeUintegerChecker<uint32_t> (1))
+  ;
+
+  return tid;
+}
+
+DctcpStepMarkQueueDisc::DctcpStepMarkQueueDisc ()
+  : QueueDisc ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+DctcpStepMarkQueueDisc::~DctcpStepMarkQueueDisc ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+DctcpStepMarkQueueDisc::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  QueueDisc::DoDispose ();
+}
+
+void
+DctcpStepMarkQueueDisc::SetMode (Queue::QueueMode mode)
+{
+  NS_LOG_FUNCTION (this << mode);
+  m_mode = mode;
+}
+
+Queue::QueueMode
+DctcpStepMarkQueueDisc::GetMode (void)
+{
+  NS_LOG_FUNCTION (this);
+  return m_mode;
+}
+
+void
+DctcpStepMarkQueueDisc::SetQueueLimit (uint32_t lim)
+{
+  NS_LOG_FUNCTION (this << lim);
+  m_queueLimit = lim;
+}
+
+DctcpStepMarkQueueDisc::Stats
+DctcpStepMarkQueueDisc::GetStats ()
+{
+  NS_LOG_FUNCTION (this);
+  return m_stats;
+}
+
+uint32_t
+DctcpStepMarkQueueDisc::GetQueueSize (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_mode == Queue::QUEUE_MODE_BYTES)
+    {
+      return GetInternalQueue (0)->GetNBytes ();
+    }
+  return GetInternalQueue (0)->GetNPackets ();
+}
+
+bool
+DctcpStepMarkQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+
+  uint32_t nQueued;
+  if (m_mode == Queue::QUEUE_MODE_BYTES)
+    {
+      nQueued = GetInternalQueue (0)->GetNBytes () + GetFluidBacklog ();
+      if (nQueued + item->GetPacketSize () > m_queueLimit)
+        {
+          NS_LOG_DEBUG ("\t Dropping due to Queue Full " << nQueued);
+          m_stats.qLimDrop++;
+          Drop (item);
+          return false;
+        }
+    }
+  else
+    {
+      // count the fluid backlog in packets of the mean size, whatever
+      // the size of the packet arriving
+      nQueued = GetInternalQueue (0)->GetNPackets () + GetFluidBacklog () / m_meanPktSize;
+      if (nQueued + item->GetSegmentCount () > m_queueLimit)
+        {
+          NS_LOG_DEBUG ("\t Dropping due to Queue Full " << nQueued);
+          m_stats.qLimDrop++;
+          Drop (item);
+          return false;
+        }
+    }
+
+  uint32_t segments = item->GetSegmentCount ();
+  if (segments > 1)
+    {
+      // mark the wire segments of a super-segment that find the queue
+      // above the threshold, as if they were enqueued one by one
+      uint32_t segmentSize = m_mode == Queue::QUEUE_MODE_BYTES ? item->GetPacketSize () / segments : 1;
+      for (uint32_t i = 0; i < segments; i++)
+        {
+          if (nQueued + i * segmentSize < m_markThreshold)
+            {
+              continue;
+            }
+          if (!item->MarkSegment (i))
+            {
+              NS_LOG_DEBUG ("\t Dropping an unmarkable super-segment " << nQueued);
+              m_stats.unmarkableDrops++;
+              Drop (item);
+              return false;
+            }
+          m_stats.marks++;
+        }
+    }
+  else if (nQueued >= m_markThreshold)
+    {
+      if (!item->Mark ())
+        {
+          NS_LOG_DEBUG ("\t Dropping an unmarkable packet " << nQueued);
+          m_stats.unmarkableDrops++;
+          Drop (item);
+          return false;
+        }
+      NS_LOG_DEBUG ("\t Marking " << nQueued);
+      m_stats.marks++;
+    }
+
+  bool retval = GetInternalQueue (0)->Enqueue (item);
+
+  if (!retval)
+    {
+      m_stats.qLimDrop++;
+    }
+
+  // If Queue::Enqueue fails, QueueDisc::Drop is called by the internal queue
+  // because QueueDisc::AddInternalQueue sets the drop callback
+
+  NS_LOG_LOGIC ("Number packets " << GetInternalQueue (0)->GetNPackets ());
+  NS_LOG_LOGIC ("Number bytes " << GetInternalQueue (0)->GetNBytes ());
+
+  return retval;
+}
+
+Ptr<QueueDiscItem>
+DctcpStepMarkQueueDisc::DoDequeue (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (GetInternalQueue (0)->IsEmpty ())
+    {
+      NS_LOG_LOGIC ("Queue empty");
+      return 0;
+    }
+
+  Ptr<QueueDiscItem> item = StaticCast<QueueDiscItem> (GetInternalQueue (0)->Dequeue ());
+
+  NS_LOG_LOGIC ("Popped " << item);
+  NS_LOG_LOGIC ("Number packets " << GetInternalQueue (0)->GetNPackets ());
+  NS_LOG_LOGIC ("Number bytes " << GetInternalQueue (0)->GetNBytes ());
+
+  return item;
+}
+
+Ptr<const QueueDiscItem>
+DctcpStepMarkQueueDisc::DoPeek (void) const
+{
+  NS_LOG_FUNCTION (this);
+  if (GetInternalQueue (0)->IsEmpty ())
+    {
+      NS_LOG_LOGIC ("Queue empty");
+      return 0;
+    }
+
+  Ptr<const QueueDiscItem> item = StaticCast<const QueueDiscItem> (GetInternalQueue (0)->Peek ());
+
+  NS_LOG_LOGIC ("Number packets " << GetInternalQueue (0)->GetNPackets ());
+  NS_LOG_LOGIC ("Number bytes " << GetInternalQueue (0)->GetNBytes ());
+
+  return item;
+}
+
+bool
+DctcpStepMarkQueueDisc::CheckConfig (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (GetNQueueDiscClasses () > 0)
+    {
+      NS_LOG_ERROR ("DctcpStepMarkQueueDisc cannot have classes");
+      return false;
+    }
+
+  if (GetNPacketFilters () > 0)
+    {
+      NS_LOG_ERROR ("DctcpStepMarkQueueDisc cannot have packet filters");
+      return false;
+    }
+
+  if (GetNInternalQueues () == 0)
+    {
+      // create a DropTail queue
+      Ptr<Queue> queue = CreateObjectWithAttributes<DropTailQueue> ("Mode", EnumValue (m_mode));
+      if (m_mode == Queue::QUEUE_MODE_PACKETS)
+        {
+          queue->SetMaxPackets (m_queueLimit);
+        }
+      else
+        {
+          queue->SetMaxBytes (m_queueLimit);
+        }
+      AddInternalQueue (queue);
+    }
+
+  if (GetNInternalQueues () != 1)
+    {
+      NS_LOG_ERROR ("DctcpStepMarkQueueDisc needs 1 internal queue");
+      return false;
+    }
+
+  if (GetInternalQueue (0)->GetMode () != m_mode)
+    {
+      NS_LOG_ERROR ("The mode of the provided queue does not match the mode set on the DctcpStepMarkQueueDisc");
+      return false;
+    }
+
+  if ((m_mode ==  Queue::QUEUE_MODE_PACKETS && GetInternalQueue (0)->GetMaxPackets () < m_queueLimit) ||
+      (m_mode ==  Queue::QUEUE_MODE_BYTES && GetInternalQueue (0)->GetMaxBytes () < m_queueLimit))
+    {
+      NS_LOG_ERROR ("The size of the internal queue is less than the queue disc limit");
+      return false;
+    }
+
+  return true;
+}
+
+void
+DctcpStepMarkQueueDisc::InitializeParams (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_stats.marks = 0;
+  m_stats.unmarkableDrops = 0;
+  m_stats.qLimDrop = 0;
+}
+
+} // namespace ns3
@@ -0,0 +1,130 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DCTCP_STEP_MARK_QUEUE_DISC_H
+#define DCTCP_STEP_MARK_QUEUE_DISC_H
+
+#include "ns3/queue-disc.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief A FIFO queue disc marking packets on the instantaneous occupancy
+ *
+ * This is the marking scheme DCTCP and ATP expect from the switches: a
+ * packet arriving when the queue holds MarkThreshold packets (or bytes) or
+ * more is marked CE; a packet that cannot be marked (not ECN capable) is
+ * dropped instead, as RED does. Packets exceeding QueueLimit are dropped.
+ *
+ * RedQueueDisc configured with MinTh == MaxTh, UseMarkP and MarkP > 1
+ * marks in a similar way, but still averages the queue size and draws a
+ * random number for every packet. Here the decision is a comparison of
+ * the occupancy of the port with a threshold, with no floating point or
+ * random number work. Note that RED marks on the average queue size
+ * unless its QW attribute is set to 1.
+ *
+ * The occupancy is the one of this port only (the traffic carried by the
+ * fluid flows included), in the unit selected by the Mode attribute.
+ */
+class DctcpStepMarkQueueDisc : public QueueDisc
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief DctcpStepMarkQueueDisc Constructor
+   */
+  DctcpStepMarkQueueDisc ();
+
+  /**
+   * \brief DctcpStepMarkQueueDisc Destructor
+   */
+  virtual ~DctcpStepMarkQueueDisc ();
+
+  /**
+   * \brief Stats
+   */
+  typedef struct
+  {
+    uint32_t marks;             //!< Packets marked above the threshold
+    uint32_t unmarkableDrops;   //!< Packets dropped above the threshold because they could not be marked
+    uint32_t qLimDrop;          //!< Drops due to queue limits
+  } Stats;
+
+  /**
+   * \brief Set the operating mode of this queue.
+   *
+   * \param mode The operating mode of this queue.
+   */
+  void SetMode (Queue::QueueMode mode);
+
+  /**
+   * \brief Get the operating mode of this queue.
+   *
+   * \returns The operating mode of this queue.
+   */
+  Queue::QueueMode GetMode (void);
+
+  /**
+   * \brief Get the current occupancy of the queue in bytes or packets.
+   *
+   * \returns The queue size in bytes or packets.
+   */
+  uint32_t GetQueueSize (void);
+
+  /**
+   * \brief Set the limit of the queue in bytes or packets.
+   *
+   * \param lim The limit in bytes or packets.
+   */
+  void SetQueueLimit (uint32_t lim);
+
+  /**
+   * \brief Get the marking statistics.
+   *
+   * \returns The marking and drop statistics.
+   */
+  Stats GetStats ();
+
+protected:
+  /**
+   * \brief Dispose of the object
+   */
+  virtual void DoDispose (void);
+
+private:
+  virtual bool DoEnqueue (Ptr<QueueDiscItem> item);
+  virtual Ptr<QueueDiscItem> DoDequeue (void);
+  virtual Ptr<const QueueDiscItem> DoPeek (void) const;
+  virtual bool CheckConfig (void);
+  virtual void InitializeParams (void);
+
+  Stats m_stats;                //!< Marking statistics
+  Queue::QueueMode m_mode;      //!< Mode (bytes or packets)
+  uint32_t m_queueLimit;        //!< Queue limit in bytes / packets
+  uint32_t m_markThreshold;     //!< Marking threshold in bytes / packets
+  uint32_t m_meanPktSize;       //!< Average packet size, for the fluid backlog in packets mode
+};
+
+} // namespace ns3
+
+#endif /* DCTCP_STEP_MARK_QUEUE_DISC_H */
@@ -22,10 +22,14 @@
 
 #include "ns3/object.h"
 #include "ns3/traced-value.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
 #include <ns3/queue.h>
 #include "ns3/net-device.h"
 #include <vector>
+#include <deque>
 #include "packet-filter.h"
+#include "shared-buffer.h"
 
 namespace ns3 {
 
@@ -76,6 +80,18 @@ public:
    */
   void SetTxQueueIndex (uint8_t txq);
 
+  /**
+   * \brief Get the time before which this item cannot be dequeued
+   * \return the time the fluid queued in front of this item is drained.
+   */
+  Time GetReadyTime (void) const;
+
+  /**
+   * \brief Set the time before which this item cannot be dequeued
+   * \param ready the time the fluid queued in front of this item is drained.
+   */
+  void SetReadyTime (Time ready);
+
   /**
    * \brief Add the header to the packet
    *
@@ -98,6 +114,17 @@ public:
    */
   virtual bool Mark (void) = 0;
 
+  /**
+   * \brief Marks a wire segment of a super-segment (see SegmentationTag) as
+   * a substitute for dropping it
+   *
+   * The default implementation marks the whole packet.
+   *
+   * \param segment the index of the wire segment
+   * \return true if the segment gets marked, false otherwise
+   */
+  virtual bool MarkSegment (uint32_t segment);
+
 private:
   /**
    * \brief Default constructor
@@ -122,6 +149,7 @@ private:
   Address m_address;      //!< MAC destination address
   uint16_t m_protocol;    //!< L3 Protocol number
   uint8_t m_txq;          //!< Transmission queue index
+  Time m_ready;           //!< Time before which the item cannot be dequeued
 };
 
 
@@ -281,6 +309,52 @@ public:
    */
   uint32_t GetTotalRequeuedBytes (void) const;
 
+  /**
+   * \brief Set the amount of bytes queued by flows modeled as a fluid
+   * \param bytes the fluid backlog, in bytes.
+   *
+   * A FluidFlowModel calls this method on the queue discs of the links
+   * its flows cross.  The fluid backlog is not stored in the queue disc;
+   * queue discs which support it (RED) count it in their occupancy when
+   * they decide to mark or drop a packet.
+   */
+  void SetFluidBacklog (uint32_t bytes);
+
+  /**
+   * \brief Get the amount of bytes queued by flows modeled as a fluid
+   * \return the fluid backlog, in bytes.
+   */
+  uint32_t GetFluidBacklog (void) const;
+
+  /**
+   * \brief Set the time the link needs to drain the fluid backlog
+   * \param delay the time to drain the fluid backlog.
+   *
+   * A FluidFlowModel calls this method along with SetFluidBacklog.  The
+   * packets enqueued while the delay is positive are held in the queue disc
+   * until the fluid queued in front of them is drained, as in a FIFO.  The
+   * packets keep their order: a packet is never released before the packets
+   * enqueued ahead of it, even when the fluid backlog shrinks.
+   */
+  void SetFluidDelay (Time delay);
+
+  /**
+   * \brief Get the time the link needs to drain the fluid backlog
+   * \return the time to drain the fluid backlog.
+   */
+  Time GetFluidDelay (void) const;
+
+  /**
+   * \brief Get the buffer shared with the other ports of the node
+   * \return the shared buffer, or zero if the port has a buffer of its own.
+   *
+   * A root queue disc looks for a SharedBuffer aggregated to the node of
+   * its device when it is initialized. It then asks the shared buffer to
+   * admit every packet before enqueuing it, and reports its occupancy
+   * (its bytes plus the fluid backlog) after every change.
+   */
+  Ptr<SharedBuffer> GetSharedBuffer (void) const;
+
   /**
    * \brief Set the NetDevice on which this queue discipline is installed.
    * \param device the NetDevice on which this queue discipline is installed.
@@ -511,10 +585,17 @@ private:
 
   /**
    * Modelled after the Linux function qdisc_restart (net/sched/sch_generic.c)
-   * Dequeue a packet (by calling DequeuePacket) and send it to the device (by calling Transmit).
-   * \return true if a packet is successfully sent to the device.
+   * Dequeue a batch of packets (by calling DequeuePacket) and send them to the
+   * device (by calling Transmit). As with the bulk dequeue of Linux, the batch
+   * holds as many packets as the device advertises it can take (see
+   * NetDeviceQueueInterface::GetTxBudget), but no more than the given quota.
+   * Multi-queue devices and devices advertising no budget get one packet.
+   * \param quota the packets that can still be sent in this run; decremented
+   *        by the number of packets sent to the device.
+   * \return true if packets were sent to the device, the device queue is not
+   *         stopped and the queue disc is not empty.
    */
-  bool Restart (void);
+  bool Restart (uint32_t &quota);
 
   /**
    * Modelled after the Linux function dequeue_skb (net/sched/sch_generic.c)
@@ -524,7 +605,8 @@ private:
 
   /**
    * Modelled after the Linux function dev_requeue_skb (net/sched/sch_generic.c)
-   * Requeues a packet whose transmission failed.
+   * Requeues a packet whose transmission failed. The packet is put ahead of
+   * the packets already requeued, if any.
    * \param item the packet to requeue
    */
   void Requeue (Ptr<QueueDiscItem> item);
@@ -538,6 +620,11 @@ private:
    */
   bool Transmit (Ptr<QueueDiscItem> item);
 
+  /**
+   * Report the occupancy of this queue disc to the shared buffer, if any.
+   */
+  void UpdateSharedBuffer (void);
+
   static const uint32_t DEFAULT_QUOTA = 64; //!< Default quota (as in /proc/sys/net/core/dev_weight)
 
   std::vector<Ptr<Queue> > m_queues;            //!< Internal queues
@@ -553,12 +640,19 @@ private:
   uint32_t m_nTotalDroppedBytes;    //!< Total dropped bytes
   uint32_t m_nTotalRequeuedPackets; //!< Total requeued packets
   uint32_t m_nTotalRequeuedBytes;   //!< Total requeued bytes
+  uint32_t m_fluidBacklog;          //!< Bytes queued by fluid flows
+  Time m_fluidDelay;                //!< Time to drain the fluid backlog
+  Time m_fluidReady;                //!< Latest time an enqueued packet is held until
+  EventId m_fluidWake;              //!< Run when the held packet at the head is ready
   uint32_t m_quota;                 //!< Maximum number of packets dequeued in a qdisc run
   Ptr<NetDevice> m_device;          //!< The NetDevice on which this queue discipline is installed
   Ptr<NetDeviceQueueInterface> m_devQueueIface;   //!< NetDevice queue interface
   bool m_running;                   //!< The queue disc is performing multiple dequeue operations
-  Ptr<QueueDiscItem> m_requeued;    //!< The last packet that failed to be transmitted
+  std::deque<Ptr<QueueDiscItem> > m_requeued;   //!< The packets that failed to be transmitted
+  std::vector<Ptr<QueueDiscItem> > m_batch;     //!< The packets dequeued by Restart
   ParentDropCallback m_parentDropCallback;   //!< Parent drop callback
+  Ptr<SharedBuffer> m_sharedBuffer; //!< The buffer shared with the other ports of the node
+  uint32_t m_sharedBufferPort;      //!< The index of this port in the shared buffer
 
   /// Traced callback: fired when a packet is enqueued
   TracedCallback<Ptr<const QueueItem> > m_traceEnqueue;
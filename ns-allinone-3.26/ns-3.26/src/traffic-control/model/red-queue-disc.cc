@@ -334,10 +334,29 @@ RedQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
       nQueued = GetInternalQueue (0)->GetNPackets ();
     }
 
+  // bytes queued by fluid flows (see FluidFlowModel) share the buffer
+  uint32_t fluid = GetFluidBacklog ();
+  if (fluid > 0)
+    {
+      if (GetMode () == Queue::QUEUE_MODE_BYTES)
+        {
+          nQueued += fluid;
+        }
+      else
+        {
+          nQueued += uint32_t (fluid / m_meanPktSize);
+        }
+    }
+
   // simulate number of packets arrival during idle period
   uint32_t m = 0;
 
-  if (m_idle == 1)
+  if (m_idle == 1 && fluid > 0)
+    {
+      // the link was kept busy by the fluid flows
+      m_idle = 0;
+    }
+  else if (m_idle == 1)
     {
       NS_LOG_DEBUG ("RED Queue Disc is idle.");
       Time now = Simulator::Now ();
@@ -355,50 +374,58 @@ RedQueueDisc::DoEnqueue (Ptr<QueueDiscItem> item)
       m_idle = 0;
     }
 
-  m_qAvg = Estimator (nQueued, m + 1, m_qAvg, m_qW);
+  // the wire segments of a super-segment arrive one after the other
+  uint32_t segments = item->GetSegmentCount ();
+  uint32_t segmentSize = item->GetPacketSize () / segments;
+  uint32_t growth = GetMode () == Queue::QUEUE_MODE_BYTES ? segmentSize : 1;
+  uint32_t dropType = DTYPE_NONE;
+  for (uint32_t segment = 0; segment < segments && dropType == DTYPE_NONE; segment++)
+    {
+      uint32_t qSize = nQueued + segment * growth;
+      m_qAvg = Estimator (qSize, segment == 0 ? m + 1 : 1, m_qAvg, m_qW);
 
-  NS_LOG_DEBUG ("\t bytesInQueue  " << GetInternalQueue (0)->GetNBytes () << "\tQavg " << m_qAvg);
-  NS_LOG_DEBUG ("\t packetsInQueue  " << GetInternalQueue (0)->GetNPackets () << "\tQavg " << m_qAvg);
+      NS_LOG_DEBUG ("\t bytesInQueue  " << GetInternalQueue (0)->GetNBytes () << "\tQavg " << m_qAvg);
+      NS_LOG_DEBUG ("\t packetsInQueue  " << GetInternalQueue (0)->GetNPackets () << "\tQavg " << m_qAvg);
 
-  m_count++;
-  m_countBytes += item->GetPacketSize ();
+      m_count++;
+      m_countBytes += segmentSize;
 
-  uint32_t dropType = DTYPE_NONE;
-  if (m_qAvg >= m_minTh && nQueued > 1)
-    {
-      if (!m_useMarkP &&
-          ((!m_isGentle && m_qAvg >= m_maxTh) ||
-          (m_isGentle && m_qAvg >= 2 * m_maxTh)))
+      if (m_qAvg >= m_minTh && qSize > 1)
         {
-          NS_LOG_DEBUG ("adding DROP FORCED MARK");
-          dropType = DTYPE_FORCED;
-        }
-      else if (m_old == 0)
-        {
-          /* 
-           * The average queue size has just crossed the
-           * threshold from below to above "minthresh", or
-           * from above "minthresh" with an empty queue to
-           * above "minthresh" with a nonempty queue.
-           */
-          m_count = 1;
-          m_countBytes = item->GetPacketSize ();
-          m_old = 1;
+          if (!m_useMarkP &&
+              ((!m_isGentle && m_qAvg >= m_maxTh) ||
+              (m_isGentle && m_qAvg >= 2 * m_maxTh)))
+            {
+              NS_LOG_DEBUG ("adding DROP FORCED MARK");
+              dropType = DTYPE_FORCED;
+            }
+          else if (m_old == 0)
+            {
+              /* 
+               * The average queue size has just crossed the
+               * threshold from below to above "minthresh", or
+               * from above "minthresh" with an empty queue to
+               * above "minthresh" with a nonempty queue.
+               */
+              m_count = 1;
+              m_countBytes = segmentSize;
+              m_old = 1;
+            }
+          else if (DropEarly (item, qSize, segment))
+            {
+              NS_LOG_LOGIC ("DropEarly returns 1");
+              dropType = DTYPE_UNFORCED;
+            }
         }
-      else if (DropEarly (item, nQueued))
+      else 
         {
-          NS_LOG_LOGIC ("DropEarly returns 1");
-          dropType = DTYPE_UNFORCED;
+          // No packets are being dropped
+          m_vProb = 0.0;
+          m_old = 0;
         }
     }
-  else 
-    {
-      // No packets are being dropped
-      m_vProb = 0.0;
-      m_old = 0;
-    }
 
-  if ((GetMode () == Queue::QUEUE_MODE_PACKETS && nQueued >= m_queueLimit) ||
+  if ((GetMode () == Queue::QUEUE_MODE_PACKETS && nQueued + segments > m_queueLimit) ||
       (GetMode () == Queue::QUEUE_MODE_BYTES && nQueued + item->GetPacketSize() > m_queueLimit))
     {
       NS_LOG_DEBUG ("\t Dropping due to Queue Full " << nQueued);
@@ -615,11 +642,12 @@ RedQueueDisc::Estimator (uint32_t nQueued, uint32_t m, double qAvg, double qW)
 
 // Check if packet p needs to be dropped due to probability mark
 uint32_t
-RedQueueDisc::DropEarly (Ptr<QueueDiscItem> item, uint32_t qSize)
+RedQueueDisc::DropEarly (Ptr<QueueDiscItem> item, uint32_t qSize, uint32_t segment)
 {
-  NS_LOG_FUNCTION (this << item << qSize);
+  NS_LOG_FUNCTION (this << item << qSize << segment);
+  uint32_t segments = item->GetSegmentCount ();
   m_vProb1 = CalculatePNew (m_qAvg, m_maxTh, m_isGentle, m_vA, m_vB, m_vC, m_vD, m_curMaxP);
-  m_vProb = ModifyP (m_vProb1, m_count, m_countBytes, m_meanPktSize, m_isWait, item->GetPacketSize ());
+  m_vProb = ModifyP (m_vProb1, m_count, m_countBytes, m_meanPktSize, m_isWait, item->GetPacketSize () / segments);
 
   // Drop probability is computed, pick random number and act
   if (m_cautious == 1)
@@ -670,7 +698,7 @@ RedQueueDisc::DropEarly (Ptr<QueueDiscItem> item, uint32_t qSize)
       /// implemented by FujiZ
       if (m_useEcn && (!m_useMarkP || m_vProb1 < m_markP))
         {
-          if (item->Mark ())
+          if (segments > 1 ? item->MarkSegment (segment) : item->Mark ())
             {
               NS_LOG_DEBUG ("\t Marking due to Prob Mark " << m_qAvg);
               m_stats.unforcedMark++;
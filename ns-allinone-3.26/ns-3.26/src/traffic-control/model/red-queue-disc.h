@@ -244,9 +244,10 @@ private:
    * \brief Check if a packet needs to be dropped due to probability mark
    * \param item queue item
    * \param qSize queue size
+   * \param segment the wire segment of the item deciding the drop/mark
    * \returns 0 for no drop/mark, 1 for drop
    */
-  uint32_t DropEarly (Ptr<QueueDiscItem> item, uint32_t qSize);
+  uint32_t DropEarly (Ptr<QueueDiscItem> item, uint32_t qSize, uint32_t segment);
   /**
    * \brief Returns a probability using these function parameters for the DropEarly function
    * \param qAvg Average queue length
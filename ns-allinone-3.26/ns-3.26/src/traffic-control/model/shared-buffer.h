@@ -0,0 +1,150 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SHARED_BUFFER_H
+#define SHARED_BUFFER_H
+
+#include "ns3/object.h"
+#include "ns3/traced-value.h"
+#include "ns3/traced-callback.h"
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief The packet buffer shared by the egress ports of a switch
+ *
+ * Aggregate a SharedBuffer to a node to make the root queue discs of all
+ * its devices draw from a single buffer of BufferSize bytes. A packet is
+ * admitted to a port only if the bytes held by the port, the packet
+ * included, do not exceed the dynamic threshold
+ *
+ *   T = Alpha * (BufferSize - bytes held by all the ports)
+ *
+ * (Choudhury and Hahne), and the buffer has room for it; otherwise the
+ * queue disc drops it before calling its own enqueue method. The limits
+ * of the queue discs still apply.
+ *
+ * The queue discs look for the SharedBuffer when they are initialized,
+ * that is when the simulation starts, so it must be aggregated to the
+ * node before. A port accounts for the bytes held by its queue disc,
+ * the backlog of the fluid flows included; the packets in the device
+ * queues are not accounted.
+ *
+ * Admission and accounting take constant time.
+ */
+class SharedBuffer : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief SharedBuffer Constructor
+   */
+  SharedBuffer ();
+
+  virtual ~SharedBuffer ();
+
+  /**
+   * \brief Add a port to the buffer
+   *
+   * \return the index of the port
+   */
+  uint32_t AddPort (void);
+
+  /**
+   * \brief Get the number of ports sharing the buffer
+   *
+   * \return the number of ports
+   */
+  uint32_t GetNPorts (void) const;
+
+  /**
+   * \brief Check whether a packet can be stored in the buffer
+   *
+   * Packets that are not admitted are counted as admission drops.
+   *
+   * \param port the index of the port
+   * \param bytes the size of the packet
+   * \return true if the packet is admitted
+   */
+  bool Admit (uint32_t port, uint32_t bytes);
+
+  /**
+   * \brief Set the number of bytes held by a port
+   *
+   * \param port the index of the port
+   * \param bytes the bytes held by the port
+   */
+  void SetPortBytes (uint32_t port, uint32_t bytes);
+
+  /**
+   * \brief Get the number of bytes held by a port
+   *
+   * \param port the index of the port
+   * \return the bytes held by the port
+   */
+  uint32_t GetPortBytes (uint32_t port) const;
+
+  /**
+   * \brief Get the number of bytes held by all the ports
+   *
+   * \return the occupancy of the buffer
+   */
+  uint32_t GetOccupancy (void) const;
+
+  /**
+   * \brief Get the current dynamic threshold
+   *
+   * \return the bytes a port may hold at most
+   */
+  uint32_t GetThreshold (void) const;
+
+  /**
+   * \brief Get the number of packets refused by Admit
+   *
+   * \return the number of admission drops
+   */
+  uint32_t GetNAdmissionDrops (void) const;
+
+  /**
+   * TracedCallback signature for port occupancy changes
+   *
+   * \param [in] port the index of the port
+   * \param [in] bytes the bytes held by the port
+   */
+  typedef void (* PortOccupancyTracedCallback)(uint32_t port, uint32_t bytes);
+
+private:
+  uint32_t m_size;                      //!< Size of the buffer in bytes
+  double m_alpha;                       //!< Dynamic threshold factor
+  std::vector<uint32_t> m_ports;        //!< Bytes held by each port
+  TracedValue<uint32_t> m_occupancy;    //!< Bytes held by all the ports
+  uint32_t m_nAdmissionDrops;           //!< Packets refused by Admit
+
+  /// Traced callback: fired when the occupancy of a port changes
+  TracedCallback<uint32_t, uint32_t> m_portOccupancyTrace;
+};
+
+} // namespace ns3
+
+#endif /* SHARED_BUFFER_H */
@@ -22,6 +22,8 @@ cpp_examples = [
     ("adaptive-red-tests --testNumber=13", "True", "True"),
     ("adaptive-red-tests --testNumber=14", "True", "True"),
     ("adaptive-red-tests --testNumber=15", "True", "True"),
+    ("fluid-hybrid-validation --hybrid=0", "True", "True"),
+    ("fluid-hybrid-validation --hybrid=1", "True", "True"),
     ("codel-vs-pfifo-asymmetric --routerWanQueueDiscType=PfifoFast --simDuration=10", "True", "True"),
     ("codel-vs-pfifo-asymmetric --routerWanQueueDiscType=CoDel --simDuration=10", "True", "True"),
     ("codel-vs-pfifo-basic-test --queueDiscType=PfifoFast --simDuration=10", "True", "True"),
@@ -0,0 +1,266 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/fluid-flow-model.h"
+#include "ns3/red-queue-disc.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+#include "ns3/mac48-address.h"
+#include "ns3/traffic-control-layer.h"
+#include "ns3/traffic-control-helper.h"
+
+using namespace ns3;
+
+class FluidFlowModelTestItem : public QueueDiscItem {
+public:
+  FluidFlowModelTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol);
+  virtual ~FluidFlowModelTestItem ();
+  virtual void AddHeader (void);
+  virtual bool Mark (void);
+
+private:
+  FluidFlowModelTestItem ();
+  FluidFlowModelTestItem (const FluidFlowModelTestItem &);
+  FluidFlowModelTestItem &operator = (const FluidFlowModelTestItem &);
+};
+
+FluidFlowModelTestItem::FluidFlowModelTestItem (Ptr<Packet> p, const Address & addr, uint16_t protocol)
+  : QueueDiscItem (p, addr, protocol)
+{
+}
+
+FluidFlowModelTestItem::~FluidFlowModelTestItem ()
+{
+}
+
+void
+FluidFlowModelTestItem::AddHeader (void)
+{
+}
+
+bool
+FluidFlowModelTestItem::Mark (void)
+{
+  return false;
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief Fluid flows sharing a link converge to a full, fair use of it
+ * with a queue around the marking threshold.
+ */
+class FluidFlowModelSharingTestCase : public TestCase
+{
+public:
+  FluidFlowModelSharingTestCase ();
+  virtual void DoRun (void);
+};
+
+FluidFlowModelSharingTestCase::FluidFlowModelSharingTestCase ()
+  : TestCase ("Fluid flows share a link fairly and fill it")
+{
+}
+
+void
+FluidFlowModelSharingTestCase::DoRun (void)
+{
+  const uint32_t nFlows = 10;
+  const uint32_t markThreshold = 65 * 1500;
+  const uint32_t limit = 300 * 1500;
+  DataRate rate ("10Gbps");
+
+  Ptr<FluidFlowModel> model = CreateObject<FluidFlowModel> ();
+  model->SetAttribute ("SegmentSize", UintegerValue (1500));
+  uint32_t link = model->AddLink (rate, markThreshold, limit);
+  std::vector<uint32_t> path (1, link);
+  for (uint32_t i = 0; i < nFlows; i++)
+    {
+      model->AddFlow (path, MicroSeconds (100), Seconds (0), Seconds (0.2));
+    }
+
+  // measure over the second half, once the flows left slow start
+  std::vector<uint64_t> before (nFlows);
+  Simulator::Stop (Seconds (0.1));
+  Simulator::Run ();
+  for (uint32_t i = 0; i < nFlows; i++)
+    {
+      before[i] = model->GetDeliveredBytes (i);
+      NS_TEST_EXPECT_MSG_LT (model->GetAlpha (i), 0.5, "α did not settle");
+    }
+  uint32_t backlog = model->GetBacklog (link);
+  NS_TEST_EXPECT_MSG_GT (backlog, markThreshold / 2, "The queue drained");
+  NS_TEST_EXPECT_MSG_LT (backlog, 2 * markThreshold, "The queue is far above the threshold");
+  uint64_t dropped = model->GetDroppedBytes (link);
+  Simulator::Stop (Seconds (0.1));
+  Simulator::Run ();
+
+  double sum = 0;
+  double sumSquares = 0;
+  for (uint32_t i = 0; i < nFlows; i++)
+    {
+      double delivered = model->GetDeliveredBytes (i) - before[i];
+      sum += delivered;
+      sumSquares += delivered * delivered;
+    }
+  double utilization = sum * 8 / (rate.GetBitRate () * 0.1);
+  NS_TEST_EXPECT_MSG_GT (utilization, 0.95, "The link is not used");
+  NS_TEST_EXPECT_MSG_LT (utilization, 1.001, "The link is used beyond its capacity");
+  double fairness = sum * sum / (nFlows * sumSquares);
+  NS_TEST_EXPECT_MSG_GT (fairness, 0.99, "The flows do not share the link fairly");
+  NS_TEST_EXPECT_MSG_EQ (model->GetDroppedBytes (link), dropped, "Drops in steady state");
+
+  // the flows are over, the model stops by itself
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (model->GetBacklog (link), 0, "The queue did not drain");
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief RedQueueDisc counts the fluid backlog in its occupancy.
+ */
+class FluidFlowModelRedTestCase : public TestCase
+{
+public:
+  FluidFlowModelRedTestCase ();
+  virtual void DoRun (void);
+};
+
+FluidFlowModelRedTestCase::FluidFlowModelRedTestCase ()
+  : TestCase ("RED queue disc counts the fluid backlog")
+{
+}
+
+void
+FluidFlowModelRedTestCase::DoRun (void)
+{
+  Address dest;
+  Ptr<RedQueueDisc> queue = CreateObject<RedQueueDisc> ();
+  queue->SetAttribute ("Mode", StringValue ("QUEUE_MODE_BYTES"));
+  queue->SetAttribute ("MinTh", DoubleValue (5000));
+  queue->SetAttribute ("MaxTh", DoubleValue (8000));
+  queue->SetAttribute ("QueueLimit", UintegerValue (10000));
+  queue->Initialize ();
+
+  queue->SetFluidBacklog (9500);
+  NS_TEST_EXPECT_MSG_EQ (queue->GetFluidBacklog (), 9500, "Wrong fluid backlog");
+  queue->Enqueue (Create<FluidFlowModelTestItem> (Create<Packet> (1000), dest, 0));
+  NS_TEST_EXPECT_MSG_EQ (queue->GetStats ().qLimDrop, 1, "The fluid backlog did not fill the queue");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 0, "The packet was enqueued in a full queue");
+
+  queue->SetFluidBacklog (0);
+  queue->Enqueue (Create<FluidFlowModelTestItem> (Create<Packet> (1000), dest, 0));
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 1000, "The packet was not enqueued");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetStats ().qLimDrop, 1, "Drop without fluid backlog");
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ * \ingroup tests
+ *
+ * \brief A queue disc holds the packets behind the fluid backlog, in order.
+ */
+class FluidFlowModelHoldTestCase : public TestCase
+{
+public:
+  FluidFlowModelHoldTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * Enqueue a packet and run the queue disc
+   * \param queue the queue disc
+   */
+  void Send (Ptr<QueueDisc> queue);
+  /**
+   * Check the number of packets in the queue disc
+   * \param queue the queue disc
+   * \param expected the expected number of packets
+   */
+  void Check (Ptr<QueueDisc> queue, uint32_t expected);
+};
+
+FluidFlowModelHoldTestCase::FluidFlowModelHoldTestCase ()
+  : TestCase ("Queue disc holds the packets behind the fluid backlog")
+{
+}
+
+void
+FluidFlowModelHoldTestCase::Send (Ptr<QueueDisc> queue)
+{
+  Address dest = Mac48Address::GetBroadcast ();
+  queue->Enqueue (Create<FluidFlowModelTestItem> (Create<Packet> (1000), dest, 0));
+  queue->Run ();
+}
+
+void
+FluidFlowModelHoldTestCase::Check (Ptr<QueueDisc> queue, uint32_t expected)
+{
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), expected,
+                         "Wrong number of packets held at " << Simulator::Now ().GetMicroSeconds () << "us");
+}
+
+void
+FluidFlowModelHoldTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  node->AggregateObject (CreateObject<TrafficControlLayer> ());
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  device->SetChannel (CreateObject<SimpleChannel> ());
+  node->AddDevice (device);
+  TrafficControlHelper tch;
+  tch.SetRootQueueDisc ("ns3::RedQueueDisc");
+  Ptr<QueueDisc> queue = tch.Install (device).Get (0);
+
+  // the first packet waits 100us for the fluid; the second one, sent once
+  // the fluid is gone, must not overtake it
+  Simulator::Schedule (MicroSeconds (10), &QueueDisc::SetFluidDelay, queue, MicroSeconds (100));
+  Simulator::Schedule (MicroSeconds (10), &FluidFlowModelHoldTestCase::Send, this, queue);
+  Simulator::Schedule (MicroSeconds (20), &QueueDisc::SetFluidDelay, queue, Time (0));
+  Simulator::Schedule (MicroSeconds (20), &FluidFlowModelHoldTestCase::Send, this, queue);
+  Simulator::Schedule (MicroSeconds (109), &FluidFlowModelHoldTestCase::Check, this, queue, 2);
+  Simulator::Schedule (MicroSeconds (111), &FluidFlowModelHoldTestCase::Check, this, queue, 0);
+  // without fluid, the packets are not held
+  Simulator::Schedule (MicroSeconds (120), &FluidFlowModelHoldTestCase::Send, this, queue);
+  Simulator::Schedule (MicroSeconds (120), &FluidFlowModelHoldTestCase::Check, this, queue, 0);
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+static class FluidFlowModelTestSuite : public TestSuite
+{
+public:
+  FluidFlowModelTestSuite ()
+    : TestSuite ("fluid-flow-model", UNIT)
+  {
+    AddTestCase (new FluidFlowModelSharingTestCase (), TestCase::QUICK);
+    AddTestCase (new FluidFlowModelRedTestCase (), TestCase::QUICK);
+    AddTestCase (new FluidFlowModelHoldTestCase (), TestCase::QUICK);
+  }
+} g_fluidFlowModelTestSuite;
@@ -0,0 +1,178 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/shared-buffer.h"
+#include "ns3/dctcp-step-mark-queue-disc.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/node.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/string.h"
+#include "ns3/simulator.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup traffic-control-test
+ *
+ * \brief Queue disc item for the shared buffer test
+ */
+class SharedBufferTestItem : public QueueDiscItem {
+public:
+  /**
+   * Constructor
+   *
+   * \param p the packet
+   */
+  SharedBufferTestItem (Ptr<Packet> p);
+  virtual ~SharedBufferTestItem ();
+  virtual void AddHeader (void);
+  virtual bool Mark (void);
+
+private:
+  SharedBufferTestItem ();
+  SharedBufferTestItem (const SharedBufferTestItem &);
+  SharedBufferTestItem &operator = (const SharedBufferTestItem &);
+};
+
+SharedBufferTestItem::SharedBufferTestItem (Ptr<Packet> p)
+  : QueueDiscItem (p, Address (), 0)
+{
+}
+
+SharedBufferTestItem::~SharedBufferTestItem ()
+{
+}
+
+void
+SharedBufferTestItem::AddHeader (void)
+{
+}
+
+bool
+SharedBufferTestItem::Mark (void)
+{
+  return false;
+}
+
+/**
+ * \ingroup traffic-control-test
+ *
+ * \brief Check the dynamic threshold admission of SharedBuffer
+ */
+class SharedBufferTestCase : public TestCase
+{
+public:
+  SharedBufferTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Enqueue packets until one is refused
+   *
+   * \param queue the queue disc
+   * \return the number of packets enqueued
+   */
+  uint32_t Fill (Ptr<QueueDisc> queue);
+  /**
+   * Record the occupancy of the buffer
+   *
+   * \param oldValue the previous occupancy
+   * \param newValue the current occupancy
+   */
+  void Occupancy (uint32_t oldValue, uint32_t newValue);
+
+  uint32_t m_maxOccupancy;   //!< The highest occupancy traced
+};
+
+SharedBufferTestCase::SharedBufferTestCase ()
+  : TestCase ("Dynamic threshold admission of the shared buffer"),
+    m_maxOccupancy (0)
+{
+}
+
+uint32_t
+SharedBufferTestCase::Fill (Ptr<QueueDisc> queue)
+{
+  uint32_t n = 0;
+  while (queue->Enqueue (Create<SharedBufferTestItem> (Create<Packet> (1000))))
+    {
+      n++;
+    }
+  return n;
+}
+
+void
+SharedBufferTestCase::Occupancy (uint32_t oldValue, uint32_t newValue)
+{
+  m_maxOccupancy = std::max (m_maxOccupancy, newValue);
+}
+
+void
+SharedBufferTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ptr<SharedBuffer> buffer = CreateObjectWithAttributes<SharedBuffer> ("BufferSize", UintegerValue (10000),
+                                                                       "Alpha", DoubleValue (1.0));
+  node->AggregateObject (buffer);
+  buffer->TraceConnectWithoutContext ("Occupancy", MakeCallback (&SharedBufferTestCase::Occupancy, this));
+
+  Ptr<QueueDisc> queues[2];
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      node->AddDevice (device);
+      queues[i] = CreateObjectWithAttributes<DctcpStepMarkQueueDisc> ("Mode", StringValue ("QUEUE_MODE_BYTES"),
+                                                                      "QueueLimit", UintegerValue (100000),
+                                                                      "MarkThreshold", UintegerValue (100000));
+      queues[i]->SetNetDevice (device);
+      queues[i]->Initialize ();
+      NS_TEST_ASSERT_MSG_EQ (queues[i]->GetSharedBuffer (), buffer, "The queue disc should use the shared buffer");
+    }
+  NS_TEST_EXPECT_MSG_EQ (buffer->GetNPorts (), 2, "Two ports expected");
+
+  // alone, a port can take half of the buffer
+  NS_TEST_EXPECT_MSG_EQ (Fill (queues[0]), 5, "The first port should hold 5 packets");
+  NS_TEST_EXPECT_MSG_EQ (buffer->GetOccupancy (), 5000, "Wrong occupancy");
+  // then the second port gets 3000 = 10000 - 5000 - 3000 bytes
+  NS_TEST_EXPECT_MSG_EQ (Fill (queues[1]), 3, "The second port should hold 3 packets");
+  NS_TEST_EXPECT_MSG_EQ (buffer->GetPortBytes (1), 3000, "Wrong port occupancy");
+  NS_TEST_EXPECT_MSG_EQ (buffer->GetNAdmissionDrops (), 2, "Two packets should have been refused");
+  NS_TEST_EXPECT_MSG_EQ (queues[1]->GetTotalDroppedPackets (), 1, "The queue disc should count the drop");
+
+  // freeing the buffer raises the threshold
+  queues[0]->Dequeue ();
+  queues[0]->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ (buffer->GetOccupancy (), 6000, "Wrong occupancy after dequeues");
+  NS_TEST_EXPECT_MSG_EQ (Fill (queues[1]), 1, "The second port should take one more packet");
+
+  // the fluid backlog is accounted as well
+  queues[1]->SetFluidBacklog (1000);
+  NS_TEST_EXPECT_MSG_EQ (buffer->GetPortBytes (1), 5000, "The fluid backlog should be accounted");
+  NS_TEST_EXPECT_MSG_EQ (m_maxOccupancy, 8000, "Wrong maximum occupancy traced");
+
+  Simulator::Destroy ();
+}
+
+static class SharedBufferTestSuite : public TestSuite
+{
+public:
+  SharedBufferTestSuite ()
+    : TestSuite ("shared-buffer", UNIT)
+  {
+    AddTestCase (new SharedBufferTestCase (), TestCase::QUICK);
+  }
+} g_sharedBufferTestSuite;
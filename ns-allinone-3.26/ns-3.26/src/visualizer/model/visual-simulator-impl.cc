@@ -203,6 +203,18 @@ VisualSimulatorImpl::IsExpired (const EventId &id) const
   return m_simulator->IsExpired (id);
 }
 
+uint32_t
+VisualSimulatorImpl::GetLiveEventCount (void) const
+{
+  return m_simulator->GetLiveEventCount ();
+}
+
+uint32_t
+VisualSimulatorImpl::GetCancelledEventCount (void) const
+{
+  return m_simulator->GetCancelledEventCount ();
+}
+
 Time 
 VisualSimulatorImpl::GetMaximumSimulationTime (void) const
 {
@@ -60,6 +60,8 @@ public:
   virtual void Remove (const EventId &id);
   virtual void Cancel (const EventId &id);
   virtual bool IsExpired (const EventId &id) const;
+  virtual uint32_t GetLiveEventCount (void) const;
+  virtual uint32_t GetCancelledEventCount (void) const;
   virtual void Run (void);
   virtual Time Now (void) const;
   virtual Time GetDelayLeft (const EventId &id) const;
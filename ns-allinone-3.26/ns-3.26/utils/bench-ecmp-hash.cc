@@ -0,0 +1,166 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Compare the packets-per-second rate of the ECMP five-tuple hash of
+// Ipv4GlobalRouting against the former text-based implementation, which
+// formatted the tuple into an std::ostringstream before hashing it.
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/hash.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/node.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/tcp-header.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv4-global-routing.h"
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <stdlib.h> // for exit ()
+
+using namespace ns3;
+
+static std::vector<Ipv4Header> g_headers;
+static std::vector<Ptr<Packet> > g_payloads;
+static Ptr<Ipv4GlobalRouting> g_routing;
+static uint32_t g_nodeId;
+static uint64_t g_sink; //!< keeps the hash computations alive
+
+/**
+ * The former implementation of Ipv4GlobalRouting::GetTupleValue.
+ */
+static uint64_t
+LegacyTupleValue (const Ipv4Header &header, Ptr<const Packet> ipPayload, bool flowcell)
+{
+  Hasher hasher;
+  std::ostringstream oss;
+  oss << header.GetSource ()
+      << header.GetDestination ()
+      << header.GetProtocol ();
+  TcpHeader tcpHeader;
+  ipPayload->PeekHeader (tcpHeader);
+  oss << tcpHeader.GetSourcePort ()
+      << tcpHeader.GetDestinationPort ();
+  if (flowcell)
+    {
+      oss << (tcpHeader.GetSequenceNumber ().GetValue () >> 16);
+    }
+  uint32_t hash = hasher.GetHash32 (oss.str ());
+  hash /= (g_nodeId + 1);
+  return hash;
+}
+
+static void
+BenchLegacy (uint32_t n, bool flowcell)
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      uint32_t k = i % g_headers.size ();
+      g_sink += LegacyTupleValue (g_headers[k], g_payloads[k], flowcell);
+    }
+}
+
+static void
+BenchBinary (uint32_t n, bool flowcell)
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      uint32_t k = i % g_headers.size ();
+      g_sink += g_routing->GetTupleValue (g_headers[k], g_payloads[k], flowcell);
+    }
+}
+
+static void
+RunBench (void (*bench) (uint32_t, bool), uint32_t n, uint32_t minIterations,
+          bool flowcell, char const *name)
+{
+  uint64_t minDelay = std::numeric_limits<uint64_t>::max ();
+  for (uint32_t i = 0; i < minIterations; i++)
+    {
+      SystemWallClockMs time;
+      time.Start ();
+      (*bench) (n, flowcell);
+      minDelay = std::min (minDelay, static_cast<uint64_t> (time.End ()));
+    }
+  double ps = n;
+  ps *= 1000;
+  ps /= std::max (minDelay, static_cast<uint64_t> (1));
+  std::cout << ps << " packets/s"
+            << " (" << minDelay << " ms elapsed)\t"
+            << name
+            << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 1000000;
+  uint32_t nFlows = 1024;
+  uint32_t minIterations = 1;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the ECMP five-tuple hash of Ipv4GlobalRouting");
+  cmd.AddValue ("n", "number of packets to hash", n);
+  cmd.AddValue ("flows", "number of distinct five tuples", nFlows);
+  cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
+  cmd.Parse (argc, argv);
+
+  if (n == 0 || nFlows == 0)
+    {
+      std::cerr << "Error-- number of packets and flows must be positive" << std::endl;
+      exit (1);
+    }
+
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  Ipv4GlobalRoutingHelper globalRouting;
+  internet.SetRoutingHelper (globalRouting);
+  internet.Install (node);
+  g_routing = node->GetObject<Ipv4L3Protocol> ()->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ();
+  g_nodeId = node->GetId ();
+
+  for (uint32_t i = 0; i < nFlows; i++)
+    {
+      Ipv4Header header;
+      header.SetSource (Ipv4Address (0x0a000000 + (i % 251)));
+      header.SetDestination (Ipv4Address (0x0a010000 + (i / 251)));
+      header.SetProtocol (6);
+      TcpHeader tcp;
+      tcp.SetSourcePort (10000 + i);
+      tcp.SetDestinationPort (5001);
+      tcp.SetSequenceNumber (SequenceNumber32 (i * 1448));
+      Ptr<Packet> p = Create<Packet> (1448);
+      p->AddHeader (tcp);
+      g_headers.push_back (header);
+      g_payloads.push_back (p);
+    }
+
+  std::cout << "Running bench-ecmp-hash with n=" << n << " flows=" << nFlows << std::endl;
+  RunBench (&BenchLegacy, n, minIterations, false, "ECMP_HASH, text tuple (legacy)");
+  RunBench (&BenchBinary, n, minIterations, false, "ECMP_HASH, binary tuple");
+  RunBench (&BenchLegacy, n, minIterations, true, "ECMP_FLOWCELL, text tuple (legacy)");
+  RunBench (&BenchBinary, n, minIterations, true, "ECMP_FLOWCELL, binary tuple");
+
+  g_routing = 0;
+  g_payloads.clear ();
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,142 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Feed a FlowMonitor with many short flows, the way the probes of a
+// web-search workload would, and measure the time to monitor them and
+// to write the results, and the peak memory of the process. Run it once
+// per mode, since the peak memory covers the whole process:
+//
+//   bench-flow-monitor --mode=xml
+//   bench-flow-monitor --mode=csv
+//   bench-flow-monitor --mode=binary
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/enum.h"
+#include "ns3/flow-monitor.h"
+#include "ns3/flow-probe.h"
+#include <iostream>
+#include <stdlib.h> // for exit ()
+#include <sys/resource.h>
+
+using namespace ns3;
+
+/**
+ * A probe reporting the packets of the benchmark flows
+ */
+class BenchProbe : public FlowProbe
+{
+public:
+  /**
+   * \param monitor the flow monitor
+   */
+  BenchProbe (Ptr<FlowMonitor> monitor)
+    : FlowProbe (monitor)
+  {
+  }
+};
+
+static Ptr<FlowMonitor> g_monitor;
+static Ptr<FlowProbe> g_probe;
+static uint32_t g_packets;
+
+/// Transmit all the packets of a flow
+static void
+FlowTx (FlowId flowId)
+{
+  for (uint32_t i = 0; i < g_packets; i++)
+    {
+      g_monitor->ReportFirstTx (g_probe, flowId, i, 1000);
+    }
+}
+
+/// Receive all the packets of a flow
+static void
+FlowRx (FlowId flowId)
+{
+  for (uint32_t i = 0; i < g_packets; i++)
+    {
+      g_monitor->ReportLastRx (g_probe, flowId, i, 1000);
+    }
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t flows = 100000;
+  std::string mode = "xml";
+  std::string fileName = "bench-flow-monitor.out";
+  g_packets = 10;
+
+  CommandLine cmd;
+  cmd.AddValue ("flows", "number of flows", flows);
+  cmd.AddValue ("packets", "number of packets per flow", g_packets);
+  cmd.AddValue ("mode", "xml, csv or binary", mode);
+  cmd.AddValue ("file", "output file", fileName);
+  cmd.Parse (argc, argv);
+
+  g_monitor = CreateObject<FlowMonitor> ();
+  if (mode == "csv" || mode == "binary")
+    {
+      g_monitor->SetAttribute ("StreamFile", StringValue (fileName));
+      g_monitor->SetAttribute ("StreamFormat", EnumValue (mode == "csv" ? FlowMonitor::STREAM_CSV : FlowMonitor::STREAM_BINARY));
+      g_monitor->SetAttribute ("FlowIdleTimeout", TimeValue (MilliSeconds (1)));
+    }
+  else if (mode != "xml")
+    {
+      std::cerr << "unknown mode " << mode << std::endl;
+      exit (1);
+    }
+  g_probe = CreateObject<BenchProbe> (g_monitor);
+
+  // a new flow every 10us, each delivered 100us after its start
+  for (uint32_t i = 0; i < flows; i++)
+    {
+      Simulator::Schedule (MicroSeconds (10 * i + 1), &FlowTx, i + 1);
+      Simulator::Schedule (MicroSeconds (10 * i + 101), &FlowRx, i + 1);
+    }
+  // the monitor checks for lost packets periodically, so stop explicitly
+  Simulator::Stop (MicroSeconds (10 * flows + 200));
+
+  SystemWallClockMs clock;
+  clock.Start ();
+  Simulator::Run ();
+  uint64_t runMs = clock.End ();
+
+  clock.Start ();
+  if (mode == "xml")
+    {
+      g_monitor->SerializeToXmlFile (fileName, true, true);
+    }
+  else
+    {
+      g_monitor->FlushStream ();
+    }
+  uint64_t writeMs = clock.End ();
+
+  struct rusage usage;
+  getrusage (RUSAGE_SELF, &usage);
+  std::cout << mode << ": " << flows << " flows of " << g_packets << " packets, monitored in "
+            << runMs << " ms, written in " << writeMs << " ms, peak RSS "
+            << usage.ru_maxrss / 1024 << " MB" << std::endl;
+
+  g_monitor->Dispose ();
+  g_probe = 0;
+  g_monitor = 0;
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,130 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Measure the time global routing takes to build the link state database
+// and compute the routes of every node of a k-ary fat-tree, with one SPF
+// thread and then with the requested number of threads, against the time
+// PointToPointFatTreeHelper takes to install the routes from the structure.
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/simulator.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+#include "ns3/node-container.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/global-route-manager.h"
+#include "ns3/global-router-interface.h"
+#include "ns3/point-to-point-fat-tree.h"
+#include <iostream>
+#include <limits>
+#include <algorithm>
+#include <stdlib.h> // for exit ()
+
+using namespace ns3;
+
+static NodeContainer g_nodes;
+
+/**
+ * \returns the number of routes of all the nodes
+ */
+static uint32_t
+CountRoutes (void)
+{
+  uint32_t routes = 0;
+  for (uint32_t i = 0; i < g_nodes.GetN (); i++)
+    {
+      routes += g_nodes.Get (i)->GetObject<GlobalRouter> ()->GetRoutingProtocol ()->GetNRoutes ();
+    }
+  return routes;
+}
+
+static void
+RunBench (uint32_t threads, uint32_t minIterations)
+{
+  GlobalValue::Bind ("GlobalRoutingSpfThreads", UintegerValue (threads));
+  uint64_t minBuild = std::numeric_limits<uint64_t>::max ();
+  uint64_t minSpf = std::numeric_limits<uint64_t>::max ();
+  for (uint32_t i = 0; i < minIterations; i++)
+    {
+      GlobalRouteManager::DeleteGlobalRoutes ();
+      SystemWallClockMs time;
+      time.Start ();
+      GlobalRouteManager::BuildGlobalRoutingDatabase ();
+      minBuild = std::min (minBuild, static_cast<uint64_t> (time.End ()));
+      time.Start ();
+      GlobalRouteManager::InitializeRoutes ();
+      minSpf = std::min (minSpf, static_cast<uint64_t> (time.End ()));
+    }
+  std::cout << minBuild << " ms elapsed\tBuildGlobalRoutingDatabase" << std::endl;
+  std::cout << minSpf << " ms elapsed\tInitializeRoutes (" << threads << " SPF threads, "
+            << CountRoutes () << " routes)" << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t k = 8;
+  uint32_t threads = 0;
+  uint32_t minIterations = 1;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the route computation of global routing on a fat-tree");
+  cmd.AddValue ("k", "number of ports of the fat-tree switches", k);
+  cmd.AddValue ("threads", "number of SPF threads, 0 for one per hardware thread", threads);
+  cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
+  cmd.Parse (argc, argv);
+
+  if (k < 2 || k % 2 != 0 || k > 128)
+    {
+      std::cerr << "Error-- k must be even, positive and at most 128" << std::endl;
+      exit (1);
+    }
+
+  PointToPointHelper link;
+  PointToPointFatTreeHelper fatTree (k, link, link);
+  InternetStackHelper internet;
+  Ipv4GlobalRoutingHelper globalRouting;
+  internet.SetRoutingHelper (globalRouting);
+  fatTree.InstallStack (internet);
+  fatTree.AssignIpv4Addresses ("10.0.0.0", Ipv4AddressHelper ("172.16.0.0", "255.255.255.252"));
+  g_nodes = NodeContainer::GetGlobal ();
+  std::cout << "Running bench-global-routing with k=" << k
+            << " (" << g_nodes.GetN () << " nodes)" << std::endl;
+
+  RunBench (1, minIterations);
+  RunBench (threads, minIterations);
+
+  uint64_t minInstall = std::numeric_limits<uint64_t>::max ();
+  for (uint32_t i = 0; i < minIterations; i++)
+    {
+      GlobalRouteManager::DeleteGlobalRoutes ();
+      SystemWallClockMs time;
+      time.Start ();
+      fatTree.InstallRoutes ();
+      minInstall = std::min (minInstall, static_cast<uint64_t> (time.End ()));
+    }
+  std::cout << minInstall << " ms elapsed\tPointToPointFatTreeHelper::InstallRoutes ("
+            << CountRoutes () << " routes)" << std::endl;
+
+  g_nodes = NodeContainer ();
+
+  Simulator::Destroy ();
+  return 0;
+}
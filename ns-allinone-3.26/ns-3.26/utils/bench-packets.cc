@@ -302,6 +302,24 @@ benchByteTags (uint32_t n)
     }
 }
 
+static void
+benchPacketTags (uint32_t n)
+{
+  BenchTag<16> tag1;
+  BenchTag<17> tag2;
+
+  for (uint32_t i = 0; i < n; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (2000);
+      p->AddPacketTag (tag1);
+      p->AddPacketTag (tag2);
+      Ptr<Packet> o = p->Copy ();
+      o->PeekPacketTag (tag1);
+      o->RemovePacketTag (tag2);
+      p->ReplacePacketTag (tag1);
+    }
+}
+
 static uint64_t
 runBenchOneIteration (void (*bench) (uint32_t), uint32_t n)
 {
@@ -329,6 +347,10 @@ runBench (void (*bench) (uint32_t), uint32_t n, uint32_t minIterations, char con
             << " (" << minDelay << " ms elapsed)\t"
             << name
             << std::endl;
+  Buffer::FreeListStats stats = Buffer::GetFreeListStats ();
+  std::cout << "\tbuffer free lists: " << stats.hits << " hits, "
+            << stats.misses << " misses, " << stats.released << " released, "
+            << stats.retainedBytes << " bytes retained" << std::endl;
 }
 
 int main (int argc, char *argv[])
@@ -350,7 +372,22 @@ int main (int argc, char *argv[])
         "by command-line argument --n=(number of packets)" << std::endl;
       exit (1);
     }
-  std::cout << "Running bench-packets with n=" << n << std::endl;
+#ifdef NS3_LEAN_PACKET
+  if (enablePrinting)
+    {
+      std::cerr << "Error-- packet printing needs the packet metadata, "
+                << "which --enable-lean-packets compiled out" << std::endl;
+      exit (1);
+    }
+  std::cout << "Running bench-packets with n=" << n << ", metadata compiled out" << std::endl;
+#else
+  if (enablePrinting)
+    {
+      Packet::EnablePrinting ();
+    }
+  std::cout << "Running bench-packets with n=" << n << ", metadata "
+            << (enablePrinting ? "enabled" : "disabled") << std::endl;
+#endif
   std::cout << "All tests begin by adding UDP and IPv4 headers." << std::endl;
 
   runBench (&benchA, n, minIterations, "Copy packet, remove headers");
@@ -359,6 +396,7 @@ int main (int argc, char *argv[])
   runBench (&benchD, n, minIterations, "Intermixed add/remove headers and tags");
   runBench (&benchFragment, n, minIterations, "Fragmentation and concatenation");
   runBench (&benchByteTags, n, minIterations, "Benchmark byte tags");
+  runBench (&benchPacketTags, n, minIterations, "Copy, peek and remove two packet tags");
 
   return 0;
 }
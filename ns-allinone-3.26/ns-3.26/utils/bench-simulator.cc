@@ -22,7 +22,9 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <algorithm>
 #include <string.h>
+#include <stdlib.h>   // strtoull
 
 #include "ns3/core-module.h"
 
@@ -124,6 +126,141 @@ Bench::Cb (void)
 }
 
 
+/**
+ * Replay an event trace recorded by DesMetrics (configure with
+ * --enable-des-metrics and run a script, e.g. scratch/atp-test, to get
+ * its JSON trace).  Every traced event is scheduled at the same virtual
+ * time, relative to the start of the replay, as in the original run, from
+ * an event running at the time it was originally scheduled, so that the
+ * scheduler sees the same sequence of inserts and removals.
+ */
+class TraceBench
+{
+public:
+  /**
+   * Read a trace.
+   * \param filename the DesMetrics JSON file
+   */
+  TraceBench (std::string filename);
+
+  /** \returns the number of traced events */
+  uint32_t GetSize (void) const
+  {
+    return m_events.size ();
+  }
+
+  void RunBench (void);
+private:
+  void Cb (void);
+  /** Schedule the traced events sent up to the current replay time. */
+  void ScheduleSent (void);
+
+  /** Traced (send, receive) time steps, sorted by send time. */
+  std::vector<std::pair<uint64_t, uint64_t> > m_events;
+  uint64_t m_base;    //!< original send time of the first traced event
+  uint64_t m_offset;  //!< replay time of the first traced event
+  uint32_t m_next;    //!< next traced event to schedule
+  uint32_t m_count;   //!< events executed
+};
+
+TraceBench::TraceBench (std::string filename)
+  : m_base (0),
+    m_offset (0),
+    m_next (0),
+    m_count (0)
+{
+  LOGME ("replaying DES Metrics event trace from " << filename);
+  std::ifstream input (filename.c_str ());
+  std::string line;
+  while (std::getline (input, line))
+    {
+      // event lines look like:  ["send context","send ts","recv context","recv ts"]
+      std::vector<std::string> fields;
+      std::string::size_type pos = 0;
+      while ((pos = line.find ('"', pos)) != std::string::npos)
+        {
+          std::string::size_type end = line.find ('"', pos + 1);
+          if (end == std::string::npos)
+            {
+              break;
+            }
+          fields.push_back (line.substr (pos + 1, end - pos - 1));
+          pos = end + 1;
+        }
+      if (fields.size () == 4 && line.find ('[') != std::string::npos)
+        {
+          uint64_t send = strtoull (fields[1].c_str (), 0, 10);
+          uint64_t recv = strtoull (fields[3].c_str (), 0, 10);
+          m_events.push_back (std::make_pair (send, std::max (send, recv)));
+        }
+    }
+  std::stable_sort (m_events.begin (), m_events.end ());
+  LOGME ("found " << m_events.size () << " events");
+  if (!m_events.empty ())
+    {
+      m_base = m_events.front ().first;
+    }
+}
+
+void
+TraceBench::ScheduleSent (void)
+{
+  uint64_t now = Simulator::Now ().GetTimeStep () - m_offset + m_base;
+  while (m_next < m_events.size () && m_events[m_next].first <= now)
+    {
+      Time delay = TimeStep (m_events[m_next].second - m_events[m_next].first);
+      Simulator::Schedule (delay, &TraceBench::Cb, this);
+      m_next++;
+    }
+}
+
+void
+TraceBench::RunBench (void)
+{
+  SystemWallClockMs time;
+  double init, simu;
+
+  m_next = 0;
+  m_count = 0;
+  m_offset = Simulator::Now ().GetTimeStep ();
+
+  time.Start ();
+  ScheduleSent ();
+  init = time.End ();
+  init /= 1000;
+  uint32_t initial = m_next;
+
+  time.Start ();
+  while (m_next < m_events.size ())
+    {
+      Simulator::Run ();
+      // nothing was pending at the time of the next traced send: skip ahead
+      if (m_next < m_events.size ())
+        {
+          m_offset = Simulator::Now ().GetTimeStep () - (m_events[m_next].first - m_base);
+          ScheduleSent ();
+        }
+    }
+  Simulator::Run ();
+  simu = time.End ();
+  simu /= 1000;
+
+  LOG (std::setw (g_fwidth) << init <<
+       std::setw (g_fwidth) << (initial / init) <<
+       std::setw (g_fwidth) << (init / initial) <<
+       std::setw (g_fwidth) << simu <<
+       std::setw (g_fwidth) << (m_count / simu) <<
+       std::setw (g_fwidth) << (simu / m_count));
+}
+
+void
+TraceBench::Cb (void)
+{
+  ++m_count;
+  ScheduleSent ();
+}
+
+
 Ptr<RandomVariableStream>
 GetRandomStream (std::string filename)
 {
@@ -179,18 +316,50 @@ GetRandomStream (std::string filename)
 
 
 
+/**
+ * Print the header of the results table.
+ */
+static void
+PrintHeader (void)
+{
+  LOG ("");
+  LOG (std::left << std::setw (g_fwidth) << "Run #" <<
+       std::left << std::setw (3 * g_fwidth) << "Inititialization:" <<
+       std::left << std::setw (3 * g_fwidth) << "Simulation:");
+  LOG (std::left << std::setw (g_fwidth) << "" <<
+       std::left << std::setw (g_fwidth) << "Time (s)" <<
+       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
+       std::left << std::setw (g_fwidth) << "Per (s/ev)" <<
+       std::left << std::setw (g_fwidth) << "Time (s)" <<
+       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
+       std::left << std::setw (g_fwidth) << "Per (s/ev)" );
+  LOG (std::setfill ('-') <<
+       std::right << std::setw (g_fwidth) << " " <<
+       std::right << std::setw (g_fwidth) << " " <<       
+       std::right << std::setw (g_fwidth) << " " <<       
+       std::right << std::setw (g_fwidth) << " " <<       
+       std::right << std::setw (g_fwidth) << " " <<       
+       std::right << std::setw (g_fwidth) << " " <<       
+       std::right << std::setw (g_fwidth) << " " <<
+       std::setfill (' ')
+       );
+}
+
 int main (int argc, char *argv[])
 {
 
-  bool schedCal  = false;
-  bool schedHeap = false;
-  bool schedList = false;
-  bool schedMap  = true;
+  bool schedCal    = false;
+  bool schedHeap   = false;
+  bool schedList   = false;
+  bool schedMap    = true;
+  bool schedLadder = false;
+  bool schedAll    = false;
 
   uint32_t pop   =  100000;
   uint32_t total = 1000000;
   uint32_t runs  =       1;
   std::string filename = "";
+  std::string traceFilename = "";
   
   CommandLine cmd;
   cmd.Usage ("Benchmark the simulator scheduler.\n"
@@ -200,78 +369,110 @@ int main (int argc, char *argv[])
              "  an ascii file, given by the --file=\"<filename>\" argument,\n"
              "  or standard input, by the argument --file=\"-\"\n"
              "In the case of either --file form, the input is expected\n"
-             "to be ascii, giving the relative event times in ns.");
-  cmd.AddValue ("cal",   "use CalendarSheduler",          schedCal);
-  cmd.AddValue ("heap",  "use HeapScheduler",             schedHeap);
-  cmd.AddValue ("list",  "use ListSheduler",              schedList);
-  cmd.AddValue ("map",   "use MapScheduler (default)",    schedMap);
+             "to be ascii, giving the relative event times in ns.\n"
+             "\n"
+             "Alternatively, --trace=\"<filename>\" replays the events of a\n"
+             "DES Metrics JSON trace, as written by scripts when ns-3 is\n"
+             "configured with --enable-des-metrics.");
+  cmd.AddValue ("cal",    "use CalendarSheduler",          schedCal);
+  cmd.AddValue ("heap",   "use HeapScheduler",             schedHeap);
+  cmd.AddValue ("list",   "use ListSheduler",              schedList);
+  cmd.AddValue ("map",    "use MapScheduler (default)",    schedMap);
+  cmd.AddValue ("ladder", "use LadderScheduler",           schedLadder);
+  cmd.AddValue ("all",    "compare all the schedulers",    schedAll);
   cmd.AddValue ("debug", "enable debugging output",       g_debug);
   cmd.AddValue ("pop",   "event population size (default 1E5)",         pop);
   cmd.AddValue ("total", "total number of events to run (default 1E6)", total);
   cmd.AddValue ("runs",  "number of runs (default 1)",    runs);
   cmd.AddValue ("file",  "file of relative event times",  filename);
+  cmd.AddValue ("trace", "DES Metrics event trace to replay", traceFilename);
   cmd.AddValue ("prec",  "printed output precision",      g_fwidth);
   cmd.Parse (argc, argv);
   g_me = cmd.GetName () + ": ";
   g_fwidth += 6;  // 5 extra chars in '2.000002e+07 ': . e+0 _
 
-  ObjectFactory factory ("ns3::MapScheduler");
-  if (schedCal)  { factory.SetTypeId ("ns3::CalendarScheduler"); }
-  if (schedHeap) { factory.SetTypeId ("ns3::HeapScheduler");     }
-  if (schedList) { factory.SetTypeId ("ns3::ListScheduler");     }  
-  Simulator::SetScheduler (factory);
+  std::vector<std::string> schedulers;
+  if (schedAll)
+    {
+      schedulers.push_back ("ns3::MapScheduler");
+      schedulers.push_back ("ns3::HeapScheduler");
+      schedulers.push_back ("ns3::CalendarScheduler");
+      schedulers.push_back ("ns3::LadderScheduler");
+      // the ListScheduler is quadratic: only compare it on request
+      if (schedList)
+        {
+          schedulers.push_back ("ns3::ListScheduler");
+        }
+    }
+  else
+    {
+      std::string scheduler = "ns3::MapScheduler";
+      if (schedCal)    { scheduler = "ns3::CalendarScheduler"; }
+      if (schedHeap)   { scheduler = "ns3::HeapScheduler";     }
+      if (schedList)   { scheduler = "ns3::ListScheduler";     }  
+      if (schedLadder) { scheduler = "ns3::LadderScheduler";   }
+      schedulers.push_back (scheduler);
+    }
 
   LOGME (std::setprecision (g_fwidth - 6));
   DEB ("debugging is ON");
 
-  LOGME ("scheduler: " << factory.GetTypeId ().GetName ());
-  LOGME ("population: " << pop);
-  LOGME ("total events: " << total);
+  Bench *bench = 0;
+  TraceBench *trace = 0;
+  if (traceFilename != "")
+    {
+      trace = new TraceBench (traceFilename);
+      LOGME ("traced events: " << trace->GetSize ());
+    }
+  else
+    {
+      LOGME ("population: " << pop);
+      LOGME ("total events: " << total);
+      bench = new Bench (pop, total);
+      bench->SetRandomStream (GetRandomStream (filename));
+    }
   LOGME ("runs: " << runs);
-  
-  Bench *bench = new Bench (pop, total);
-  bench->SetRandomStream (GetRandomStream (filename));
 
-  // table header
-  LOG ("");
-  LOG (std::left << std::setw (g_fwidth) << "Run #" <<
-       std::left << std::setw (3 * g_fwidth) << "Inititialization:" <<
-       std::left << std::setw (3 * g_fwidth) << "Simulation:");
-  LOG (std::left << std::setw (g_fwidth) << "" <<
-       std::left << std::setw (g_fwidth) << "Time (s)" <<
-       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
-       std::left << std::setw (g_fwidth) << "Per (s/ev)" <<
-       std::left << std::setw (g_fwidth) << "Time (s)" <<
-       std::left << std::setw (g_fwidth) << "Rate (ev/s)" <<
-       std::left << std::setw (g_fwidth) << "Per (s/ev)" );
-  LOG (std::setfill ('-') <<
-       std::right << std::setw (g_fwidth) << " " <<
-       std::right << std::setw (g_fwidth) << " " <<       
-       std::right << std::setw (g_fwidth) << " " <<       
-       std::right << std::setw (g_fwidth) << " " <<       
-       std::right << std::setw (g_fwidth) << " " <<       
-       std::right << std::setw (g_fwidth) << " " <<       
-       std::right << std::setw (g_fwidth) << " " <<
-       std::setfill (' ')
-       );
-       
-  // prime
-  DEB ("priming");
-  std::cout << std::left << std::setw (g_fwidth) << "(prime)";
-  bench->RunBench ();
-
-  bench->SetPopulation (pop);
-  bench->SetTotal (total);
-  for (uint32_t i = 0; i < runs; i++)
+  for (std::vector<std::string>::const_iterator s = schedulers.begin ();
+       s != schedulers.end (); ++s)
     {
-      std::cout << std::setw (g_fwidth) << i;
-      
-      bench->RunBench ();
+      ObjectFactory factory (*s);
+      Simulator::SetScheduler (factory);
+
+      LOG ("");
+      LOGME ("scheduler: " << factory.GetTypeId ().GetName ());
+      PrintHeader ();
+
+      // prime
+      DEB ("priming");
+      std::cout << std::left << std::setw (g_fwidth) << "(prime)";
+      if (trace)
+        {
+          trace->RunBench ();
+        }
+      else
+        {
+          bench->RunBench ();
+          bench->SetPopulation (pop);
+          bench->SetTotal (total);
+        }
+      for (uint32_t i = 0; i < runs; i++)
+        {
+          std::cout << std::setw (g_fwidth) << i;
+          if (trace)
+            {
+              trace->RunBench ();
+            }
+          else
+            {
+              bench->RunBench ();
+            }
+        }
+      Simulator::Destroy ();
     }
 
   LOG ("");
+  delete bench;
+  delete trace;
   return 0;
-
-  Simulator::Destroy ();
-
 }
@@ -0,0 +1,186 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Measure the segments-per-second rate of the TCP send buffer, first
+// alone, as TcpSocketBase::SendDataPacket drives it (application
+// writes, in-order segments, ACKs and a few retransmissions), then
+// through a whole BulkSend transfer over a point-to-point link.
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/tcp-tx-buffer.h"
+#include "ns3/tcp-socket-base.h"
+#include "ns3/tcp-header.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-interface-container.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/bulk-send-helper.h"
+#include "ns3/packet-sink-helper.h"
+#include "ns3/application-container.h"
+#include <iostream>
+#include <limits>
+#include <algorithm>
+#include <stdlib.h> // for exit ()
+
+using namespace ns3;
+
+static uint32_t g_writeSize;
+static uint32_t g_segmentSize;
+static uint32_t g_bufferSize;
+static uint64_t g_sink; //!< keeps the extracted packets alive
+static uint64_t g_segments;
+
+/**
+ * Fill and drain a TcpTxBuffer n segments at a time: the application
+ * keeps the buffer full, a window of half the buffer is in flight, one
+ * segment out of 100 is retransmitted before it is acknowledged.
+ */
+static void
+BenchBuffer (uint32_t n)
+{
+  Ptr<TcpTxBuffer> buffer = CreateObject<TcpTxBuffer> ();
+  buffer->SetMaxBufferSize (g_bufferSize);
+  SequenceNumber32 next = buffer->HeadSequence ();
+  uint32_t window = g_bufferSize / 2;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      while (buffer->Available () >= g_writeSize)
+        {
+          buffer->Add (Create<Packet> (g_writeSize));
+        }
+      Ptr<Packet> p = buffer->CopyFromSequence (g_segmentSize, next);
+      g_sink += p->GetSize ();
+      next += p->GetSize ();
+      if (i % 100 == 0)
+        {
+          g_sink += buffer->CopyFromSequence (g_segmentSize, buffer->HeadSequence ())->GetSize ();
+        }
+      if (next - buffer->HeadSequence () > static_cast<int32_t> (window))
+        {
+          buffer->DiscardUpTo (buffer->HeadSequence () + g_segmentSize * 2);
+        }
+    }
+}
+
+static void
+CountSegment (Ptr<const Packet> p, const TcpHeader &header, Ptr<const TcpSocketBase> socket)
+{
+  if (p->GetSize () > 0)
+    {
+      ++g_segments;
+    }
+}
+
+/**
+ * Send n segments with BulkSend from one node to another.
+ */
+static void
+BenchTransfer (uint32_t n)
+{
+  Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (g_segmentSize));
+  Config::SetDefault ("ns3::TcpSocket::SndBufSize", UintegerValue (g_bufferSize));
+  Config::SetDefault ("ns3::TcpSocket::RcvBufSize", UintegerValue (g_bufferSize));
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("10Gbps"));
+  p2p.SetChannelAttribute ("Delay", StringValue ("10us"));
+  NetDeviceContainer devices = p2p.Install (nodes);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressHelper address ("10.0.0.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = address.Assign (devices);
+
+  BulkSendHelper source ("ns3::TcpSocketFactory", InetSocketAddress (interfaces.GetAddress (1), 5001));
+  source.SetAttribute ("SendSize", UintegerValue (g_writeSize));
+  source.SetAttribute ("MaxBytes", UintegerValue (static_cast<uint64_t> (n) * g_segmentSize));
+  source.Install (nodes.Get (0));
+  PacketSinkHelper sink ("ns3::TcpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), 5001));
+  sink.Install (nodes.Get (1));
+
+  // the socket is created when the application starts
+  Simulator::Schedule (NanoSeconds (1), &Config::ConnectWithoutContext,
+                       "/NodeList/0/$ns3::TcpL4Protocol/SocketList/*/Tx",
+                       MakeCallback (&CountSegment));
+  Simulator::Stop (Seconds (1000));
+  Simulator::Run ();
+  Simulator::Destroy ();
+}
+
+static void
+RunBench (void (*bench) (uint32_t), uint32_t n, uint32_t minIterations, char const *name)
+{
+  uint64_t minDelay = std::numeric_limits<uint64_t>::max ();
+  uint64_t segments = n;
+  for (uint32_t i = 0; i < minIterations; i++)
+    {
+      g_segments = 0;
+      SystemWallClockMs time;
+      time.Start ();
+      (*bench) (n);
+      minDelay = std::min (minDelay, static_cast<uint64_t> (time.End ()));
+      if (g_segments > 0)
+        {
+          segments = g_segments;
+        }
+    }
+  double ps = segments;
+  ps *= 1000;
+  ps /= std::max (minDelay, static_cast<uint64_t> (1));
+  std::cout << ps << " segments/s"
+            << " (" << segments << " segments, " << minDelay << " ms elapsed)\t"
+            << name
+            << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 1000000;
+  uint32_t minIterations = 1;
+  g_writeSize = 512;
+  g_segmentSize = 1448;
+  g_bufferSize = 131072;
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the TCP send buffer");
+  cmd.AddValue ("n", "number of segments to send", n);
+  cmd.AddValue ("write", "size of the application writes", g_writeSize);
+  cmd.AddValue ("segment", "TCP segment size", g_segmentSize);
+  cmd.AddValue ("buffer", "size of the send buffer", g_bufferSize);
+  cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
+  cmd.Parse (argc, argv);
+
+  if (n == 0 || g_writeSize == 0 || g_segmentSize == 0 || g_bufferSize < 4 * g_segmentSize)
+    {
+      std::cerr << "Error-- sizes must be positive and the buffer hold four segments" << std::endl;
+      exit (1);
+    }
+
+  std::cout << "Running bench-tcp-tx-buffer with n=" << n << " write=" << g_writeSize
+            << " segment=" << g_segmentSize << " buffer=" << g_bufferSize << std::endl;
+  RunBench (&BenchBuffer, n, minIterations, "TcpTxBuffer");
+  RunBench (&BenchTransfer, std::max (n / 10, 1u), minIterations, "BulkSend transfer");
+  return 0;
+}
@@ -0,0 +1,237 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLOW_GENERATOR_APPLICATION_H
+#define FLOW_GENERATOR_APPLICATION_H
+
+#include "ns3/address.h"
+#include "ns3/application.h"
+#include "ns3/event-id.h"
+#include "ns3/ptr.h"
+#include "ns3/data-rate.h"
+#include "ns3/nstime.h"
+#include "ns3/traced-callback.h"
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+
+class Socket;
+class ExponentialRandomVariable;
+class UniformRandomVariable;
+class EmpiricalRandomVariable;
+
+/**
+ * \ingroup applications
+ * \defgroup flowgenerator FlowGeneratorApplication
+ *
+ * This traffic generator starts flows whose sizes follow an empirical
+ * distribution, such as the web search and data mining workloads, with
+ * Poisson arrivals. Only SOCK_STREAM and SOCK_SEQPACKET sockets are
+ * supported.
+ */
+
+/**
+ * \ingroup flowgenerator
+ *
+ * \brief Start flows of empirically distributed sizes with Poisson arrivals
+ *
+ * The application sends flows from its node to a set of peers, chosen
+ * uniformly for each flow. The flow sizes are drawn from a CDF (see
+ * SetFlowSizeCdf) and the flows arrive as a Poisson process whose rate
+ * makes the offered load the Load attribute times LinkRate:
+ * Load * LinkRate / (8 * mean flow size) flows per second.
+ *
+ * The arrivals are scheduled one at a time: the application has at most
+ * one pending event, whatever the number of flows, and the state of a
+ * flow is a slot of a pool recycled when the flow completes. A flow
+ * completes when all its data has been acknowledged.
+ *
+ * By default each flow opens its own connection, and closes it once all
+ * its data is queued, which is what FctMonitor expects. With
+ * ReuseConnections, a completed flow leaves its connection open and the
+ * next flow to the same peer is sent on it: the FlowComplete trace is
+ * then the only way to measure the completion times.
+ */
+class FlowGeneratorApplication : public Application
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  FlowGeneratorApplication ();
+
+  virtual ~FlowGeneratorApplication ();
+
+  /// A CDF of flow sizes: (size in bytes, probability) points
+  typedef std::vector<std::pair<double, double> > Cdf;
+
+  /**
+   * \brief Read a CDF of flow sizes from a file
+   *
+   * Each line holds a flow size, in bytes, in its first column and the
+   * probability that a flow is not larger, as a fraction or as a
+   * percentage, in its last column. The probabilities are normalized by
+   * the last one. Empty lines and lines starting with '#' are ignored.
+   *
+   * \param fileName the name of the file
+   * \return the CDF
+   */
+  static Cdf ReadCdf (std::string fileName);
+
+  /**
+   * \param cdf the CDF of the flow sizes, in non-decreasing order
+   */
+  void SetFlowSizeCdf (const Cdf &cdf);
+
+  /**
+   * \return the mean flow size of the CDF, in bytes
+   */
+  double GetMeanFlowSize (void) const;
+
+  /**
+   * \param peers the addresses the flows are sent to
+   */
+  void SetPeers (const std::vector<Address> &peers);
+
+  /**
+   * \return the number of flows started
+   */
+  uint32_t GetNFlows (void) const;
+
+  /**
+   * \return the number of connections opened
+   */
+  uint32_t GetNConnections (void) const;
+
+  /**
+   * \brief Assign a fixed random variable stream number to the random
+   * variables used by this model.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this model
+   */
+  int64_t AssignStreams (int64_t stream);
+
+  /**
+   * TracedCallback signature for the start of a flow
+   *
+   * \param [in] size the size of the flow, in bytes
+   * \param [in] peer the address of the peer
+   */
+  typedef void (* FlowStartTracedCallback) (uint64_t size, const Address &peer);
+
+  /**
+   * TracedCallback signature for the completion of a flow
+   *
+   * \param [in] size the size of the flow, in bytes
+   * \param [in] fct the completion time of the flow
+   */
+  typedef void (* FlowCompleteTracedCallback) (uint64_t size, Time fct);
+
+protected:
+  virtual void DoDispose (void);
+private:
+  // inherited from Application base class.
+  virtual void StartApplication (void);    // Called at time specified by Start
+  virtual void StopApplication (void);     // Called at time specified by Stop
+
+  /// The state of a flow in progress
+  struct Flow
+  {
+    Ptr<Socket> socket;   //!< the socket of the flow
+    uint32_t peer;        //!< index of the peer
+    uint64_t size;        //!< size of the flow
+    uint64_t remaining;   //!< bytes not yet passed to the socket
+    uint32_t txCapacity;  //!< transmission buffer space of the idle socket
+    Time start;           //!< arrival time of the flow
+  };
+
+  /**
+   * \brief Start a flow and schedule the next arrival
+   */
+  void NewFlow (void);
+
+  /**
+   * \brief Schedule the next arrival
+   */
+  void ScheduleNextFlow (void);
+
+  /**
+   * \brief Send the data of a flow until the transmission buffer is full
+   * \param id the id of the flow
+   */
+  void SendData (uint32_t id);
+
+  /**
+   * \brief Complete a flow and recycle its slot
+   * \param id the id of the flow
+   */
+  void CompleteFlow (uint32_t id);
+
+  /**
+   * \brief Connection Succeeded (called by Socket through a callback)
+   * \param socket the connected socket
+   */
+  void ConnectionSucceeded (Ptr<Socket> socket);
+  /**
+   * \brief Connection Failed (called by Socket through a callback)
+   * \param socket the connected socket
+   */
+  void ConnectionFailed (Ptr<Socket> socket);
+  /**
+   * \brief Send more data, or complete the flow, as acknowledgments free
+   * the transmission buffer
+   */
+  void DataSend (Ptr<Socket>, uint32_t); // for socket's SetSendCallback
+
+  std::vector<Address> m_peers;          //!< Peer addresses
+  Cdf             m_cdf;                 //!< CDF of the flow sizes
+  double          m_meanSize;            //!< Mean flow size
+  double          m_load;                //!< Offered load, relative to the link rate
+  DataRate        m_linkRate;            //!< Rate of the access link
+  uint32_t        m_sendSize;            //!< Size of data to send each time
+  uint32_t        m_maxFlows;            //!< Limit on the number of flows
+  bool            m_reuse;               //!< Whether connections are reused
+  TypeId          m_tid;                 //!< The type of protocol to use.
+  bool            m_active;              //!< True between start and stop
+  uint32_t        m_nFlows;              //!< Flows started
+  uint32_t        m_nConnections;        //!< Connections opened
+  EventId         m_nextFlowEvent;       //!< Next arrival
+
+  std::vector<Flow> m_flows;                      //!< Flow slots, by id
+  std::vector<uint32_t> m_freeFlows;              //!< Unused flow slots
+  std::map<Ptr<Socket>, uint32_t> m_socketFlows;  //!< Flow of the busy sockets
+  std::vector<std::vector<Ptr<Socket> > > m_idleSockets; //!< Idle connections, by peer
+
+  Ptr<ExponentialRandomVariable> m_interArrival; //!< Time between arrivals
+  Ptr<UniformRandomVariable> m_peerChooser;      //!< Peer of a flow
+  Ptr<EmpiricalRandomVariable> m_flowSize;       //!< Size of a flow
+
+  /// Traced Callback: flow started
+  TracedCallback<uint64_t, const Address &> m_flowStartTrace;
+  /// Traced Callback: flow completed
+  TracedCallback<uint64_t, Time> m_flowCompleteTrace;
+};
+
+} // namespace ns3
+
+#endif /* FLOW_GENERATOR_APPLICATION_H */
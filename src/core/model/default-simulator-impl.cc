@@ -25,6 +25,7 @@
 
 #include "ptr.h"
 #include "pointer.h"
+#include "boolean.h"
 #include "assert.h"
 #include "log.h"
 
@@ -53,6 +54,14 @@ DefaultSimulatorImpl::GetTypeId (void)
     .SetParent<SimulatorImpl> ()
     .SetGroupName ("Core")
     .AddConstructor<DefaultSimulatorImpl> ()
+    .AddAttribute ("RemoveCancelledEvents",
+                   "Remove cancelled events from the event list instead of "
+                   "only marking them as cancelled until they reach its head. "
+                   "Only worth it with a scheduler whose Remove is cheap, such "
+                   "as the MapScheduler: the HeapScheduler removes in O(n).",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&DefaultSimulatorImpl::m_removeCancelled),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
@@ -71,6 +80,8 @@ DefaultSimulatorImpl::DefaultSimulatorImpl ()
   m_currentTs = 0;
   m_currentContext = Simulator::NO_CONTEXT;
   m_unscheduledEvents = 0;
+  m_cancelledEvents = 0;
+  m_removeCancelled = false;
   m_eventsWithContextEmpty = true;
   m_main = SystemThread::Self();
 }
@@ -141,6 +152,10 @@ DefaultSimulatorImpl::ProcessOneEvent (void)
 
   NS_ASSERT (next.key.m_ts >= m_currentTs);
   m_unscheduledEvents--;
+  if (m_cancelledEvents > 0 && next.impl->IsCancelled ())
+    {
+      m_cancelledEvents--;
+    }
 
   NS_LOG_LOGIC ("handle " << next.key.m_ts);
   m_currentTs = next.key.m_ts;
@@ -344,6 +359,12 @@ DefaultSimulatorImpl::Remove (const EventId &id)
     {
       return;
     }
+  DoRemove (id);
+}
+
+void
+DefaultSimulatorImpl::DoRemove (const EventId &id)
+{
   Scheduler::Event event;
   event.impl = id.PeekEventImpl ();
   event.key.m_ts = id.GetTs ();
@@ -360,10 +381,24 @@ DefaultSimulatorImpl::Remove (const EventId &id)
 void
 DefaultSimulatorImpl::Cancel (const EventId &id)
 {
-  if (!IsExpired (id))
+  if (IsExpired (id))
     {
+      return;
+    }
+  if (id.GetUid () == 2)
+    {
+      // destroy events are only run at Destroy: just mark them.
       id.PeekEventImpl ()->Cancel ();
     }
+  else if (m_removeCancelled)
+    {
+      DoRemove (id);
+    }
+  else
+    {
+      id.PeekEventImpl ()->Cancel ();
+      m_cancelledEvents++;
+    }
 }
 
 bool
@@ -400,6 +435,18 @@ DefaultSimulatorImpl::IsExpired (const EventId &id) const
     }
 }
 
+uint32_t
+DefaultSimulatorImpl::GetLiveEventCount (void) const
+{
+  return m_unscheduledEvents - m_cancelledEvents;
+}
+
+uint32_t
+DefaultSimulatorImpl::GetCancelledEventCount (void) const
+{
+  return m_cancelledEvents;
+}
+
 Time 
 DefaultSimulatorImpl::GetMaximumSimulationTime (void) const
 {
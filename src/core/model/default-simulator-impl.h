@@ -70,6 +70,8 @@ public:
   virtual void Remove (const EventId &id);
   virtual void Cancel (const EventId &id);
   virtual bool IsExpired (const EventId &id) const;
+  virtual uint32_t GetLiveEventCount (void) const;
+  virtual uint32_t GetCancelledEventCount (void) const;
   virtual void Run (void);
   virtual Time Now (void) const;
   virtual Time GetDelayLeft (const EventId &id) const;
@@ -85,6 +87,12 @@ private:
   void ProcessOneEvent (void);
   /** Move events from a different context into the main event queue. */
   void ProcessEventsWithContext (void);
+  /**
+   * Remove a pending event from the event list.
+   *
+   * \param [in] id The event, which must not have expired.
+   */
+  void DoRemove (const EventId &id);
  
   /** Wrap an event with its execution context. */
   struct EventWithContext {
@@ -129,6 +137,13 @@ private:
    *  not counting the Destroy events; this is used for validation
    */
   int m_unscheduledEvents;
+  /**
+   * Number of events which have been cancelled but are still in the
+   * event list.
+   */
+  int m_cancelledEvents;
+  /** Remove cancelled events from the event list. */
+  bool m_removeCancelled;
 
   /** Main execution thread. */
   SystemThread::ThreadId m_main;
@@ -21,6 +21,7 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <cstddef>
 #include "simple-ref-count.h"
 
 /**
@@ -66,6 +67,26 @@ public:
    */
   bool IsCancelled (void);
 
+  /**
+   * Allocate the storage of an event.
+   *
+   * Events are allocated and freed at a very high rate, mostly by
+   * MakeEvent(), so they are recycled through per-thread free lists,
+   * one per size class, instead of going through the global heap.
+   * Events larger than the largest size class use the global heap.
+   *
+   * \param [in] size The size of the event, in bytes.
+   * \returns The storage of the event.
+   */
+  static void * operator new (std::size_t size);
+  /**
+   * Release the storage of an event to the free list of its size class.
+   *
+   * \param [in] p The storage of the event.
+   * \param [in] size The size of the event, in bytes.
+   */
+  static void operator delete (void *p, std::size_t size);
+
 protected:
   /**
    * Implementation for Invoke().
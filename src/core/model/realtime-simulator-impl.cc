@@ -90,6 +90,7 @@ RealtimeSimulatorImpl::RealtimeSimulatorImpl ()
   m_currentTs = 0;
   m_currentContext = Simulator::NO_CONTEXT;
   m_unscheduledEvents = 0;
+  m_cancelledEvents = 0;
 
   m_main = SystemThread::Self();
 
@@ -330,6 +331,10 @@ RealtimeSimulatorImpl::ProcessOneEvent (void)
                    "RealtimeSimulatorImpl::ProcessOneEvent(): event queue is empty");
     next = m_events->RemoveNext ();
     m_unscheduledEvents--;
+    if (m_cancelledEvents > 0 && next.impl->IsCancelled ())
+      {
+        m_cancelledEvents--;
+      }
 
     //
     // We cannot make any assumption that "next" is the same event we originally waited 
@@ -753,9 +758,26 @@ RealtimeSimulatorImpl::Cancel (const EventId &id)
   if (IsExpired (id) == false)
     {
       id.PeekEventImpl ()->Cancel ();
+      if (id.GetUid () != 2)
+        {
+          CriticalSection cs (m_mutex);
+          m_cancelledEvents++;
+        }
     }
 }
 
+uint32_t
+RealtimeSimulatorImpl::GetLiveEventCount (void) const
+{
+  return m_unscheduledEvents - m_cancelledEvents;
+}
+
+uint32_t
+RealtimeSimulatorImpl::GetCancelledEventCount (void) const
+{
+  return m_cancelledEvents;
+}
+
 bool
 RealtimeSimulatorImpl::IsExpired (const EventId &id) const
 {
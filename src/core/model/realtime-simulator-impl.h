@@ -100,6 +100,8 @@ public:
   virtual void Remove (const EventId &ev);
   virtual void Cancel (const EventId &ev);
   virtual bool IsExpired (const EventId &ev) const;
+  virtual uint32_t GetLiveEventCount (void) const;
+  virtual uint32_t GetCancelledEventCount (void) const;
   virtual void Run (void);
   virtual Time Now (void) const;
   virtual Time GetDelayLeft (const EventId &id) const;
@@ -194,6 +196,11 @@ private:
   Ptr<Scheduler> m_events;
   /**< Number of events in the event list. */
   int m_unscheduledEvents;
+  /**
+   * Number of events which have been cancelled but are still in the
+   * event list.
+   */
+  int m_cancelledEvents;
   /**< Unique id for the next event to be scheduled. */
   uint32_t m_uid;
   /**< Unique id of the current event. */
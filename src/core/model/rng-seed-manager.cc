@@ -23,6 +23,10 @@
 #include "integer.h"
 #include "config.h"
 #include "log.h"
+#ifdef NS3_MTP
+#include "simulator.h"
+#include "assert.h"
+#endif
 
 /**
  * \file
@@ -34,12 +38,31 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("RngSeedManager");
 
+#ifdef NS3_MTP
+/**
+ * \relates RngSeedManager
+ * The next automatic stream number of one system, alone on its cache line.
+ */
+struct StreamIndex
+{
+  alignas (64) uint64_t next; //!< The next stream number
+};
+/**
+ * \relates RngSeedManager
+ * The next random number generator stream number to use
+ * for automatic assignment, per system id: each thread of a
+ * multithreaded simulation counts its own streams, whatever the
+ * other threads do.
+ */
+static StreamIndex g_nextStreamIndex[Simulator::MAX_SYSTEM_IDS];
+#else
 /**
  * \relates RngSeedManager
  * The next random number generator stream number to use
  * for automatic assignment.
  */
 static uint64_t g_nextStreamIndex = 0;
+#endif
 /**
  * \relates RngSeedManager
  * The random number generator seed number global value.  This is used to
@@ -100,9 +123,14 @@ uint64_t RngSeedManager::GetRun ()
 uint64_t RngSeedManager::GetNextStreamIndex (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  uint64_t next = g_nextStreamIndex;
-  g_nextStreamIndex++;
-  return next;
+#ifdef NS3_MTP
+  // the system id, in the upper bits, keeps the streams of the systems apart
+  uint32_t systemId = Simulator::GetSystemId ();
+  NS_ASSERT (systemId < Simulator::MAX_SYSTEM_IDS);
+  return static_cast<uint64_t> (systemId) << 48 | g_nextStreamIndex[systemId].next++;
+#else
+  return g_nextStreamIndex++;
+#endif
 }
 
 } // namespace ns3
@@ -337,6 +337,26 @@ Simulator::IsExpired (const EventId &id)
   return GetImpl ()->IsExpired (id);
 }
 
+uint32_t
+Simulator::GetLiveEventCount (void)
+{
+  if (*PeekImpl () == 0)
+    {
+      return 0;
+    }
+  return GetImpl ()->GetLiveEventCount ();
+}
+
+uint32_t
+Simulator::GetCancelledEventCount (void)
+{
+  if (*PeekImpl () == 0)
+    {
+      return 0;
+    }
+  return GetImpl ()->GetCancelledEventCount ();
+}
+
 Time Now (void)
 {
   return Time (Simulator::Now ());
@@ -191,6 +191,14 @@ public:
      */
     NO_CONTEXT = 0xffffffff
   };
+
+#ifdef NS3_MTP
+  /**
+   * Maximum number of system ids of a multithreaded simulation, which
+   * sizes the per system packet uid and random stream counters.
+   */
+  static const uint32_t MAX_SYSTEM_IDS = 256;
+#endif
   
   /**
    * @name Schedule events (in the same context) to run at a future time.
@@ -1084,8 +1092,11 @@ public:
    * will not be invoked when it expires.
    *
    * This method has the same visible effect as the 
-   * ns3::Simulator::Remove method but its algorithmic complexity is 
-   * much lower: it has O(1) complexity.
+   * ns3::Simulator::Remove method, and O(1) complexity.  The
+   * DefaultSimulatorImpl can also remove the event from the event list,
+   * at the cost of a Remove, so that frequently rescheduled timers do
+   * not fill the event list with dead events (see its
+   * RemoveCancelledEvents attribute, off by default).
    * This method has the exact same semantics as ns3::EventId::Cancel.
    * Note that it is not possible to cancel events which were scheduled
    * for the "destroy" time. Doing so will result in a program error (crash).
@@ -1110,6 +1121,22 @@ public:
    */
   static bool IsExpired (const EventId &id);
 
+  /**
+   * Get the number of events in the event list which will still run,
+   * not counting the events scheduled for the "destroy" time.
+   *
+   * @returns The number of pending, not cancelled, events.
+   */
+  static uint32_t GetLiveEventCount (void);
+
+  /**
+   * Get the number of events which have been cancelled but are still
+   * held in the event list, until they reach its head.
+   *
+   * @returns The number of cancelled events in the event list.
+   */
+  static uint32_t GetCancelledEventCount (void);
+
   /**
    * Return the current simulation virtual time.
    *
@@ -1178,7 +1205,8 @@ public:
    * Get the system id of this simulator.
    *
    * The system id is the identifier for this simulator instance
-   * in a distributed simulation.  For MPI this is the MPI rank.
+   * in a distributed simulation.  For MPI this is the MPI rank; for the
+   * multithreaded simulator, the partition run by the calling thread.
    * @return The system id for this simulator.
    */
   static uint32_t GetSystemId (void);
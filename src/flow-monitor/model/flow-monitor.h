@@ -23,12 +23,14 @@
 
 #include <vector>
 #include <map>
+#include <fstream>
 
 #include "ns3/ptr.h"
 #include "ns3/object.h"
 #include "ns3/flow-probe.h"
 #include "ns3/flow-classifier.h"
 #include "ns3/histogram.h"
+#include "ns3/flow-hash-table.h"
 #include "ns3/nstime.h"
 #include "ns3/event-id.h"
 
@@ -46,6 +48,25 @@ namespace ns3 {
  * The FlowMonitor class is responsible for coordinating efforts
  * regarding probes, and collects end-to-end flow statistics.
  *
+ * By default the statistics of every flow are kept until the end of
+ * the simulation. When the StreamFile attribute is set, the monitor
+ * instead streams them: a flow which has no packet in flight and has
+ * been idle for FlowIdleTimeout is finalized, that is, its statistics
+ * are appended to the file as one CSV line or binary record and its
+ * state, including the per-probe statistics, is freed. The flows still
+ * active are finalized when the monitor stops, when FlushStream is
+ * called, or when the monitor is disposed. The histograms are not
+ * collected in this mode, and GetFlowStats and the XML output only
+ * report the flows not yet finalized. A flow which resumes after being
+ * finalized is reported again, under the same flow id.
+ *
+ * Each binary record holds, in host byte order, the flow id (uint32),
+ * the times of the first and last transmitted and received packets,
+ * the delay and jitter sums (int64, in nanoseconds), the transmitted
+ * and received bytes (uint64), then the transmitted, received and lost
+ * packets and the times forwarded (uint32); the file starts with the
+ * 8 bytes "FMONBIN1". The CSV file has the same columns after a
+ * header line.
  */
 class FlowMonitor : public Object
 {
@@ -137,6 +158,13 @@ public:
     Histogram flowInterruptionsHistogram; //!< histogram of durations of flow interruptions
   };
 
+  /// Format of the flow records written in streaming mode
+  enum StreamFormat
+  {
+    STREAM_CSV,     //!< one line of comma separated values per flow
+    STREAM_BINARY   //!< one fixed-size binary record per flow
+  };
+
   // --- basic methods ---
   /**
    * \brief Get the type ID.
@@ -204,6 +232,15 @@ public:
   /// Check right now for packets that appear to be lost
   void CheckForLostPackets ();
 
+  /// In streaming mode, finalize the flows which have no packet in
+  /// flight and have been idle for at least idleTime
+  /// \param idleTime the minimum idle time
+  void FinalizeIdleFlows (Time idleTime);
+
+  /// In streaming mode, finalize all the flows right now, whether
+  /// complete or not, and flush the stream
+  void FlushStream ();
+
   /// Check right now for packets that appear to be lost, considering
   /// packets as lost if not seen in the network for a time larger
   /// than maxDelay
@@ -228,7 +265,7 @@ public:
   /// Retrieve all collected the flow statistics.  Note, if the
   /// FlowMonitor has not stopped monitoring yet, you should call
   /// CheckForLostPackets() to make sure all possibly lost packets are
-  /// accounted for.
+  /// accounted for.  The container is a snapshot taken by this call.
   /// \returns the flows statistics
   const FlowStatsContainer& GetFlowStats () const;
 
@@ -272,12 +309,21 @@ private:
     uint32_t timesForwarded; //!< number of times the packet was reportedly forwarded
   };
 
-  /// FlowId --> FlowStats
-  FlowStatsContainer m_flowStats;
+  /// Structure to represent the state of a flow
+  struct FlowState
+  {
+    FlowStats stats;          //!< the statistics of the flow
+    uint32_t packetsInFlight; //!< number of tracked packets of the flow
+  };
+
+  /// FlowId --> FlowState
+  typedef FlowHashTable<FlowState> FlowStateTable;
+  FlowStateTable m_flows; //!< the flows being monitored
+  mutable FlowStatsContainer m_flowStats; //!< snapshot returned by GetFlowStats
 
   /// (FlowId,PacketId) --> TrackedPacket
-  typedef std::map< std::pair<FlowId, FlowPacketId>, TrackedPacket> TrackedPacketMap;
-  TrackedPacketMap m_trackedPackets; //!< Tracked packets
+  typedef FlowHashTable<TrackedPacket> TrackedPacketTable;
+  TrackedPacketTable m_trackedPackets; //!< Tracked packets
   Time m_maxPerHopDelay; //!< Minimum per-hop delay
   FlowProbeContainer m_flowProbes; //!< all the FlowProbes
 
@@ -292,14 +338,37 @@ private:
   double m_packetSizeBinWidth;  //!< packet size bin width (for histograms)
   double m_flowInterruptionsBinWidth; //!< Flow interruptions bin width (for histograms)
   Time m_flowInterruptionsMinTime; //!< Flow interruptions minimum time
+  std::string m_streamFileName; //!< Stream file, empty if not streaming
+  StreamFormat m_streamFormat;  //!< Format of the stream
+  Time m_flowIdleTimeout;       //!< Idle time after which a flow is finalized
+  std::ofstream m_stream;       //!< The stream, opened on the first record
+  EventId m_finalizeEvent;      //!< Periodic finalization event
 
-  /// Get the stats for a given flow
+  /// Get the state of a given flow
   /// \param flowId the Flow identification
-  /// \returns the stats of the flow
-  FlowStats& GetStatsForFlow (FlowId flowId);
+  /// \returns the state of the flow
+  FlowState& GetStateForFlow (FlowId flowId);
 
   /// Periodic function to check for lost packets and prune statistics
   void PeriodicCheckForLostPackets ();
+
+  /// Periodic function to finalize the idle flows in streaming mode
+  void PeriodicFinalizeIdleFlows ();
+
+  /// \return true if the flows are streamed
+  bool IsStreaming () const;
+
+  /// Write the record of a flow to the stream and free its state
+  /// \param flowId the Flow identification
+  void FinalizeFlow (FlowId flowId);
+
+  /// Open the stream file, if not open yet
+  void OpenStream ();
+
+  /// Write the statistics of a flow to the stream
+  /// \param flowId the Flow identification
+  /// \param stats the statistics of the flow
+  void WriteStreamRecord (FlowId flowId, const FlowStats &stats);
 };
 
 
@@ -0,0 +1,302 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation;
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "ns3/flow-hash-table.h"
+#include "ns3/flow-monitor.h"
+#include "ns3/flow-probe.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/enum.h"
+#include "ns3/nstime.h"
+#include "ns3/test.h"
+#include <fstream>
+#include <sstream>
+#include <map>
+
+using namespace ns3;
+
+class FlowHashTableTestCase : public TestCase
+{
+public:
+  FlowHashTableTestCase ();
+  virtual void DoRun (void);
+};
+
+FlowHashTableTestCase::FlowHashTableTestCase ()
+  : TestCase ("Insert, find and erase in the flat flow hash table")
+{
+}
+
+void
+FlowHashTableTestCase::DoRun (void)
+{
+  FlowHashTable<uint32_t> table;
+  NS_TEST_EXPECT_MSG_EQ ((table.Find (1) == 0), true, "The table is empty");
+  NS_TEST_EXPECT_MSG_EQ (table.Erase (1), false, "The table is empty");
+
+  // packet keys: flow id in the high half, packet id in the low half
+  for (uint64_t flow = 1; flow <= 40; flow++)
+    {
+      for (uint64_t packet = 0; packet < 50; packet++)
+        {
+          table[(flow << 32) | packet] = flow * 1000 + packet;
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (table.GetSize (), 2000, "2000 entries expected");
+  NS_TEST_EXPECT_MSG_EQ ((table.GetNSlots () >= 4000), true, "The table should be at most half full");
+
+  // erase the odd flows
+  for (uint64_t flow = 1; flow <= 40; flow += 2)
+    {
+      for (uint64_t packet = 0; packet < 50; packet++)
+        {
+          NS_TEST_EXPECT_MSG_EQ (table.Erase ((flow << 32) | packet), true, "The entry should be erased");
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (table.GetSize (), 1000, "1000 entries expected");
+  bool found = true;
+  for (uint64_t flow = 1; flow <= 40; flow++)
+    {
+      for (uint64_t packet = 0; packet < 50; packet++)
+        {
+          uint32_t *value = table.Find ((flow << 32) | packet);
+          if (flow % 2 == 0)
+            {
+              found &= (value != 0 && *value == flow * 1000 + packet);
+            }
+          else
+            {
+              found &= (value == 0);
+            }
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (found, true, "The remaining entries should be found after the backward shifts");
+
+  uint32_t visited = 0;
+  for (uint32_t i = 0; i < table.GetNSlots (); i++)
+    {
+      if (table.IsUsed (i))
+        {
+          visited++;
+          NS_TEST_EXPECT_MSG_EQ (table.GetKey (i) % 2, table.GetValue (i) % 2, "Wrong value in slot " << i);
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (visited, 1000, "Every entry should be visited");
+
+  // the memory follows the number of entries
+  for (uint64_t flow = 2; flow <= 40; flow += 2)
+    {
+      for (uint64_t packet = 0; packet < 50; packet++)
+        {
+          table.Erase ((flow << 32) | packet);
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (table.GetSize (), 0, "The table should be empty");
+  NS_TEST_EXPECT_MSG_EQ ((table.GetNSlots () <= 32), true, "The table should have shrunk");
+}
+
+/**
+ * A probe reporting the packets the test tells it to
+ */
+class StreamTestProbe : public FlowProbe
+{
+public:
+  /**
+   * \param monitor the flow monitor
+   */
+  StreamTestProbe (Ptr<FlowMonitor> monitor)
+    : FlowProbe (monitor)
+  {
+  }
+};
+
+class FlowMonitorStreamTestCase : public TestCase
+{
+public:
+  /**
+   * \param format the format of the stream
+   */
+  FlowMonitorStreamTestCase (FlowMonitor::StreamFormat format);
+  virtual void DoRun (void);
+
+private:
+  /// Transmit a packet
+  void Tx (FlowId flowId, FlowPacketId packetId);
+  /// Receive a packet
+  void Rx (FlowId flowId, FlowPacketId packetId);
+  /// Drop a packet
+  void Drop (FlowId flowId, FlowPacketId packetId);
+  /// Check the flows still monitored
+  void CheckActive (uint32_t nFlows, uint32_t nProbeFlows);
+
+  FlowMonitor::StreamFormat m_format; //!< the format of the stream
+  Ptr<FlowMonitor> m_monitor;         //!< the flow monitor
+  Ptr<FlowProbe> m_probe;             //!< the probe
+};
+
+FlowMonitorStreamTestCase::FlowMonitorStreamTestCase (FlowMonitor::StreamFormat format)
+  : TestCase (format == FlowMonitor::STREAM_CSV ? "Stream the completed flows as CSV"
+              : "Stream the completed flows as binary records"),
+    m_format (format)
+{
+}
+
+void
+FlowMonitorStreamTestCase::Tx (FlowId flowId, FlowPacketId packetId)
+{
+  m_monitor->ReportFirstTx (m_probe, flowId, packetId, 100);
+}
+
+void
+FlowMonitorStreamTestCase::Rx (FlowId flowId, FlowPacketId packetId)
+{
+  m_monitor->ReportLastRx (m_probe, flowId, packetId, 100);
+}
+
+void
+FlowMonitorStreamTestCase::Drop (FlowId flowId, FlowPacketId packetId)
+{
+  m_monitor->ReportDrop (m_probe, flowId, packetId, 100, 0);
+}
+
+void
+FlowMonitorStreamTestCase::CheckActive (uint32_t nFlows, uint32_t nProbeFlows)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_monitor->GetFlowStats ().size (), nFlows,
+                         "Wrong number of flows at " << Simulator::Now ().GetSeconds ());
+  NS_TEST_EXPECT_MSG_EQ (m_probe->GetStats ().size (), nProbeFlows,
+                         "Wrong number of probe flows at " << Simulator::Now ().GetSeconds ());
+}
+
+void
+FlowMonitorStreamTestCase::DoRun (void)
+{
+  std::string fileName = CreateTempDirFilename ("flow-monitor-stream");
+  m_monitor = CreateObject<FlowMonitor> ();
+  m_monitor->SetAttribute ("StreamFile", StringValue (fileName));
+  m_monitor->SetAttribute ("StreamFormat", EnumValue (m_format));
+  m_monitor->SetAttribute ("FlowIdleTimeout", TimeValue (MilliSeconds (100)));
+  m_probe = CreateObject<StreamTestProbe> (m_monitor);
+
+  // flow 1 completes at 20ms, flow 3 loses its packet at 30ms and
+  // flow 2 receives its packet at 500ms
+  Simulator::Schedule (MilliSeconds (10), &FlowMonitorStreamTestCase::Tx, this, 1, 0);
+  Simulator::Schedule (MilliSeconds (10), &FlowMonitorStreamTestCase::Tx, this, 2, 0);
+  Simulator::Schedule (MilliSeconds (10), &FlowMonitorStreamTestCase::Tx, this, 3, 0);
+  Simulator::Schedule (MilliSeconds (20), &FlowMonitorStreamTestCase::Rx, this, 1, 0);
+  Simulator::Schedule (MilliSeconds (30), &FlowMonitorStreamTestCase::Drop, this, 3, 0);
+  Simulator::Schedule (MilliSeconds (500), &FlowMonitorStreamTestCase::Rx, this, 2, 0);
+  // flow 4 is still active when the monitor stops
+  Simulator::Schedule (MilliSeconds (700), &FlowMonitorStreamTestCase::Tx, this, 4, 0);
+
+  Simulator::Schedule (MilliSeconds (50), &FlowMonitorStreamTestCase::CheckActive, this, 3, 3);
+  // the packet of flow 2 is still in flight
+  Simulator::Schedule (MilliSeconds (350), &FlowMonitorStreamTestCase::CheckActive, this, 1, 1);
+  Simulator::Schedule (MilliSeconds (650), &FlowMonitorStreamTestCase::CheckActive, this, 0, 0);
+  Simulator::Schedule (MilliSeconds (750), &FlowMonitorStreamTestCase::CheckActive, this, 1, 1);
+  Simulator::Schedule (MilliSeconds (800), &FlowMonitor::StopRightNow, m_monitor);
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+  CheckActive (0, 0);
+
+  std::ifstream is (fileName.c_str (), std::ios::in|std::ios::binary);
+  NS_TEST_ASSERT_MSG_EQ (is.is_open (), true, "The stream file should exist");
+  std::map<uint32_t, std::vector<int64_t> > records;
+  if (m_format == FlowMonitor::STREAM_CSV)
+    {
+      std::string line;
+      std::getline (is, line);
+      NS_TEST_EXPECT_MSG_EQ (line.substr (0, 7), "flowId,", "Wrong header line");
+      while (std::getline (is, line))
+        {
+          std::istringstream fields (line);
+          std::vector<int64_t> values;
+          int64_t value;
+          char comma;
+          while (fields >> value)
+            {
+              values.push_back (value);
+              fields >> comma;
+            }
+          NS_TEST_EXPECT_MSG_EQ (values.size (), 13, "Wrong number of columns in " << line);
+          records[values[0]] = values;
+        }
+    }
+  else
+    {
+      char magic[8];
+      is.read (magic, 8);
+      NS_TEST_EXPECT_MSG_EQ (std::string (magic, 8), "FMONBIN1", "Wrong file header");
+      uint32_t flowId;
+      while (is.read (reinterpret_cast<char *> (&flowId), sizeof (flowId)))
+        {
+          std::vector<int64_t> values (1, flowId);
+          for (uint32_t i = 0; i < 6; i++)
+            {
+              int64_t time;
+              is.read (reinterpret_cast<char *> (&time), sizeof (time));
+              values.push_back (time);
+            }
+          for (uint32_t i = 0; i < 2; i++)
+            {
+              uint64_t bytes;
+              is.read (reinterpret_cast<char *> (&bytes), sizeof (bytes));
+              values.push_back (bytes);
+            }
+          for (uint32_t i = 0; i < 4; i++)
+            {
+              uint32_t count;
+              is.read (reinterpret_cast<char *> (&count), sizeof (count));
+              values.push_back (count);
+            }
+          NS_TEST_EXPECT_MSG_EQ (bool (is), true, "Truncated record");
+          records[flowId] = values;
+        }
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (records.size (), 4, "Each flow should be reported once");
+  // flowId, timeFirstTx, timeFirstRx, timeLastTx, timeLastRx, delaySum,
+  // jitterSum, txBytes, rxBytes, txPackets, rxPackets, lost, forwarded
+  int64_t flow1[] = { 1, 10000000, 20000000, 10000000, 20000000, 10000000, 0, 100, 100, 1, 1, 0, 0 };
+  int64_t flow2[] = { 2, 10000000, 500000000, 10000000, 500000000, 490000000, 0, 100, 100, 1, 1, 0, 0 };
+  int64_t flow3[] = { 3, 10000000, 0, 10000000, 0, 0, 0, 100, 0, 1, 0, 1, 0 };
+  int64_t flow4[] = { 4, 700000000, 0, 700000000, 0, 0, 0, 100, 0, 1, 0, 0, 0 };
+  NS_TEST_EXPECT_MSG_EQ ((records[1] == std::vector<int64_t> (flow1, flow1 + 13)), true, "Wrong record for flow 1");
+  NS_TEST_EXPECT_MSG_EQ ((records[2] == std::vector<int64_t> (flow2, flow2 + 13)), true, "Wrong record for flow 2");
+  NS_TEST_EXPECT_MSG_EQ ((records[3] == std::vector<int64_t> (flow3, flow3 + 13)), true, "Wrong record for flow 3");
+  NS_TEST_EXPECT_MSG_EQ ((records[4] == std::vector<int64_t> (flow4, flow4 + 13)), true, "Wrong record for flow 4");
+
+  m_monitor->Dispose ();
+  m_probe = 0;
+  m_monitor = 0;
+  Simulator::Destroy ();
+}
+
+class FlowMonitorStreamTestSuite : public TestSuite
+{
+public:
+  FlowMonitorStreamTestSuite ();
+};
+
+FlowMonitorStreamTestSuite::FlowMonitorStreamTestSuite ()
+  : TestSuite ("flow-monitor-stream", UNIT)
+{
+  AddTestCase (new FlowHashTableTestCase, TestCase::QUICK);
+  AddTestCase (new FlowMonitorStreamTestCase (FlowMonitor::STREAM_CSV), TestCase::QUICK);
+  AddTestCase (new FlowMonitorStreamTestCase (FlowMonitor::STREAM_BINARY), TestCase::QUICK);
+}
+
+static FlowMonitorStreamTestSuite g_flowMonitorStreamTestSuite;
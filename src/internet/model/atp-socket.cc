@@ -1,6 +1,8 @@
 #include "atp-socket.h"
 
 #include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "tcp-option-skip.h"
 
 namespace ns3 {
 
@@ -20,6 +22,20 @@ AtpSocket::GetTypeId (void)
                      DoubleValue (1.0 / 16.0),
                      MakeDoubleAccessor (&AtpSocket::m_g),
                      MakeDoubleChecker<double> (0.0, 1.0))
+      .AddAttribute ("LossBudget",
+                     "Fraction of the bytes sent which may be lost, i.e. "
+                     "abandoned instead of retransmitted; 0 for a reliable flow",
+                     DoubleValue (0.0001),
+                     MakeDoubleAccessor (&AtpSocket::SetLossBudget,
+                                         &AtpSocket::GetLossBudget),
+                     MakeDoubleChecker<double> (0.0, 1.0))
+      .AddAttribute ("LossWindow",
+                     "Number of bytes, the last ones sent, the LossBudget is counted over; "
+                     "0 for the whole flow",
+                     UintegerValue (0),
+                     MakeUintegerAccessor (&AtpSocket::SetLossWindow,
+                                           &AtpSocket::GetLossWindow),
+                     MakeUintegerChecker<uint32_t> ())
       .AddTraceSource ("AtpAlpha",
                        "Alpha parameter stands for the congestion status",
                        MakeTraceSourceAccessor (&AtpSocket::m_alpha),
@@ -42,12 +58,7 @@ AtpSocket::AtpSocket (void)
     m_alphaUpdateSeq (0),
     m_atpMaxSeq (0),
     m_ecnTransition (false),
-    maxLossRate (0.0001),
-    curAckRate (0.0),
-    curLossRate (0.0),
-    sentPackageNum (0),
-    ackPackageNum (0),
-    lostPackageNum (0)
+    m_skipPermitted (false)
 {
 }
 
@@ -60,13 +71,48 @@ AtpSocket::AtpSocket (const AtpSocket &sock)
     m_alphaUpdateSeq (sock.m_alphaUpdateSeq),
     m_atpMaxSeq (sock.m_atpMaxSeq),
     m_ecnTransition (sock.m_ecnTransition),
-    maxLossRate (0.0001),
-    curAckRate (0.0),
-    curLossRate (0.0),
-    sentPackageNum (0),
-    ackPackageNum (0),
-    lostPackageNum (0)
+    m_lossBudget (sock.m_lossBudget),
+    m_skipPermitted (sock.m_skipPermitted)
+{
+}
+
+void
+AtpSocket::SetLossBudget (double budget)
 {
+  NS_LOG_FUNCTION (this << budget);
+  m_lossBudget.SetBudget (budget);
+}
+
+double
+AtpSocket::GetLossBudget (void) const
+{
+  return m_lossBudget.GetBudget ();
+}
+
+void
+AtpSocket::SetLossWindow (uint32_t window)
+{
+  NS_LOG_FUNCTION (this << window);
+  m_lossBudget.SetWindow (window);
+}
+
+uint32_t
+AtpSocket::GetLossWindow (void) const
+{
+  return m_lossBudget.GetWindow ();
+}
+
+int
+AtpSocket::SendMessage (Ptr<Packet> p, uint32_t flags, double lossBudget)
+{
+  NS_LOG_FUNCTION (this << p << flags << lossBudget);
+  SequenceNumber32 head = m_txBuffer->TailSequence ();
+  int sent = Send (p, flags);
+  if (sent > 0)
+    {
+      m_lossBudget.AddMessage (head, head + sent, lossBudget);
+    }
+  return sent;
 }
 
 void
@@ -112,6 +158,7 @@ AtpSocket::UpdateRttHistory (const SequenceNumber32 &seq, uint32_t sz,
 {
   // set atp max seq to highTxMark
   m_atpMaxSeq =std::max (std::max (seq + sz, m_tcb->m_highTxMark.Get ()), m_atpMaxSeq);
+  m_lossBudget.Sent (seq, sz);
   TcpSocketBase::UpdateRttHistory (seq, sz, isRetransmission);
 }
 
@@ -150,30 +197,157 @@ AtpSocket::DoRetransmit (void)
   NS_LOG_FUNCTION (this);
   // reset atp seq value to  if retransmit (why?)
   m_alphaUpdateSeq = m_atpMaxSeq = m_tcb->m_nextTxSequence;
-  lostPackageNum++;
-  curLossRate = (double)lostPackageNum/sentPackageNum;
-  if(curLossRate >= maxLossRate){
-    TcpSocketBase::DoRetransmit ();
-  }
+  SequenceNumber32 head = m_txBuffer->HeadSequence ();
+  uint32_t size = std::min (m_txBuffer->SizeFromSequence (head), m_tcb->m_segmentSize);
+  if (m_state != SYN_SENT && AbandonRange (head, size))
+    {
+      // In case of RTO, go on after the abandoned range
+      m_tcb->m_nextTxSequence = std::max (m_tcb->m_nextTxSequence.Get (), head + size);
+      SendSkip ();
+      return;
+    }
+  TcpSocketBase::DoRetransmit ();
 }
 
-int
-AtpSocket::Send (Ptr<Packet> p, uint32_t flags)
+void
+AtpSocket::RetransmitHole (SequenceNumber32 seq, uint32_t size)
 {
-  NS_LOG_FUNCTION(this);
-  sentPackageNum++;
-  curLossRate = (double)lostPackageNum/sentPackageNum;
-  return TcpSocketBase::Send (p, flags);
+  NS_LOG_FUNCTION (this << seq << size);
+  // the holes of the SACK scoreboard are losses under the same budget
+  if (AbandonRange (seq, size))
+    {
+      SendSkip ();
+      return;
+    }
+  TcpSocketBase::RetransmitHole (seq, size);
+}
+
+bool
+AtpSocket::AbandonRange (SequenceNumber32 seq, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << seq << size);
+  if (!m_skipPermitted || size == 0
+      || m_lossBudget.GetAbandonedBytes (seq, seq + size) > 0)
+    {
+      return false;
+    }
+  if (!m_lossBudget.Abandon (seq, size))
+    {
+      return false;
+    }
+  NS_LOG_DEBUG ("Abandoned " << size << " bytes at seq " << seq);
+  return true;
 }
 
 void
-AtpSocket::NewAck (SequenceNumber32 const& ack, bool resetRTO){
-  NS_LOG_FUNCTION(this);
-  ackPackageNum++;
-  if(sentPackageNum != 0)
-    curAckRate = (double)ackPackageNum/sentPackageNum;
-    NS_LOG_DEBUG("--------at NewAck r_wnd" << m_rWnd << ", lostPackageNum = " << lostPackageNum);
-  TcpSocketBase::NewAck(ack, resetRTO);
+AtpSocket::SendSkip (void)
+{
+  NS_LOG_FUNCTION (this);
+  SendACK ();
+  if (!m_retxEvent.IsRunning ())
+    {
+      m_retxEvent = Simulator::Schedule (m_rto, &AtpSocket::ReTxTimeout, this);
+    }
+}
+
+void
+AtpSocket::NewAck (SequenceNumber32 const& ack, bool resetRTO)
+{
+  NS_LOG_FUNCTION (this << ack);
+  m_lossBudget.DiscardUpTo (ack);
+  TcpSocketBase::NewAck (ack, resetRTO);
+}
+
+void
+AtpSocket::AddOptions (TcpHeader& header)
+{
+  NS_LOG_FUNCTION (this << header);
+  TcpSocketBase::AddOptions (header);
+
+  // An empty Skip option on the SYN, and on the SYN-ACK if the SYN had one,
+  // tells that the end understands it
+  if (header.GetFlags () & TcpHeader::SYN)
+    {
+      if (!(header.GetFlags () & TcpHeader::ACK) || m_skipPermitted)
+        {
+          header.AppendOption (CreateObject<TcpOptionSkip> ());
+        }
+      return;
+    }
+  if (!m_skipPermitted)
+    {
+      return;
+    }
+  uint32_t room = header.GetMaxOptionLength () - header.GetOptionLength ();
+  if (room < 10)
+    {
+      return;
+    }
+  uint32_t maxBlocks = std::min ((room - 2) / 8, TcpOptionSkip::MAX_BLOCKS);
+  std::vector<AtpLossBudget::Range> ranges =
+    m_lossBudget.GetAbandonedRanges (m_txBuffer->HeadSequence (), maxBlocks);
+  if (ranges.empty ())
+    {
+      return;
+    }
+  Ptr<TcpOptionSkip> option = CreateObject<TcpOptionSkip> ();
+  for (std::vector<AtpLossBudget::Range>::const_iterator it = ranges.begin (); it != ranges.end (); ++it)
+    {
+      option->AddSkipBlock (*it);
+    }
+  header.AppendOption (option);
+  NS_LOG_INFO (m_node->GetId () << " Add option Skip with " << ranges.size () << " ranges");
+}
+
+void
+AtpSocket::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
+                        const Address &toAddress)
+{
+  NS_LOG_FUNCTION (this << packet);
+  TcpHeader tcpHeader;
+  packet->PeekHeader (tcpHeader);
+  if (tcpHeader.GetFlags () & TcpHeader::SYN)
+    {
+      // The Skip option is used only if both ends understand it
+      m_skipPermitted = tcpHeader.HasOption (TcpOption::SKIP);
+    }
+
+  TcpSocketBase::DoForwardUp (packet, fromAddress, toAddress);
+
+  if (m_skipPermitted && !(tcpHeader.GetFlags () & TcpHeader::SYN)
+      && tcpHeader.HasOption (TcpOption::SKIP)
+      && (m_state == ESTABLISHED || m_state == FIN_WAIT_1 || m_state == FIN_WAIT_2))
+    {
+      ProcessOptionSkip (tcpHeader.GetOption (TcpOption::SKIP));
+    }
+}
+
+void
+AtpSocket::ProcessOptionSkip (const Ptr<const TcpOption> option)
+{
+  NS_LOG_FUNCTION (this << option);
+
+  Ptr<const TcpOptionSkip> skip = DynamicCast<const TcpOptionSkip> (option);
+  SequenceNumber32 expectedSeq = m_rxBuffer->NextRxSequence ();
+  const TcpOptionSkip::SkipList &list = skip->GetSkipList ();
+  for (TcpOptionSkip::SkipList::const_iterator it = list.begin (); it != list.end (); ++it)
+    {
+      m_rxBuffer->Fill (it->first, it->second);
+    }
+  if (expectedSeq < m_rxBuffer->NextRxSequence ())
+    { // The application reads the abandoned bytes as zeros, and the sender
+      // learns that they need no retransmission
+      NS_LOG_DEBUG ("Skipped from " << expectedSeq << " to " << m_rxBuffer->NextRxSequence ());
+      SendACK ();
+      if (!m_shutdownRecv)
+        {
+          NotifyDataRecv ();
+        }
+      if (m_rxBuffer->Finished ())
+        {
+          DoPeerClose ();
+        }
+    }
 }
 
 Ptr<TcpSocketBase>
@@ -4,6 +4,7 @@
 #include "tcp-socket-base.h"
 #include "tcp-congestion-ops.h"
 #include "tcp-l4-protocol.h"
+#include "atp-loss-budget.h"
 
 namespace ns3 {
 
@@ -36,6 +37,51 @@ public:
    */
   AtpSocket (const AtpSocket& sock);
 
+  /**
+   * \brief Set the loss budget of the flow
+   *
+   * The data sent out of a message may lose this fraction of the last
+   * LossWindow bytes sent: the losses are abandoned instead of
+   * retransmitted while they stay within it, and the receiver reads the
+   * abandoned bytes as zeros.  A budget of 0 makes the flow reliable;
+   * the default, 0.0001, is the loss rate ATP has always tolerated.
+   *
+   * \param budget the fraction of the bytes sent which may be lost
+   */
+  void SetLossBudget (double budget);
+
+  /**
+   * \brief Get the loss budget of the flow
+   * \returns the fraction of the bytes sent which may be lost
+   */
+  double GetLossBudget (void) const;
+
+  /**
+   * \brief Set the window the loss budget of the flow is counted over
+   * \param window the number of bytes, the last ones sent; 0 for the
+   * whole flow
+   */
+  void SetLossWindow (uint32_t window);
+
+  /**
+   * \brief Get the window the loss budget of the flow is counted over
+   * \returns the number of bytes
+   */
+  uint32_t GetLossWindow (void) const;
+
+  /**
+   * \brief Send a message with its own loss budget
+   *
+   * The bytes of the message are queued as Send does; up to lossBudget of
+   * them may be abandoned, whatever the budget of the flow.
+   *
+   * \param p the message
+   * \param flags the flags of Send
+   * \param lossBudget the fraction of the bytes of the message which may be lost
+   * \returns the number of bytes accepted, -1 on error
+   */
+  int SendMessage (Ptr<Packet> p, uint32_t flags, double lossBudget);
+
 protected:
 
   // inherited from TcpSocketBase
@@ -44,8 +90,11 @@ protected:
   virtual void UpdateRttHistory (const SequenceNumber32 &seq, uint32_t sz,
                                  bool isRetransmission);
   virtual void DoRetransmit (void);
-  virtual void NewAck (SequenceNumber32 const& ack, bool resetRTO); // 重载TCP的收到ack函数
-  virtual int Send (Ptr<Packet> p, uint32_t flags);                 // 重载TCP的send函数
+  virtual void RetransmitHole (SequenceNumber32 seq, uint32_t size);
+  virtual void NewAck (SequenceNumber32 const& ack, bool resetRTO);
+  virtual void AddOptions (TcpHeader& tcpHeader);
+  virtual void DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
+                            const Address &toAddress);
   virtual Ptr<TcpSocketBase> Fork (void);
   virtual void UpdateEcnState (const TcpHeader &tcpHeader);
   virtual uint32_t GetSsThresh (void);
@@ -53,6 +102,30 @@ protected:
 
   void UpdateAlpha (const TcpHeader &tcpHeader);
 
+  /**
+   * \brief Abandon a lost range if the loss budget allows it
+   *
+   * A range abandoned already is not abandoned again: its retransmission
+   * carries the Skip option too, and counts against the retries.
+   *
+   * \param seq sequence number of the first byte lost
+   * \param size number of bytes lost
+   * \returns true if the range is abandoned
+   */
+  bool AbandonRange (SequenceNumber32 seq, uint32_t size);
+
+  /**
+   * \brief Tell the peer about the abandoned ranges at once, in an ACK
+   * with the Skip option; the retransmission timer covers its loss
+   */
+  void SendSkip (void);
+
+  /**
+   * \brief Fill the ranges the peer abandoned and acknowledge past them
+   * \param option the Skip option
+   */
+  void ProcessOptionSkip (const Ptr<const TcpOption> option);
+
   // ATP related params
   double m_g;   //!< atp g param
   TracedValue<double> m_alpha;   //!< atp alpha param
@@ -62,12 +135,8 @@ protected:
   SequenceNumber32 m_atpMaxSeq;
   bool m_ecnTransition; //!< ce state machine to support delayed ACK
 
-  double maxLossRate; //maximum loss rate set by application
-  double curAckRate; 
-  double curLossRate;//current loss rate
-  int sentPackageNum; //package num had sent
-  int ackPackageNum;  //package num had ack
-  int lostPackageNum;
+  AtpLossBudget m_lossBudget; //!< The losses the flow may leave unrepaired
+  bool m_skipPermitted;       //!< Both ends understand the Skip option
 };
 
 } // namespace ns3
@@ -49,24 +49,27 @@ operator<< (std::ostream& os, const SPFVertex::VertexType& t)
 std::ostream& 
 operator<< (std::ostream& os, const CandidateQueue& q)
 {
-  typedef CandidateQueue::CandidateList_t List_t;
-  typedef List_t::const_iterator CIter_t;
-  const CandidateQueue::CandidateList_t& list = q.m_candidates;
+  typedef std::vector<CandidateQueue::Candidate> Heap_t;
+  typedef Heap_t::const_iterator CIter_t;
+  Heap_t sorted = q.m_heap;
+  std::sort (sorted.begin (), sorted.end ());
 
   os << "*** CandidateQueue Begin (<id, distance, LSA-type>) ***" << std::endl;
-  for (CIter_t iter = list.begin (); iter != list.end (); iter++)
+  for (CIter_t iter = sorted.begin (); iter != sorted.end (); iter++)
     {
       os << "<" 
-      << (*iter)->GetVertexId () << ", "
-      << (*iter)->GetDistanceFromRoot () << ", "
-      << (*iter)->GetVertexType () << ">" << std::endl;
+      << iter->vertex->GetVertexId () << ", "
+      << iter->vertex->GetDistanceFromRoot () << ", "
+      << iter->vertex->GetVertexType () << ">" << std::endl;
     }
   os << "*** CandidateQueue End ***";
   return os;
 }
 
 CandidateQueue::CandidateQueue()
-  : m_candidates ()
+  : m_heap (),
+    m_index (),
+    m_sequence (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -81,7 +84,7 @@ void
 CandidateQueue::Clear (void)
 {
   NS_LOG_FUNCTION (this);
-  while (!m_candidates.empty ())
+  while (!m_heap.empty ())
     {
       SPFVertex *p = Pop ();
       delete p;
@@ -94,24 +97,37 @@ CandidateQueue::Push (SPFVertex *vNew)
 {
   NS_LOG_FUNCTION (this << vNew);
 
-  CandidateList_t::iterator i = std::upper_bound (
-      m_candidates.begin (), m_candidates.end (), vNew,
-      &CandidateQueue::CompareSPFVertex
-      );
-  m_candidates.insert (i, vNew);
+  Candidate c;
+  c.vertex = vNew;
+  Place (c);
+  m_heap.push_back (c);
+  vNew->m_candidateIndex = m_heap.size () - 1;
+  SiftUp (m_heap.size () - 1);
+  m_index.insert (std::make_pair (vNew->GetVertexId (), vNew));
 }
 
 SPFVertex *
 CandidateQueue::Pop (void)
 {
   NS_LOG_FUNCTION (this);
-  if (m_candidates.empty ())
+  if (m_heap.empty ())
     {
       return 0;
     }
 
-  SPFVertex *v = m_candidates.front ();
-  m_candidates.pop_front ();
+  SPFVertex *v = m_heap.front ().vertex;
+  std::map<Ipv4Address, SPFVertex*>::iterator i = m_index.find (v->GetVertexId ());
+  if (i != m_index.end () && i->second == v)
+    {
+      m_index.erase (i);
+    }
+  Candidate last = m_heap.back ();
+  m_heap.pop_back ();
+  if (!m_heap.empty ())
+    {
+      Store (0, last);
+      SiftDown (0);
+    }
   return v;
 }
 
@@ -119,44 +135,55 @@ SPFVertex *
 CandidateQueue::Top (void) const
 {
   NS_LOG_FUNCTION (this);
-  if (m_candidates.empty ())
+  if (m_heap.empty ())
     {
       return 0;
     }
 
-  return m_candidates.front ();
+  return m_heap.front ().vertex;
 }
 
 bool
 CandidateQueue::Empty (void) const
 {
   NS_LOG_FUNCTION (this);
-  return m_candidates.empty ();
+  return m_heap.empty ();
 }
 
 uint32_t
 CandidateQueue::Size (void) const
 {
   NS_LOG_FUNCTION (this);
-  return m_candidates.size ();
+  return m_heap.size ();
 }
 
 SPFVertex *
 CandidateQueue::Find (const Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this);
-  CandidateList_t::const_iterator i = m_candidates.begin ();
-
-  for (; i != m_candidates.end (); i++)
+  std::map<Ipv4Address, SPFVertex*>::const_iterator i = m_index.find (addr);
+  if (i == m_index.end ())
     {
-      SPFVertex *v = *i;
-      if (v->GetVertexId () == addr)
-        {
-          return v;
-        }
+      return 0;
     }
+  return i->second;
+}
 
-  return 0;
+void
+CandidateQueue::DecreaseKey (SPFVertex *v)
+{
+  NS_LOG_FUNCTION (this << v);
+  uint32_t index = v->m_candidateIndex;
+  NS_ASSERT_MSG (index < m_heap.size () && m_heap[index].vertex == v,
+                 "CandidateQueue::DecreaseKey (): vertex not in the queue");
+  NS_ASSERT_MSG (v->GetDistanceFromRoot () <= m_heap[index].distance,
+                 "CandidateQueue::DecreaseKey (): distance increased");
+  if (v->GetDistanceFromRoot () == m_heap[index].distance)
+    {
+      return;
+    }
+  Place (m_heap[index]);
+  SiftUp (index);
 }
 
 void
@@ -164,11 +191,84 @@ CandidateQueue::Reorder (void)
 {
   NS_LOG_FUNCTION (this);
 
-  m_candidates.sort (&CandidateQueue::CompareSPFVertex);
+//
+// Sorting by the ranks the vertices were placed at gives the order of the
+// queue before the distances changed.  Placing the vertices again in that
+// order, then sorting by the new ranks, is a stable sort by distance; a
+// sorted vector is a heap.
+//
+  std::sort (m_heap.begin (), m_heap.end ());
+  for (std::vector<Candidate>::iterator i = m_heap.begin (); i != m_heap.end (); i++)
+    {
+      Place (*i);
+    }
+  std::sort (m_heap.begin (), m_heap.end ());
+  for (uint32_t i = 0; i < m_heap.size (); i++)
+    {
+      m_heap[i].vertex->m_candidateIndex = i;
+    }
   NS_LOG_LOGIC ("After reordering the CandidateQueue");
   NS_LOG_LOGIC (*this);
 }
 
+void
+CandidateQueue::Place (Candidate &c)
+{
+  c.distance = c.vertex->GetDistanceFromRoot ();
+  c.network = c.vertex->GetVertexType () == SPFVertex::VertexNetwork;
+  c.sequence = m_sequence++;
+}
+
+void
+CandidateQueue::Store (uint32_t index, const Candidate &c)
+{
+  m_heap[index] = c;
+  c.vertex->m_candidateIndex = index;
+}
+
+void
+CandidateQueue::SiftUp (uint32_t index)
+{
+  Candidate c = m_heap[index];
+  while (index > 0)
+    {
+      uint32_t parent = (index - 1) / 2;
+      if (!(c < m_heap[parent]))
+        {
+          break;
+        }
+      Store (index, m_heap[parent]);
+      index = parent;
+    }
+  Store (index, c);
+}
+
+void
+CandidateQueue::SiftDown (uint32_t index)
+{
+  Candidate c = m_heap[index];
+  uint32_t size = m_heap.size ();
+  for (;;)
+    {
+      uint32_t child = 2 * index + 1;
+      if (child >= size)
+        {
+          break;
+        }
+      if (child + 1 < size && m_heap[child + 1] < m_heap[child])
+        {
+          child++;
+        }
+      if (!(m_heap[child] < c))
+        {
+          break;
+        }
+      Store (index, m_heap[child]);
+      index = child;
+    }
+  Store (index, c);
+}
+
 /*
  * In this implementation, SPFVertex follows the ordering where
  * a vertex is ranked first if its GetDistanceFromRoot () is smaller;
@@ -177,24 +277,17 @@ CandidateQueue::Reorder (void)
  * This ordering is necessary for implementing ECMP
  */
 bool 
-CandidateQueue::CompareSPFVertex (const SPFVertex* v1, const SPFVertex* v2)
+CandidateQueue::Candidate::operator< (const Candidate &other) const
 {
-  NS_LOG_FUNCTION (&v1 << &v2);
-
-  bool result = false;
-  if (v1->GetDistanceFromRoot () < v2->GetDistanceFromRoot ())
+  if (distance != other.distance)
     {
-      result = true;
+      return distance < other.distance;
     }
-  else if (v1->GetDistanceFromRoot () == v2->GetDistanceFromRoot ())
+  if (network != other.network)
     {
-      if (v1->GetVertexType () == SPFVertex::VertexNetwork 
-          && v2->GetVertexType () == SPFVertex::VertexRouter)
-        {
-          result = true;
-        }
+      return network;
     }
-  return result;
+  return sequence < other.sequence;
 }
 
 } // namespace ns3
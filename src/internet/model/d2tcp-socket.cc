@@ -131,6 +131,8 @@ D2tcpSocket::Connect (const Address &address)
 
   m_finishTime = m_deadline != Time (0) ? Simulator::Now () + m_deadline : Time (0);
 
+  StartFlow ();
+
   // DoConnect() will do state-checking and send a SYN packet
   return DoConnect ();
 }
@@ -172,6 +174,12 @@ D2tcpSocket::Fork (void)
   return CopyObject<D2tcpSocket> (this);
 }
 
+Time
+D2tcpSocket::GetFlowDeadline (void) const
+{
+  return m_deadline;
+}
+
 uint32_t
 D2tcpSocket::GetSsThresh (void)
 {
@@ -38,6 +38,8 @@ const uint32_t SPF_INFINITY = 0xffffffff; //!< "infinite" distance between nodes
 
 class CandidateQueue;
 class Ipv4GlobalRouting;
+class Ipv4;
+class Node;
 
 /**
  * \ingroup globalrouting
@@ -538,6 +540,9 @@ private:
   ListOfSPFVertex_t m_parents; //!< parent list
   ListOfSPFVertex_t m_children; //!< Children list
   bool m_vertexProcessed; //!< Flag to note whether vertex has been processed in stage two of SPF computation
+  uint32_t m_candidateIndex; //!< Position in the heap of the CandidateQueue holding the vertex
+
+  friend class CandidateQueue;
 
 /**
  * @brief The SPFVertex copy construction is disallowed.  There's no need for
@@ -606,6 +611,11 @@ public:
  *
  * @see GlobalRoutingLSA
  * @see Ipv4Address
+ * The LSA is given the next index of the database (see
+ * GlobalRoutingLSA::GetIndex), and its transit network link records are
+ * indexed for GetLSAByLinkData, so they must be complete when it is
+ * inserted.  An LSA whose address is already in the database is ignored.
+ *
  * @param addr The IP address associated with the LSA.  Typically the Router 
  * ID.
  * @param lsa A pointer to the Link State Advertisement for the router.
@@ -641,13 +651,25 @@ public:
  */
   GlobalRoutingLSA* GetLSAByLinkData (Ipv4Address addr) const;
 
+/**
+ * @brief Get the number of Link State Advertisements in the database, not
+ * counting the External Link State Advertisements.
+ *
+ * The LSAs of the database have the indices 0 to GetNumLSAs () - 1.
+ *
+ * @see GlobalRoutingLSA::GetIndex
+ * @returns the number of Link State Advertisements.
+ */
+  uint32_t GetNumLSAs () const;
+
 /**
  * @brief Set all LSA flags to an initialized state, for SPF computation
  *
  * This function walks the database and resets the status flags of all of the
- * contained Link State Advertisements to LSA_SPF_NOT_EXPLORED.  This is done
- * prior to each SPF calculation to reset the state of the SPFVertex structures
- * that will reference the LSAs during the calculation.
+ * contained Link State Advertisements to LSA_SPF_NOT_EXPLORED.  The SPF
+ * calculations of GlobalRouteManagerImpl no longer use these flags: they
+ * keep the status of the LSAs by index (see GlobalRoutingLSA::GetIndex), so
+ * that several calculations can share the database.
  *
  * @see GlobalRoutingLSA
  * @see SPFVertex
@@ -680,6 +702,8 @@ private:
   typedef std::pair<Ipv4Address, GlobalRoutingLSA*> LSDBPair_t; //!< pair of IPv4 addresses / Link State Advertisements
 
   LSDBMap_t m_database; //!< database of IPv4 addresses / Link State Advertisements
+  /// Link data of the transit network link records / the first entry of m_database holding one
+  std::map<Ipv4Address, LSDBPair_t> m_linkDataIndex;
   std::vector<GlobalRoutingLSA*> m_extdatabase; //!< database of External Link State Advertisements
 
 /**
@@ -707,6 +731,11 @@ private:
  * Then, it can compute shortest paths on a per-node basis to all routers, 
  * and finally configure each of the node's forwarding tables.
  *
+ * The per-node computations only read the LSDB and only write the
+ * forwarding table of their root, so InitializeRoutes () can run them on
+ * several threads: see the GlobalRoutingSpfThreads global value.  The
+ * routes do not depend on the number of threads.
+ *
  * The design is guided by OSPFv2 \RFC{2328} section 16.1.1 and quagga ospfd.
  */
 class GlobalRouteManagerImpl
@@ -732,6 +761,10 @@ public:
 /**
  * @brief Compute routes using a Dijkstra SPF computation and populate
  * per-node forwarding tables
+ *
+ * The computations of the routers are shared among the number of threads
+ * of the GlobalRoutingSpfThreads global value.  The log output of
+ * concurrent computations is interleaved.
  */
   virtual void InitializeRoutes ();
 
@@ -766,8 +799,41 @@ private:
  */
   GlobalRouteManagerImpl& operator= (GlobalRouteManagerImpl& srmi);
 
+  /// The routers whose routes InitializeRoutes () computes, shared by its threads
+  struct SPFRootQueue;
+
+/**
+ * @brief Create a worker computing routes on the LSDB of another global
+ * route manager, which keeps the ownership of the LSDB
+ *
+ * @param lsdb the LSDB
+ * @param roots the routers whose routes are computed
+ */
+  GlobalRouteManagerImpl (GlobalRouteManagerLSDB* lsdb, SPFRootQueue* roots);
+
+  /**
+   * \brief Compute the routes of the routers of m_rootQueue, one after the
+   * other, until there are none left
+   *
+   * This is the body of each thread of InitializeRoutes ().
+   */
+  void SPFCalculateQueued (void);
+
+  /**
+   * \brief Look up the node of a router
+   * \param routerId the router ID
+   * \returns the node whose GlobalRouter has this ID, or 0
+   */
+  static Ptr<Node> FindRouterNode (Ipv4Address routerId);
+
   SPFVertex* m_spfroot; //!< the root node
   GlobalRouteManagerLSDB* m_lsdb; //!< the Link State DataBase (LSDB) of the Global Route Manager
+  bool m_ownsLsdb; //!< whether m_lsdb is deleted with this object
+  SPFRootQueue* m_rootQueue; //!< the routers whose routes are being computed
+  Ptr<Node> m_spfrootNode; //!< the node of the root, if any
+  Ptr<Ipv4> m_spfrootIpv4; //!< the Ipv4 of the node of the root
+  Ptr<Ipv4GlobalRouting> m_spfrootRouting; //!< the routing protocol written to
+  std::vector<GlobalRoutingLSA::SPFStatus> m_lsaStatus; //!< SPF status of the LSAs, by LSDB index
 
   /**
    * \brief Test if a node is a stub, from an OSPF sense.
@@ -789,6 +855,18 @@ private:
    */
   void SPFCalculate (Ipv4Address root);
 
+  /**
+   * \brief Calculate the shortest path first (SPF) tree and write the routes
+   * to the node of the root
+   *
+   * The computation only touches the LSDB, without changing it, and the
+   * node; it does not look at the other nodes.
+   *
+   * \param root the root node
+   * \param node the node of the root, or 0 if there is none
+   */
+  void SPFCalculate (Ipv4Address root, Ptr<Node> node);
+
   /**
    * \brief Process Stub nodes
    *
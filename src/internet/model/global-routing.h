@@ -55,8 +55,9 @@
  * ns3::GlobalRouteManager::PopulateRoutingTables (), prior to the 
  * ns3::Simulator::Run() call.
  *
- * There are two attributes of Ipv4GlobalRouting that govern behavior.
- * - Ipv4GlobalRouting::RandomEcmpRouting
+ * There are three attributes of Ipv4GlobalRouting that govern behavior.
+ * - Ipv4GlobalRouting::EcmpMode
+ * - Ipv4GlobalRouting::EcmpHashSalt
  * - Ipv4GlobalRouting::RespondToInterfaceEvents
  *
  * \section impl Implementation
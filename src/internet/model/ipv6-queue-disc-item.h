@@ -85,6 +85,14 @@ public:
    */
   virtual bool Mark (void);
 
+  /**
+   * \brief Marks a wire segment of a super-segment in its SegmentationTag
+   * if the packet has ECN_ECT0 or ECN_ECT1 bits set
+   * \param segment the index of the wire segment
+   * \return true if the segment is marked
+   */
+  virtual bool MarkSegment (uint32_t segment);
+
 private:
   /**
    * \brief Default constructor
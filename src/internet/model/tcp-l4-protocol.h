@@ -41,6 +41,7 @@ class TcpSocketBase;
 class Ipv4EndPoint;
 class Ipv6EndPoint;
 class NetDevice;
+class FctMonitor;
 
 
 /**
@@ -130,6 +131,15 @@ public:
    */
   Ptr<Socket> CreateSocket (TypeId congestionTypeId, TypeId socketBaseTypeId);
 
+  /**
+   * \brief Set the monitor of the flow completion times
+   *
+   * The sockets created afterwards report their flows to it.
+   *
+   * \param monitor the monitor, or 0 to record no flow
+   */
+  void SetFctMonitor (Ptr<FctMonitor> monitor);
+
   /**
    * \brief Allocate an IPv4 Endpoint
    * \return the Endpoint
@@ -315,6 +325,7 @@ private:
   TypeId m_congestionTypeId;       //!< The congestion TypeId
   TypeId m_socketBaseTypeId;           //!< The socketBase TypeId
   std::vector<Ptr<TcpSocketBase> > m_sockets;      //!< list of sockets
+  Ptr<FctMonitor> m_fctMonitor;                    //!< monitor of the flow completion times
   IpL4Protocol::DownTargetCallback m_downTarget;   //!< Callback to send packets over IPv4
   IpL4Protocol::DownTargetCallback6 m_downTarget6; //!< Callback to send packets over IPv6
 
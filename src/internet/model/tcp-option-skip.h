@@ -0,0 +1,93 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TCP_OPTION_SKIP_H
+#define TCP_OPTION_SKIP_H
+
+#include <vector>
+#include <utility>
+#include "ns3/tcp-option.h"
+#include "ns3/sequence-number.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Defines the TCP option of kind 253 (experimental, \RFC{4727})
+ * carrying the ranges of data an ATP sender abandoned
+ *
+ * The sender lists the ranges it gave up retransmitting beyond the
+ * cumulative ACK, each as the sequence number of its first byte and the
+ * one following its last byte, as the SACK option does; the receiver
+ * fills them with zeros and acknowledges past them.  An option without
+ * blocks, sent on the SYN and the SYN-ACK, tells that the end
+ * understands the option.
+ */
+class TcpOptionSkip : public TcpOption
+{
+public:
+  /// An abandoned range, [first, second)
+  typedef std::pair<SequenceNumber32, SequenceNumber32> SkipBlock;
+  /// The ranges of an option
+  typedef std::vector<SkipBlock> SkipList;
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  TcpOptionSkip ();
+  virtual ~TcpOptionSkip ();
+
+  virtual void Print (std::ostream &os) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+  virtual uint8_t GetKind (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+
+  /**
+   * \brief Add a range at the end of the option
+   *
+   * \param block the range, which must not be empty
+   */
+  void AddSkipBlock (SkipBlock block);
+
+  /**
+   * \brief Get the number of ranges
+   * \return the number of ranges
+   */
+  uint32_t GetNumSkipBlocks (void) const;
+
+  /**
+   * \brief Get the ranges, in the order of the option
+   * \return the ranges
+   */
+  const SkipList & GetSkipList (void) const;
+
+  /// Maximum number of ranges of an option, bound by the 40 bytes of option space
+  static const uint32_t MAX_BLOCKS = 4;
+
+protected:
+  SkipList m_skipList; //!< The ranges
+};
+
+} // namespace ns3
+
+#endif /* TCP_OPTION_SKIP_H */
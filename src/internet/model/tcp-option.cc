@@ -22,6 +22,9 @@
 #include "tcp-option-rfc793.h"
 #include "tcp-option-winscale.h"
 #include "tcp-option-ts.h"
+#include "tcp-option-sack-permitted.h"
+#include "tcp-option-sack.h"
+#include "tcp-option-skip.h"
 
 #include "ns3/type-id.h"
 #include "ns3/log.h"
@@ -68,7 +71,6 @@ TcpOption::CreateOption (uint8_t kind)
     TypeId tid;
   };
 
-  static ObjectFactory objectFactory;
   static kindToTid toTid[] =
   {
     { TcpOption::END,       TcpOptionEnd::GetTypeId () },
@@ -76,6 +78,9 @@ TcpOption::CreateOption (uint8_t kind)
     { TcpOption::NOP,       TcpOptionNOP::GetTypeId () },
     { TcpOption::TS,        TcpOptionTS::GetTypeId () },
     { TcpOption::WINSCALE,  TcpOptionWinScale::GetTypeId () },
+    { TcpOption::SACKPERMITTED, TcpOptionSackPermitted::GetTypeId () },
+    { TcpOption::SACK,      TcpOptionSack::GetTypeId () },
+    { TcpOption::SKIP,      TcpOptionSkip::GetTypeId () },
     { TcpOption::UNKNOWN,  TcpOptionUnknown::GetTypeId () }
   };
 
@@ -83,6 +88,7 @@ TcpOption::CreateOption (uint8_t kind)
     {
       if (toTid[i].kind == kind)
         {
+          ObjectFactory objectFactory;
           objectFactory.SetTypeId (toTid[i].tid);
           return objectFactory.Create<TcpOption> ();
         }
@@ -100,7 +106,10 @@ TcpOption::IsKindKnown (uint8_t kind)
     case NOP:
     case MSS:
     case WINSCALE:
+    case SACKPERMITTED:
+    case SACK:
     case TS:
+    case SKIP:
     // Do not add UNKNOWN here
       return true;
     }
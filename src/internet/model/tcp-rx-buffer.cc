@@ -18,6 +18,8 @@
  * Author: Adrian Sai-wah Tam <adrian.sw.tam@gmail.com>
  */
 
+#include <algorithm>
+
 #include "ns3/packet.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
@@ -52,12 +54,36 @@ TcpRxBuffer::GetTypeId (void)
  * initialized below is insignificant.
  */
 TcpRxBuffer::TcpRxBuffer (uint32_t n)
-  : m_nextRxSeq (n), m_gotFin (false), m_size (0), m_maxBuffer (32768), m_availBytes (0)
+  : m_nextRxSeq (n), m_gotFin (false), m_size (0), m_maxBuffer (32768), m_availBytes (0),
+    m_firstPiece (0)
 {
 }
 
+TcpRxBuffer::TcpRxBuffer (const TcpRxBuffer &other)
+  : Object (other),
+    m_nextRxSeq (other.m_nextRxSeq),
+    m_finSeq (other.m_finSeq),
+    m_gotFin (other.m_gotFin),
+    m_size (other.m_size),
+    m_maxBuffer (other.m_maxBuffer),
+    m_availBytes (other.m_availBytes),
+    m_pieces (other.m_pieces.begin () + other.m_firstPiece, other.m_pieces.end ()),
+    m_firstPiece (0),
+    m_blocks (other.m_blocks),
+    m_lastHead (other.m_lastHead)
+{
+  for (std::vector<RxPiece>::iterator i = m_pieces.begin (); i != m_pieces.end (); ++i)
+    {
+      i->packet->Ref ();
+    }
+}
+
 TcpRxBuffer::~TcpRxBuffer ()
 {
+  for (uint32_t i = m_firstPiece; i < m_pieces.size (); ++i)
+    {
+      m_pieces[i].packet->Unref ();
+    }
 }
 
 SequenceNumber32
@@ -114,9 +140,9 @@ TcpRxBuffer::MaxRxSequence (void) const
     { // No data allowed beyond FIN
       return m_finSeq;
     }
-  else if (m_data.size ())
+  else if (m_firstPiece < m_pieces.size ())
     { // No data allowed beyond Rx window allowed
-      return m_data.begin ()->first + SequenceNumber32 (m_maxBuffer);
+      return m_pieces[m_firstPiece].head + SequenceNumber32 (m_maxBuffer);
     }
   return m_nextRxSeq + SequenceNumber32 (m_maxBuffer);
 }
@@ -137,6 +163,63 @@ TcpRxBuffer::Finished (void)
   return (m_gotFin && m_finSeq < m_nextRxSeq);
 }
 
+uint32_t
+TcpRxBuffer::FindPiece (const SequenceNumber32& seq) const
+{
+  uint32_t low = m_firstPiece;
+  uint32_t high = m_pieces.size ();
+  while (low < high)
+    {
+      uint32_t middle = low + (high - low) / 2;
+      if (m_pieces[middle].tail <= seq)
+        {
+          low = middle + 1;
+        }
+      else
+        {
+          high = middle;
+        }
+    }
+  return low;
+}
+
+void
+TcpRxBuffer::AddBlock (const SequenceNumber32& head, const SequenceNumber32& tail)
+{
+  // First block ending at or after head, i.e. touching or after the range
+  uint32_t low = 0;
+  uint32_t high = m_blocks.size ();
+  while (low < high)
+    {
+      uint32_t middle = low + (high - low) / 2;
+      if (m_blocks[middle].second < head)
+        {
+          low = middle + 1;
+        }
+      else
+        {
+          high = middle;
+        }
+    }
+  uint32_t last = low;
+  SackBlock block (head, tail);
+  while (last < m_blocks.size () && m_blocks[last].first <= tail)
+    {
+      block.first = std::min (block.first, m_blocks[last].first);
+      block.second = std::max (block.second, m_blocks[last].second);
+      ++last;
+    }
+  if (last == low)
+    {
+      m_blocks.insert (m_blocks.begin () + low, block);
+    }
+  else
+    {
+      m_blocks[low] = block;
+      m_blocks.erase (m_blocks.begin () + low + 1, m_blocks.begin () + last);
+    }
+}
+
 bool
 TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
 {
@@ -150,67 +233,64 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
 
   // Trim packet to fit Rx window specification
   if (headSeq < m_nextRxSeq) headSeq = m_nextRxSeq;
-  if (m_data.size ())
+  if (m_firstPiece < m_pieces.size ())
     {
-      SequenceNumber32 maxSeq = m_data.begin ()->first + SequenceNumber32 (m_maxBuffer);
+      SequenceNumber32 maxSeq = m_pieces[m_firstPiece].head + SequenceNumber32 (m_maxBuffer);
       if (maxSeq < tailSeq) tailSeq = maxSeq;
-      if (tailSeq < headSeq) headSeq = tailSeq;
     }
-  // Remove overlapped bytes from packet
-  BufIterator i = m_data.begin ();
-  while (i != m_data.end () && i->first <= tailSeq)
+  if (headSeq >= tailSeq)
+    {
+      NS_LOG_LOGIC ("Nothing to buffer");
+      return false;
+    }
+
+  // Store the ranges of [headSeq, tailSeq) which are not buffered yet,
+  // each as a piece of the packet
+  uint32_t i = FindPiece (headSeq);
+  SequenceNumber32 seq = headSeq;
+  uint32_t added = 0;
+  while (seq < tailSeq)
     {
-      SequenceNumber32 lastByteSeq = i->first + SequenceNumber32 (i->second->GetSize ());
-      if (lastByteSeq > headSeq)
+      SequenceNumber32 end = tailSeq;
+      if (i < m_pieces.size () && m_pieces[i].head < end)
+        {
+          end = m_pieces[i].head;
+        }
+      if (seq < end)
+        {
+          RxPiece piece;
+          piece.head = seq;
+          piece.tail = end;
+          piece.packet = PeekPointer (p);
+          piece.packet->Ref ();
+          piece.offset = seq - tcph.GetSequenceNumber ();
+          m_pieces.insert (m_pieces.begin () + i, piece);
+          NS_LOG_LOGIC ("Buffered piece of seqno=" << seq << " len=" << end - seq);
+          added += end - seq;
+          ++i;
+        }
+      if (i == m_pieces.size ())
         {
-          if (i->first > headSeq && lastByteSeq < tailSeq)
-            { // Rare case: Existing packet is embedded fully in the new packet
-              m_size -= i->second->GetSize ();
-              m_data.erase (i++);
-              continue;
-            }
-          if (i->first <= headSeq)
-            { // Incoming head is overlapped
-              headSeq = lastByteSeq;
-            }
-          if (lastByteSeq >= tailSeq)
-            { // Incoming tail is overlapped
-              tailSeq = i->first;
-            }
+          break;
         }
+      seq = m_pieces[i].tail;
       ++i;
     }
-  // We now know how much we are going to store, trim the packet
-  if (headSeq >= tailSeq)
+  if (added == 0)
     {
       NS_LOG_LOGIC ("Nothing to buffer");
       return false; // Nothing to buffer anyway
     }
-  else
-    {
-      uint32_t start = headSeq - tcph.GetSequenceNumber ();
-      uint32_t length = tailSeq - headSeq;
-      p = p->CreateFragment (start, length);
-      NS_ASSERT (length == p->GetSize ());
-    }
-  // Insert packet into buffer
-  NS_ASSERT (m_data.find (headSeq) == m_data.end ()); // Shouldn't be there yet
-  m_data [ headSeq ] = p;
-  NS_LOG_LOGIC ("Buffered packet of seqno=" << headSeq << " len=" << p->GetSize ());
+  AddBlock (headSeq, tailSeq);
+  m_lastHead = headSeq;
+
   // Update variables
-  m_size += p->GetSize ();      // Occupancy
-  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
+  m_size += added;      // Occupancy
+  const SackBlock &first = m_blocks.front ();
+  if (first.first <= m_nextRxSeq && m_nextRxSeq < first.second)
     {
-      if (i->first < m_nextRxSeq)
-        {
-          continue;
-        }
-      else if (i->first > m_nextRxSeq)
-        {
-          break;
-        };
-      m_nextRxSeq = i->first + SequenceNumber32 (i->second->GetSize ());
-      m_availBytes += i->second->GetSize ();
+      m_availBytes += first.second - m_nextRxSeq.Get ();
+      m_nextRxSeq = first.second;
     }
   NS_LOG_LOGIC ("Updated buffer occupancy=" << m_size << " nextRxSeq=" << m_nextRxSeq);
   if (m_gotFin && m_nextRxSeq == m_finSeq)
@@ -228,55 +308,123 @@ TcpRxBuffer::Extract (uint32_t maxSize)
   uint32_t extractSize = std::min (maxSize, m_availBytes);
   NS_LOG_LOGIC ("Requested to extract " << extractSize << " bytes from TcpRxBuffer of size=" << m_size);
   if (extractSize == 0) return 0;  // No contiguous block to return
-  NS_ASSERT (m_data.size ()); // At least we have something to extract
-  Ptr<Packet> outPkt = Create<Packet> (); // The packet that contains all the data to return
-  BufIterator i;
-  while (extractSize)
+  NS_ASSERT (m_firstPiece < m_pieces.size ()); // At least we have something to extract
+  Ptr<Packet> outPkt; // The packet that contains all the data to return
+  uint32_t extracted = 0;
+  while (extracted < extractSize)
     { // Check the buffered data for delivery
-      i = m_data.begin ();
-      NS_ASSERT (i->first <= m_nextRxSeq); // in-sequence data expected
-      // Check if we send the whole pkt or just a partial
-      uint32_t pktSize = i->second->GetSize ();
-      if (pktSize <= extractSize)
-        { // Whole packet is extracted
-          if (outPkt->GetSize ())
-            {
-              outPkt->AddAtEnd (i->second);
-            }
-          else
-            {
-              outPkt = i->second;
-            }
-          m_data.erase (i);
-          m_size -= pktSize;
-          m_availBytes -= pktSize;
-          extractSize -= pktSize;
+      RxPiece &piece = m_pieces[m_firstPiece];
+      NS_ASSERT (piece.head <= m_nextRxSeq); // in-sequence data expected
+      uint32_t length = std::min (static_cast<uint32_t> (piece.tail - piece.head), extractSize - extracted);
+      Ptr<Packet> data;
+      if (piece.offset == 0 && length == piece.packet->GetSize ())
+        { // The whole packet is delivered as it was received
+          data = Ptr<Packet> (piece.packet);
+        }
+      else
+        {
+          data = piece.packet->CreateFragment (piece.offset, length);
+        }
+      if (outPkt == 0)
+        {
+          outPkt = data;
         }
       else
-        { // Partial is extracted and done
-          if (outPkt->GetSize ())
-            {
-              outPkt->AddAtEnd (i->second->CreateFragment (0, extractSize));
-            }
-          else
-            {
-              outPkt = i->second->CreateFragment (0, extractSize);
-            }
-          m_data[i->first + SequenceNumber32 (extractSize)] = i->second->CreateFragment (extractSize, pktSize - extractSize);
-          m_data.erase (i);
-          m_size -= extractSize;
-          m_availBytes -= extractSize;
-          extractSize = 0;
+        {
+          outPkt->AddAtEnd (data);
+        }
+      extracted += length;
+      piece.head += length;
+      piece.offset += length;
+      if (piece.head == piece.tail)
+        {
+          piece.packet->Unref ();
+          ++m_firstPiece;
         }
     }
-  if (outPkt->GetSize () == 0)
+  m_size -= extracted;
+  m_availBytes -= extracted;
+  m_blocks.front ().first += extracted;
+  if (m_blocks.front ().first == m_blocks.front ().second)
     {
-      NS_LOG_LOGIC ("Nothing extracted.");
-      return 0;
+      m_blocks.erase (m_blocks.begin ());
+    }
+  // Reclaim the room of the extracted pieces
+  if (m_firstPiece == m_pieces.size ())
+    {
+      m_pieces.clear ();
+      m_firstPiece = 0;
+    }
+  else if (m_firstPiece >= 64 && m_firstPiece * 2 >= m_pieces.size ())
+    {
+      m_pieces.erase (m_pieces.begin (), m_pieces.begin () + m_firstPiece);
+      m_firstPiece = 0;
     }
   NS_LOG_LOGIC ("Extracted " << outPkt->GetSize ( ) << " bytes, bufsize=" << m_size
-                             << ", num pkts in buffer=" << m_data.size ());
+                             << ", num pieces in buffer=" << m_pieces.size () - m_firstPiece);
   return outPkt;
 }
 
+TcpRxBuffer::SackList
+TcpRxBuffer::GetSackList (uint32_t maxBlocks) const
+{
+  NS_LOG_FUNCTION (this << maxBlocks);
+  SackList list;
+  // The blocks ending at or before m_nextRxSeq are in order
+  uint32_t first = 0;
+  while (first < m_blocks.size () && m_blocks[first].second <= m_nextRxSeq)
+    {
+      ++first;
+    }
+  uint32_t last = m_blocks.size ();
+  for (uint32_t i = first; i < last && maxBlocks > 0; ++i)
+    {
+      if (m_blocks[i].first <= m_lastHead && m_lastHead < m_blocks[i].second)
+        {
+          list.push_back (m_blocks[i]);
+          break;
+        }
+    }
+  for (uint32_t i = first; i < last && list.size () < maxBlocks; ++i)
+    {
+      if (list.empty () || m_blocks[i] != list.front ())
+        {
+          list.push_back (m_blocks[i]);
+        }
+    }
+  return list;
+}
+
+uint32_t
+TcpRxBuffer::GetSackListSize (void) const
+{
+  uint32_t n = 0;
+  for (uint32_t i = m_blocks.size (); i > 0 && m_blocks[i - 1].second > m_nextRxSeq; --i)
+    {
+      ++n;
+    }
+  return n;
+}
+
+uint32_t
+TcpRxBuffer::Fill (const SequenceNumber32& head, const SequenceNumber32& tail)
+{
+  NS_LOG_FUNCTION (this << head << tail);
+
+  SequenceNumber32 first = std::max (head, m_nextRxSeq.Get ());
+  SequenceNumber32 last = std::min (tail, MaxRxSequence ());
+  if (first >= last)
+    {
+      return 0;
+    }
+  // The bytes of a packet created with a size are zeros; Add buffers
+  // only the ranges still missing
+  TcpHeader tcph;
+  tcph.SetSequenceNumber (first);
+  uint32_t size = m_size;
+  Add (Create<Packet> (last - first), tcph);
+  NS_LOG_LOGIC ("Filled " << m_size - size << " bytes of [" << first << ";" << last << ")");
+  return m_size - size;
+}
+
 } //namepsace ns3
@@ -41,6 +41,7 @@
 #include "ns3/double.h"
 #include "ns3/pointer.h"
 #include "ns3/trace-source-accessor.h"
+#include "ns3/segmentation-tag.h"
 #include "tcp-socket-base.h"
 #include "tcp-l4-protocol.h"
 #include "ipv4-end-point.h"
@@ -49,6 +50,8 @@
 #include "tcp-header.h"
 #include "tcp-option-winscale.h"
 #include "tcp-option-ts.h"
+#include "tcp-option-sack-permitted.h"
+#include "tcp-option-sack.h"
 #include "rtt-estimator.h"
 #include "tcp-congestion-ops.h"
 
@@ -98,6 +101,36 @@ TcpSocketBase::GetTypeId (void)
                    BooleanValue (true),
                    MakeBooleanAccessor (&TcpSocketBase::m_timestampEnabled),
                    MakeBooleanChecker ())
+    .AddAttribute ("Sack", "Enable or disable SACK option",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_sackEnabled),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Pacing", "Pace the new data at cWnd / SRTT times the pacing gain",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::m_pacing),
+                   MakeBooleanChecker ())
+    .AddAttribute ("PacingSsGain", "Pacing gain in slow start",
+                   DoubleValue (2.0),
+                   MakeDoubleAccessor (&TcpSocketBase::m_pacingSsGain),
+                   MakeDoubleChecker<double> (0.1))
+    .AddAttribute ("PacingCaGain", "Pacing gain in congestion avoidance",
+                   DoubleValue (1.2),
+                   MakeDoubleAccessor (&TcpSocketBase::m_pacingCaGain),
+                   MakeDoubleChecker<double> (0.1))
+    .AddAttribute ("PacingQuantum", "Segments released at once by the pacing timer",
+                   UintegerValue (2),
+                   MakeUintegerAccessor (&TcpSocketBase::m_pacingQuantum),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Offload", "Send the new data in super-segments, segmented by the devices",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpSocketBase::SetOffload,
+                                        &TcpSocketBase::GetOffload),
+                   MakeBooleanChecker ())
+    .AddAttribute ("OffloadMaxSize", "Maximum payload size of a super-segment, "
+                   "at most 64 segments",
+                   UintegerValue (65536),
+                   MakeUintegerAccessor (&TcpSocketBase::m_offloadMaxSize),
+                   MakeUintegerChecker<uint32_t> ())
     .AddAttribute ("MinRto",
                    "Minimum retransmit timeout value",
                    TimeValue (Seconds (1.0)), // RFC 6298 says min RTO=1 sec, but Linux uses 200ms.
@@ -323,18 +356,30 @@ TcpSocketBase::TcpSocketBase (void)
     m_sndWindShift (0),
     m_timestampEnabled (true),
     m_timestampToEcho (0),
+    m_sackEnabled (false),
     m_sendPendingDataEvent (),
+    m_pacing (false),
+    m_pacingSsGain (2.0),
+    m_pacingCaGain (1.2),
+    m_pacingQuantum (2),
+    m_pacingEvent (),
+    m_offload (false),
+    m_offloadMaxSize (65536),
     // Set m_recover to the initial sequence number
     m_recover (0),
     m_retxThresh (3),
     m_limitedTx (false),
     m_retransOut (0),
+    m_highRxt (0),
     m_congestionControl (0),
     m_isFirstPartialAck (true),
     m_ecn (false),
     m_ecnState (ECN_DISABLED),
     m_ecnEchoSeq (0),
-    m_ceReceived (false)
+    m_ceReceived (false),
+    m_fctMonitor (0),
+    m_fctFlow (FctMonitor::NO_FLOW),
+    m_fctClosed (false)
 {
   NS_LOG_FUNCTION (this);
   m_rxBuffer = CreateObject<TcpRxBuffer> ();
@@ -405,17 +450,28 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
     m_sndWindShift (sock.m_sndWindShift),
     m_timestampEnabled (sock.m_timestampEnabled),
     m_timestampToEcho (sock.m_timestampToEcho),
+    m_sackEnabled (sock.m_sackEnabled),
+    m_pacing (sock.m_pacing),
+    m_pacingSsGain (sock.m_pacingSsGain),
+    m_pacingCaGain (sock.m_pacingCaGain),
+    m_pacingQuantum (sock.m_pacingQuantum),
+    m_offload (sock.m_offload),
+    m_offloadMaxSize (sock.m_offloadMaxSize),
     m_recover (sock.m_recover),
     m_retxThresh (sock.m_retxThresh),
     m_limitedTx (sock.m_limitedTx),
     m_retransOut (sock.m_retransOut),
+    m_highRxt (sock.m_highRxt),
     m_isFirstPartialAck (sock.m_isFirstPartialAck),
     m_txTrace (sock.m_txTrace),
     m_rxTrace (sock.m_rxTrace),
     m_ecn (sock.m_ecn),
     m_ecnState (sock.m_ecnState),
     m_ecnEchoSeq (sock.m_ecnEchoSeq),
-    m_ceReceived (sock.m_ceReceived)
+    m_ceReceived (sock.m_ceReceived),
+    m_fctMonitor (sock.m_fctMonitor),
+    m_fctFlow (FctMonitor::NO_FLOW),
+    m_fctClosed (false)
 {
   NS_LOG_FUNCTION (this);
   NS_LOG_LOGIC ("Invoked the copy constructor");
@@ -512,6 +568,13 @@ TcpSocketBase::SetRtt (Ptr<RttEstimator> rtt)
   m_rtt = rtt;
 }
 
+/* Report the flows of this socket to a monitor */
+void
+TcpSocketBase::SetFctMonitor (Ptr<FctMonitor> monitor)
+{
+  m_fctMonitor = monitor;
+}
+
 /* Inherit from Socket class: Returns error code */
 enum Socket::SocketErrno
 TcpSocketBase::GetErrno (void) const
@@ -741,6 +804,8 @@ TcpSocketBase::Connect (const Address & address)
   m_synCount = m_synRetries;
   m_dataRetrCount = m_dataRetries;
 
+  StartFlow ();
+
   // DoConnect() will do state-checking and send a SYN packet
   return DoConnect ();
 }
@@ -779,6 +844,9 @@ TcpSocketBase::Close (void)
       return 0;
     }
 
+  m_fctClosed = true;
+  CheckFlowCompletion ();
+
   if (m_txBuffer->SizeFromSequence (m_tcb->m_nextTxSequence) > 0)
     { // App close with pending data must wait until all data transmitted
       if (m_closeOnEmpty == false)
@@ -800,6 +868,8 @@ TcpSocketBase::ShutdownSend (void)
   //this prevents data from being added to the buffer
   m_shutdownSend = true;
   m_closeOnEmpty = true;
+  m_fctClosed = true;
+  CheckFlowCompletion ();
   //if buffer is already empty, send a fin now
   //otherwise fin will go when buffer empties.
   if (m_txBuffer->Size () == 0)
@@ -854,6 +924,10 @@ TcpSocketBase::Send (Ptr<Packet> p, uint32_t flags)
           m_errno = ERROR_SHUTDOWN;
           return -1;
         }
+      if (m_fctFlow != FctMonitor::NO_FLOW)
+        {
+          m_fctMonitor->AddBytes (m_fctFlow, p->GetSize ());
+        }
       // Submit the data to lower layers
       NS_LOG_LOGIC ("txBufSize=" << m_txBuffer->Size () << " state " << TcpStateName[m_state]);
       if (m_state == ESTABLISHED || m_state == CLOSE_WAIT)
@@ -1173,12 +1247,7 @@ TcpSocketBase::ForwardUp (Ptr<Packet> packet, Ipv4Header header, uint16_t port,
   Address toAddress = InetSocketAddress (header.GetDestination (),
                                          m_endPoint->GetLocalPort ());
 
-  if (header.GetEcn() == Ipv4Header::ECN_CE)
-    {
-      NS_LOG_INFO ("Received CE packet");
-      m_ceReceived = true;
-    }
-  DoForwardUp (packet, fromAddress, toAddress);
+  ForwardUpSegments (packet, header.GetEcn () == Ipv4Header::ECN_CE, fromAddress, toAddress);
 }
 
 void
@@ -1195,12 +1264,63 @@ TcpSocketBase::ForwardUp6 (Ptr<Packet> packet, Ipv6Header header, uint16_t port,
   Address toAddress = Inet6SocketAddress (header.GetDestinationAddress (),
                                           m_endPoint6->GetLocalPort ());
 
-  if (header.GetEcn() == Ipv6Header::ECN_CE)
+  ForwardUpSegments (packet, header.GetEcn () == Ipv6Header::ECN_CE, fromAddress, toAddress);
+}
+
+void
+TcpSocketBase::ForwardUpSegments (Ptr<Packet> packet, bool ceReceived,
+                                  const Address &fromAddress, const Address &toAddress)
+{
+  SegmentationTag segmentationTag;
+  if (!SegmentationTag::IsEnabled () || !packet->RemovePacketTag (segmentationTag))
     {
-      NS_LOG_INFO ("Received CE packet");
-      m_ceReceived = true;
+      if (ceReceived)
+        {
+          NS_LOG_INFO ("Received CE packet");
+          m_ceReceived = true;
+        }
+      DoForwardUp (packet, fromAddress, toAddress);
+      return;
+    }
+
+  Ptr<Packet> payload = packet->Copy ();
+  TcpHeader tcpHeader;
+  payload->RemoveHeader (tcpHeader);
+  uint32_t segmentSize = segmentationTag.GetSegmentSize ();
+  uint32_t segments = segmentationTag.GetSegmentCount ();
+  uint32_t first = 0;
+  while (first < segments)
+    {
+      bool ce = ceReceived || segmentationTag.IsSegmentMarked (first);
+      uint32_t last = first + 1;
+      while (last < segments && (ceReceived || segmentationTag.IsSegmentMarked (last)) == ce)
+        {
+          last++;
+        }
+      if (ce)
+        {
+          NS_LOG_INFO ("Received CE segments " << first << " to " << last - 1);
+          m_ceReceived = true;
+        }
+      if (first == 0 && last == segments)
+        {
+          DoForwardUp (packet, fromAddress, toAddress);
+          return;
+        }
+
+      uint32_t offset = first * segmentSize;
+      uint32_t size = std::min (last * segmentSize, payload->GetSize ()) - offset;
+      Ptr<Packet> run = payload->CreateFragment (offset, size);
+      TcpHeader runHeader = tcpHeader;
+      runHeader.SetSequenceNumber (tcpHeader.GetSequenceNumber () + offset);
+      if (last < segments)
+        {
+          runHeader.SetFlags (tcpHeader.GetFlags () & ~TcpHeader::FIN);
+        }
+      run->AddHeader (runHeader);
+      DoForwardUp (run, fromAddress, toAddress);
+      first = last;
     }
-  DoForwardUp (packet, fromAddress, toAddress);
 }
 
 void
@@ -1299,6 +1419,12 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
           m_timestampEnabled = false;
         }
 
+      // SACK is used only if both ends permit it
+      if (!tcpHeader.HasOption (TcpOption::SACKPERMITTED))
+        {
+          m_sackEnabled = false;
+        }
+
       // Initialize cWnd and ssThresh
       m_tcb->m_cWnd = GetInitialCwnd () * GetSegSize ();
       m_tcb->m_ssThresh = GetInitialSSThresh ();
@@ -1330,6 +1456,11 @@ TcpSocketBase::DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
             }
         }
 
+      if (m_sackEnabled && tcpHeader.HasOption (TcpOption::SACK))
+        {
+          ProcessOptionSack (tcpHeader.GetOption (TcpOption::SACK));
+        }
+
       EstimateRtt (tcpHeader);
       UpdateWindowSize (tcpHeader);
     }
@@ -1527,7 +1658,13 @@ TcpSocketBase::FastRetransmit ()
   NS_LOG_INFO (m_dupAckCount << " dupack. Enter fast recovery mode." <<
                "Reset cwnd to " << m_tcb->m_cWnd << ", ssthresh to " <<
                m_tcb->m_ssThresh << " at fast recovery seqnum " << m_recover);
+  m_highRxt = m_txBuffer->HeadSequence () + m_tcb->m_segmentSize;
   DoRetransmit ();
+
+  if (m_sackEnabled)
+    { // Other holes may be deemed lost already
+      SendPendingData (m_connected);
+    }
 }
 
 void
@@ -1701,7 +1838,11 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
               m_retransOut  = SafeSubtraction (m_retransOut, 1);  // at least one retransmission
                                                                   // has reached the other side
               m_txBuffer->DiscardUpTo (ackNumber);  //Bug 1850:  retransmit before newack
-              DoRetransmit (); // Assume the next seq is lost. Retransmit lost packet
+              if (!m_sackEnabled || ackNumber >= m_highRxt)
+                { // With SACK, the holes already retransmitted are not sent again
+                  m_highRxt = ackNumber + m_tcb->m_segmentSize;
+                  DoRetransmit (); // Assume the next seq is lost. Retransmit lost packet
+                }
 
               if (m_isFirstPartialAck)
                 {
@@ -2388,6 +2529,11 @@ TcpSocketBase::SendEmptyPacket (uint8_t flags)
           AddOptionWScale (header);
         }
 
+      if (m_sackEnabled)
+        {
+          AddOptionSackPermitted (header);
+        }
+
       if (m_synCount == 0)
         { // No more connection retries, give up
           NS_LOG_LOGIC ("Connection failed.");
@@ -2619,6 +2765,11 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
   Ptr<Packet> p = m_txBuffer->CopyFromSequence (maxSize, seq);
   uint32_t sz = p->GetSize (); // Size of packet
   uint8_t flags = withAck ? TcpHeader::ACK : 0;
+  if (sz > m_tcb->m_segmentSize)
+    {
+      NS_LOG_LOGIC ("Super-segment of " << sz << " bytes");
+      p->AddPacketTag (SegmentationTag (m_tcb->m_segmentSize, sz));
+    }
   uint32_t remainingData = m_txBuffer->SizeFromSequence (seq + SequenceNumber32 (sz));
 
   if (withAck)
@@ -2817,8 +2968,47 @@ TcpSocketBase::SendPendingData (bool withAck)
       return false; // Is this the right way to handle this condition?
     }
   uint32_t nPacketsSent = 0;
+  if (m_sackEnabled && m_tcb->m_congState == TcpSocketState::CA_RECOVERY)
+    {
+      // Retransmit the holes deemed lost before any new data (RFC 6675).
+      // The lost data left the network: the window counts the lost holes
+      // not retransmitted yet as room, each one retransmitted takes its place.
+      SequenceNumber32 head;
+      SequenceNumber32 tail;
+      uint32_t lost = 0;
+      for (SequenceNumber32 seq = m_highRxt; NextLostHole (seq, head, tail); seq = tail)
+        {
+          lost += tail - head;
+        }
+      uint32_t w = AvailableWindow () + lost;
+      while (NextLostHole (m_highRxt, head, tail))
+        {
+          uint32_t sz = std::min (static_cast<uint32_t> (tail - head), m_tcb->m_segmentSize);
+          if (w < sz)
+            {
+              NS_LOG_LOGIC ("No window to retransmit the hole at " << head);
+              return (nPacketsSent > 0);
+            }
+          RetransmitHole (head, sz);
+          m_highRxt = head + sz;
+          w -= sz;
+          nPacketsSent++;
+        }
+    }
+  uint32_t pacedSegments = 0; // New segments released in this pacing quantum
+  uint32_t pacedBytes = 0;
   while (m_txBuffer->SizeFromSequence (m_tcb->m_nextTxSequence))
     {
+      if (m_sackEnabled && m_tcb->m_nextTxSequence < m_tcb->m_highTxMark)
+        { // Going back after a timeout: the peer already holds SACKed data
+          SequenceNumber32 next = m_txBuffer->SkipSacked (m_tcb->m_nextTxSequence);
+          if (next != m_tcb->m_nextTxSequence)
+            {
+              NS_LOG_LOGIC ("Skipping SACKed data up to " << next);
+              m_tcb->m_nextTxSequence = next;
+              continue;
+            }
+        }
       if ((m_ecnState & (ECN_RX_ECHO | ECN_SEND_CWR)) == ECN_RX_ECHO)
         {
           NS_LOG_INFO ("ECE received: decrease ssthresh && cwnd");
@@ -2841,6 +3031,11 @@ TcpSocketBase::SendPendingData (bool withAck)
           NS_LOG_LOGIC ("Invoking Nagle's algorithm. Wait to send.");
           break;
         }
+      if (m_pacingEvent.IsRunning ())
+        {
+          NS_LOG_LOGIC ("Pacing. Wait to send.");
+          break;
+        }
       NS_LOG_LOGIC ("TcpSocketBase " << this << " SendPendingData" <<
                     " w " << w <<
                     " rxwin " << m_rWnd <<
@@ -2855,17 +3050,35 @@ TcpSocketBase::SendPendingData (bool withAck)
                     " unAck: " << UnAckDataCount ());
 
       uint32_t s = std::min (w, m_tcb->m_segmentSize);  // Send no more than window
+      if (m_offload && w >= 2 * m_tcb->m_segmentSize)
+        { // Whole segments of the window at once, cut by the devices
+          uint32_t maxSize = std::min (m_offloadMaxSize,
+                                       SegmentationTag::MAX_SEGMENTS * m_tcb->m_segmentSize);
+          s = std::max (std::min (w, maxSize) / m_tcb->m_segmentSize, 1u) * m_tcb->m_segmentSize;
+        }
       uint32_t sz = SendDataPacket (m_tcb->m_nextTxSequence, s, withAck);
       if (sz > 0)
         {
           nPacketsSent++;                             // Count sent this loop
           m_tcb->m_nextTxSequence += sz;                     // Advance next tx sequence
+          pacedBytes += sz;
+          pacedSegments += (sz + m_tcb->m_segmentSize - 1) / m_tcb->m_segmentSize;
+          if (m_pacing && pacedSegments >= m_pacingQuantum)
+            {
+              SchedulePacing (pacedBytes);
+              pacedSegments = 0;
+              pacedBytes = 0;
+            }
         }
       else
         {
           break;
         }
     }
+  if (m_pacing && pacedBytes > 0)
+    {
+      SchedulePacing (pacedBytes);
+    }
   if (nPacketsSent > 0)
     {
       NS_LOG_DEBUG ("SendPendingData sent " << nPacketsSent << " segments");
@@ -2873,6 +3086,22 @@ TcpSocketBase::SendPendingData (bool withAck)
   return (nPacketsSent > 0);
 }
 
+void
+TcpSocketBase::SchedulePacing (uint32_t bytes)
+{
+  NS_LOG_FUNCTION (this << bytes);
+  Time srtt = m_rtt->GetEstimate ();
+  if (srtt.IsZero ())
+    {
+      return;
+    }
+  double gain = (m_tcb->m_cWnd < m_tcb->m_ssThresh) ? m_pacingSsGain : m_pacingCaGain;
+  Time interval = Seconds (srtt.GetSeconds () * bytes / (gain * m_tcb->m_cWnd.Get ()));
+  NS_LOG_LOGIC ("Next pacing quantum in " << interval.GetSeconds () << "s");
+  m_pacingEvent = Simulator::Schedule (interval, &TcpSocketBase::SendPendingData,
+                                       this, m_connected);
+}
+
 uint32_t
 TcpSocketBase::UnAckDataCount () const
 {
@@ -3091,6 +3320,7 @@ TcpSocketBase::NewAck (SequenceNumber32 const& ack, bool resetRTO)
   NS_LOG_LOGIC ("TCP " << this << " NewAck " << ack <<
                 " numberAck " << (ack - m_txBuffer->HeadSequence ())); // Number bytes ack'ed
   m_txBuffer->DiscardUpTo (ack);
+  CheckFlowCompletion ();
   if (GetTxAvailable () > 0)
     {
       NotifySend (GetTxAvailable ());
@@ -3324,6 +3554,26 @@ TcpSocketBase::DoRetransmit ()
   NS_LOG_DEBUG ("retxing seq " << m_txBuffer->HeadSequence ());
 }
 
+void
+TcpSocketBase::RetransmitHole (SequenceNumber32 seq, uint32_t size)
+{
+  NS_LOG_FUNCTION (this << seq << size);
+  SendDataPacket (seq, size, true);
+  ++m_retransOut;
+  NS_LOG_DEBUG ("retxing hole at seq " << seq);
+}
+
+bool
+TcpSocketBase::NextLostHole (const SequenceNumber32 &seq, SequenceNumber32 &head,
+                             SequenceNumber32 &tail) const
+{
+  if (!m_txBuffer->FindHole (seq, head, tail))
+    {
+      return false;
+    }
+  return m_txBuffer->GetSackedBytesFrom (tail) > (m_retxThresh - 1) * m_tcb->m_segmentSize;
+}
+
 void
 TcpSocketBase::CancelAllTimers ()
 {
@@ -3333,6 +3583,7 @@ TcpSocketBase::CancelAllTimers ()
   m_lastAckEvent.Cancel ();
   m_timewaitEvent.Cancel ();
   m_sendPendingDataEvent.Cancel ();
+  m_pacingEvent.Cancel ();
 }
 
 /* Move TCP to Time_Wait state and schedule a transition to Closed state */
@@ -3515,6 +3766,12 @@ TcpSocketBase::AddOptions (TcpHeader& header)
     {
       AddOptionTimestamp (header);
     }
+
+  if (m_sackEnabled && (header.GetFlags () & TcpHeader::ACK)
+      && !(header.GetFlags () & TcpHeader::SYN) && m_rxBuffer->GetSackListSize () > 0)
+    {
+      AddOptionSack (header);
+    }
 }
 
 void
@@ -3614,6 +3871,52 @@ TcpSocketBase::AddOptionTimestamp (TcpHeader& header)
                option->GetTimestamp () << " echo=" << m_timestampToEcho);
 }
 
+void
+TcpSocketBase::ProcessOptionSack (const Ptr<const TcpOption> option)
+{
+  NS_LOG_FUNCTION (this << option);
+
+  Ptr<const TcpOptionSack> sack = DynamicCast<const TcpOptionSack> (option);
+
+  uint32_t sacked = m_txBuffer->Sack (sack->GetSackList (), m_tcb->m_highTxMark);
+
+  NS_LOG_INFO (m_node->GetId () << " Got " << sack->GetNumSackBlocks () <<
+               " SACK blocks, " << sacked << " bytes newly SACKed");
+}
+
+void
+TcpSocketBase::AddOptionSackPermitted (TcpHeader &header)
+{
+  NS_LOG_FUNCTION (this << header);
+  NS_ASSERT (header.GetFlags () & TcpHeader::SYN);
+
+  header.AppendOption (CreateObject<TcpOptionSackPermitted> ());
+  NS_LOG_INFO (m_node->GetId () << " Add option SACK permitted");
+}
+
+void
+TcpSocketBase::AddOptionSack (TcpHeader& header)
+{
+  NS_LOG_FUNCTION (this << header);
+
+  uint32_t room = header.GetMaxOptionLength () - header.GetOptionLength ();
+  if (room < 10)
+    {
+      return;
+    }
+  uint32_t maxBlocks = std::min ((room - 2) / 8, TcpOptionSack::MAX_BLOCKS);
+
+  Ptr<TcpOptionSack> option = CreateObject<TcpOptionSack> ();
+  TcpRxBuffer::SackList list = m_rxBuffer->GetSackList (maxBlocks);
+  for (TcpRxBuffer::SackList::const_iterator it = list.begin (); it != list.end (); ++it)
+    {
+      option->AddSackBlock (*it);
+    }
+
+  header.AppendOption (option);
+  NS_LOG_INFO (m_node->GetId () << " Add option SACK with " << list.size () << " blocks");
+}
+
 void TcpSocketBase::UpdateWindowSize (const TcpHeader &header)
 {
   NS_LOG_FUNCTION (this << header);
@@ -3658,6 +3961,23 @@ void TcpSocketBase::UpdateWindowSize (const TcpHeader &header)
     }
 }
 
+void
+TcpSocketBase::SetOffload (bool offload)
+{
+  NS_LOG_FUNCTION (this << offload);
+  m_offload = offload;
+  if (offload)
+    {
+      SegmentationTag::Enable ();
+    }
+}
+
+bool
+TcpSocketBase::GetOffload (void) const
+{
+  return m_offload;
+}
+
 void
 TcpSocketBase::SetMinRto (Time minRto)
 {
@@ -3801,6 +4121,33 @@ TcpSocketBase::MarkEmptyPacket (void) const
   return m_ecnState & ECN_CONN;
 }
 
+Time
+TcpSocketBase::GetFlowDeadline (void) const
+{
+  return Time (0);
+}
+
+void
+TcpSocketBase::StartFlow (void)
+{
+  if (m_fctMonitor != 0 && m_state == CLOSED)
+    {
+      m_fctFlow = m_fctMonitor->StartFlow (GetFlowDeadline ());
+      m_fctClosed = false;
+    }
+}
+
+void
+TcpSocketBase::CheckFlowCompletion (void)
+{
+  if (m_fctFlow != FctMonitor::NO_FLOW && m_fctClosed && m_txBuffer->Size () == 0)
+    {
+      NS_LOG_LOGIC (this << " flow " << m_fctFlow << " completed");
+      m_fctMonitor->CompleteFlow (m_fctFlow);
+      m_fctFlow = FctMonitor::NO_FLOW;
+    }
+}
+
 uint32_t
 TcpSocketBase::SafeSubtraction (uint32_t a, uint32_t b)
 {
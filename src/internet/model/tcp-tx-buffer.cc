@@ -57,7 +57,15 @@ TcpTxBuffer::GetTypeId (void)
  * initialized below is insignificant.
  */
 TcpTxBuffer::TcpTxBuffer (uint32_t n)
-  : m_firstByteSeq (n), m_size (0), m_maxBuffer (32768), m_data (0)
+  : m_firstByteSeq (n),
+    m_size (0),
+    m_maxBuffer (32768),
+    m_headPosition (0),
+    m_ring (16),
+    m_ringHead (0),
+    m_nSegments (0),
+    m_lastFound (0),
+    m_sackedBytes (0)
 {
 }
 
@@ -111,7 +119,20 @@ TcpTxBuffer::Add (Ptr<Packet> p)
     {
       if (p->GetSize () > 0)
         {
-          m_data.push_back (p);
+          if (m_nSegments == m_ring.size ())
+            { // Unroll the ring into a vector twice as large
+              std::vector<TxSegment> ring (2 * m_ring.size ());
+              for (uint32_t i = 0; i < m_nSegments; ++i)
+                {
+                  ring[i] = GetSegment (i);
+                }
+              m_ring.swap (ring);
+              m_ringHead = 0;
+            }
+          TxSegment &segment = GetSegment (m_nSegments);
+          segment.packet = p;
+          segment.end = m_headPosition + m_size + p->GetSize ();
+          ++m_nSegments;
           m_size += p->GetSize ();
           NS_LOG_LOGIC ("Updated size=" << m_size << ", lastSeq=" << m_firstByteSeq + SequenceNumber32 (m_size));
         }
@@ -133,6 +154,50 @@ TcpTxBuffer::SizeFromSequence (const SequenceNumber32& seq) const
   return lastSeq - seq;
 }
 
+TcpTxBuffer::TxSegment &
+TcpTxBuffer::GetSegment (uint32_t index)
+{
+  return m_ring[(m_ringHead + index) & (m_ring.size () - 1)];
+}
+
+uint64_t
+TcpTxBuffer::GetSegmentStart (uint32_t index)
+{
+  TxSegment &segment = GetSegment (index);
+  return segment.end - segment.packet->GetSize ();
+}
+
+uint32_t
+TcpTxBuffer::FindSegment (uint64_t position)
+{
+  NS_ASSERT (position >= m_headPosition && position < m_headPosition + m_size);
+  for (uint32_t i = m_lastFound; i < m_lastFound + 2 && i < m_nSegments; ++i)
+    {
+      if (GetSegmentStart (i) <= position && position < GetSegment (i).end)
+        {
+          m_lastFound = i;
+          return i;
+        }
+    }
+  // First segment ending after the position
+  uint32_t low = 0;
+  uint32_t high = m_nSegments - 1;
+  while (low < high)
+    {
+      uint32_t middle = low + (high - low) / 2;
+      if (GetSegment (middle).end <= position)
+        {
+          low = middle + 1;
+        }
+      else
+        {
+          high = middle;
+        }
+    }
+  m_lastFound = low;
+  return low;
+}
+
 Ptr<Packet>
 TcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
 {
@@ -142,61 +207,41 @@ TcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
     {
       return Create<Packet> (); // Empty packet returned
     }
-  if (m_data.size () == 0)
+  if (m_nSegments == 0)
     { // No actual data, just return dummy-data packet of correct size
       return Create<Packet> (s);
     }
 
   // Extract data from the buffer and return
-  uint32_t offset = seq - m_firstByteSeq.Get ();
-  uint32_t count = 0;      // Offset of the first byte of a packet in the buffer
-  uint32_t pktSize = 0;
-  bool beginFound = false;
-  int pktCount = 0;
-  Ptr<Packet> outPacket;
-  NS_LOG_LOGIC ("There are " << m_data.size () << " number of packets in buffer");
-  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
-    {
-      pktCount++;
-      pktSize = (*i)->GetSize ();
-      if (!beginFound)
-        { // Look for first fragment
-          if (count + pktSize > offset)
-            {
-              NS_LOG_LOGIC ("First byte found in packet #" << pktCount << " at buffer offset " << count
-                                                           << ", packet len=" << pktSize);
-              beginFound = true;
-              uint32_t packetOffset = offset - count;
-              uint32_t fragmentLength = count + pktSize - offset;
-              if (fragmentLength >= s)
-                { // Data to be copied falls entirely in this packet
-                  return (*i)->CreateFragment (packetOffset, s);
-                }
-              else
-                { // This packet only fulfills part of the request
-                  outPacket = (*i)->CreateFragment (packetOffset, fragmentLength);
-                }
-              NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
-            }
+  uint64_t position = m_headPosition + (seq - m_firstByteSeq.Get ());
+  uint64_t last = position + s;
+  uint32_t i = FindSegment (position);
+  NS_LOG_LOGIC ("First byte found in segment #" << i << " of " << m_nSegments);
+  uint64_t start = GetSegmentStart (i);
+  TxSegment *segment = &GetSegment (i);
+  if (last <= segment->end)
+    { // Data to be copied falls entirely in this packet
+      if (position == start && last == segment->end)
+        {
+          return segment->packet->Copy ();
         }
-      else if (count + pktSize >= offset + s)
+      return segment->packet->CreateFragment (position - start, s);
+    }
+  Ptr<Packet> outPacket = segment->packet->CreateFragment (position - start, segment->end - position);
+  while (true)
+    {
+      segment = &GetSegment (++i);
+      if (last <= segment->end)
         { // Last packet fragment found
-          NS_LOG_LOGIC ("Last byte found in packet #" << pktCount << " at buffer offset " << count
-                                                      << ", packet len=" << pktSize);
-          uint32_t fragmentLength = offset + s - count;
-          Ptr<Packet> endFragment = (*i)->CreateFragment (0, fragmentLength);
-          outPacket->AddAtEnd (endFragment);
-          NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
+          uint64_t length = last - (segment->end - segment->packet->GetSize ());
+          outPacket->AddAtEnd (segment->packet->CreateFragment (0, length));
           break;
         }
-      else
-        {
-          NS_LOG_LOGIC ("Appending to output the packet #" << pktCount << " of offset " << count << " len=" << pktSize);
-          outPacket->AddAtEnd (*i);
-          NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
-        }
-      count += pktSize;
+      NS_LOG_LOGIC ("Appending to output the segment #" << i);
+      outPacket->AddAtEnd (segment->packet);
     }
+  m_lastFound = i;
+  NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
   NS_ASSERT (outPacket->GetSize () == s);
   return outPacket;
 }
@@ -213,44 +258,161 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
 {
   NS_LOG_FUNCTION (this << seq);
   NS_LOG_LOGIC ("current data size=" << m_size << ", headSeq=" << m_firstByteSeq << ", maxBuffer=" << m_maxBuffer
-                                     << ", numPkts=" << m_data.size ());
+                                     << ", numPkts=" << m_nSegments);
   // Cases do not need to scan the buffer
   if (m_firstByteSeq >= seq) return;
 
-  // Scan the buffer and discard packets
-  uint32_t offset = seq - m_firstByteSeq.Get ();  // Number of bytes to remove
-  uint32_t pktSize;
+  uint32_t offset = std::min (static_cast<uint32_t> (seq - m_firstByteSeq.Get ()), m_size); // Number of bytes to remove
   NS_LOG_LOGIC ("Offset=" << offset);
-  BufIterator i = m_data.begin ();
-  while (i != m_data.end ())
+  m_headPosition += offset;
+  m_size -= offset;
+  // Release the packets behind the seqnum; a packet acknowledged in part stays whole
+  uint32_t removed = 0;
+  while (removed < m_nSegments && GetSegment (removed).end <= m_headPosition)
     {
-      if (offset > (*i)->GetSize ())
-        { // This packet is behind the seqnum. Remove this packet from the buffer
-          pktSize = (*i)->GetSize ();
-          m_size -= pktSize;
-          offset -= pktSize;
-          m_firstByteSeq += pktSize;
-          i = m_data.erase (i);
-          NS_LOG_LOGIC ("Removed one packet of size " << pktSize << ", offset=" << offset);
+      GetSegment (removed).packet = 0;
+      ++removed;
+    }
+  m_ringHead = (m_ringHead + removed) & (m_ring.size () - 1);
+  m_nSegments -= removed;
+  m_lastFound = m_lastFound > removed ? m_lastFound - removed : 0;
+  NS_LOG_LOGIC ("Removed " << removed << " packets");
+  m_firstByteSeq = seq;
+  // Forget the SACKed ranges behind the seqnum
+  uint32_t acked = FindSacked (seq);
+  for (uint32_t i = 0; i < acked; ++i)
+    {
+      m_sackedBytes -= m_sacked[i].second - m_sacked[i].first;
+    }
+  m_sacked.erase (m_sacked.begin (), m_sacked.begin () + acked);
+  if (!m_sacked.empty () && m_sacked.front ().first < seq)
+    {
+      m_sackedBytes -= seq - m_sacked.front ().first;
+      m_sacked.front ().first = seq;
+    }
+  NS_LOG_LOGIC ("size=" << m_size << " headSeq=" << m_firstByteSeq << " maxBuffer=" << m_maxBuffer
+                        <<" numPkts="<< m_nSegments);
+}
+
+uint32_t
+TcpTxBuffer::FindSacked (const SequenceNumber32 &seq) const
+{
+  uint32_t low = 0;
+  uint32_t high = m_sacked.size ();
+  while (low < high)
+    {
+      uint32_t middle = low + (high - low) / 2;
+      if (m_sacked[middle].second <= seq)
+        {
+          low = middle + 1;
         }
-      else if (offset > 0)
-        { // Part of the packet is behind the seqnum. Fragment
-          pktSize = (*i)->GetSize () - offset;
-          *i = (*i)->CreateFragment (offset, pktSize);
-          m_size -= offset;
-          m_firstByteSeq += offset;
-          NS_LOG_LOGIC ("Fragmented one packet by size " << offset << ", new size=" << pktSize);
-          break;
+      else
+        {
+          high = middle;
         }
     }
-  // Catching the case of ACKing a FIN
-  if (m_size == 0)
+  return low;
+}
+
+uint32_t
+TcpTxBuffer::Sack (const SackList &list, const SequenceNumber32 &highTx)
+{
+  NS_LOG_FUNCTION (this << highTx);
+  uint32_t before = m_sackedBytes;
+  for (SackList::const_iterator it = list.begin (); it != list.end (); ++it)
     {
-      m_firstByteSeq = seq;
+      SequenceNumber32 head = std::max (it->first, m_firstByteSeq.Get ());
+      SequenceNumber32 tail = std::min (it->second, highTx);
+      if (head >= tail)
+        {
+          NS_LOG_LOGIC ("Ignored SACK block [" << it->first << ";" << it->second << ")");
+          continue;
+        }
+      // Merge the block with the ranges it touches, as TcpRxBuffer does
+      uint32_t low = 0;
+      uint32_t high = m_sacked.size ();
+      while (low < high)
+        {
+          uint32_t middle = low + (high - low) / 2;
+          if (m_sacked[middle].second < head)
+            {
+              low = middle + 1;
+            }
+          else
+            {
+              high = middle;
+            }
+        }
+      uint32_t last = low;
+      SackBlock block (head, tail);
+      while (last < m_sacked.size () && m_sacked[last].first <= tail)
+        {
+          block.first = std::min (block.first, m_sacked[last].first);
+          block.second = std::max (block.second, m_sacked[last].second);
+          m_sackedBytes -= m_sacked[last].second - m_sacked[last].first;
+          ++last;
+        }
+      m_sackedBytes += block.second - block.first;
+      if (last == low)
+        {
+          m_sacked.insert (m_sacked.begin () + low, block);
+        }
+      else
+        {
+          m_sacked[low] = block;
+          m_sacked.erase (m_sacked.begin () + low + 1, m_sacked.begin () + last);
+        }
     }
-  NS_LOG_LOGIC ("size=" << m_size << " headSeq=" << m_firstByteSeq << " maxBuffer=" << m_maxBuffer
-                        <<" numPkts="<< m_data.size ());
-  NS_ASSERT (m_firstByteSeq == seq);
+  NS_LOG_LOGIC ("SACKed bytes=" << m_sackedBytes << " in " << m_sacked.size () << " ranges");
+  return m_sackedBytes - before;
+}
+
+uint32_t
+TcpTxBuffer::GetSackedBytes (void) const
+{
+  return m_sackedBytes;
+}
+
+uint32_t
+TcpTxBuffer::GetSackedBytesFrom (const SequenceNumber32 &seq) const
+{
+  uint32_t sacked = 0;
+  for (uint32_t i = m_sacked.size (); i > 0 && m_sacked[i - 1].second > seq; --i)
+    {
+      sacked += m_sacked[i - 1].second - std::max (m_sacked[i - 1].first, seq);
+    }
+  return sacked;
+}
+
+SequenceNumber32
+TcpTxBuffer::SkipSacked (const SequenceNumber32 &seq) const
+{
+  uint32_t i = FindSacked (seq);
+  if (i < m_sacked.size () && m_sacked[i].first <= seq)
+    {
+      return m_sacked[i].second;
+    }
+  return seq;
+}
+
+bool
+TcpTxBuffer::FindHole (const SequenceNumber32 &seq, SequenceNumber32 &head,
+                       SequenceNumber32 &tail) const
+{
+  SequenceNumber32 from = std::max (seq, m_firstByteSeq.Get ());
+  uint32_t i = FindSacked (from);
+  if (i < m_sacked.size () && m_sacked[i].first <= from)
+    { // from is SACKed, the hole starts after its range
+      from = m_sacked[i].second;
+      ++i;
+    }
+  if (i == m_sacked.size ())
+    {
+      return false;
+    }
+  head = from;
+  tail = m_sacked[i].first;
+  return true;
 }
 
 } // namepsace ns3
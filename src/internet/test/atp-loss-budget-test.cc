@@ -0,0 +1,329 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#include <vector>
+#include <list>
+#include "ns3/test.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/node-container.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/error-model.h"
+#include "ns3/uinteger.h"
+#include "ns3/tcp-l4-protocol.h"
+#include "ns3/tcp-congestion-ops.h"
+#include "ns3/atp-socket.h"
+#include "ns3/atp-loss-budget.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("AtpLossBudgetTestSuite");
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the decisions of the loss budget: within the window of
+ * the flow, within a message, and for ranges abandoned already.
+ */
+class AtpLossBudgetTestCase : public TestCase
+{
+public:
+  AtpLossBudgetTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+AtpLossBudgetTestCase::AtpLossBudgetTestCase ()
+  : TestCase ("Abandon losses within the budget of the flow and of the messages")
+{
+}
+
+void
+AtpLossBudgetTestCase::DoRun (void)
+{
+  AtpLossBudget budget;
+  budget.SetBudget (0.1);
+  budget.SetWindow (10000);
+
+  // 10% of 500 bytes sent
+  budget.Sent (SequenceNumber32 (1), 500);
+  NS_TEST_ASSERT_MSG_EQ (budget.Abandon (SequenceNumber32 (1), 500), false, "Loss beyond the budget abandoned");
+
+  // 10% of 10000 bytes sent
+  for (uint32_t i = 1; i < 20; ++i)
+    {
+      budget.Sent (SequenceNumber32 (1 + 500 * i), 500);
+    }
+  NS_TEST_ASSERT_MSG_EQ (budget.Abandon (SequenceNumber32 (1), 500), true, "Loss within the budget kept");
+  NS_TEST_ASSERT_MSG_EQ (budget.Abandon (SequenceNumber32 (1), 500), true, "Range abandoned already kept");
+  NS_TEST_ASSERT_MSG_EQ (budget.GetAbandonedBytes (SequenceNumber32 (1), SequenceNumber32 (10001)), 500,
+                         "Range abandoned twice counted twice");
+  NS_TEST_ASSERT_MSG_EQ (budget.Abandon (SequenceNumber32 (501), 500), true, "Loss within the budget kept");
+  NS_TEST_ASSERT_MSG_EQ (budget.Abandon (SequenceNumber32 (1001), 500), false, "Loss beyond the budget abandoned");
+  std::vector<AtpLossBudget::Range> ranges = budget.GetAbandonedRanges (SequenceNumber32 (1), 4);
+  NS_TEST_ASSERT_MSG_EQ (ranges.size (), 1, "Adjacent ranges not merged");
+  NS_TEST_ASSERT_MSG_EQ (ranges[0].first, SequenceNumber32 (1), "Wrong range");
+  NS_TEST_ASSERT_MSG_EQ (ranges[0].second, SequenceNumber32 (1001), "Wrong range");
+
+  // The window slides past the abandoned ranges
+  for (uint32_t i = 20; i < 40; ++i)
+    {
+      budget.Sent (SequenceNumber32 (1 + 500 * i), 500);
+    }
+  NS_TEST_ASSERT_MSG_EQ (budget.Abandon (SequenceNumber32 (15001), 500), true, "Budget not renewed by the window");
+  NS_TEST_ASSERT_MSG_EQ (budget.GetAbandonedRanges (SequenceNumber32 (1), 4).size (), 2, "Wrong number of ranges");
+  ranges = budget.GetAbandonedRanges (SequenceNumber32 (15201), 4);
+  NS_TEST_ASSERT_MSG_EQ (ranges.size (), 1, "Acknowledged range reported");
+  NS_TEST_ASSERT_MSG_EQ (ranges[0].first, SequenceNumber32 (15201), "Range not clipped at the ACK");
+  budget.DiscardUpTo (SequenceNumber32 (15001));
+  NS_TEST_ASSERT_MSG_EQ (budget.GetAbandonedBytes (SequenceNumber32 (1), SequenceNumber32 (20001)), 500,
+                         "Range out of the window and acknowledged kept");
+
+  // A message without budget is reliable, whatever the budget of the flow
+  budget.AddMessage (SequenceNumber32 (20001), SequenceNumber32 (20501), 0.0);
+  budget.Sent (SequenceNumber32 (20001), 500);
+  NS_TEST_ASSERT_MSG_EQ (budget.Abandon (SequenceNumber32 (20001), 500), false, "Loss of a reliable message abandoned");
+
+  // A message may lose more than the flow
+  budget.AddMessage (SequenceNumber32 (20501), SequenceNumber32 (30501), 0.5);
+  budget.Sent (SequenceNumber32 (20501), 10000);
+  NS_TEST_ASSERT_MSG_EQ (budget.Abandon (SequenceNumber32 (20501), 5000), true, "Loss within the message budget kept");
+  NS_TEST_ASSERT_MSG_EQ (budget.Abandon (SequenceNumber32 (25501), 500), false, "Loss beyond the message budget abandoned");
+
+  budget.DiscardUpTo (SequenceNumber32 (30501));
+  NS_TEST_ASSERT_MSG_EQ (budget.GetAbandonedBytes (SequenceNumber32 (1), SequenceNumber32 (30501)), 5000,
+                         "Wrong ranges kept for the window");
+
+  // By default the budget is counted over the whole flow: 0.01% of 5 MB
+  // sent lets one 500 byte segment go, however long ago it was sent
+  AtpLossBudget flow;
+  flow.SetBudget (0.0001);
+  NS_TEST_ASSERT_MSG_EQ (flow.GetWindow (), 0, "The default window is not the whole flow");
+  for (uint32_t i = 0; i < 10000; ++i)
+    {
+      flow.Sent (SequenceNumber32 (1 + 500 * i), 500);
+    }
+  NS_TEST_ASSERT_MSG_EQ (flow.Abandon (SequenceNumber32 (1), 500), true, "Loss within the flow budget kept");
+  NS_TEST_ASSERT_MSG_EQ (flow.Abandon (SequenceNumber32 (2500001), 500), false, "Loss beyond the flow budget abandoned");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Transfer 50000 bytes between two ATP sockets, losing two data
+ * segments on the way
+ *
+ * With a loss budget, the sender abandons the losses and the receiver
+ * reads zeros in their place; without, they are retransmitted.  Either
+ * way the whole stream, of the size sent, reaches the receiver.
+ */
+class AtpSkipTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   * \param desc Description
+   * \param lossBudget Loss budget of the sender
+   */
+  AtpSkipTestCase (const std::string &desc, double lossBudget);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Create an ATP socket
+   * \param node the node
+   * \returns the socket
+   */
+  Ptr<AtpSocket> CreateSocket (Ptr<Node> node);
+
+  /**
+   * \brief Connect, send the data and close
+   * \param sender the sending socket
+   * \param to the address of the receiver
+   */
+  void StartFlow (Ptr<AtpSocket> sender, InetSocketAddress to);
+
+  /**
+   * \brief Accept a connection
+   * \param socket the new socket
+   * \param from the address of the peer
+   */
+  void Accept (Ptr<Socket> socket, const Address &from);
+
+  /**
+   * \brief Read the data received and count the zeros
+   * \param socket the receiving socket
+   */
+  void Receive (Ptr<Socket> socket);
+
+  /**
+   * \brief Count the data segments sent again
+   * \param p the packet
+   * \param h its TCP header
+   * \param socket the sending socket
+   */
+  void Tx (Ptr<const Packet> p, const TcpHeader &h, Ptr<const TcpSocketBase> socket);
+
+  double m_lossBudget;          //!< Loss budget of the sender
+  uint32_t m_received;          //!< Bytes read by the receiver
+  uint32_t m_zeros;             //!< Zeros read by the receiver
+  uint32_t m_retransmissions;   //!< Data segments sent again
+  SequenceNumber32 m_highTx;    //!< Sequence number following the highest byte sent
+};
+
+AtpSkipTestCase::AtpSkipTestCase (const std::string &desc, double lossBudget)
+  : TestCase (desc),
+    m_lossBudget (lossBudget),
+    m_received (0),
+    m_zeros (0),
+    m_retransmissions (0),
+    m_highTx (0)
+{
+}
+
+Ptr<AtpSocket>
+AtpSkipTestCase::CreateSocket (Ptr<Node> node)
+{
+  Ptr<Socket> socket = node->GetObject<TcpL4Protocol> ()->CreateSocket (TcpNewReno::GetTypeId (),
+                                                                        AtpSocket::GetTypeId ());
+  socket->SetAttribute ("SegmentSize", UintegerValue (500));
+  return DynamicCast<AtpSocket> (socket);
+}
+
+void
+AtpSkipTestCase::StartFlow (Ptr<AtpSocket> sender, InetSocketAddress to)
+{
+  sender->Bind ();
+  sender->Connect (to);
+  std::vector<uint8_t> data (50000, 0xff);
+  NS_TEST_ASSERT_MSG_EQ (sender->Send (Create<Packet> (&data[0], data.size ()), 0), 50000, "Data not queued");
+  sender->Close ();
+}
+
+void
+AtpSkipTestCase::Accept (Ptr<Socket> socket, const Address &from)
+{
+  socket->SetRecvCallback (MakeCallback (&AtpSkipTestCase::Receive, this));
+}
+
+void
+AtpSkipTestCase::Receive (Ptr<Socket> socket)
+{
+  Ptr<Packet> p;
+  while ((p = socket->Recv ()))
+    {
+      std::vector<uint8_t> data (p->GetSize ());
+      p->CopyData (&data[0], data.size ());
+      for (uint32_t i = 0; i < data.size (); ++i)
+        {
+          m_zeros += (data[i] == 0);
+        }
+      m_received += data.size ();
+    }
+}
+
+void
+AtpSkipTestCase::Tx (Ptr<const Packet> p, const TcpHeader &h, Ptr<const TcpSocketBase> socket)
+{
+  if (p->GetSize () == 0)
+    {
+      return;
+    }
+  if (h.GetSequenceNumber () < m_highTx)
+    {
+      m_retransmissions++;
+    }
+  m_highTx = std::max (m_highTx, h.GetSequenceNumber () + p->GetSize ());
+}
+
+void
+AtpSkipTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+
+  SimpleNetDeviceHelper helperChannel;
+  helperChannel.SetNetDevicePointToPointMode (true);
+  NetDeviceContainer net = helperChannel.Install (nodes);
+
+  // Packets 0 and 1 open the connection, then come the data segments
+  Ptr<ReceiveListErrorModel> errorModel = CreateObject<ReceiveListErrorModel> ();
+  std::list<uint32_t> drops;
+  drops.push_back (20);
+  drops.push_back (40);
+  errorModel->SetList (drops);
+  DynamicCast<SimpleNetDevice> (net.Get (1))->SetReceiveErrorModel (errorModel);
+
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = ipv4.Assign (net);
+
+  Ptr<AtpSocket> receiver = CreateSocket (nodes.Get (1));
+  receiver->Bind (InetSocketAddress (Ipv4Address::GetAny (), 4477));
+  receiver->Listen ();
+  receiver->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                               MakeCallback (&AtpSkipTestCase::Accept, this));
+
+  Ptr<AtpSocket> sender = CreateSocket (nodes.Get (0));
+  sender->SetLossBudget (m_lossBudget);
+  sender->TraceConnectWithoutContext ("Tx", MakeCallback (&AtpSkipTestCase::Tx, this));
+  Simulator::Schedule (Seconds (0), &AtpSkipTestCase::StartFlow, this, sender,
+                       InetSocketAddress (interfaces.GetAddress (1), 4477));
+
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_received, 50000, "Stream not delivered whole");
+  if (m_lossBudget > 0)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_zeros, 2 * 500, "The lost segments should be read as zeros");
+      NS_TEST_EXPECT_MSG_EQ (m_retransmissions, 0, "Abandoned segments retransmitted");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_zeros, 0, "Data of a reliable flow lost");
+      NS_TEST_EXPECT_MSG_GT_OR_EQ (m_retransmissions, 2, "Lost segments not retransmitted");
+    }
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief ATP loss budget TestSuite
+ */
+static class AtpLossBudgetTestSuite : public TestSuite
+{
+public:
+  AtpLossBudgetTestSuite () : TestSuite ("atp-loss-budget", UNIT)
+  {
+    AddTestCase (new AtpLossBudgetTestCase (), TestCase::QUICK);
+    AddTestCase (new AtpSkipTestCase ("Lost segments abandoned within the budget", 0.1), TestCase::QUICK);
+    AddTestCase (new AtpSkipTestCase ("Lost segments retransmitted without budget", 0.0), TestCase::QUICK);
+  }
+} g_atpLossBudgetTestSuite;
+
+} // namespace ns3
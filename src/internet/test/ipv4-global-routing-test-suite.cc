@@ -15,6 +15,9 @@
  */
 
 #include <vector>
+#include <algorithm>
+#include <set>
+#include <sstream>
 #include "ns3/boolean.h"
 #include "ns3/config.h"
 #include "ns3/inet-socket-address.h"
@@ -42,6 +45,11 @@
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/ipv4-global-routing.h"
 #include "ns3/bridge-helper.h"
+#include "ns3/udp-header.h"
+#include "ns3/tcp-header.h"
+#include "ns3/enum.h"
+#include "ns3/queue.h"
+#include "ns3/global-value.h"
 
 using namespace ns3;
 
@@ -1167,6 +1175,467 @@ Ipv4GlobalRoutingSlash32TestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \brief Checks the binary five-tuple hash used for ECMP_HASH and
+ * ECMP_FLOWCELL: it must be deterministic, depend on the ports, the flowcell
+ * and the per-node salt, and spread flows evenly over next hops.
+ */
+class Ipv4GlobalRoutingEcmpHashTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingEcmpHashTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \brief Build an UDP payload with the given ports.
+   * \param sport source port
+   * \param dport destination port
+   * \return the packet
+   */
+  Ptr<Packet> MakeUdp (uint16_t sport, uint16_t dport);
+  /**
+   * \brief Build a TCP payload with the given ports and sequence number.
+   * \param sport source port
+   * \param dport destination port
+   * \param seq sequence number
+   * \return the packet
+   */
+  Ptr<Packet> MakeTcp (uint16_t sport, uint16_t dport, uint32_t seq);
+};
+
+Ipv4GlobalRoutingEcmpHashTestCase::Ipv4GlobalRoutingEcmpHashTestCase ()
+  : TestCase ("ECMP five-tuple hashing")
+{
+}
+
+Ptr<Packet>
+Ipv4GlobalRoutingEcmpHashTestCase::MakeUdp (uint16_t sport, uint16_t dport)
+{
+  Ptr<Packet> p = Create<Packet> (100);
+  UdpHeader udp;
+  udp.SetSourcePort (sport);
+  udp.SetDestinationPort (dport);
+  p->AddHeader (udp);
+  return p;
+}
+
+Ptr<Packet>
+Ipv4GlobalRoutingEcmpHashTestCase::MakeTcp (uint16_t sport, uint16_t dport, uint32_t seq)
+{
+  Ptr<Packet> p = Create<Packet> (100);
+  TcpHeader tcp;
+  tcp.SetSourcePort (sport);
+  tcp.SetDestinationPort (dport);
+  tcp.SetSequenceNumber (SequenceNumber32 (seq));
+  p->AddHeader (tcp);
+  return p;
+}
+
+void
+Ipv4GlobalRoutingEcmpHashTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+  InternetStackHelper internet;
+  Ipv4GlobalRoutingHelper ipv4RoutingHelper;
+  internet.SetRoutingHelper (ipv4RoutingHelper);
+  internet.Install (nodes);
+
+  Ptr<Ipv4GlobalRouting> routing0 = nodes.Get (0)->GetObject<Ipv4L3Protocol> ()
+    ->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ();
+  Ptr<Ipv4GlobalRouting> routing1 = nodes.Get (1)->GetObject<Ipv4L3Protocol> ()
+    ->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ();
+  NS_TEST_ASSERT_MSG_NE (routing0, 0, "Error-- no Ipv4GlobalRouting object");
+  NS_TEST_ASSERT_MSG_NE (routing1, 0, "Error-- no Ipv4GlobalRouting object");
+
+  Ipv4Header header;
+  header.SetSource (Ipv4Address ("10.0.0.1"));
+  header.SetDestination (Ipv4Address ("10.0.1.1"));
+  header.SetProtocol (17);
+
+  uint64_t h = routing0->GetTupleValue (header, MakeUdp (1000, 80));
+  NS_TEST_ASSERT_MSG_EQ (routing0->GetTupleValue (header, MakeUdp (1000, 80)), h,
+                         "hash is not deterministic");
+  NS_TEST_ASSERT_MSG_NE (routing0->GetTupleValue (header, MakeUdp (1001, 80)), h,
+                         "hash does not depend on the source port");
+  NS_TEST_ASSERT_MSG_NE (routing1->GetTupleValue (header, MakeUdp (1000, 80)), h,
+                         "hash does not depend on the node salt");
+
+  // flows must spread evenly over the next hops
+  const uint32_t nFlows = 4000;
+  const uint32_t nPaths = 4;
+  std::vector<uint32_t> count (nPaths, 0);
+  for (uint32_t i = 0; i < nFlows; i++)
+    {
+      count[routing0->GetTupleValue (header, MakeUdp (10000 + i, 80)) % nPaths]++;
+    }
+  for (uint32_t i = 0; i < nPaths; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ_TOL (count[i], nFlows / nPaths, nFlows / nPaths / 5,
+                                 "uneven spread on path " << i);
+    }
+
+  // the flowcell changes every 64KB of sequence space
+  header.SetProtocol (6);
+  h = routing0->GetTupleValue (header, MakeTcp (1000, 80, 0x10000), true);
+  NS_TEST_ASSERT_MSG_EQ (routing0->GetTupleValue (header, MakeTcp (1000, 80, 0x1ffff), true), h,
+                         "hash changed within a flowcell");
+  NS_TEST_ASSERT_MSG_NE (routing0->GetTupleValue (header, MakeTcp (1000, 80, 0x20000), true), h,
+                         "hash did not change across flowcells");
+  NS_TEST_ASSERT_MSG_EQ (routing0->GetTupleValue (header, MakeTcp (1000, 80, 0x10000)),
+                         routing0->GetTupleValue (header, MakeTcp (1000, 80, 0x20000)),
+                         "per-flow hash depends on the sequence number");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Checks that lookups through the forwarding index match host routes
+ * first, then network routes by longest prefix, that routes are cached per
+ * next hop, and that the index follows changes to the routing table.
+ */
+class Ipv4GlobalRoutingIndexTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingIndexTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \brief Look up the gateway towards a destination.
+   * \param routing the routing protocol
+   * \param dest the destination
+   * \return the gateway, or 255.255.255.255 if there is no route
+   */
+  Ipv4Address Gateway (Ptr<Ipv4GlobalRouting> routing, Ipv4Address dest);
+};
+
+Ipv4GlobalRoutingIndexTestCase::Ipv4GlobalRoutingIndexTestCase ()
+  : TestCase ("Forwarding index longest prefix match")
+{
+}
+
+Ipv4Address
+Ipv4GlobalRoutingIndexTestCase::Gateway (Ptr<Ipv4GlobalRouting> routing, Ipv4Address dest)
+{
+  Ipv4Header header;
+  header.SetDestination (dest);
+  Socket::SocketErrno sockerr;
+  Ptr<Ipv4Route> route = routing->RouteOutput (Create<Packet> (), header, 0, sockerr);
+  if (route == 0)
+    {
+      return Ipv4Address::GetBroadcast ();
+    }
+  return route->GetGateway ();
+}
+
+void
+Ipv4GlobalRoutingIndexTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+  Ptr<SimpleChannel> channel = CreateObject <SimpleChannel> ();
+  SimpleNetDeviceHelper simpleHelper;
+  simpleHelper.SetNetDevicePointToPointMode (true);
+  NetDeviceContainer net = simpleHelper.Install (nodes, channel);
+
+  InternetStackHelper internet;
+  Ipv4GlobalRoutingHelper ipv4RoutingHelper;
+  internet.SetRoutingHelper (ipv4RoutingHelper);
+  internet.Install (nodes);
+
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  ipv4.Assign (net);
+
+  Ptr<Ipv4GlobalRouting> routing = nodes.Get (0)->GetObject<Ipv4L3Protocol> ()
+    ->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ();
+  NS_TEST_ASSERT_MSG_NE (routing, 0, "Error-- no Ipv4GlobalRouting object");
+
+  routing->AddHostRouteTo (Ipv4Address ("10.2.3.4"), Ipv4Address ("10.1.1.4"), 1);
+  routing->AddNetworkRouteTo (Ipv4Address ("10.2.0.0"), Ipv4Mask ("255.255.0.0"), Ipv4Address ("10.1.1.16"), 1);
+  routing->AddNetworkRouteTo (Ipv4Address ("10.2.3.0"), Ipv4Mask ("255.255.255.0"), Ipv4Address ("10.1.1.24"), 1);
+  routing->AddNetworkRouteTo (Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"), Ipv4Address ("10.1.1.99"), 1);
+
+  NS_TEST_ASSERT_MSG_EQ (Gateway (routing, Ipv4Address ("10.2.3.4")), Ipv4Address ("10.1.1.4"),
+                         "host route not preferred");
+  NS_TEST_ASSERT_MSG_EQ (Gateway (routing, Ipv4Address ("10.2.3.5")), Ipv4Address ("10.1.1.24"),
+                         "/24 route not preferred over /16");
+  NS_TEST_ASSERT_MSG_EQ (Gateway (routing, Ipv4Address ("10.2.9.9")), Ipv4Address ("10.1.1.16"),
+                         "/16 route not preferred over default");
+  NS_TEST_ASSERT_MSG_EQ (Gateway (routing, Ipv4Address ("10.3.0.1")), Ipv4Address ("10.1.1.99"),
+                         "default route not used");
+
+  // routes are built once per next hop and shared afterwards
+  Ipv4Header header;
+  header.SetDestination (Ipv4Address ("10.2.3.5"));
+  Socket::SocketErrno sockerr;
+  Ptr<Ipv4Route> route = routing->RouteOutput (Create<Packet> (), header, 0, sockerr);
+  NS_TEST_ASSERT_MSG_EQ (routing->RouteOutput (Create<Packet> (), header, 0, sockerr), route,
+                         "route not cached");
+  NS_TEST_ASSERT_MSG_EQ (route->GetSource (), Ipv4Address ("10.1.1.1"), "wrong source address");
+
+  // removing the host route must be reflected by the index
+  routing->RemoveRoute (0);
+  NS_TEST_ASSERT_MSG_EQ (Gateway (routing, Ipv4Address ("10.2.3.4")), Ipv4Address ("10.1.1.24"),
+                         "index not rebuilt after a route removal");
+  // so must the removal of the default route
+  routing->RemoveRoute (2);
+  NS_TEST_ASSERT_MSG_EQ (Gateway (routing, Ipv4Address ("10.3.0.1")), Ipv4Address::GetBroadcast (),
+                         "route found after removal of the default route");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Checks flowlet switching (ECMP_FLOWLET) and queue-aware flowlet
+ * placement (ECMP_CONGA) on a node with two equal-cost next hops.
+ */
+class Ipv4GlobalRoutingFlowletTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingFlowletTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \brief Route two back-to-back packets of the same flow and record the
+   * output device.
+   */
+  void RouteBurst (void);
+  /**
+   * \brief Route a packet of a flow.
+   * \param sport the source port of the flow
+   * \return the output device
+   */
+  Ptr<NetDevice> Route (uint16_t sport);
+
+  Ptr<Ipv4GlobalRouting> m_routing;        //!< routing protocol under test
+  std::vector<Ptr<NetDevice> > m_devices;  //!< output device of each burst
+  bool m_burstSplit;                       //!< true if a burst was split across next hops
+};
+
+Ipv4GlobalRoutingFlowletTestCase::Ipv4GlobalRoutingFlowletTestCase ()
+  : TestCase ("ECMP flowlet switching"),
+    m_burstSplit (false)
+{
+}
+
+Ptr<NetDevice>
+Ipv4GlobalRoutingFlowletTestCase::Route (uint16_t sport)
+{
+  Ipv4Header header;
+  header.SetSource (Ipv4Address ("10.1.1.1"));
+  header.SetDestination (Ipv4Address ("10.9.9.9"));
+  header.SetProtocol (17);
+  Ptr<Packet> p = Create<Packet> (100);
+  UdpHeader udp;
+  udp.SetSourcePort (sport);
+  udp.SetDestinationPort (80);
+  p->AddHeader (udp);
+  Socket::SocketErrno sockerr;
+  return m_routing->RouteOutput (p, header, 0, sockerr)->GetOutputDevice ();
+}
+
+void
+Ipv4GlobalRoutingFlowletTestCase::RouteBurst (void)
+{
+  Ptr<NetDevice> device = Route (1000);
+  m_burstSplit |= (Route (1000) != device);
+  m_devices.push_back (device);
+}
+
+void
+Ipv4GlobalRoutingFlowletTestCase::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (3);
+  SimpleNetDeviceHelper simpleHelper;
+  simpleHelper.SetNetDevicePointToPointMode (true);
+  NetDeviceContainer net1 = simpleHelper.Install (NodeContainer (nodes.Get (0), nodes.Get (1)));
+  NetDeviceContainer net2 = simpleHelper.Install (NodeContainer (nodes.Get (0), nodes.Get (2)));
+
+  InternetStackHelper internet;
+  Ipv4GlobalRoutingHelper ipv4RoutingHelper;
+  internet.SetRoutingHelper (ipv4RoutingHelper);
+  internet.Install (nodes);
+
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  ipv4.Assign (net1);
+  ipv4.SetBase ("10.1.2.0", "255.255.255.0");
+  ipv4.Assign (net2);
+
+  m_routing = nodes.Get (0)->GetObject<Ipv4L3Protocol> ()
+    ->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ();
+  NS_TEST_ASSERT_MSG_NE (m_routing, 0, "Error-- no Ipv4GlobalRouting object");
+  m_routing->AddHostRouteTo (Ipv4Address ("10.9.9.9"), Ipv4Address ("10.1.1.2"), 1);
+  m_routing->AddHostRouteTo (Ipv4Address ("10.9.9.9"), Ipv4Address ("10.1.2.2"), 2);
+
+  // bursts separated by more than the flowlet timeout are placed at random
+  m_routing->SetAttribute ("EcmpMode", EnumValue (ECMP_FLOWLET));
+  m_routing->SetAttribute ("FlowletTimeout", TimeValue (MicroSeconds (500)));
+  for (uint32_t i = 0; i < 40; i++)
+    {
+      Simulator::Schedule (MilliSeconds (i), &Ipv4GlobalRoutingFlowletTestCase::RouteBurst, this);
+    }
+  Simulator::Run ();
+  NS_TEST_ASSERT_MSG_EQ (m_burstSplit, false, "flowlet split across next hops");
+  uint32_t onFirst = std::count (m_devices.begin (), m_devices.end (), net1.Get (0));
+  NS_TEST_ASSERT_MSG_GT (onFirst, 0, "new flowlets never placed on the first next hop");
+  NS_TEST_ASSERT_MSG_LT (onFirst, m_devices.size (), "new flowlets never placed on the second next hop");
+
+  // new flowlets avoid the next hop with a backlog
+  m_routing->SetAttribute ("EcmpMode", EnumValue (ECMP_CONGA));
+  PointerValue queue;
+  net1.Get (0)->GetAttribute ("TxQueue", queue);
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      queue.Get<Queue> ()->Enqueue (Create<QueueItem> (Create<Packet> (1000)));
+    }
+  for (uint16_t sport = 2000; sport < 2050; sport++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (Route (sport), net2.Get (0), "flowlet placed on the congested next hop");
+    }
+
+  m_routing = 0;
+  Simulator::Destroy ();
+}
+
+/**
+ * \brief Checks that the routes computed with several SPF threads are
+ * those computed with one, on a k=4 fat-tree with ECMP.
+ */
+class Ipv4GlobalRoutingThreadsTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingThreadsTestCase ();
+
+private:
+  virtual void DoRun (void);
+  /**
+   * \brief Connect two nodes with a point-to-point link.
+   * \param a the first node
+   * \param b the second node
+   * \param ipv4 the address helper, whose network is used by the link
+   */
+  void Link (Ptr<Node> a, Ptr<Node> b, Ipv4AddressHelper &ipv4);
+  /**
+   * \brief Dump the global routes of the nodes.
+   * \param nodes the nodes
+   * \return one line per route
+   */
+  std::vector<std::string> Routes (NodeContainer nodes);
+};
+
+Ipv4GlobalRoutingThreadsTestCase::Ipv4GlobalRoutingThreadsTestCase ()
+  : TestCase ("Parallel SPF computes the routes of a serial one")
+{
+}
+
+void
+Ipv4GlobalRoutingThreadsTestCase::Link (Ptr<Node> a, Ptr<Node> b, Ipv4AddressHelper &ipv4)
+{
+  Ptr<SimpleChannel> channel = CreateObject <SimpleChannel> ();
+  SimpleNetDeviceHelper simpleHelper;
+  simpleHelper.SetNetDevicePointToPointMode (true);
+  ipv4.Assign (simpleHelper.Install (NodeContainer (a, b), channel));
+  ipv4.NewNetwork ();
+}
+
+std::vector<std::string>
+Ipv4GlobalRoutingThreadsTestCase::Routes (NodeContainer nodes)
+{
+  std::vector<std::string> routes;
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      Ptr<Ipv4GlobalRouting> routing = nodes.Get (i)->GetObject<Ipv4L3Protocol> ()
+        ->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ();
+      for (uint32_t j = 0; j < routing->GetNRoutes (); j++)
+        {
+          Ipv4RoutingTableEntry *route = routing->GetRoute (j);
+          std::ostringstream oss;
+          oss << i << " " << route->GetDest () << "/" << route->GetDestNetworkMask ()
+              << " via " << route->GetGateway () << " if " << route->GetInterface ();
+          routes.push_back (oss.str ());
+        }
+    }
+  return routes;
+}
+
+void
+Ipv4GlobalRoutingThreadsTestCase::DoRun (void)
+{
+  const uint32_t k = 4;
+  NodeContainer core, agg, edge, hosts;
+  core.Create (k * k / 4);
+  agg.Create (k * k / 2);
+  edge.Create (k * k / 2);
+  hosts.Create (k * k * k / 4);
+  NodeContainer nodes (core, agg, edge, hosts);
+
+  InternetStackHelper internet;
+  Ipv4GlobalRoutingHelper ipv4RoutingHelper;
+  internet.SetRoutingHelper (ipv4RoutingHelper);
+  internet.Install (nodes);
+
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.0.0.0", "255.255.255.252");
+  for (uint32_t e = 0; e < edge.GetN (); e++)
+    {
+      uint32_t pod = e / (k / 2);
+      for (uint32_t h = 0; h < k / 2; h++)
+        {
+          Link (hosts.Get (e * k / 2 + h), edge.Get (e), ipv4);
+        }
+      for (uint32_t a = 0; a < k / 2; a++)
+        {
+          Link (edge.Get (e), agg.Get (pod * k / 2 + a), ipv4);
+        }
+    }
+  for (uint32_t a = 0; a < agg.GetN (); a++)
+    {
+      for (uint32_t c = 0; c < k / 2; c++)
+        {
+          Link (agg.Get (a), core.Get ((a % (k / 2)) * k / 2 + c), ipv4);
+        }
+    }
+
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  std::vector<std::string> serial = Routes (nodes);
+
+  GlobalValue::Bind ("GlobalRoutingSpfThreads", UintegerValue (4));
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  std::vector<std::string> parallel = Routes (nodes);
+  GlobalValue::Bind ("GlobalRoutingSpfThreads", UintegerValue (1));
+
+  NS_TEST_ASSERT_MSG_EQ (serial.size (), parallel.size (), "different number of routes");
+  for (uint32_t i = 0; i < serial.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (serial[i], parallel[i], "route " << i << " differs");
+    }
+
+  // an edge switch reaches the hosts of another pod through all its
+  // aggregation switches
+  Ptr<Ipv4GlobalRouting> routing = edge.Get (0)->GetObject<Ipv4L3Protocol> ()
+    ->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ();
+  Ipv4Address remote = hosts.Get (hosts.GetN () - 1)->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ();
+  std::set<Ipv4Address> nextHops;
+  for (uint32_t j = 0; j < routing->GetNRoutes (); j++)
+    {
+      Ipv4RoutingTableEntry *route = routing->GetRoute (j);
+      if (route->GetDest () == remote.CombineMask (route->GetDestNetworkMask ())
+          && route->GetDestNetworkMask () == Ipv4Mask ("255.255.255.252"))
+        {
+          nextHops.insert (route->GetGateway ());
+        }
+    }
+  NS_TEST_ASSERT_MSG_EQ (nextHops.size (), k / 2, "missing equal-cost next hops");
+
+  Simulator::Destroy ();
+}
+
 class Ipv4GlobalRoutingTestSuite : public TestSuite
 {
 public:
@@ -1184,6 +1653,10 @@ Ipv4GlobalRoutingTestSuite::Ipv4GlobalRoutingTestSuite ()
     AddTestCase (new TwoBridgeTest, TestCase::QUICK);
     AddTestCase (new Ipv4DynamicGlobalRoutingTestCase, TestCase::QUICK);
     AddTestCase (new Ipv4GlobalRoutingSlash32TestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingEcmpHashTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingIndexTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingFlowletTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingThreadsTestCase, TestCase::QUICK);
   }
 
 // Do not forget to allocate an instance of this TestSuite
@@ -0,0 +1,226 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "tcp-general-test.h"
+#include "ns3/node.h"
+#include "ns3/log.h"
+#include "ns3/error-model.h"
+#include "ns3/segmentation-tag.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpOffloadTestSuite");
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Error model marking the second wire segment of every
+ * super-segment, as a queue disc above its marking threshold would
+ */
+class TcpSegmentMarkErrorModel : public ErrorModel
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+private:
+  virtual bool DoCorrupt (Ptr<Packet> p);
+  virtual void DoReset (void);
+};
+
+TypeId
+TcpSegmentMarkErrorModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpSegmentMarkErrorModel")
+    .SetParent<ErrorModel> ()
+  ;
+  return tid;
+}
+
+bool
+TcpSegmentMarkErrorModel::DoCorrupt (Ptr<Packet> p)
+{
+  SegmentationTag tag;
+  if (p->PeekPacketTag (tag))
+    {
+      tag.MarkSegment (1);
+      p->ReplacePacketTag (tag);
+    }
+  return false;
+}
+
+void
+TcpSegmentMarkErrorModel::DoReset (void)
+{
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the super-segments of a sender with segmentation offload
+ *
+ * The sender has a full buffer, and sends its new data in super-segments.
+ * The receiver hands each of them to its buffer at once, unless some of
+ * its wire segments are marked CE: it is then split in runs of segments
+ * of the same CE state, and the marks are echoed.
+ */
+class TcpOffloadTest : public TcpGeneralTest
+{
+public:
+  /**
+   * \brief Constructor
+   * \param desc Description
+   * \param mark Mark the second wire segment of every super-segment
+   */
+  TcpOffloadTest (const std::string &desc, bool mark);
+
+protected:
+  virtual Ptr<TcpSocketMsgBase> CreateSenderSocket (Ptr<Node> node);
+  virtual Ptr<ErrorModel> CreateReceiverErrorModel ();
+  virtual void Tx (const Ptr<const Packet> p, const TcpHeader&h, SocketWho who);
+  virtual void Rx (const Ptr<const Packet> p, const TcpHeader&h, SocketWho who);
+  virtual void ConfigureEnvironment ();
+  virtual void ConfigureProperties ();
+  virtual void FinalChecks ();
+
+private:
+  bool m_mark;                  //!< Mark the second wire segment
+  uint32_t m_superSegments;     //!< Super-segments sent
+  uint32_t m_expectedRx;        //!< Data packets the receiver should see
+  uint32_t m_rx;                //!< Data packets seen by the receiver
+  bool m_eceReceived;           //!< The sender got an ECN echo
+};
+
+TcpOffloadTest::TcpOffloadTest (const std::string &desc, bool mark)
+  : TcpGeneralTest (desc),
+    m_mark (mark),
+    m_superSegments (0),
+    m_expectedRx (0),
+    m_rx (0),
+    m_eceReceived (false)
+{
+}
+
+void
+TcpOffloadTest::ConfigureEnvironment ()
+{
+  TcpGeneralTest::ConfigureEnvironment ();
+  SetAppPktCount (200);
+  SetAppPktInterval (Seconds (0));
+  SetPropagationDelay (MilliSeconds (50));
+}
+
+void
+TcpOffloadTest::ConfigureProperties ()
+{
+  TcpGeneralTest::ConfigureProperties ();
+  if (m_mark)
+    {
+      SetECN (SENDER);
+      SetECN (RECEIVER);
+    }
+}
+
+Ptr<TcpSocketMsgBase>
+TcpOffloadTest::CreateSenderSocket (Ptr<Node> node)
+{
+  Ptr<TcpSocketMsgBase> socket = TcpGeneralTest::CreateSenderSocket (node);
+  socket->SetAttribute ("Offload", BooleanValue (true));
+  // four segments of 500 bytes, the segment size set by TcpGeneralTest
+  socket->SetAttribute ("OffloadMaxSize", UintegerValue (4 * 500));
+  return socket;
+}
+
+Ptr<ErrorModel>
+TcpOffloadTest::CreateReceiverErrorModel ()
+{
+  if (m_mark)
+    {
+      return CreateObject<TcpSegmentMarkErrorModel> ();
+    }
+  return TcpGeneralTest::CreateReceiverErrorModel ();
+}
+
+void
+TcpOffloadTest::Tx (const Ptr<const Packet> p, const TcpHeader &h, SocketWho who)
+{
+  if (who != SENDER || p->GetSize () == 0)
+    {
+      return;
+    }
+  SegmentationTag tag;
+  if (!p->PeekPacketTag (tag))
+    {
+      m_expectedRx++;
+      return;
+    }
+  NS_TEST_ASSERT_MSG_LT_OR_EQ (p->GetSize (), 4 * GetSegSize (SENDER), "Super-segment larger than OffloadMaxSize");
+  NS_TEST_ASSERT_MSG_EQ (tag.GetSegmentSize (), GetSegSize (SENDER), "Wire segments of the wrong size");
+  m_superSegments++;
+  // the marked segment splits the super-segment in up to three runs
+  m_expectedRx += m_mark ? std::min (tag.GetSegmentCount (), 3u) : 1;
+}
+
+void
+TcpOffloadTest::Rx (const Ptr<const Packet> p, const TcpHeader &h, SocketWho who)
+{
+  if (who == RECEIVER && p->GetSize () > 0)
+    {
+      NS_LOG_DEBUG ("Received " << p->GetSize () << " bytes at " << h.GetSequenceNumber ());
+      m_rx++;
+    }
+  else if (who == SENDER && (h.GetFlags () & TcpHeader::ECE))
+    {
+      m_eceReceived = true;
+    }
+}
+
+void
+TcpOffloadTest::FinalChecks ()
+{
+  NS_TEST_ASSERT_MSG_EQ (GetRxBuffer (RECEIVER)->NextRxSequence (),
+                         SequenceNumber32 (1 + GetPktCount () * GetPktSize () + 1),
+                         "Transfer not completed");
+  NS_TEST_ASSERT_MSG_GT (m_superSegments, 0, "No super-segment sent");
+  NS_TEST_ASSERT_MSG_EQ (m_rx, m_expectedRx, "Super-segments not handed up as expected");
+  NS_TEST_ASSERT_MSG_EQ (m_eceReceived, m_mark, "The marks should be echoed");
+}
+
+//-----------------------------------------------------------------------------
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP segmentation offload TestSuite
+ */
+static class TcpOffloadTestSuite : public TestSuite
+{
+public:
+  TcpOffloadTestSuite () : TestSuite ("tcp-offload-test", UNIT)
+  {
+    AddTestCase (new TcpOffloadTest ("Super-segments coalesced at the receiver", false), TestCase::QUICK);
+    AddTestCase (new TcpOffloadTest ("Super-segments split at the CE marks", true), TestCase::QUICK);
+  }
+} g_tcpOffloadTestSuite;
+
+} // namespace ns3
@@ -0,0 +1,293 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/tcp-rx-buffer.h"
+#include "ns3/tcp-header.h"
+#include "ns3/log.h"
+
+#include <vector>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpRxBufferTestSuite");
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Feed a TcpRxBuffer with out of order, overlapping and duplicate
+ * segments, and check the sequence numbers, the SACK blocks and the
+ * bytes delivered to the application.
+ */
+class TcpRxBufferTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   * \param firstSeq Sequence number of the first byte
+   * \param name Test description
+   */
+  TcpRxBufferTestCase (uint32_t firstSeq, const std::string &name);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Build a segment of the stream
+   * \param offset Offset of the first byte in the stream
+   * \param size Size of the segment
+   * \returns the segment
+   */
+  Ptr<Packet> MakeSegment (uint32_t offset, uint32_t size);
+
+  /**
+   * \brief Add a segment of the stream to the buffer
+   * \param offset Offset of the first byte in the stream
+   * \param size Size of the segment
+   * \returns the value returned by TcpRxBuffer::Add
+   */
+  bool Receive (uint32_t offset, uint32_t size);
+
+  /**
+   * \brief Extract data and check it
+   * \param maxSize Size asked for
+   * \param expectedSize Size expected
+   */
+  void CheckExtract (uint32_t maxSize, uint32_t expectedSize);
+
+  /**
+   * \brief Check a SACK block
+   * \param block The block
+   * \param head Expected offset in the stream of the first byte
+   * \param tail Expected offset in the stream following the last byte
+   */
+  void CheckBlock (const TcpRxBuffer::SackBlock &block, uint32_t head, uint32_t tail);
+
+  Ptr<TcpRxBuffer> m_buffer;    //!< Buffer under test
+  SequenceNumber32 m_firstSeq;  //!< Sequence number of the first byte of the stream
+  uint32_t m_read;              //!< Number of bytes extracted
+};
+
+TcpRxBufferTestCase::TcpRxBufferTestCase (uint32_t firstSeq, const std::string &name)
+  : TestCase (name),
+    m_firstSeq (firstSeq),
+    m_read (0)
+{
+}
+
+Ptr<Packet>
+TcpRxBufferTestCase::MakeSegment (uint32_t offset, uint32_t size)
+{
+  std::vector<uint8_t> data (size);
+  for (uint32_t i = 0; i < size; ++i)
+    {
+      data[i] = static_cast<uint8_t> ((offset + i) % 251);
+    }
+  return Create<Packet> (&data[0], size);
+}
+
+bool
+TcpRxBufferTestCase::Receive (uint32_t offset, uint32_t size)
+{
+  TcpHeader header;
+  header.SetSequenceNumber (m_firstSeq + offset);
+  return m_buffer->Add (MakeSegment (offset, size), header);
+}
+
+void
+TcpRxBufferTestCase::CheckExtract (uint32_t maxSize, uint32_t expectedSize)
+{
+  Ptr<Packet> p = m_buffer->Extract (maxSize);
+  if (expectedSize == 0)
+    {
+      NS_TEST_ASSERT_MSG_EQ (p, 0, "Data extracted from an empty buffer");
+      return;
+    }
+  NS_TEST_ASSERT_MSG_NE (p, 0, "No data extracted");
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), expectedSize, "Wrong size extracted at " << m_read);
+  std::vector<uint8_t> data (expectedSize);
+  p->CopyData (&data[0], expectedSize);
+  for (uint32_t i = 0; i < expectedSize; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (data[i]), (m_read + i) % 251,
+                             "Wrong byte " << i << " extracted at " << m_read);
+    }
+  m_read += expectedSize;
+}
+
+void
+TcpRxBufferTestCase::CheckBlock (const TcpRxBuffer::SackBlock &block, uint32_t head, uint32_t tail)
+{
+  NS_TEST_EXPECT_MSG_EQ (block.first, m_firstSeq + head, "Wrong SACK block head");
+  NS_TEST_EXPECT_MSG_EQ (block.second, m_firstSeq + tail, "Wrong SACK block tail");
+}
+
+void
+TcpRxBufferTestCase::DoRun (void)
+{
+  m_buffer = CreateObject<TcpRxBuffer> ();
+  m_buffer->SetNextRxSequence (m_firstSeq);
+  m_buffer->SetMaxBufferSize (10000);
+
+  // Three holes: [0, 1000), [2000, 3000), [4000, 6000)
+  NS_TEST_ASSERT_MSG_EQ (Receive (3000, 500), true, "Out of order segment refused");
+  NS_TEST_ASSERT_MSG_EQ (Receive (1000, 1000), true, "Out of order segment refused");
+  NS_TEST_ASSERT_MSG_EQ (Receive (6000, 1000), true, "Out of order segment refused");
+  NS_TEST_ASSERT_MSG_EQ (Receive (3500, 500), true, "Out of order segment refused");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->NextRxSequence (), m_firstSeq, "Hole at the head skipped");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->Size (), 3000, "Wrong occupancy");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->Available (), 0, "Out of order data available");
+  CheckExtract (1000, 0);
+
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->GetSackListSize (), 3, "Wrong number of SACK blocks");
+  TcpRxBuffer::SackList sack = m_buffer->GetSackList ();
+  NS_TEST_ASSERT_MSG_EQ (sack.size (), 3, "Wrong number of SACK blocks");
+  CheckBlock (sack[0], 3000, 4000); // most recent first
+  CheckBlock (sack[1], 1000, 2000);
+  CheckBlock (sack[2], 6000, 7000);
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->GetSackList (2).size (), 2, "SACK list not truncated");
+
+  // A duplicate is refused, a segment across two holes fills both
+  NS_TEST_ASSERT_MSG_EQ (Receive (1200, 300), false, "Duplicate segment accepted");
+  NS_TEST_ASSERT_MSG_EQ (Receive (1500, 3000), true, "Overlapping segment refused");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->Size (), 4500, "Wrong occupancy after an overlap");
+  sack = m_buffer->GetSackList ();
+  NS_TEST_ASSERT_MSG_EQ (sack.size (), 2, "Wrong number of SACK blocks after an overlap");
+  CheckBlock (sack[0], 1000, 4500);
+  CheckBlock (sack[1], 6000, 7000);
+
+  // The head arrives in two pieces
+  Ptr<Packet> head = MakeSegment (0, 600);
+  TcpHeader header;
+  header.SetSequenceNumber (m_firstSeq);
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->Add (head, header), true, "In order segment refused");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->Available (), 600, "Wrong available data");
+  NS_TEST_ASSERT_MSG_EQ (Receive (0, 1000), true, "Overlapping segment refused");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->NextRxSequence (), m_firstSeq + 4500, "Holes not filled");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->Available (), 4500, "Wrong available data");
+  sack = m_buffer->GetSackList ();
+  NS_TEST_ASSERT_MSG_EQ (sack.size (), 1, "In order data reported in SACK blocks");
+  CheckBlock (sack[0], 6000, 7000);
+
+  // The first packet is delivered as it was received
+  Ptr<Packet> p = m_buffer->Extract (600);
+  NS_TEST_ASSERT_MSG_EQ (PeekPointer (p), PeekPointer (head), "Whole packet fragmented on delivery");
+  m_read = 600;
+  CheckExtract (1, 1);
+  CheckExtract (2000, 2000);
+  CheckExtract (100000, 1899);
+  CheckExtract (100000, 0);
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->Size (), 1000, "Wrong occupancy after extraction");
+
+  // The window starts at the first byte buffered
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->MaxRxSequence (), m_firstSeq + 16000, "Wrong window end");
+  NS_TEST_ASSERT_MSG_EQ (Receive (15500, 1000), true, "Segment in the window refused");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->Size (), 1500, "Segment not trimmed to the window");
+  NS_TEST_ASSERT_MSG_EQ (Receive (16000, 1000), false, "Segment beyond the window accepted");
+
+  // Fill the holes, then the FIN
+  NS_TEST_ASSERT_MSG_EQ (Receive (4500, 1500), true, "In order segment refused");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->NextRxSequence (), m_firstSeq + 7000, "Hole not filled");
+  CheckExtract (100000, 2500);
+  m_buffer->SetFinSequence (m_firstSeq + 16000);
+  NS_TEST_ASSERT_MSG_EQ (Receive (7000, 8500), true, "In order segment refused");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->NextRxSequence (), m_firstSeq + 16001, "FIN not accounted");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->Finished (), true, "Buffer not finished");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->GetSackListSize (), 0, "SACK blocks left");
+  CheckExtract (100000, 9000);
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->Size (), 0, "Data left after extraction");
+  m_buffer = 0;
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Fill the ranges a sender abandoned, around the data received,
+ * and check that the zeros are delivered at their offset in the stream.
+ */
+class TcpRxBufferFillTestCase : public TestCase
+{
+public:
+  TcpRxBufferFillTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TcpRxBufferFillTestCase::TcpRxBufferFillTestCase ()
+  : TestCase ("Fill abandoned ranges with zeros")
+{
+}
+
+void
+TcpRxBufferFillTestCase::DoRun (void)
+{
+  SequenceNumber32 first (1000);
+  Ptr<TcpRxBuffer> buffer = CreateObject<TcpRxBuffer> ();
+  buffer->SetNextRxSequence (first);
+  buffer->SetMaxBufferSize (10000);
+
+  // Data at [500, 1000) only; [0, 1500) is abandoned
+  std::vector<uint8_t> data (500, 0xff);
+  TcpHeader header;
+  header.SetSequenceNumber (first + 500);
+  NS_TEST_ASSERT_MSG_EQ (buffer->Add (Create<Packet> (&data[0], 500), header), true, "Segment refused");
+  NS_TEST_ASSERT_MSG_EQ (buffer->Fill (first, first + 1500), 1000, "Wrong number of bytes filled");
+  NS_TEST_ASSERT_MSG_EQ (buffer->NextRxSequence (), first + 1500, "Abandoned range not skipped");
+  NS_TEST_ASSERT_MSG_EQ (buffer->Available (), 1500, "Wrong available data");
+  NS_TEST_ASSERT_MSG_EQ (buffer->GetSackListSize (), 0, "SACK blocks left");
+  NS_TEST_ASSERT_MSG_EQ (buffer->Fill (first, first + 1500), 0, "Range filled twice");
+
+  Ptr<Packet> p = buffer->Extract (100000);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 1500, "Wrong size extracted");
+  std::vector<uint8_t> read (1500);
+  p->CopyData (&read[0], 1500);
+  for (uint32_t i = 0; i < 1500; ++i)
+    {
+      uint32_t expected = (i >= 500 && i < 1000) ? 0xff : 0;
+      NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (read[i]), expected, "Wrong byte " << i);
+    }
+
+  // A range beyond the window is filled up to it
+  NS_TEST_ASSERT_MSG_EQ (buffer->Fill (first + 1500, first + 20000), 10000, "Fill beyond the window");
+  NS_TEST_ASSERT_MSG_EQ (buffer->NextRxSequence (), first + 11500, "Wrong next sequence");
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TcpRxBuffer TestSuite
+ */
+class TcpRxBufferTestSuite : public TestSuite
+{
+public:
+  TcpRxBufferTestSuite () : TestSuite ("tcp-rx-buffer", UNIT)
+  {
+    AddTestCase (new TcpRxBufferTestCase (1, "Reorder and deliver data"), TestCase::QUICK);
+    AddTestCase (new TcpRxBufferTestCase (0xfffff000, "Reorder and deliver data across a sequence wrap"),
+                 TestCase::QUICK);
+    AddTestCase (new TcpRxBufferFillTestCase (), TestCase::QUICK);
+  }
+};
+
+static TcpRxBufferTestSuite g_tcpRxBufferTestSuite; //!< Static variable for test initialization
+
+} // namespace ns3
@@ -0,0 +1,196 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "tcp-general-test.h"
+#include "ns3/node.h"
+#include "ns3/log.h"
+#include "tcp-error-model.h"
+
+#include <map>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpSackTestSuite");
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Drop several segments of the same window, and check that the
+ * sender recovers them without an RTO, retransmitting each of them once
+ *
+ * With SACK disabled on both sides, the check is that no SACK option
+ * travels and that the transfer completes anyway.
+ */
+class TcpSackTest : public TcpGeneralTest
+{
+public:
+  /**
+   * \brief Constructor
+   * \param desc Description
+   * \param sack Enable SACK on both sockets
+   * \param toDrop Sequence numbers of the segments to drop
+   */
+  TcpSackTest (const std::string &desc, bool sack, std::vector<uint32_t> &toDrop);
+
+protected:
+  virtual Ptr<ErrorModel> CreateReceiverErrorModel ();
+  virtual Ptr<TcpSocketMsgBase> CreateReceiverSocket (Ptr<Node> node);
+  virtual Ptr<TcpSocketMsgBase> CreateSenderSocket (Ptr<Node> node);
+  virtual void Tx (const Ptr<const Packet> p, const TcpHeader&h, SocketWho who);
+  virtual void RTOExpired (const Ptr<const TcpSocketState> tcb, SocketWho who);
+  virtual void ConfigureEnvironment ();
+  virtual void FinalChecks ();
+
+private:
+  bool m_sack;                                  //!< SACK enabled
+  std::vector<uint32_t> m_toDrop;               //!< Sequence numbers to drop
+  std::map<uint32_t, uint32_t> m_retransmitted; //!< Retransmissions, by sequence number
+  SequenceNumber32 m_highestTx;                 //!< Highest sequence number sent
+  uint32_t m_sackOptions;                       //!< SACK options sent by the receiver
+  uint32_t m_rtoExpired;                        //!< RTO expirations at the sender
+};
+
+TcpSackTest::TcpSackTest (const std::string &desc, bool sack,
+                          std::vector<uint32_t> &toDrop)
+  : TcpGeneralTest (desc),
+    m_sack (sack),
+    m_toDrop (toDrop),
+    m_highestTx (0),
+    m_sackOptions (0),
+    m_rtoExpired (0)
+{
+}
+
+void
+TcpSackTest::ConfigureEnvironment ()
+{
+  TcpGeneralTest::ConfigureEnvironment ();
+  SetAppPktCount (100);
+  SetPropagationDelay (MilliSeconds (50));
+  SetTransmitStart (Seconds (2.0));
+}
+
+Ptr<ErrorModel>
+TcpSackTest::CreateReceiverErrorModel ()
+{
+  Ptr<TcpSeqErrorModel> errorModel = CreateObject<TcpSeqErrorModel> ();
+  for (std::vector<uint32_t>::iterator it = m_toDrop.begin (); it != m_toDrop.end (); ++it)
+    {
+      errorModel->AddSeqToKill (SequenceNumber32 (*it));
+    }
+  return errorModel;
+}
+
+Ptr<TcpSocketMsgBase>
+TcpSackTest::CreateReceiverSocket (Ptr<Node> node)
+{
+  Ptr<TcpSocketMsgBase> socket = TcpGeneralTest::CreateReceiverSocket (node);
+  socket->SetAttribute ("Sack", BooleanValue (m_sack));
+  return socket;
+}
+
+Ptr<TcpSocketMsgBase>
+TcpSackTest::CreateSenderSocket (Ptr<Node> node)
+{
+  Ptr<TcpSocketMsgBase> socket = TcpGeneralTest::CreateSenderSocket (node);
+  socket->SetAttribute ("Sack", BooleanValue (m_sack));
+  return socket;
+}
+
+void
+TcpSackTest::Tx (const Ptr<const Packet> p, const TcpHeader &h, SocketWho who)
+{
+  if (who == RECEIVER)
+    {
+      if (h.HasOption (TcpOption::SACK))
+        {
+          NS_TEST_ASSERT_MSG_EQ (m_sack, true, "SACK option sent while disabled");
+          m_sackOptions++;
+        }
+    }
+  else if (p->GetSize () > 0)
+    {
+      NS_TEST_ASSERT_MSG_EQ (h.HasOption (TcpOption::SACK), false, "SACK option sent with data");
+      if (h.GetSequenceNumber () < m_highestTx)
+        {
+          NS_LOG_DEBUG ("Retransmission of " << h.GetSequenceNumber ());
+          m_retransmitted[h.GetSequenceNumber ().GetValue ()]++;
+        }
+      else
+        {
+          m_highestTx = h.GetSequenceNumber ();
+        }
+    }
+}
+
+void
+TcpSackTest::RTOExpired (const Ptr<const TcpSocketState> tcb, SocketWho who)
+{
+  if (who == SENDER)
+    {
+      m_rtoExpired++;
+    }
+}
+
+void
+TcpSackTest::FinalChecks ()
+{
+  NS_TEST_ASSERT_MSG_EQ (GetRxBuffer (RECEIVER)->NextRxSequence (),
+                         SequenceNumber32 (1 + GetPktCount () * GetPktSize () + 1),
+                         "Transfer not completed");
+  if (!m_sack)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_sackOptions, 0, "SACK options seen while disabled");
+      return;
+    }
+
+  NS_TEST_ASSERT_MSG_GT (m_sackOptions, 0, "No SACK option seen");
+  NS_TEST_ASSERT_MSG_EQ (m_rtoExpired, 0, "RTO expired, the holes were not recovered");
+  NS_TEST_ASSERT_MSG_EQ (m_retransmitted.size (), m_toDrop.size (), "Data not lost retransmitted");
+  for (std::vector<uint32_t>::iterator it = m_toDrop.begin (); it != m_toDrop.end (); ++it)
+    {
+      NS_TEST_ASSERT_MSG_EQ (m_retransmitted[*it], 1, "Segment " << *it << " not retransmitted once");
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP SACK TestSuite
+ */
+static class TcpSackTestSuite : public TestSuite
+{
+public:
+  TcpSackTestSuite () : TestSuite ("tcp-sack-test", UNIT)
+  {
+    std::vector<uint32_t> toDrop;
+    toDrop.push_back (5001);
+    AddTestCase (new TcpSackTest ("SACK, one drop", true, toDrop), TestCase::QUICK);
+    toDrop.push_back (6001);
+    toDrop.push_back (7001);
+    AddTestCase (new TcpSackTest ("SACK, three drops in a window", true, toDrop), TestCase::QUICK);
+    toDrop.push_back (7501);
+    AddTestCase (new TcpSackTest ("SACK, four drops in a window", true, toDrop), TestCase::QUICK);
+    AddTestCase (new TcpSackTest ("No SACK, four drops in a window", false, toDrop), TestCase::QUICK);
+  }
+} g_tcpSackTestSuite;
+
+} // namespace ns3
@@ -0,0 +1,288 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/tcp-tx-buffer.h"
+#include "ns3/log.h"
+
+#include <vector>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TcpTxBufferTestSuite");
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the data extracted from a TcpTxBuffer against the bytes
+ * written by the application, while the buffer is sent and acknowledged
+ * in pieces which do not match the written packets.
+ */
+class TcpTxBufferTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   * \param firstSeq Sequence number of the first byte
+   * \param name Test description
+   */
+  TcpTxBufferTestCase (uint32_t firstSeq, const std::string &name);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Write one packet of the stream into the buffer
+   * \param size Size of the packet
+   * \returns the value returned by TcpTxBuffer::Add
+   */
+  bool Write (uint32_t size);
+
+  /**
+   * \brief Check a segment extracted from the buffer
+   * \param seq Sequence number of the segment
+   * \param size Size asked for
+   * \param expectedSize Size expected
+   */
+  void CheckSegment (SequenceNumber32 seq, uint32_t size, uint32_t expectedSize);
+
+  Ptr<TcpTxBuffer> m_buffer;    //!< Buffer under test
+  SequenceNumber32 m_firstSeq;  //!< Sequence number of the first byte of the stream
+  uint32_t m_written;           //!< Number of bytes written
+};
+
+TcpTxBufferTestCase::TcpTxBufferTestCase (uint32_t firstSeq, const std::string &name)
+  : TestCase (name),
+    m_firstSeq (firstSeq),
+    m_written (0)
+{
+}
+
+bool
+TcpTxBufferTestCase::Write (uint32_t size)
+{
+  std::vector<uint8_t> data (size);
+  for (uint32_t i = 0; i < size; ++i)
+    {
+      data[i] = static_cast<uint8_t> ((m_written + i) % 251);
+    }
+  bool added = m_buffer->Add (Create<Packet> (&data[0], size));
+  if (added)
+    {
+      m_written += size;
+    }
+  return added;
+}
+
+void
+TcpTxBufferTestCase::CheckSegment (SequenceNumber32 seq, uint32_t size, uint32_t expectedSize)
+{
+  Ptr<Packet> p = m_buffer->CopyFromSequence (size, seq);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), expectedSize, "Wrong size extracted at " << seq);
+  if (expectedSize == 0)
+    {
+      return;
+    }
+  std::vector<uint8_t> data (expectedSize);
+  p->CopyData (&data[0], expectedSize);
+  uint32_t offset = seq - m_firstSeq;
+  for (uint32_t i = 0; i < expectedSize; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (data[i]), (offset + i) % 251,
+                             "Wrong byte " << i << " extracted at " << seq);
+    }
+}
+
+void
+TcpTxBufferTestCase::DoRun (void)
+{
+  m_buffer = CreateObject<TcpTxBuffer> ();
+  m_buffer->SetHeadSequence (m_firstSeq);
+  m_buffer->SetMaxBufferSize (64000);
+
+  // More packets than the initial ring, of sizes unrelated to the segments
+  const uint32_t sizes[] = { 512, 1, 1000, 3000, 7 };
+  uint32_t k = 0;
+  while (m_written < 40000)
+    {
+      NS_TEST_ASSERT_MSG_EQ (Write (sizes[k++ % 5]), true, "Add failed with room left");
+    }
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->Size (), m_written, "Wrong buffer size");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->TailSequence (), m_firstSeq + m_written, "Wrong tail");
+  NS_TEST_ASSERT_MSG_EQ (Write (30000), false, "Add beyond the buffer size succeeded");
+
+  // Send everything in order, then retransmit from the middle
+  SequenceNumber32 seq = m_firstSeq;
+  while (seq < m_buffer->TailSequence ())
+    {
+      uint32_t expected = std::min (1448u, m_buffer->SizeFromSequence (seq));
+      CheckSegment (seq, 1448, expected);
+      seq += expected;
+    }
+  CheckSegment (m_firstSeq + 20000, 1448, 1448);
+  CheckSegment (m_firstSeq + 513, 1, 1);
+  CheckSegment (m_firstSeq + m_written - 10, 1448, 10);
+  CheckSegment (m_firstSeq + m_written, 1448, 0);
+
+  // Acknowledge in the middle of a packet, and across the next ones
+  m_buffer->DiscardUpTo (m_firstSeq + 100);
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->HeadSequence (), m_firstSeq + 100, "Wrong head");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->Size (), m_written - 100, "Wrong size after a partial ACK");
+  CheckSegment (m_firstSeq + 100, 1448, 1448);
+  m_buffer->DiscardUpTo (m_firstSeq + 5000);
+  CheckSegment (m_firstSeq + 5000, 536, 536);
+  CheckSegment (m_firstSeq + 30000, 3000, 3000);
+
+  // The freed room takes more packets, which wrap around the ring
+  while (m_buffer->Available () >= 3000)
+    {
+      NS_TEST_ASSERT_MSG_EQ (Write (sizes[k++ % 5]), true, "Add failed with room left");
+    }
+  seq = m_buffer->HeadSequence ();
+  while (seq < m_buffer->TailSequence ())
+    {
+      uint32_t expected = std::min (536u, m_buffer->SizeFromSequence (seq));
+      CheckSegment (seq, 536, expected);
+      seq += expected;
+    }
+
+  // Acknowledge everything, then the FIN
+  m_buffer->DiscardUpTo (m_buffer->TailSequence ());
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->Size (), 0, "Data left after the last ACK");
+  m_buffer->DiscardUpTo (m_firstSeq + m_written + 1);
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->HeadSequence (), m_firstSeq + m_written + 1, "FIN not acknowledged");
+  NS_TEST_ASSERT_MSG_EQ (Write (100), true, "Add failed on an empty buffer");
+  m_firstSeq += 1;
+  CheckSegment (m_buffer->HeadSequence (), 1448, 100);
+  m_buffer = 0;
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the SACK scoreboard of a TcpTxBuffer: merged blocks,
+ * holes, and the ranges forgotten when the data is acknowledged.
+ */
+class TcpTxBufferSackTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   * \param firstSeq Sequence number of the first byte
+   * \param name Test description
+   */
+  TcpTxBufferSackTestCase (uint32_t firstSeq, const std::string &name);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief SACK a block of the buffer
+   * \param head Offset of the first byte of the block
+   * \param tail Offset of the byte following the block
+   * \returns the number of bytes newly SACKed
+   */
+  uint32_t Sack (uint32_t head, uint32_t tail);
+
+  Ptr<TcpTxBuffer> m_buffer;    //!< Buffer under test
+  SequenceNumber32 m_firstSeq;  //!< Sequence number of the first byte of the stream
+};
+
+TcpTxBufferSackTestCase::TcpTxBufferSackTestCase (uint32_t firstSeq, const std::string &name)
+  : TestCase (name),
+    m_firstSeq (firstSeq)
+{
+}
+
+uint32_t
+TcpTxBufferSackTestCase::Sack (uint32_t head, uint32_t tail)
+{
+  TcpTxBuffer::SackList list;
+  list.push_back (TcpTxBuffer::SackBlock (m_firstSeq + head, m_firstSeq + tail));
+  return m_buffer->Sack (list, m_firstSeq + 10000);
+}
+
+void
+TcpTxBufferSackTestCase::DoRun (void)
+{
+  m_buffer = CreateObject<TcpTxBuffer> ();
+  m_buffer->SetHeadSequence (m_firstSeq);
+  m_buffer->SetMaxBufferSize (64000);
+  m_buffer->Add (Create<Packet> (20000));
+
+  SequenceNumber32 head;
+  SequenceNumber32 tail;
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->FindHole (m_firstSeq, head, tail), false, "Hole without SACK");
+
+  NS_TEST_ASSERT_MSG_EQ (Sack (2000, 3000), 1000, "Wrong bytes SACKed");
+  NS_TEST_ASSERT_MSG_EQ (Sack (5000, 6000), 1000, "Wrong bytes SACKed");
+  NS_TEST_ASSERT_MSG_EQ (Sack (2500, 3000), 0, "Data SACKed twice");
+  NS_TEST_ASSERT_MSG_EQ (Sack (9000, 12000), 1000, "Data not sent SACKed");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->GetSackedBytes (), 3000, "Wrong SACKed bytes");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->GetSackedBytesFrom (m_firstSeq + 5500), 1500, "Wrong SACKed bytes above");
+
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->FindHole (m_firstSeq, head, tail), true, "Hole not found");
+  NS_TEST_ASSERT_MSG_EQ (head, m_firstSeq, "Wrong head of the first hole");
+  NS_TEST_ASSERT_MSG_EQ (tail, m_firstSeq + 2000, "Wrong tail of the first hole");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->FindHole (m_firstSeq + 2500, head, tail), true, "Hole not found");
+  NS_TEST_ASSERT_MSG_EQ (head, m_firstSeq + 3000, "Wrong head of the second hole");
+  NS_TEST_ASSERT_MSG_EQ (tail, m_firstSeq + 5000, "Wrong tail of the second hole");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->FindHole (m_firstSeq + 9000, head, tail), false, "Hole beyond the SACKed data");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->SkipSacked (m_firstSeq + 5200), m_firstSeq + 6000, "SACKed data not skipped");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->SkipSacked (m_firstSeq + 4000), m_firstSeq + 4000, "Data not SACKed skipped");
+
+  // A block filling a hole merges the blocks around it
+  NS_TEST_ASSERT_MSG_EQ (Sack (3000, 5000), 2000, "Wrong bytes SACKed");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->SkipSacked (m_firstSeq + 2000), m_firstSeq + 6000, "Blocks not merged");
+
+  // An ACK in the middle of a block forgets the SACKed bytes behind it
+  m_buffer->DiscardUpTo (m_firstSeq + 4000);
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->GetSackedBytes (), 3000, "Wrong SACKed bytes after an ACK");
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->FindHole (m_firstSeq, head, tail), true, "Hole not found");
+  NS_TEST_ASSERT_MSG_EQ (head, m_firstSeq + 6000, "Wrong head of the hole after an ACK");
+  NS_TEST_ASSERT_MSG_EQ (Sack (0, 4500), 0, "Acknowledged data SACKed");
+  m_buffer->DiscardUpTo (m_firstSeq + 10000);
+  NS_TEST_ASSERT_MSG_EQ (m_buffer->GetSackedBytes (), 0, "SACKed bytes left after the last ACK");
+  m_buffer = 0;
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TcpTxBuffer TestSuite
+ */
+class TcpTxBufferTestSuite : public TestSuite
+{
+public:
+  TcpTxBufferTestSuite () : TestSuite ("tcp-tx-buffer", UNIT)
+  {
+    AddTestCase (new TcpTxBufferTestCase (1, "Extract and discard data"), TestCase::QUICK);
+    AddTestCase (new TcpTxBufferTestCase (0xffffff00, "Extract and discard data across a sequence wrap"),
+                 TestCase::QUICK);
+    AddTestCase (new TcpTxBufferSackTestCase (1, "SACK scoreboard"), TestCase::QUICK);
+    AddTestCase (new TcpTxBufferSackTestCase (0xfffff000, "SACK scoreboard across a sequence wrap"),
+                 TestCase::QUICK);
+  }
+};
+
+static TcpTxBufferTestSuite g_tcpTxBufferTestSuite; //!< Static variable for test initialization
+
+} // namespace ns3
@@ -0,0 +1,56 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_MTP_INTERFACE_H
+#define NS3_MTP_INTERFACE_H
+
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup mtp
+ * Declaration of class ns3::MtpInterface.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup mtp
+ *
+ * \brief Entry point of multithreaded simulation.
+ *
+ * Call Enable before the first use of the simulator:
+ * \code
+ *   MtpInterface::Enable (4);
+ *   // build the topology, then
+ *   Simulator::Run ();
+ * \endcode
+ */
+class MtpInterface
+{
+public:
+  /**
+   * Select ns3::MultithreadedSimulatorImpl as the simulator.
+   *
+   * \param [in] maxThreads The maximum number of threads, 0 for one
+   *             per hardware thread.
+   */
+  static void Enable (uint32_t maxThreads = 0);
+};
+
+} // namespace ns3
+
+#endif /* NS3_MTP_INTERFACE_H */
@@ -0,0 +1,780 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "multithreaded-simulator-impl.h"
+
+#include "ns3/simulator.h"
+#include "ns3/make-event.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+#include "ns3/assert.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/node-list.h"
+#include "ns3/topology-partition-helper.h"
+
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+/**
+ * \file
+ * \ingroup mtp
+ * Implementation of class ns3::MultithreadedSimulatorImpl.
+ */
+
+namespace ns3 {
+
+// Logging in this file is largely avoided: most functions run
+// concurrently in several threads.
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+namespace {
+
+/** Timestamp larger than any event. */
+const uint64_t INFINITE_TS = std::numeric_limits<uint64_t>::max ();
+
+/** Spins before a waiting thread starts yielding its core. */
+const uint32_t SPINS_BEFORE_YIELD = 1000;
+
+} // unnamed namespace
+
+/**
+ * \ingroup mtp
+ * The events and clock of one partition.
+ */
+class MultithreadedSimulatorImpl::LogicalProcess
+{
+public:
+  /** An event sent to another logical process. */
+  struct Message
+  {
+    uint64_t ts;        //!< Absolute timestamp.
+    uint32_t context;   //!< Context of the event.
+    EventImpl *event;   //!< The event.
+  };
+  /** The messages sent to one logical process during one window. */
+  struct Outbox
+  {
+    std::vector<Message> messages;  //!< Messages in sending order.
+    uint64_t minTs;                 //!< Smallest timestamp of messages.
+  };
+
+  /**
+   * Constructor.
+   * \param [in] sim The simulator.
+   * \param [in] index The index of this logical process.
+   */
+  LogicalProcess (MultithreadedSimulatorImpl *sim, uint32_t index)
+    : m_sim (sim),
+      m_index (index),
+      m_uid (4),
+      m_currentUid (0),
+      m_currentTs (0),
+      m_currentContext (Simulator::NO_CONTEXT),
+      m_unscheduledEvents (0)
+  {
+  }
+
+  /** Unref the pending events. */
+  ~LogicalProcess ()
+  {
+    for (uint32_t parity = 0; parity < 2; ++parity)
+      {
+        for (std::vector<Outbox>::iterator i = m_outbox[parity].begin ();
+             i != m_outbox[parity].end (); ++i)
+          {
+            for (std::vector<Message>::iterator j = i->messages.begin ();
+                 j != i->messages.end (); ++j)
+              {
+                j->event->Unref ();
+              }
+          }
+      }
+    if (m_events != 0)
+      {
+        while (!m_events->IsEmpty ())
+          {
+            m_events->RemoveNext ().impl->Unref ();
+          }
+      }
+  }
+
+  /**
+   * Insert an event.
+   * \param [in] ts The absolute timestamp.
+   * \param [in] context The context.
+   * \param [in] event The event.
+   * \return The inserted event.
+   */
+  Scheduler::Event Insert (uint64_t ts, uint32_t context, EventImpl *event)
+  {
+    NS_ASSERT (ts >= m_currentTs);
+    Scheduler::Event ev;
+    ev.impl = event;
+    ev.key.m_ts = ts;
+    ev.key.m_context = context;
+    ev.key.m_uid = m_uid;
+    m_uid++;
+    m_unscheduledEvents++;
+    m_events->Insert (ev);
+    return ev;
+  }
+
+  /**
+   * Queue an event for another logical process.
+   * \param [in] parity The parity of the current window.
+   * \param [in] dst The destination index.
+   * \param [in] message The event.
+   */
+  void Send (uint32_t parity, uint32_t dst, const Message &message)
+  {
+    Outbox &outbox = m_outbox[parity][dst];
+    outbox.messages.push_back (message);
+    outbox.minTs = std::min (outbox.minTs, message.ts);
+  }
+
+  /**
+   * Insert the events another logical process sent to this one.
+   * \param [in] src The sender.
+   * \param [in] parity The parity of the window the events were sent in.
+   */
+  void Receive (LogicalProcess *src, uint32_t parity)
+  {
+    Outbox &outbox = src->m_outbox[parity][m_index];
+    for (std::vector<Message>::const_iterator i = outbox.messages.begin ();
+         i != outbox.messages.end (); ++i)
+      {
+        Insert (i->ts, i->context, i->event);
+      }
+    outbox.messages.clear ();
+    outbox.minTs = INFINITE_TS;
+  }
+
+  /**
+   * \param [in] parity The parity of a window.
+   * \param [in] dst The destination index.
+   * \return The smallest timestamp sent to dst during the window.
+   */
+  uint64_t GetSentTs (uint32_t parity, uint32_t dst) const
+  {
+    return m_outbox[parity][dst].minTs;
+  }
+
+  /**
+   * Size the outboxes.
+   * \param [in] n The number of logical processes.
+   */
+  void SetPeers (uint32_t n)
+  {
+    Outbox empty;
+    empty.minTs = INFINITE_TS;
+    m_outbox[0].assign (n, empty);
+    m_outbox[1].assign (n, empty);
+  }
+
+  /** \return The timestamp of the next event, INFINITE_TS if none. */
+  uint64_t GetNextTs (void) const
+  {
+    return m_events->IsEmpty () ? INFINITE_TS : m_events->PeekNext ().key.m_ts;
+  }
+
+  /** Run the next event. */
+  void ProcessOneEvent (void)
+  {
+    Scheduler::Event next = m_events->RemoveNext ();
+
+    NS_ASSERT (next.key.m_ts >= m_currentTs);
+    m_unscheduledEvents--;
+    m_currentTs = next.key.m_ts;
+    m_currentContext = next.key.m_context;
+    m_currentUid = next.key.m_uid;
+    next.impl->Invoke ();
+    next.impl->Unref ();
+  }
+
+  /** Body of the thread running this logical process. */
+  void Work (void)
+  {
+    m_sim->Work (this);
+  }
+
+  MultithreadedSimulatorImpl *m_sim;  //!< The simulator.
+  uint32_t m_index;                   //!< Index in the simulator.
+  Ptr<Scheduler> m_events;            //!< The event list.
+  uint32_t m_uid;                     //!< Next event uid.
+  uint32_t m_currentUid;              //!< Uid of the current event.
+  uint64_t m_currentTs;               //!< Timestamp of the current event.
+  uint32_t m_currentContext;          //!< Context of the current event.
+  int m_unscheduledEvents;            //!< Number of events in m_events.
+  /** Outboxes indexed by window parity, then destination. */
+  std::vector<Outbox> m_outbox[2];
+};
+
+/** The logical process run by this thread, 0 for the global one. */
+static thread_local MultithreadedSimulatorImpl::LogicalProcess *g_current = 0;
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .SetGroupName ("Mtp")
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+    .AddAttribute ("MaxThreads",
+                   "The maximum number of partitions, each run by one thread, "
+                   "up to 256. 0 uses one thread per hardware thread.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MultithreadedSimulatorImpl::m_maxThreads),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+  : m_partitioned (false),
+    m_maxThreads (0),
+    m_lookahead (INFINITE_TS),
+    m_stop (false),
+    m_inWindow (false),
+    m_windowEnd (0),
+    m_round (0),
+    m_firstRound (0),
+    m_arrived (0),
+    m_exit (false)
+{
+  NS_LOG_FUNCTION (this);
+  m_lps.push_back (new LogicalProcess (this, 0));
+  m_lps[0]->SetPeers (1);
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (std::vector<LogicalProcess *>::iterator i = m_lps.begin (); i != m_lps.end (); ++i)
+    {
+      delete *i;
+    }
+  m_lps.clear ();
+  m_lpOfContext.clear ();
+  g_current = 0;
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  m_schedulerFactory = schedulerFactory;
+  for (std::vector<LogicalProcess *>::iterator i = m_lps.begin (); i != m_lps.end (); ++i)
+    {
+      Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+      if ((*i)->m_events != 0)
+        {
+          while (!(*i)->m_events->IsEmpty ())
+            {
+              scheduler->Insert ((*i)->m_events->RemoveNext ());
+            }
+        }
+      (*i)->m_events = scheduler;
+    }
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  // The global LP and partition 1 both run on the main thread, never at
+  // the same time, and share system id 0: with one partition the packet
+  // uids and random streams are those of the default simulator.
+  uint32_t index = GetCurrent ()->m_index;
+  return index > 0 ? index - 1 : 0;
+}
+
+MultithreadedSimulatorImpl::LogicalProcess *
+MultithreadedSimulatorImpl::GetLogicalProcess (uint32_t context) const
+{
+  if (context < m_lpOfContext.size ())
+    {
+      return m_lps[m_lpOfContext[context]];
+    }
+  return m_lps[0];
+}
+
+MultithreadedSimulatorImpl::LogicalProcess *
+MultithreadedSimulatorImpl::GetCurrent (void) const
+{
+  return g_current != 0 ? g_current : m_lps[0];
+}
+
+void
+MultithreadedSimulatorImpl::Partition (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_partitioned = true;
+
+  uint32_t maxThreads = m_maxThreads;
+  if (maxThreads == 0)
+    {
+      maxThreads = std::max (std::thread::hardware_concurrency (), 1u);
+    }
+  maxThreads = std::min (maxThreads, Simulator::MAX_SYSTEM_IDS);
+  uint32_t nNodes = NodeList::GetNNodes ();
+  uint32_t nParts = 0;
+  m_lookahead = INFINITE_TS;
+  if (nNodes > 0)
+    {
+      TopologyPartitionHelper partitioner;
+      partitioner.Partition (maxThreads);
+      nParts = partitioner.GetNPartitions ();
+      m_lpOfContext.resize (nNodes);
+      for (uint32_t i = 0; i < nNodes; ++i)
+        {
+          // number the partitions from 1, 0 is the global one.
+          m_lpOfContext[i] = partitioner.GetPartition (i) + 1;
+        }
+      if (partitioner.GetLookahead () != Time::Max ())
+        {
+          m_lookahead = partitioner.GetLookahead ().GetTimeStep ();
+        }
+    }
+
+  LogicalProcess *global = m_lps[0];
+  for (uint32_t i = 1; i <= nParts; ++i)
+    {
+      LogicalProcess *lp = new LogicalProcess (this, i);
+      lp->m_events = m_schedulerFactory.Create<Scheduler> ();
+      lp->m_uid = global->m_uid;
+      lp->m_currentUid = global->m_currentUid;
+      lp->m_currentTs = global->m_currentTs;
+      m_lps.push_back (lp);
+    }
+  for (std::vector<LogicalProcess *>::iterator i = m_lps.begin (); i != m_lps.end (); ++i)
+    {
+      (*i)->SetPeers (m_lps.size ());
+    }
+
+  // Hand the events scheduled so far to their partitions.
+  std::vector<Scheduler::Event> events;
+  while (!global->m_events->IsEmpty ())
+    {
+      events.push_back (global->m_events->RemoveNext ());
+    }
+  global->m_unscheduledEvents = 0;
+  for (std::vector<Scheduler::Event>::const_iterator i = events.begin (); i != events.end (); ++i)
+    {
+      LogicalProcess *lp = GetLogicalProcess (i->key.m_context);
+      lp->m_events->Insert (*i);
+      lp->m_unscheduledEvents++;
+    }
+
+  NS_LOG_INFO (nNodes << " nodes in " << nParts << " partitions, lookahead "
+                      << TimeStep (m_lookahead == INFINITE_TS ? 0 : m_lookahead));
+}
+
+void
+MultithreadedSimulatorImpl::ProcessWindow (LogicalProcess *lp, uint32_t round)
+{
+  g_current = lp;
+  for (std::vector<LogicalProcess *>::iterator i = m_lps.begin (); i != m_lps.end (); ++i)
+    {
+      lp->Receive (*i, (round - 1) & 1);
+    }
+  while (!m_stop.load (std::memory_order_relaxed) && lp->GetNextTs () < m_windowEnd)
+    {
+      lp->ProcessOneEvent ();
+    }
+  g_current = 0;
+}
+
+void
+MultithreadedSimulatorImpl::Work (LogicalProcess *lp)
+{
+  uint32_t seen = m_firstRound;
+  while (true)
+    {
+      for (uint32_t spins = 0; m_round.load () == seen; ++spins)
+        {
+          if (spins > SPINS_BEFORE_YIELD)
+            {
+              std::this_thread::yield ();
+            }
+        }
+      seen = m_round.load ();
+      if (m_exit.load ())
+        {
+          return;
+        }
+      ProcessWindow (lp, seen);
+      m_arrived.fetch_add (1);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_partitioned)
+    {
+      Partition ();
+    }
+  m_stop = false;
+  m_exit = false;
+
+  LogicalProcess *global = m_lps[0];
+  uint32_t nWorkers = m_lps.size () > 2 ? m_lps.size () - 2 : 0;
+  // the main thread may start the first window before a worker runs.
+  m_firstRound = m_round.load ();
+  for (uint32_t i = 0; i < nWorkers; ++i)
+    {
+      Ptr<SystemThread> thread = Create<SystemThread> (MakeCallback (&LogicalProcess::Work, m_lps[i + 2]));
+      m_threads.push_back (thread);
+    }
+  for (uint32_t i = 0; i < nWorkers; ++i)
+    {
+      m_threads[i]->Start ();
+    }
+
+  while (!m_stop)
+    {
+      uint32_t parity = m_round.load () & 1;
+      // the global logical process is run by this thread, so its
+      // events sent during the last window are inserted here.
+      for (std::vector<LogicalProcess *>::iterator i = m_lps.begin (); i != m_lps.end (); ++i)
+        {
+          global->Receive (*i, parity);
+        }
+
+      uint64_t next = global->GetNextTs ();
+      for (uint32_t i = 1; i < m_lps.size (); ++i)
+        {
+          next = std::min (next, m_lps[i]->GetNextTs ());
+          for (uint32_t j = 0; j < m_lps.size (); ++j)
+            {
+              next = std::min (next, m_lps[j]->GetSentTs (parity, i));
+            }
+        }
+      if (next == INFINITE_TS)
+        {
+          break;
+        }
+      if (global->GetNextTs () == next)
+        {
+          // every partition is done with the events before this one.
+          global->ProcessOneEvent ();
+          continue;
+        }
+
+      m_windowEnd = global->GetNextTs ();
+      if (m_lookahead < INFINITE_TS - next)
+        {
+          m_windowEnd = std::min (m_windowEnd, next + m_lookahead);
+        }
+      m_inWindow = true;
+      m_arrived = 0;
+      uint32_t round = m_round.fetch_add (1) + 1;
+      ProcessWindow (m_lps[1], round);
+      for (uint32_t spins = 0; m_arrived.load () != nWorkers; ++spins)
+        {
+          if (spins > SPINS_BEFORE_YIELD)
+            {
+              std::this_thread::yield ();
+            }
+        }
+      m_inWindow = false;
+    }
+
+  m_exit = true;
+  m_round.fetch_add (1);
+  for (std::vector<Ptr<SystemThread> >::iterator i = m_threads.begin (); i != m_threads.end (); ++i)
+    {
+      (*i)->Join ();
+    }
+  m_threads.clear ();
+
+  // keep the events still in flight, and leave the global clock at the
+  // most advanced partition for the code run after Simulator::Run.
+  for (uint32_t parity = 0; parity < 2; ++parity)
+    {
+      for (std::vector<LogicalProcess *>::iterator dst = m_lps.begin (); dst != m_lps.end (); ++dst)
+        {
+          for (std::vector<LogicalProcess *>::iterator src = m_lps.begin (); src != m_lps.end (); ++src)
+            {
+              (*dst)->Receive (*src, parity);
+            }
+        }
+    }
+  for (std::vector<LogicalProcess *>::iterator i = m_lps.begin (); i != m_lps.end (); ++i)
+    {
+      global->m_currentTs = std::max (global->m_currentTs, (*i)->m_currentTs);
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  if (m_stop)
+    {
+      return true;
+    }
+  for (std::vector<LogicalProcess *>::const_iterator i = m_lps.begin (); i != m_lps.end (); ++i)
+    {
+      if (!(*i)->m_events->IsEmpty ())
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_stop = true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &delay)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep ());
+  // in the global logical process, where every partition stops at once.
+  ScheduleWithContext (Simulator::NO_CONTEXT, delay, MakeEvent (&Simulator::Stop));
+}
+
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &delay, EventImpl *event)
+{
+  LogicalProcess *lp = GetCurrent ();
+  Time tAbsolute = delay + TimeStep (lp->m_currentTs);
+
+  NS_ASSERT (tAbsolute.IsPositive ());
+  Scheduler::Event ev = lp->Insert ((uint64_t) tAbsolute.GetTimeStep (), lp->m_currentContext, event);
+  return EventId (event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event)
+{
+  LogicalProcess *lp = GetCurrent ();
+  LogicalProcess *dst = GetLogicalProcess (context);
+  uint64_t ts = lp->m_currentTs + delay.GetTimeStep ();
+
+  if (dst == lp || !m_inWindow)
+    {
+      dst->Insert (ts, context, event);
+      return;
+    }
+  NS_ABORT_MSG_IF (ts < m_windowEnd,
+                   "Event for context " << context << " scheduled " << delay
+                   << " ahead, less than the lookahead " << TimeStep (m_lookahead)
+                   << " of the partitions");
+  LogicalProcess::Message message = { ts, context, event };
+  lp->Send (m_round.load (std::memory_order_relaxed) & 1, dst->m_index, message);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  return Schedule (TimeStep (0), event);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  EventId id (Ptr<EventImpl> (event, false), GetCurrent ()->m_currentTs, 0xffffffff, 2);
+  m_destroyEvents.push_back (id);
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  // Do not add function logging here, to avoid stack overflow
+  return TimeStep (GetCurrent ()->m_currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs () - GetCurrent ()->m_currentTs);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  LogicalProcess *lp = GetLogicalProcess (id.GetContext ());
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  lp->m_events->Remove (event);
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+
+  lp->m_unscheduledEvents--;
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (IsExpired (id))
+    {
+      return;
+    }
+  if (id.GetUid () == 2)
+    {
+      id.PeekEventImpl ()->Cancel ();
+      return;
+    }
+  // a cancelled event left in the list would keep its partition from
+  // finishing early, so it is always removed.
+  Remove (id);
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &id) const
+{
+  if (id.GetUid () == 2)
+    {
+      if (id.PeekEventImpl () == 0
+          || id.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  LogicalProcess *lp = GetLogicalProcess (id.GetContext ());
+  if (id.PeekEventImpl () == 0
+      || id.GetTs () < lp->m_currentTs
+      || (id.GetTs () == lp->m_currentTs
+          && id.GetUid () <= lp->m_currentUid)
+      || id.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetLiveEventCount (void) const
+{
+  uint32_t count = 0;
+  for (std::vector<LogicalProcess *>::const_iterator i = m_lps.begin (); i != m_lps.end (); ++i)
+    {
+      count += (*i)->m_unscheduledEvents;
+    }
+  return count;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetCancelledEventCount (void) const
+{
+  // cancelled events are always removed.
+  return 0;
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return TimeStep (0x7fffffffffffffffLL);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  return GetCurrent ()->m_currentContext;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartitionCount (void) const
+{
+  return m_lps.size () - 1;
+}
+
+Time
+MultithreadedSimulatorImpl::GetLookahead (void) const
+{
+  return TimeStep (m_lookahead == INFINITE_TS ? 0x7fffffffffffffffLL : m_lookahead);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartition (uint32_t nodeId) const
+{
+  return nodeId < m_lpOfContext.size () ? m_lpOfContext[nodeId] : 0;
+}
+
+} // namespace ns3
@@ -0,0 +1,182 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_MULTITHREADED_SIMULATOR_IMPL_H
+#define NS3_MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "ns3/simulator-impl.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/object-factory.h"
+#include "ns3/system-thread.h"
+#include "ns3/ptr.h"
+
+#include <atomic>
+#include <list>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup mtp
+ * Declaration of class ns3::MultithreadedSimulatorImpl.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup mtp
+ *
+ * \brief Shared-memory conservative parallel simulator.
+ *
+ * At the first call to Run the topology is split into partitions
+ * (logical processes) along PointToPointChannel links with a non-zero
+ * delay, by a TopologyPartitionHelper.  Every partition owns the
+ * events of its nodes and is run by one thread; partitions exchange
+ * events through per-pair outboxes which need no lock.  Threads advance in windows of one lookahead,
+ * the smallest delay of a cut link, so that no event sent during a
+ * window can fall inside it.
+ *
+ * Events without a node context (Simulator::Stop, statistics probes,
+ * events of nodes created after partitioning) live in a global logical
+ * process which is run by the main thread while every partition is
+ * stopped at its timestamp.
+ *
+ * The model code of the nodes may run concurrently, so shared objects
+ * such as a FlowMonitor or a trace sink connected to several nodes
+ * must not be used with more than one thread.  The core and network
+ * modules are only thread-safe when built with --enable-mtp.
+ *
+ * Each partition but the first has its own system id, under which it
+ * numbers its packet uids and automatic random streams, so that a run
+ * does not depend on how the threads interleave.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  MultithreadedSimulatorImpl ();
+  /** Destructor. */
+  ~MultithreadedSimulatorImpl ();
+
+  // virtual from SimulatorImpl
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (const Time &delay);
+  virtual EventId Schedule (const Time &delay, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, const Time &delay, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &id);
+  virtual void Cancel (const EventId &id);
+  virtual bool IsExpired (const EventId &id) const;
+  virtual uint32_t GetLiveEventCount (void) const;
+  virtual uint32_t GetCancelledEventCount (void) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+  /**
+   * \return The number of partitions, zero before the first Run.
+   */
+  uint32_t GetPartitionCount (void) const;
+  /**
+   * \return The synchronization window, infinite when no link is cut.
+   */
+  Time GetLookahead (void) const;
+  /**
+   * \param [in] nodeId The node id.
+   * \return The partition running the node, starting from 1,
+   *         or 0 if the node runs in the global logical process.
+   */
+  uint32_t GetPartition (uint32_t nodeId) const;
+
+  /** The events and clock of one partition. */
+  class LogicalProcess;
+
+private:
+  virtual void DoDispose (void);
+
+  /** Split the nodes into partitions and move their events. */
+  void Partition (void);
+  /**
+   * \param [in] context The context of an event.
+   * \return The logical process owning the events of this context.
+   */
+  LogicalProcess * GetLogicalProcess (uint32_t context) const;
+  /** \return The logical process of the calling thread. */
+  LogicalProcess * GetCurrent (void) const;
+  /**
+   * Body of the worker threads.
+   * \param [in] lp The logical process run by this thread.
+   */
+  void Work (LogicalProcess *lp);
+  /**
+   * Process one window in a logical process.
+   * \param [in] lp The logical process.
+   * \param [in] round The window number.
+   */
+  void ProcessWindow (LogicalProcess *lp, uint32_t round);
+
+  /** The logical processes, the global one first. */
+  std::vector<LogicalProcess *> m_lps;
+  /** The partition of each node id. */
+  std::vector<uint32_t> m_lpOfContext;
+  /** Whether Partition has run. */
+  bool m_partitioned;
+  /** Factory of the per logical process schedulers. */
+  ObjectFactory m_schedulerFactory;
+
+  /** Container type for the destroy events. */
+  typedef std::list<EventId> DestroyEvents;
+  /** The container of events to run at Destroy. */
+  DestroyEvents m_destroyEvents;
+
+  /** Maximum number of partitions and threads, 0 for one per core. */
+  uint32_t m_maxThreads;
+  /** The lookahead, in time steps. */
+  uint64_t m_lookahead;
+  /** Flag calling for the end of the simulation. */
+  std::atomic<bool> m_stop;
+  /** Set while partitions run concurrently. */
+  bool m_inWindow;
+  /** Exclusive end of the current window, in time steps. */
+  uint64_t m_windowEnd;
+  /** Window counter, bumped by the main thread to start a window. */
+  std::atomic<uint32_t> m_round;
+  /** Value of m_round when the worker threads of this Run start. */
+  uint32_t m_firstRound;
+  /** Number of worker threads done with the current window. */
+  std::atomic<uint32_t> m_arrived;
+  /** Set to make the worker threads return. */
+  std::atomic<bool> m_exit;
+  /** The worker threads, running partitions 2 and up. */
+  std::vector<Ptr<SystemThread> > m_threads;
+};
+
+} // namespace ns3
+
+#endif /* NS3_MULTITHREADED_SIMULATOR_IMPL_H */
@@ -0,0 +1,344 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/global-value.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/mtp-interface.h"
+
+#include <map>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup mtp
+ * \defgroup mtp-tests Multithreaded simulation tests
+ */
+
+/**
+ * \ingroup mtp-tests
+ *
+ * \brief Send packets both ways along a chain of point-to-point links,
+ * forwarded hop by hop by the receive callbacks, and check that the
+ * multithreaded simulator delivers each of them at the same time as
+ * the default one, and that two multithreaded runs number the packets
+ * alike.
+ */
+class MtpChainTestCase : public TestCase
+{
+public:
+  MtpChainTestCase ();
+  virtual ~MtpChainTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /** Number of nodes in the chain. */
+  static const uint32_t N_NODES = 8;
+  /** Number of packets sent by each end. */
+  static const uint32_t N_PACKETS = 50;
+
+  /**
+   * Build the chain, run it and record the receptions.
+   * \param [in] threads Number of threads, 0 to use the default simulator.
+   * \return The reception times, in time steps, of each node.
+   */
+  std::vector<std::vector<int64_t> > RunChain (uint32_t threads);
+  /**
+   * Make the uids received comparable across runs: the counters of the
+   * systems are not reset between runs, so the uids of each system are
+   * counted from the smallest one received.
+   * \return The uids received, per node.
+   */
+  std::vector<std::vector<uint64_t> > GetRelativeUids (void) const;
+  /**
+   * Send one packet.
+   * \param [in] device The device to send on.
+   */
+  void Send (Ptr<NetDevice> device);
+  /**
+   * Record a packet and forward it to the next hop.
+   * \param [in] device The receiving device.
+   * \param [in] packet The packet.
+   * \param [in] protocol The protocol number.
+   * \param [in] from The sender address.
+   * \return true
+   */
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                uint16_t protocol, const Address &from);
+
+  /** The device to the previous node, per node. */
+  std::vector<Ptr<NetDevice> > m_left;
+  /** The device to the next node, per node. */
+  std::vector<Ptr<NetDevice> > m_right;
+  /** The reception times, per node; each is written by its node only. */
+  std::vector<std::vector<int64_t> > m_received;
+  /** The uids of the packets received, per node. */
+  std::vector<std::vector<uint64_t> > m_uids;
+};
+
+MtpChainTestCase::MtpChainTestCase ()
+  : TestCase ("Check that a multithreaded run of a chain matches a sequential one")
+{
+}
+
+MtpChainTestCase::~MtpChainTestCase ()
+{
+}
+
+void
+MtpChainTestCase::Send (Ptr<NetDevice> device)
+{
+  device->Send (Create<Packet> (1000), device->GetBroadcast (), 0x800);
+}
+
+bool
+MtpChainTestCase::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet,
+                           uint16_t protocol, const Address &from)
+{
+  uint32_t id = device->GetNode ()->GetId ();
+  m_received[id].push_back (Simulator::Now ().GetTimeStep ());
+  m_uids[id].push_back (packet->GetUid ());
+  Ptr<NetDevice> next = device == m_left[id] ? m_right[id] : m_left[id];
+  if (next != 0)
+    {
+      next->Send (packet->Copy (), next->GetBroadcast (), 0x800);
+    }
+  return true;
+}
+
+std::vector<std::vector<int64_t> >
+MtpChainTestCase::RunChain (uint32_t threads)
+{
+  if (threads > 0)
+    {
+      MtpInterface::Enable (threads);
+    }
+  else
+    {
+      GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+    }
+
+  NodeContainer nodes;
+  nodes.Create (N_NODES);
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+  p2p.SetChannelAttribute ("Delay", StringValue ("1ms"));
+
+  m_left.assign (N_NODES, 0);
+  m_right.assign (N_NODES, 0);
+  m_received.assign (N_NODES, std::vector<int64_t> ());
+  m_uids.assign (N_NODES, std::vector<uint64_t> ());
+  for (uint32_t i = 0; i + 1 < N_NODES; ++i)
+    {
+      NetDeviceContainer devices = p2p.Install (nodes.Get (i), nodes.Get (i + 1));
+      m_right[i] = devices.Get (0);
+      m_left[i + 1] = devices.Get (1);
+    }
+  for (uint32_t i = 0; i < N_NODES; ++i)
+    {
+      for (uint32_t j = 0; j < nodes.Get (i)->GetNDevices (); ++j)
+        {
+          nodes.Get (i)->GetDevice (j)->SetReceiveCallback (MakeCallback (&MtpChainTestCase::Receive, this));
+        }
+    }
+
+  // packets leave faster than the links drain, so the queues fill.
+  for (uint32_t k = 0; k < N_PACKETS; ++k)
+    {
+      Simulator::ScheduleWithContext (0, MicroSeconds (500 * k),
+                                      &MtpChainTestCase::Send, this, m_right[0]);
+      Simulator::ScheduleWithContext (N_NODES - 1, MicroSeconds (300 + 700 * k),
+                                      &MtpChainTestCase::Send, this, m_left[N_NODES - 1]);
+    }
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+
+  if (threads > 0)
+    {
+      Ptr<MultithreadedSimulatorImpl> impl =
+        DynamicCast<MultithreadedSimulatorImpl> (Simulator::GetImplementation ());
+      NS_TEST_EXPECT_MSG_NE (impl, 0, "MtpInterface::Enable did not select the simulator");
+      NS_TEST_EXPECT_MSG_EQ (impl->GetPartitionCount (), threads, "Wrong number of partitions");
+      NS_TEST_EXPECT_MSG_EQ (impl->GetLookahead (), MilliSeconds (1), "Wrong lookahead");
+      uint32_t cuts = 0;
+      for (uint32_t i = 1; i < N_NODES; ++i)
+        {
+          cuts += impl->GetPartition (i) != impl->GetPartition (i - 1);
+        }
+      NS_TEST_EXPECT_MSG_EQ (cuts, threads - 1, "A chain should be cut in consecutive pieces");
+    }
+  Simulator::Destroy ();
+  m_left.clear ();
+  m_right.clear ();
+  return m_received;
+}
+
+std::vector<std::vector<uint64_t> >
+MtpChainTestCase::GetRelativeUids (void) const
+{
+  std::map<uint32_t, uint32_t> first;
+  for (uint32_t i = 0; i < N_NODES; ++i)
+    {
+      for (uint32_t j = 0; j < m_uids[i].size (); ++j)
+        {
+          uint32_t system = m_uids[i][j] >> 32;
+          uint32_t count = m_uids[i][j] & 0xffffffff;
+          if (first.find (system) == first.end () || count < first[system])
+            {
+              first[system] = count;
+            }
+        }
+    }
+  std::vector<std::vector<uint64_t> > uids = m_uids;
+  for (uint32_t i = 0; i < N_NODES; ++i)
+    {
+      for (uint32_t j = 0; j < uids[i].size (); ++j)
+        {
+          uids[i][j] -= first[uids[i][j] >> 32];
+        }
+    }
+  return uids;
+}
+
+void
+MtpChainTestCase::DoRun (void)
+{
+  std::vector<std::vector<int64_t> > expected = RunChain (0);
+  std::vector<std::vector<int64_t> > actual = RunChain (4);
+  std::vector<std::vector<uint64_t> > uids = GetRelativeUids ();
+  RunChain (4);
+  std::vector<std::vector<uint64_t> > again = GetRelativeUids ();
+  GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+  Config::Reset ();
+
+  NS_TEST_ASSERT_MSG_EQ (expected[N_NODES - 1].size (), N_PACKETS, "Packets lost in the chain");
+  for (uint32_t i = 0; i < N_NODES; ++i)
+    {
+      NS_TEST_ASSERT_MSG_EQ (actual[i].size (), expected[i].size (),
+                             "Node " << i << " received another number of packets");
+      for (uint32_t j = 0; j < expected[i].size (); ++j)
+        {
+          NS_TEST_EXPECT_MSG_EQ (actual[i][j], expected[i][j],
+                                 "Node " << i << " received packet " << j << " at another time");
+        }
+      NS_TEST_ASSERT_MSG_EQ (again[i].size (), uids[i].size (),
+                             "Node " << i << " received another number of packets");
+      for (uint32_t j = 0; j < uids[i].size (); ++j)
+        {
+          NS_TEST_EXPECT_MSG_EQ (again[i][j], uids[i][j],
+                                 "Node " << i << " received packet " << j << " with another uid");
+        }
+    }
+  // the ends of the chain run in different partitions, so number their
+  // packets under different system ids
+  uint32_t leftSystem = uids[N_NODES - 1][0] >> 32;
+  uint32_t rightSystem = uids[0][0] >> 32;
+  NS_TEST_EXPECT_MSG_NE (leftSystem, rightSystem, "The partitions share a packet counter");
+}
+
+/**
+ * \ingroup mtp-tests
+ *
+ * \brief Check the ordering, cancellation and stop of events without
+ * a topology, where everything runs in the global logical process.
+ */
+class MtpEventsTestCase : public TestCase
+{
+public:
+  MtpEventsTestCase ();
+  virtual ~MtpEventsTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Record an event.
+   * \param [in] value The value to record.
+   */
+  void Record (int value);
+
+  /** The recorded values. */
+  std::vector<int> m_values;
+};
+
+MtpEventsTestCase::MtpEventsTestCase ()
+  : TestCase ("Check events of the multithreaded simulator without nodes")
+{
+}
+
+MtpEventsTestCase::~MtpEventsTestCase ()
+{
+}
+
+void
+MtpEventsTestCase::Record (int value)
+{
+  m_values.push_back (value);
+}
+
+void
+MtpEventsTestCase::DoRun (void)
+{
+  MtpInterface::Enable (2);
+  Simulator::Schedule (Seconds (2), &MtpEventsTestCase::Record, this, 2);
+  Simulator::Schedule (Seconds (1), &MtpEventsTestCase::Record, this, 1);
+  EventId cancelled = Simulator::Schedule (Seconds (1.5), &MtpEventsTestCase::Record, this, 0);
+  Simulator::Schedule (Seconds (4), &MtpEventsTestCase::Record, this, 4);
+  Simulator::Cancel (cancelled);
+  NS_TEST_EXPECT_MSG_EQ (Simulator::IsExpired (cancelled), true, "Cancelled event not expired");
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetLiveEventCount (), 3, "Cancelled event still counted");
+  Simulator::Stop (Seconds (3));
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_values.size (), 2, "Wrong number of events run");
+  NS_TEST_EXPECT_MSG_EQ (m_values[0], 1, "Events run out of order");
+  NS_TEST_EXPECT_MSG_EQ (m_values[1], 2, "Events run out of order");
+  NS_TEST_EXPECT_MSG_EQ (Simulator::Now (), Seconds (3), "Wrong stop time");
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetLiveEventCount (), 1, "Pending event lost");
+
+  Simulator::Destroy ();
+  GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+  Config::Reset ();
+}
+
+/**
+ * \ingroup mtp-tests
+ *
+ * \brief The multithreaded simulation TestSuite.
+ */
+class MtpTestSuite : public TestSuite
+{
+public:
+  MtpTestSuite ();
+};
+
+MtpTestSuite::MtpTestSuite ()
+  : TestSuite ("mtp", UNIT)
+{
+  AddTestCase (new MtpEventsTestCase, TestCase::QUICK);
+  AddTestCase (new MtpChainTestCase, TestCase::QUICK);
+}
+
+static MtpTestSuite g_mtpTestSuite; //!< Static variable for test initialization
@@ -20,6 +20,8 @@
 #include "buffer.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
+#include "ns3/system-mutex.h"
+#include <algorithm>
 
 #define LOG_INTERNAL_STATE(y)                                                                    \
   NS_LOG_LOGIC (y << "start="<<m_start<<", end="<<m_end<<", zero start="<<m_zeroAreaStart<<              \
@@ -50,7 +52,13 @@ namespace ns3 {
 NS_LOG_COMPONENT_DEFINE ("Buffer");
 
 
+#ifdef NS3_MTP
+thread_local uint32_t Buffer::g_recommendedStart = 0;
+thread_local uint32_t Buffer::g_recommendedEnd = 0;
+#else
 uint32_t Buffer::g_recommendedStart = 0;
+uint32_t Buffer::g_recommendedEnd = 0;
+#endif
 #ifdef BUFFER_FREE_LIST
 /* The following macros are pretty evil but they are needed to allow us to
  * keep track of 3 possible states for the g_freeList variable:
@@ -75,20 +83,256 @@ uint32_t Buffer::g_recommendedStart = 0;
 #define IS_INITIALIZED(x) (!IS_UNINITIALIZED (x) && !IS_DESTROYED (x))
 #define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
 #define UNINITIALIZED ((Buffer::FreeList*)0)
-uint32_t Buffer::g_maxSize = 0;
+/**
+ * \ingroup packet
+ * \brief A counter of a free list
+ *
+ * Only the thread owning the free list updates it, but GetFreeListStats
+ * reads it from any thread: with MTP, it is a relaxed atomic, whose
+ * loads and stores cost the same as plain ones.
+ */
+class FreeListCounter
+{
+public:
+  FreeListCounter ()
+    : m_value (0)
+  {
+  }
+  /**
+   * \param n the amount to add, by the owning thread only
+   */
+  void Add (int64_t n)
+  {
+#ifdef NS3_MTP
+    m_value.store (m_value.load (std::memory_order_relaxed) + n, std::memory_order_relaxed);
+#else
+    m_value += n;
+#endif
+  }
+  /**
+   * \brief Reset the counter, by the owning thread only
+   */
+  void Clear (void)
+  {
+#ifdef NS3_MTP
+    m_value.store (0, std::memory_order_relaxed);
+#else
+    m_value = 0;
+#endif
+  }
+  /**
+   * \returns the value of the counter
+   */
+  uint64_t Get (void) const
+  {
+#ifdef NS3_MTP
+    return m_value.load (std::memory_order_relaxed);
+#else
+    return m_value;
+#endif
+  }
+
+private:
+#ifdef NS3_MTP
+  std::atomic<uint64_t> m_value; //!< Value
+#else
+  uint64_t m_value; //!< Value
+#endif
+};
+
+/**
+ * \ingroup packet
+ * \brief The free lists of buffer data areas of one thread
+ *
+ * The data areas are allocated with a power-of-two size, from 64 bytes
+ * to 16 KiB, and kept in the free list of their size class when they
+ * are recycled, so that small areas (ACKs, headers) and large ones
+ * (segments created from real bytes, fragments) do not evict each
+ * other.  Larger areas are allocated with their exact size and never
+ * kept.
+ *
+ * Every FreeList is registered in a process-wide list, for
+ * Buffer::GetFreeListStats; the lists of the exited threads leave their
+ * counters there.
+ */
+class Buffer::FreeList
+{
+public:
+  /// Log2 of the smallest size class
+  static const uint32_t MIN_SHIFT = 6;
+  /// Number of size classes
+  static const uint32_t N_CLASSES = 9;
+
+  FreeList ();
+  /** Free the data areas and fold the counters into the registry. */
+  ~FreeList ();
+
+  /**
+   * \param size the size of a data area
+   * \returns the smallest size class holding \pname{size} bytes, or
+   *          N_CLASSES if \pname{size} is larger than every class
+   */
+  static inline uint32_t GetClass (uint32_t size);
+  /**
+   * \param sizeClass the size class
+   * \returns the size of the data areas of the class
+   */
+  static inline uint32_t GetClassSize (uint32_t sizeClass);
+
+  /**
+   * \param data the data area
+   * \returns true if \pname{data} was kept, false if it must be freed
+   */
+  inline bool Put (struct Buffer::Data *data);
+  /**
+   * \param sizeClass the size class
+   * \returns a data area of the class, or 0 if the free list is empty
+   */
+  inline struct Buffer::Data *Get (uint32_t sizeClass);
+  /**
+   * \param stats the statistics to add the counters of this list to
+   */
+  void AddStats (Buffer::FreeListStats &stats) const;
+
+  /// The free lists of all the threads
+  struct Registry
+  {
+    SystemMutex mutex;                  //!< Protects the members below
+    std::vector<FreeList *> lists;      //!< Lists of the running threads
+    Buffer::FreeListStats retired;      //!< Counters of the exited threads
+  };
+  /**
+   * \returns the registry, which is never destroyed, so that threads
+   *          may exit during the static destruction.
+   */
+  static Registry *GetRegistry (void);
+
+  static uint32_t g_maxBuffers; //!< Maximum number of data areas per class
+  static uint32_t g_maxBytes;   //!< Maximum number of bytes per thread
+
+  FreeListCounter m_hits;      //!< Data areas taken from a free list
+  FreeListCounter m_misses;    //!< Data areas allocated from the heap
+  FreeListCounter m_released;  //!< Data areas freed because a free list was full
+
+private:
+  std::vector<struct Buffer::Data *> m_free[N_CLASSES]; //!< Free lists
+  FreeListCounter m_retainedBuffers; //!< Data areas kept in the free lists
+  FreeListCounter m_retainedBytes;   //!< Bytes kept in the free lists
+};
+
+uint32_t Buffer::FreeList::g_maxBuffers = 1000;
+uint32_t Buffer::FreeList::g_maxBytes = 8 << 20;
+
+Buffer::FreeList::FreeList ()
+{
+  Registry *registry = GetRegistry ();
+  CriticalSection cs (registry->mutex);
+  registry->lists.push_back (this);
+}
+
+Buffer::FreeList::~FreeList ()
+{
+  for (uint32_t i = 0; i < N_CLASSES; i++)
+    {
+      for (std::vector<struct Buffer::Data *>::iterator it = m_free[i].begin ();
+           it != m_free[i].end (); it++)
+        {
+          Buffer::Deallocate (*it);
+        }
+      m_free[i].clear ();
+    }
+  m_retainedBuffers.Clear ();
+  m_retainedBytes.Clear ();
+  Registry *registry = GetRegistry ();
+  CriticalSection cs (registry->mutex);
+  AddStats (registry->retired);
+  registry->lists.erase (std::find (registry->lists.begin (), registry->lists.end (), this));
+}
+
+Buffer::FreeList::Registry *
+Buffer::FreeList::GetRegistry (void)
+{
+  static Registry *registry = new Registry ();
+  return registry;
+}
+
+uint32_t
+Buffer::FreeList::GetClass (uint32_t size)
+{
+  uint32_t sizeClass = 0;
+  while (sizeClass < N_CLASSES && size > GetClassSize (sizeClass))
+    {
+      sizeClass++;
+    }
+  return sizeClass;
+}
+
+uint32_t
+Buffer::FreeList::GetClassSize (uint32_t sizeClass)
+{
+  return 1U << (sizeClass + MIN_SHIFT);
+}
+
+bool
+Buffer::FreeList::Put (struct Buffer::Data *data)
+{
+  uint32_t sizeClass = GetClass (data->m_size);
+  if (sizeClass == N_CLASSES)
+    {
+      return false;
+    }
+  NS_ASSERT (data->m_size == GetClassSize (sizeClass));
+  if (m_free[sizeClass].size () >= g_maxBuffers
+      || m_retainedBytes.Get () + data->m_size > g_maxBytes)
+    {
+      m_released.Add (1);
+      return false;
+    }
+  m_free[sizeClass].push_back (data);
+  m_retainedBuffers.Add (1);
+  m_retainedBytes.Add (data->m_size);
+  return true;
+}
+
+struct Buffer::Data *
+Buffer::FreeList::Get (uint32_t sizeClass)
+{
+  if (m_free[sizeClass].empty ())
+    {
+      m_misses.Add (1);
+      return 0;
+    }
+  struct Buffer::Data *data = m_free[sizeClass].back ();
+  m_free[sizeClass].pop_back ();
+  m_retainedBuffers.Add (-1);
+  m_retainedBytes.Add (-static_cast<int64_t> (data->m_size));
+  m_hits.Add (1);
+  return data;
+}
+
+void
+Buffer::FreeList::AddStats (Buffer::FreeListStats &stats) const
+{
+  stats.hits += m_hits.Get ();
+  stats.misses += m_misses.Get ();
+  stats.released += m_released.Get ();
+  stats.retainedBuffers += m_retainedBuffers.Get ();
+  stats.retainedBytes += m_retainedBytes.Get ();
+}
+
+#ifdef NS3_MTP
+thread_local Buffer::FreeList *Buffer::g_freeList = 0;
+thread_local struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
+#else
 Buffer::FreeList *Buffer::g_freeList = 0;
 struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
+#endif
 
 Buffer::LocalStaticDestructor::~LocalStaticDestructor(void)
 {
   NS_LOG_FUNCTION (this);
   if (IS_INITIALIZED (g_freeList))
     {
-      for (Buffer::FreeList::iterator i = g_freeList->begin ();
-           i != g_freeList->end (); i++)
-        {
-          Buffer::Deallocate (*i);
-        }
       delete g_freeList;
       g_freeList = DESTROYED;
     }
@@ -99,19 +343,15 @@ Buffer::Recycle (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
-  NS_ASSERT (!IS_UNINITIALIZED (g_freeList));
-  g_maxSize = std::max (g_maxSize, data->m_size);
-  /* feed into free list */
-  if (data->m_size < g_maxSize ||
-      IS_DESTROYED (g_freeList) ||
-      g_freeList->size () > 1000)
+  if (IS_UNINITIALIZED (g_freeList))
     {
-      Buffer::Deallocate (data);
+      // with MTP, the last reference may be dropped by another thread
+      g_freeList = new Buffer::FreeList ();
     }
-  else
+  /* feed into free list */
+  if (IS_DESTROYED (g_freeList) || !g_freeList->Put (data))
     {
-      NS_ASSERT (IS_INITIALIZED (g_freeList));
-      g_freeList->push_back (data);
+      Buffer::Deallocate (data);
     }
 }
 
@@ -119,29 +359,59 @@ Buffer::Data *
 Buffer::Create (uint32_t dataSize)
 {
   NS_LOG_FUNCTION (dataSize);
-  /* try to find a buffer correctly sized. */
+  /* try to find a buffer of the right size class. */
   if (IS_UNINITIALIZED (g_freeList))
     {
       g_freeList = new Buffer::FreeList ();
     }
-  else if (IS_INITIALIZED (g_freeList))
+  uint32_t sizeClass = FreeList::GetClass (dataSize);
+  if (IS_INITIALIZED (g_freeList))
     {
-      while (!g_freeList->empty ()) 
+      if (sizeClass == FreeList::N_CLASSES)
         {
-          struct Buffer::Data *data = g_freeList->back ();
-          g_freeList->pop_back ();
-          if (data->m_size >= dataSize) 
+          g_freeList->m_misses.Add (1);
+        }
+      else
+        {
+          struct Buffer::Data *data = g_freeList->Get (sizeClass);
+          if (data != 0)
             {
               data->m_count = 1;
               return data;
             }
-          Buffer::Deallocate (data);
         }
     }
+  if (sizeClass < FreeList::N_CLASSES)
+    {
+      dataSize = FreeList::GetClassSize (sizeClass);
+    }
   struct Buffer::Data *data = Buffer::Allocate (dataSize);
   NS_ASSERT (data->m_count == 1);
   return data;
 }
+
+Buffer::FreeListStats
+Buffer::GetFreeListStats (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  FreeList::Registry *registry = FreeList::GetRegistry ();
+  CriticalSection cs (registry->mutex);
+  FreeListStats stats = registry->retired;
+  for (std::vector<FreeList *>::const_iterator it = registry->lists.begin ();
+       it != registry->lists.end (); it++)
+    {
+      (*it)->AddStats (stats);
+    }
+  return stats;
+}
+
+void
+Buffer::SetFreeListLimits (uint32_t maxBuffers, uint32_t maxBytes)
+{
+  NS_LOG_FUNCTION (maxBuffers << maxBytes);
+  FreeList::g_maxBuffers = maxBuffers;
+  FreeList::g_maxBytes = maxBytes;
+}
 #else /* BUFFER_FREE_LIST */
 void
 Buffer::Recycle (struct Buffer::Data *data)
@@ -157,8 +427,30 @@ Buffer::Create (uint32_t size)
   NS_LOG_FUNCTION (size);
   return Allocate (size);
 }
+
+Buffer::FreeListStats
+Buffer::GetFreeListStats (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  return FreeListStats ();
+}
+
+void
+Buffer::SetFreeListLimits (uint32_t maxBuffers, uint32_t maxBytes)
+{
+  NS_LOG_FUNCTION (maxBuffers << maxBytes);
+}
 #endif /* BUFFER_FREE_LIST */
 
+Buffer::FreeListStats::FreeListStats ()
+  : hits (0),
+    misses (0),
+    released (0),
+    retainedBuffers (0),
+    retainedBytes (0)
+{
+}
+
 struct Buffer::Data *
 Buffer::Allocate (uint32_t reqSize)
 {
@@ -244,7 +536,13 @@ void
 Buffer::Initialize (uint32_t zeroSize)
 {
   NS_LOG_FUNCTION (this << zeroSize);
-  m_data = Buffer::Create (0);
+  uint32_t size = g_recommendedStart + g_recommendedEnd;
+#ifdef BUFFER_FREE_LIST
+  // the hints are maxima over all the buffers: do not let a single large
+  // buffer make every new buffer too large to be recycled
+  size = std::min (size, FreeList::GetClassSize (FreeList::N_CLASSES - 1));
+#endif
+  m_data = Buffer::Create (size);
   m_start = std::min (m_data->m_size, g_recommendedStart);
   m_maxZeroAreaStart = m_start;
   m_zeroAreaStart = m_start;
@@ -262,8 +560,7 @@ Buffer::operator = (Buffer const&o)
   if (m_data != o.m_data) 
     {
       // not assignment to self.
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      if (--m_data->m_count == 0) 
         {
           Recycle (m_data);
         }
@@ -271,6 +568,7 @@ Buffer::operator = (Buffer const&o)
       m_data->m_count++;
     }
   g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
+  g_recommendedEnd = std::max (g_recommendedEnd, m_end - m_zeroAreaEnd);
   m_maxZeroAreaStart = o.m_maxZeroAreaStart;
   m_zeroAreaStart = o.m_zeroAreaStart;
   m_zeroAreaEnd = o.m_zeroAreaEnd;
@@ -285,8 +583,8 @@ Buffer::~Buffer ()
   NS_LOG_FUNCTION (this);
   NS_ASSERT (CheckInternalState ());
   g_recommendedStart = std::max (g_recommendedStart, m_maxZeroAreaStart);
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
+  g_recommendedEnd = std::max (g_recommendedEnd, m_end - m_zeroAreaEnd);
+  if (--m_data->m_count == 0) 
     {
       Recycle (m_data);
     }
@@ -310,7 +608,12 @@ Buffer::AddAtStart (uint32_t start)
 {
   NS_LOG_FUNCTION (this << start);
   NS_ASSERT (CheckInternalState ());
+#ifdef NS3_MTP
+  // a data area shared with another thread is never written in place
+  bool isDirty = m_data->m_count > 1;
+#else
   bool isDirty = m_data->m_count > 1 && m_start > m_data->m_dirtyStart;
+#endif
   if (m_start >= start && !isDirty)
     {
       /* enough space in the buffer and not dirty. 
@@ -328,8 +631,7 @@ Buffer::AddAtStart (uint32_t start)
       uint32_t newSize = GetInternalSize () + start;
       struct Buffer::Data *newData = Buffer::Create (newSize);
       memcpy (newData->m_data + start, m_data->m_data + m_start, GetInternalSize ());
-      m_data->m_count--;
-      if (m_data->m_count == 0)
+      if (--m_data->m_count == 0)
         {
           Buffer::Recycle (m_data);
         }
@@ -355,7 +657,11 @@ Buffer::AddAtEnd (uint32_t end)
 {
   NS_LOG_FUNCTION (this << end);
   NS_ASSERT (CheckInternalState ());
+#ifdef NS3_MTP
+  bool isDirty = m_data->m_count > 1;
+#else
   bool isDirty = m_data->m_count > 1 && m_end < m_data->m_dirtyEnd;
+#endif
   if (GetInternalEnd () + end <= m_data->m_size && !isDirty)
     {
       /* enough space in buffer and not dirty
@@ -373,8 +679,7 @@ Buffer::AddAtEnd (uint32_t end)
       uint32_t newSize = GetInternalSize () + end;
       struct Buffer::Data *newData = Buffer::Create (newSize);
       memcpy (newData->m_data, m_data->m_data + m_start, GetInternalSize ());
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      if (--m_data->m_count == 0) 
         {
           Buffer::Recycle (m_data);
         }
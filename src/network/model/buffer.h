@@ -23,6 +23,9 @@
 #include <stdint.h>
 #include <vector>
 #include <ostream>
+#ifdef NS3_MTP
+#include <atomic>
+#endif
 #include "ns3/assert.h"
 
 #define BUFFER_FREE_LIST 1
@@ -38,9 +41,11 @@ namespace ns3 {
  * automatically adjusted to hold any data prepended
  * or appended by the user. Its implementation is optimized
  * to ensure that the number of buffer resizes is minimized,
- * by creating new Buffers of the maximum size ever used.
- * The correct maximum size is learned at runtime during use by 
- * recording the maximum size of each packet.
+ * by creating new Buffers with room for the largest headers ever
+ * added.  This room is learned at runtime during use by recording
+ * the headers of each packet.  Unused data areas are kept in
+ * per-thread free lists, one per power-of-two size class, see
+ * SetFreeListLimits and GetFreeListStats.
  *
  * \internal
  * The implementation of the Buffer class uses a COW (Copy On Write)
@@ -610,6 +615,50 @@ private:
    */
   uint32_t CopyData (uint8_t *buffer, uint32_t size) const;
 
+  /**
+   * \brief Statistics of the free lists of buffer data areas
+   *
+   * The counters cover all the threads which created buffers, including
+   * the ones which already exited.
+   */
+  struct FreeListStats
+  {
+    FreeListStats ();
+    uint64_t hits;            //!< Data areas taken from a free list
+    uint64_t misses;          //!< Data areas allocated from the heap
+    uint64_t released;        //!< Data areas freed because their free list was full
+    uint64_t retainedBuffers; //!< Data areas kept in the free lists
+    uint64_t retainedBytes;   //!< Bytes kept in the free lists
+  };
+
+  /**
+   * \brief Get the statistics of the free lists
+   *
+   * With the multithreaded simulator, the counters of the other threads
+   * are read with relaxed atomic loads: they are safe to read at any
+   * time, but only add up to an exact snapshot when the simulator is not
+   * running.
+   *
+   * \returns the statistics summed over all the threads
+   */
+  static FreeListStats GetFreeListStats (void);
+
+  /**
+   * \brief Bound the memory kept by the free lists
+   *
+   * Each thread keeps the unused data areas in one free list per size
+   * class (powers of two from 64 bytes to 16 KiB).  A data area is freed
+   * instead of being kept when its free list holds \pname{maxBuffers}
+   * areas or when the free lists of the thread hold \pname{maxBytes}
+   * bytes.  The default is 1000 areas per size class and 8 MiB per
+   * thread.  The limits apply to all the threads; set them before
+   * starting the simulation.
+   *
+   * \param maxBuffers the maximum number of data areas per size class
+   * \param maxBytes the maximum number of bytes per thread
+   */
+  static void SetFreeListLimits (uint32_t maxBuffers, uint32_t maxBytes);
+
   /**
    * \brief Copy constructor
    * \param o the buffer to copy
@@ -662,7 +711,11 @@ private:
      * The reference count of an instance of this data structure.
      * Each buffer which references an instance holds a count.
      */
+#ifdef NS3_MTP
+    std::atomic<uint32_t> m_count;
+#else
     uint32_t m_count;
+#endif
     /**
      * the size of the m_data field below.
      */
@@ -766,7 +819,21 @@ private:
    * writing data. i.e., m_start should be initialized to this 
    * value.
    */
+#ifdef NS3_MTP
+  static thread_local uint32_t g_recommendedStart;
+#else
   static uint32_t g_recommendedStart;
+#endif
+  /**
+   * room to leave after the zero area of a newly-allocated buffer,
+   * for the trailers: the largest number of bytes ever written after
+   * the zero area of a buffer.
+   */
+#ifdef NS3_MTP
+  static thread_local uint32_t g_recommendedEnd;
+#else
+  static uint32_t g_recommendedEnd;
+#endif
 
   /**
    * offset to the start of the virtual zero area from the start
@@ -790,17 +857,21 @@ private:
   uint32_t m_end;
 
 #ifdef BUFFER_FREE_LIST
-  /// Container for buffer data
-  typedef std::vector<struct Buffer::Data*> FreeList;
+  class FreeList;
   /// Local static destructor structure
   struct LocalStaticDestructor 
   {
     ~LocalStaticDestructor ();
   };
-  static uint32_t g_maxSize; //!< Max observed data size
-  static FreeList *g_freeList; //!< Buffer data container
+#ifdef NS3_MTP
+  // each thread of the MultithreadedSimulatorImpl recycles its own buffers
+  static thread_local FreeList *g_freeList; //!< Buffer data free lists
+  static thread_local struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
+#else
+  static FreeList *g_freeList; //!< Buffer data free lists
   static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
 #endif
+#endif
 };
 
 } // namespace ns3
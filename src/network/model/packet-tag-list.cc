@@ -157,7 +157,29 @@ PacketTagList::COWTraverse (Tag & tag, PacketTagList::COWWriter Writer)
 bool
 PacketTagList::Remove (Tag & tag)
 {
+#ifdef NS3_LEAN_PACKET
+  TypeId tid = tag.GetInstanceTypeId ();
+  for (uint8_t i = 0; i < m_nInline; i++)
+    {
+      if (m_inline[i].tid == tid)
+        {
+          tag.Deserialize (TagBuffer (m_inline[i].data,
+                                      m_inline[i].data + TagData::MAX_SIZE));
+          for (m_nInline--; i < m_nInline; i++)
+            {
+              std::memcpy (m_inline[i].data, m_inline[i + 1].data, TagData::MAX_SIZE);
+              m_inline[i].tid = m_inline[i + 1].tid;
+            }
+          Relink ();
+          return true;
+        }
+    }
+  bool found = COWTraverse (tag, &PacketTagList::RemoveWriter);
+  Relink ();
+  return found;
+#else
   return COWTraverse (tag, &PacketTagList::RemoveWriter);
+#endif
 }
 
 // COWWriter implementing Remove
@@ -196,11 +218,29 @@ PacketTagList::RemoveWriter (Tag & tag, bool preMerge,
 bool
 PacketTagList::Replace (Tag & tag)
 {
+#ifdef NS3_LEAN_PACKET
+  TypeId tid = tag.GetInstanceTypeId ();
+  for (uint8_t i = 0; i < m_nInline; i++)
+    {
+      if (m_inline[i].tid == tid)
+        {
+          tag.Serialize (TagBuffer (m_inline[i].data,
+                                    m_inline[i].data + tag.GetSerializedSize ()));
+          return true;
+        }
+    }
+#endif
   bool found = COWTraverse (tag, &PacketTagList::ReplaceWriter);
   if (!found)
     {
       Add (tag);
     }
+#ifdef NS3_LEAN_PACKET
+  else
+    {
+      Relink ();
+    }
+#endif
   return found;
 }
 
@@ -245,19 +285,34 @@ PacketTagList::Add (const Tag &tag) const
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
   // ensure this id was not yet added
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
+  for (const struct TagData *cur = Head (); cur != 0; cur = cur->next) 
     {
       NS_ASSERT_MSG (cur->tid != tag.GetInstanceTypeId (), "Error: cannot add the same kind of tag twice.");
     }
+  NS_ASSERT (tag.GetSerializedSize () <= TagData::MAX_SIZE);
+  PacketTagList *self = const_cast<PacketTagList *> (this);
+#ifdef NS3_LEAN_PACKET
+  if (m_nInline < INLINE_TAGS)
+    {
+      struct TagData *slot = &self->m_inline[self->m_nInline++];
+      slot->count = 1;
+      slot->tid = tag.GetInstanceTypeId ();
+      tag.Serialize (TagBuffer (slot->data, slot->data + tag.GetSerializedSize ()));
+      self->Relink ();
+      return;
+    }
+#endif
   struct TagData * head = new struct TagData ();
   head->count = 1;
   head->next = 0;
   head->tid = tag.GetInstanceTypeId ();
   head->next = m_next;
-  NS_ASSERT (tag.GetSerializedSize () <= TagData::MAX_SIZE);
   tag.Serialize (TagBuffer (head->data, head->data + tag.GetSerializedSize ()));
 
-  const_cast<PacketTagList *> (this)->m_next = head;
+  self->m_next = head;
+#ifdef NS3_LEAN_PACKET
+  self->Relink ();
+#endif
 }
 
 bool
@@ -265,7 +320,7 @@ PacketTagList::Peek (Tag &tag) const
 {
   NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
   TypeId tid = tag.GetInstanceTypeId ();
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next) 
+  for (struct TagData *cur = const_cast<struct TagData *> (Head ()); cur != 0; cur = cur->next) 
     {
       if (cur->tid == tid) 
         {
@@ -281,7 +336,11 @@ PacketTagList::Peek (Tag &tag) const
 const struct PacketTagList::TagData *
 PacketTagList::Head (void) const
 {
+#ifdef NS3_LEAN_PACKET
+  return m_nInline > 0 ? &m_inline[0] : m_next;
+#else
   return m_next;
+#endif
 }
 
 } /* namespace ns3 */
@@ -361,6 +361,56 @@ BufferTest::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (val1, val2, "Bad ReadNtohU16()");
 }
 //-----------------------------------------------------------------------------
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Buffer data areas are recycled through the free lists, within
+ * their limits.
+ */
+class BufferFreeListTest : public TestCase {
+public:
+  virtual void DoRun (void);
+  BufferFreeListTest ();
+};
+
+BufferFreeListTest::BufferFreeListTest ()
+  : TestCase ("Buffer free lists")
+{
+}
+
+void
+BufferFreeListTest::DoRun (void)
+{
+  Buffer::FreeListStats before = Buffer::GetFreeListStats ();
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      Buffer small;
+      small.AddAtStart (40);
+      Buffer large;
+      large.AddAtStart (900);
+      large.AddAtEnd (900);
+    }
+  Buffer::FreeListStats after = Buffer::GetFreeListStats ();
+  // once the first iteration filled the free lists, every data area is reused
+  NS_TEST_EXPECT_MSG_GT_OR_EQ (after.hits - before.hits, 9 * 2, "Data areas not reused");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (after.misses - before.misses, 3 * 2, "Data areas not reused");
+  NS_TEST_EXPECT_MSG_EQ (after.released, before.released, "Data areas freed below the limits");
+  NS_TEST_EXPECT_MSG_GT (after.retainedBytes, 0, "No bytes retained");
+
+  // without room in the free lists, the data areas go back to the heap
+  Buffer::SetFreeListLimits (0, 0);
+  before = Buffer::GetFreeListStats ();
+  {
+    Buffer b;
+    b.AddAtEnd (5000);
+  }
+  after = Buffer::GetFreeListStats ();
+  NS_TEST_EXPECT_MSG_GT (after.released, before.released, "Data area kept beyond the limits");
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (after.retainedBuffers, before.retainedBuffers, "Data area kept beyond the limits");
+  Buffer::SetFreeListLimits (1000, 8 << 20);
+}
+
 class BufferTestSuite : public TestSuite
 {
 public:
@@ -371,6 +421,7 @@ BufferTestSuite::BufferTestSuite ()
   : TestSuite ("buffer", UNIT)
 {
   AddTestCase (new BufferTest, TestCase::QUICK);
+  AddTestCase (new BufferFreeListTest, TestCase::QUICK);
 }
 
 static BufferTestSuite g_bufferTestSuite;
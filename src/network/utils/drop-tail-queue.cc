@@ -37,7 +37,8 @@ TypeId DropTailQueue::GetTypeId (void)
 
 DropTailQueue::DropTailQueue () :
   Queue (),
-  m_packets ()
+  m_packets (),
+  m_nSegments (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -51,9 +52,11 @@ bool
 DropTailQueue::DoEnqueue (Ptr<QueueItem> item)
 {
   NS_LOG_FUNCTION (this << item);
-  NS_ASSERT (m_packets.size () == GetNPackets ());
+  // a super-segment counts as the packets of its wire segments
+  NS_ASSERT (m_nSegments == GetNPackets ());
 
   m_packets.push (item);
+  m_nSegments += item->GetSegmentCount ();
 
   return true;
 }
@@ -62,10 +65,11 @@ Ptr<QueueItem>
 DropTailQueue::DoDequeue (void)
 {
   NS_LOG_FUNCTION (this);
-  NS_ASSERT (m_packets.size () == GetNPackets ());
+  NS_ASSERT (m_nSegments == GetNPackets ());
 
   Ptr<QueueItem> item = m_packets.front ();
   m_packets.pop ();
+  m_nSegments -= item->GetSegmentCount ();
 
   NS_LOG_LOGIC ("Popped " << item);
 
@@ -76,10 +80,11 @@ Ptr<QueueItem>
 DropTailQueue::DoRemove (void)
 {
   NS_LOG_FUNCTION (this);
-  NS_ASSERT (m_packets.size () == GetNPackets ());
+  NS_ASSERT (m_nSegments == GetNPackets ());
 
   Ptr<QueueItem> item = m_packets.front ();
   m_packets.pop ();
+  m_nSegments -= item->GetSegmentCount ();
 
   NS_LOG_LOGIC ("Removed " << item);
 
@@ -90,7 +95,7 @@ Ptr<const QueueItem>
 DropTailQueue::DoPeek (void) const
 {
   NS_LOG_FUNCTION (this);
-  NS_ASSERT (m_packets.size () == GetNPackets ());
+  NS_ASSERT (m_nSegments == GetNPackets ());
 
   return m_packets.front ();
 }
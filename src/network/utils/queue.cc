@@ -98,7 +98,7 @@ Queue::Enqueue (Ptr<QueueItem> item)
 {
   NS_LOG_FUNCTION (this << item);
 
-  if (m_mode == QUEUE_MODE_PACKETS && (m_nPackets.Get () >= m_maxPackets))
+  if (m_mode == QUEUE_MODE_PACKETS && (m_nPackets.Get () + item->GetSegmentCount () > m_maxPackets))
     {
       NS_LOG_LOGIC ("Queue full (at max packets) -- dropping pkt");
       Drop (item);
@@ -125,8 +125,8 @@ Queue::Enqueue (Ptr<QueueItem> item)
       m_nBytes += size;
       m_nTotalReceivedBytes += size;
 
-      m_nPackets++;
-      m_nTotalReceivedPackets++;
+      m_nPackets += item->GetSegmentCount ();
+      m_nTotalReceivedPackets += item->GetSegmentCount ();
     }
   return retval;
 }
@@ -147,10 +147,10 @@ Queue::Dequeue (void)
   if (item != 0)
     {
       NS_ASSERT (m_nBytes.Get () >= item->GetPacketSize ());
-      NS_ASSERT (m_nPackets.Get () > 0);
+      NS_ASSERT (m_nPackets.Get () >= item->GetSegmentCount ());
 
       m_nBytes -= item->GetPacketSize ();
-      m_nPackets--;
+      m_nPackets -= item->GetSegmentCount ();
 
       NS_LOG_LOGIC ("m_traceDequeue (packet)");
       m_traceDequeue (item->GetPacket ());
@@ -174,10 +174,10 @@ Queue::Remove (void)
   if (item != 0)
     {
       NS_ASSERT (m_nBytes.Get () >= item->GetPacketSize ());
-      NS_ASSERT (m_nPackets.Get () > 0);
+      NS_ASSERT (m_nPackets.Get () >= item->GetSegmentCount ());
 
       m_nBytes -= item->GetPacketSize ();
-      m_nPackets--;
+      m_nPackets -= item->GetSegmentCount ();
 
       Drop (item);
     }
@@ -365,7 +365,7 @@ Queue::Drop (Ptr<QueueItem> item)
 {
   NS_LOG_FUNCTION (this << item);
 
-  m_nTotalDroppedPackets++;
+  m_nTotalDroppedPackets += item->GetSegmentCount ();
   m_nTotalDroppedBytes += item->GetPacketSize ();
 
   NS_LOG_LOGIC ("m_traceDrop (p)");
@@ -0,0 +1,169 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include "segmentation-tag.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SegmentationTag");
+
+NS_OBJECT_ENSURE_REGISTERED (SegmentationTag);
+
+#ifdef NS3_MTP
+std::atomic<bool> SegmentationTag::m_enabled (false);
+#else
+bool SegmentationTag::m_enabled = false;
+#endif
+
+TypeId
+SegmentationTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SegmentationTag")
+    .SetParent<Tag> ()
+    .SetGroupName ("Network")
+    .AddConstructor<SegmentationTag> ()
+  ;
+  return tid;
+}
+TypeId
+SegmentationTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+uint32_t
+SegmentationTag::GetSerializedSize (void) const
+{
+  return 14;
+}
+void
+SegmentationTag::Serialize (TagBuffer buf) const
+{
+  buf.WriteU16 (m_segmentSize);
+  buf.WriteU32 (m_payloadSize);
+  buf.WriteU64 (m_marks);
+}
+void
+SegmentationTag::Deserialize (TagBuffer buf)
+{
+  m_segmentSize = buf.ReadU16 ();
+  m_payloadSize = buf.ReadU32 ();
+  m_marks = buf.ReadU64 ();
+}
+void
+SegmentationTag::Print (std::ostream &os) const
+{
+  os << "SegmentSize=" << m_segmentSize << " PayloadSize=" << m_payloadSize
+     << " Segments=" << GetSegmentCount ();
+}
+SegmentationTag::SegmentationTag ()
+  : Tag (),
+    m_segmentSize (1),
+    m_payloadSize (0),
+    m_marks (0)
+{
+}
+
+SegmentationTag::SegmentationTag (uint16_t segmentSize, uint32_t payloadSize)
+  : Tag (),
+    m_segmentSize (segmentSize),
+    m_payloadSize (payloadSize),
+    m_marks (0)
+{
+  NS_LOG_FUNCTION (this << segmentSize << payloadSize);
+  NS_ASSERT_MSG (segmentSize > 0 && GetSegmentCount () <= MAX_SEGMENTS,
+                 "A super-segment has 1 to " << MAX_SEGMENTS << " wire segments");
+}
+
+void
+SegmentationTag::Enable (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+#ifdef NS3_MTP
+  // read first: every socket with offload calls this method, from any thread
+  if (m_enabled.load (std::memory_order_relaxed) || m_enabled.exchange (true))
+    {
+      return;
+    }
+#else
+  if (m_enabled)
+    {
+      return;
+    }
+  m_enabled = true;
+#endif
+  Simulator::ScheduleDestroy (&SegmentationTag::Disable);
+}
+
+void
+SegmentationTag::Disable (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  m_enabled = false;
+}
+
+bool
+SegmentationTag::IsEnabled (void)
+{
+#ifdef NS3_MTP
+  return m_enabled.load (std::memory_order_relaxed);
+#else
+  return m_enabled;
+#endif
+}
+
+uint16_t
+SegmentationTag::GetSegmentSize (void) const
+{
+  return m_segmentSize;
+}
+
+uint32_t
+SegmentationTag::GetPayloadSize (void) const
+{
+  return m_payloadSize;
+}
+
+uint32_t
+SegmentationTag::GetSegmentCount (void) const
+{
+  return std::max<uint32_t> ((m_payloadSize + m_segmentSize - 1) / m_segmentSize, 1);
+}
+
+uint32_t
+SegmentationTag::GetWireSize (uint32_t packetSize) const
+{
+  NS_ASSERT (packetSize >= m_payloadSize);
+  // every wire segment repeats the headers
+  return packetSize + (GetSegmentCount () - 1) * (packetSize - m_payloadSize);
+}
+
+void
+SegmentationTag::MarkSegment (uint32_t segment)
+{
+  NS_ASSERT (segment < GetSegmentCount ());
+  m_marks |= uint64_t (1) << segment;
+}
+
+bool
+SegmentationTag::IsSegmentMarked (uint32_t segment) const
+{
+  NS_ASSERT (segment < GetSegmentCount ());
+  return (m_marks >> segment) & 1;
+}
+
+} // namespace ns3
@@ -19,6 +19,7 @@
  */
 #include "simple-net-device.h"
 #include "simple-channel.h"
+#include "segmentation-tag.h"
 #include "ns3/node.h"
 #include "ns3/packet.h"
 #include "ns3/log.h"
@@ -424,11 +425,28 @@ SimpleNetDevice::Send (Ptr<Packet> packet, const Address& dest, uint16_t protoco
   return SendFrom (packet, m_address, dest, protocolNumber);
 }
 
+/**
+ * \param p a packet
+ * \returns the size of the packet on the wire, that of the segments it
+ * stands for if it is a super-segment
+ */
+static uint32_t
+GetWireSize (Ptr<const Packet> p)
+{
+  SegmentationTag tag;
+  if (SegmentationTag::IsEnabled () && p->PeekPacketTag (tag))
+    {
+      return tag.GetWireSize (p->GetSize ());
+    }
+  return p->GetSize ();
+}
+
 bool
 SimpleNetDevice::SendFrom (Ptr<Packet> p, const Address& source, const Address& dest, uint16_t protocolNumber)
 {
   NS_LOG_FUNCTION (this << p << source << dest << protocolNumber);
-  if (p->GetSize () > GetMtu ())
+  SegmentationTag segmentationTag;
+  if (p->GetSize () > GetMtu () && !p->PeekPacketTag (segmentationTag))
     {
       return false;
     }
@@ -444,16 +462,17 @@ SimpleNetDevice::SendFrom (Ptr<Packet> p, const Address& source, const Address&
 
   p->AddPacketTag (tag);
 
+  bool wasEmpty = m_queue->IsEmpty ();
   if (m_queue->Enqueue (Create<QueueItem> (p)))
     {
-      if (m_queue->GetNPackets () == 1 && !TransmitCompleteEvent.IsRunning ())
+      if (wasEmpty && !TransmitCompleteEvent.IsRunning ())
         {
           p = m_queue->Dequeue ()->GetPacket ();
           p->RemovePacketTag (tag);
           Time txTime = Time (0);
           if (m_bps > DataRate (0))
             {
-              txTime = m_bps.CalculateBytesTxTime (packet->GetSize ());
+              txTime = m_bps.CalculateBytesTxTime (GetWireSize (packet));
             }
           m_channel->Send (p, protocolNumber, to, from, this);
           TransmitCompleteEvent = Simulator::Schedule (txTime, &SimpleNetDevice::TransmitComplete, this);
@@ -493,7 +512,7 @@ SimpleNetDevice::TransmitComplete ()
       Time txTime = Time (0);
       if (m_bps > DataRate (0))
         {
-          txTime = m_bps.CalculateBytesTxTime (packet->GetSize ());
+          txTime = m_bps.CalculateBytesTxTime (GetWireSize (packet));
         }
       TransmitCompleteEvent = Simulator::Schedule (txTime, &SimpleNetDevice::TransmitComplete, this);
     }
@@ -0,0 +1,233 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// ns3 includes
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/point-to-point-fat-tree.h"
+
+#include "ns3/ipv4.h"
+#include "ns3/global-router-interface.h"
+#include "ns3/ipv4-global-routing.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PointToPointFatTreeHelper");
+
+/**
+ * \param node the node
+ * \returns the global routing protocol of the node
+ */
+static Ptr<Ipv4GlobalRouting>
+GetGlobalRouting (Ptr<Node> node)
+{
+  Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
+  NS_ABORT_MSG_IF (router == 0, "Node " << node->GetId () << " has no Ipv4GlobalRouting");
+  return router->GetRoutingProtocol ();
+}
+
+/**
+ * \brief Add a route through a link to the global routing of a node
+ * \param network the destination network
+ * \param mask the mask of the destination network
+ * \param device the device of the node on the link
+ * \param peer the device at the other end of the link, the next hop
+ */
+static void
+AddRoute (Ipv4Address network, Ipv4Mask mask, Ptr<NetDevice> device, Ptr<NetDevice> peer)
+{
+  Ptr<Node> node = device->GetNode ();
+  int32_t interface = node->GetObject<Ipv4> ()->GetInterfaceForDevice (device);
+  Ptr<Ipv4> peerIpv4 = peer->GetNode ()->GetObject<Ipv4> ();
+  int32_t peerInterface = peerIpv4->GetInterfaceForDevice (peer);
+  NS_ABORT_MSG_IF (interface < 0 || peerInterface < 0, "Link without IPv4 addresses");
+  Ipv4Address nextHop = peerIpv4->GetAddress (peerInterface, 0).GetLocal ();
+  GetGlobalRouting (node)->AddNetworkRouteTo (network, mask, nextHop, interface);
+}
+
+PointToPointFatTreeHelper::PointToPointFatTreeHelper (uint32_t k,
+                                                      PointToPointHelper hostLink,
+                                                      PointToPointHelper fabricLink)
+  : m_k (k)
+{
+  NS_ABORT_MSG_IF (k < 2 || k % 2 != 0 || k > 128, "A fat-tree needs an even k, at most 128");
+  uint32_t half = k / 2;
+  m_hosts.Create (k * half * half);
+  m_edges.Create (k * half);
+  m_aggregations.Create (k * half);
+  m_cores.Create (half * half);
+
+  for (uint32_t e = 0; e < m_edges.GetN (); ++e)
+    {
+      uint32_t pod = e / half;
+      for (uint32_t h = 0; h < half; ++h)
+        {
+          m_hostLinks.push_back (hostLink.Install (m_hosts.Get (e * half + h), m_edges.Get (e)));
+        }
+      for (uint32_t a = 0; a < half; ++a)
+        {
+          m_edgeLinks.push_back (fabricLink.Install (m_edges.Get (e), m_aggregations.Get (pod * half + a)));
+        }
+    }
+  for (uint32_t a = 0; a < m_aggregations.GetN (); ++a)
+    {
+      for (uint32_t c = 0; c < half; ++c)
+        {
+          m_coreLinks.push_back (fabricLink.Install (m_aggregations.Get (a), m_cores.Get ((a % half) * half + c)));
+        }
+    }
+}
+
+PointToPointFatTreeHelper::~PointToPointFatTreeHelper ()
+{
+}
+
+Ptr<Node>
+PointToPointFatTreeHelper::GetHost (uint32_t i) const
+{
+  return m_hosts.Get (i);
+}
+
+Ptr<Node>
+PointToPointFatTreeHelper::GetEdge (uint32_t i) const
+{
+  return m_edges.Get (i);
+}
+
+Ptr<Node>
+PointToPointFatTreeHelper::GetAggregation (uint32_t i) const
+{
+  return m_aggregations.Get (i);
+}
+
+Ptr<Node>
+PointToPointFatTreeHelper::GetCore (uint32_t i) const
+{
+  return m_cores.Get (i);
+}
+
+NodeContainer
+PointToPointFatTreeHelper::GetHosts () const
+{
+  return m_hosts;
+}
+
+Ipv4Address
+PointToPointFatTreeHelper::GetHostIpv4Address (uint32_t i) const
+{
+  return m_hostInterfaces.GetAddress (i);
+}
+
+uint32_t
+PointToPointFatTreeHelper::HostCount () const
+{
+  return m_hosts.GetN ();
+}
+
+void
+PointToPointFatTreeHelper::InstallStack (InternetStackHelper stack)
+{
+  stack.Install (m_hosts);
+  stack.Install (m_edges);
+  stack.Install (m_aggregations);
+  stack.Install (m_cores);
+}
+
+void
+PointToPointFatTreeHelper::AssignIpv4Addresses (Ipv4Address hostNetwork,
+                                                Ipv4AddressHelper fabricAddress)
+{
+  NS_ABORT_MSG_IF ((hostNetwork.Get () & 0x00ffffff) != 0,
+                   "The hosts of a fat-tree need a /8 network, not " << hostNetwork);
+  uint32_t half = m_k / 2;
+  Ipv4AddressHelper hostAddress;
+  for (uint32_t i = 0; i < m_hosts.GetN (); ++i)
+    {
+      uint32_t edge = i / half;
+      uint32_t pod = edge / half;
+      Ipv4Address network (hostNetwork.Get () | (pod << 16) | ((edge % half) << 8) | ((i % half) * 4));
+      hostAddress.SetBase (network, "255.255.255.252");
+      m_hostInterfaces.Add (hostAddress.Assign (m_hostLinks[i]).Get (0));
+    }
+  for (uint32_t i = 0; i < m_edgeLinks.size (); ++i)
+    {
+      fabricAddress.Assign (m_edgeLinks[i]);
+      fabricAddress.NewNetwork ();
+    }
+  for (uint32_t i = 0; i < m_coreLinks.size (); ++i)
+    {
+      fabricAddress.Assign (m_coreLinks[i]);
+      fabricAddress.NewNetwork ();
+    }
+}
+
+void
+PointToPointFatTreeHelper::InstallRoutes ()
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t half = m_k / 2;
+  Ipv4Mask linkMask ("255.255.255.252");
+  Ipv4Mask torMask ("255.255.255.0");
+  Ipv4Mask podMask ("255.255.0.0");
+  Ipv4Address any = Ipv4Address::GetAny ();
+  Ipv4Mask anyMask = Ipv4Mask::GetZero ();
+
+  // hosts: everything through their edge switch
+  for (uint32_t i = 0; i < m_hosts.GetN (); ++i)
+    {
+      AddRoute (any, anyMask, m_hostLinks[i].Get (0), m_hostLinks[i].Get (1));
+    }
+
+  // edge switches: their hosts, then up through every aggregation switch
+  for (uint32_t e = 0; e < m_edges.GetN (); ++e)
+    {
+      Ptr<Node> edge = m_edges.Get (e);
+      Ptr<Ipv4GlobalRouting> routing = GetGlobalRouting (edge);
+      for (uint32_t h = 0; h < half; ++h)
+        {
+          uint32_t host = e * half + h;
+          int32_t interface = edge->GetObject<Ipv4> ()->GetInterfaceForDevice (m_hostLinks[host].Get (1));
+          routing->AddNetworkRouteTo (GetHostIpv4Address (host).CombineMask (linkMask), linkMask, interface);
+        }
+      for (uint32_t a = 0; a < half; ++a)
+        {
+          const NetDeviceContainer &link = m_edgeLinks[e * half + a];
+          AddRoute (any, anyMask, link.Get (0), link.Get (1));
+        }
+    }
+
+  // aggregation switches: the edge switches of their pod, then up
+  // through every core switch they are linked to; the core switches
+  // reach each pod through the aggregation switch they are linked to
+  for (uint32_t a = 0; a < m_aggregations.GetN (); ++a)
+    {
+      uint32_t pod = a / half;
+      for (uint32_t e = pod * half; e < (pod + 1) * half; ++e)
+        {
+          const NetDeviceContainer &link = m_edgeLinks[e * half + a % half];
+          AddRoute (GetHostIpv4Address (e * half).CombineMask (torMask), torMask, link.Get (1), link.Get (0));
+        }
+      Ipv4Address podPrefix = GetHostIpv4Address (pod * half * half).CombineMask (podMask);
+      for (uint32_t c = 0; c < half; ++c)
+        {
+          const NetDeviceContainer &link = m_coreLinks[a * half + c];
+          AddRoute (any, anyMask, link.Get (0), link.Get (1));
+          AddRoute (podPrefix, podMask, link.Get (1), link.Get (0));
+        }
+    }
+}
+
+} // namespace ns3
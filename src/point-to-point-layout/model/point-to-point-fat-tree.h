@@ -0,0 +1,161 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Define an object to create a k-ary fat-tree topology.
+
+#ifndef POINT_TO_POINT_FAT_TREE_HELPER_H
+#define POINT_TO_POINT_FAT_TREE_HELPER_H
+
+#include <vector>
+
+#include "point-to-point-helper.h"
+#include "ipv4-address-helper.h"
+#include "internet-stack-helper.h"
+#include "ipv4-interface-container.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup point-to-point-layout
+ *
+ * \brief A helper to make it easier to create a k-ary fat-tree
+ * topology with PointToPoint links, and to route it without SPF
+ *
+ * The fat-tree has k pods of k/2 edge (ToR) switches and k/2
+ * aggregation switches, each edge switch linked to every aggregation
+ * switch of its pod and to k/2 hosts, and (k/2)^2 core switches. The
+ * aggregation switch i of every pod is linked to the core switches
+ * i*k/2 to i*k/2 + k/2 - 1. The nodes are numbered pod by pod, and the
+ * hosts of an edge switch are consecutive.
+ *
+ * The hosts of the edge switch e of pod p are addressed from the /24
+ * prefix base + p.e.0, one /30 link per host, so that a pod is a /16
+ * prefix. InstallRoutes uses this plan to write the routes of every
+ * node into its Ipv4GlobalRouting directly: a default route on the
+ * hosts, the host links and an equal-cost default route towards the
+ * aggregation switches on the edge switches, the /24 prefixes of the
+ * pod and an equal-cost default route towards the core on the
+ * aggregation switches, and the /16 prefixes of the pods on the core
+ * switches. Each switch holds k routes, whatever the number of hosts,
+ * and no link state database is built.
+ */
+class PointToPointFatTreeHelper
+{
+public:
+  /**
+   * Create a PointToPointFatTreeHelper in order to easily create
+   * fat-tree topologies using p2p links
+   *
+   * \param k the number of ports of the switches, even and at most 128
+   *
+   * \param hostLink the link helper for the links between the hosts
+   *        and the edge switches
+   *
+   * \param fabricLink the link helper for the links between the
+   *        switches
+   */
+  PointToPointFatTreeHelper (uint32_t k,
+                             PointToPointHelper hostLink,
+                             PointToPointHelper fabricLink);
+
+  ~PointToPointFatTreeHelper ();
+
+public:
+  /**
+   * \param i an index into the hosts
+   *
+   * \returns a node pointer to the indexed host
+   */
+  Ptr<Node> GetHost (uint32_t i) const;
+
+  /**
+   * \param i an index into the edge switches
+   *
+   * \returns a node pointer to the indexed edge switch
+   */
+  Ptr<Node> GetEdge (uint32_t i) const;
+
+  /**
+   * \param i an index into the aggregation switches
+   *
+   * \returns a node pointer to the indexed aggregation switch
+   */
+  Ptr<Node> GetAggregation (uint32_t i) const;
+
+  /**
+   * \param i an index into the core switches
+   *
+   * \returns a node pointer to the indexed core switch
+   */
+  Ptr<Node> GetCore (uint32_t i) const;
+
+  /**
+   * \returns the hosts of the fat-tree
+   */
+  NodeContainer GetHosts () const;
+
+  /**
+   * \param i index into the host interfaces
+   *
+   * \returns Ipv4Address of the indexed host
+   */
+  Ipv4Address GetHostIpv4Address (uint32_t i) const;
+
+  /**
+   * \returns the total number of hosts in the fat-tree
+   */
+  uint32_t HostCount () const;
+
+  /**
+   * \param stack an InternetStackHelper which is used to install
+   *              on every node in the fat-tree; its routing must
+   *              include Ipv4GlobalRouting for InstallRoutes
+   */
+  void InstallStack (InternetStackHelper stack);
+
+  /**
+   * \param hostNetwork the /8 network the host prefixes are taken from
+   *
+   * \param fabricAddress an Ipv4AddressHelper which is used to address
+   *                      the links between the switches, one network
+   *                      per link
+   */
+  void AssignIpv4Addresses (Ipv4Address hostNetwork,
+                            Ipv4AddressHelper fabricAddress);
+
+  /**
+   * Add the routes of every node to its Ipv4GlobalRouting, in place of
+   * Ipv4GlobalRoutingHelper::PopulateRoutingTables.  The routes reach
+   * the hosts only; they are removed by
+   * Ipv4GlobalRoutingHelper::RecomputeRoutingTables.
+   */
+  void InstallRoutes ();
+
+private:
+  uint32_t m_k;                          //!< Number of ports of the switches
+  NodeContainer m_hosts;                 //!< Hosts
+  NodeContainer m_edges;                 //!< Edge switches
+  NodeContainer m_aggregations;          //!< Aggregation switches
+  NodeContainer m_cores;                 //!< Core switches
+  std::vector<NetDeviceContainer> m_hostLinks;  //!< Host and edge devices, by host
+  std::vector<NetDeviceContainer> m_edgeLinks;  //!< Edge and aggregation devices, by edge switch then port
+  std::vector<NetDeviceContainer> m_coreLinks;  //!< Aggregation and core devices, by aggregation switch then port
+  Ipv4InterfaceContainer m_hostInterfaces;      //!< IPv4 host interfaces
+};
+
+} // namespace ns3
+
+#endif /* POINT_TO_POINT_FAT_TREE_HELPER_H */
@@ -0,0 +1,198 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// ns3 includes
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/point-to-point-leaf-spine.h"
+
+#include "ns3/ipv4.h"
+#include "ns3/global-router-interface.h"
+#include "ns3/ipv4-global-routing.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PointToPointLeafSpineHelper");
+
+/**
+ * \param node the node
+ * \returns the global routing protocol of the node
+ */
+static Ptr<Ipv4GlobalRouting>
+GetGlobalRouting (Ptr<Node> node)
+{
+  Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
+  NS_ABORT_MSG_IF (router == 0, "Node " << node->GetId () << " has no Ipv4GlobalRouting");
+  return router->GetRoutingProtocol ();
+}
+
+/**
+ * \brief Add a route through a link to the global routing of a node
+ * \param network the destination network
+ * \param mask the mask of the destination network
+ * \param device the device of the node on the link
+ * \param peer the device at the other end of the link, the next hop
+ */
+static void
+AddRoute (Ipv4Address network, Ipv4Mask mask, Ptr<NetDevice> device, Ptr<NetDevice> peer)
+{
+  Ptr<Node> node = device->GetNode ();
+  int32_t interface = node->GetObject<Ipv4> ()->GetInterfaceForDevice (device);
+  Ptr<Ipv4> peerIpv4 = peer->GetNode ()->GetObject<Ipv4> ();
+  int32_t peerInterface = peerIpv4->GetInterfaceForDevice (peer);
+  NS_ABORT_MSG_IF (interface < 0 || peerInterface < 0, "Link without IPv4 addresses");
+  Ipv4Address nextHop = peerIpv4->GetAddress (peerInterface, 0).GetLocal ();
+  GetGlobalRouting (node)->AddNetworkRouteTo (network, mask, nextHop, interface);
+}
+
+PointToPointLeafSpineHelper::PointToPointLeafSpineHelper (uint32_t nLeaves,
+                                                          uint32_t nSpines,
+                                                          uint32_t hostsPerLeaf,
+                                                          PointToPointHelper hostLink,
+                                                          PointToPointHelper fabricLink)
+  : m_hostsPerLeaf (hostsPerLeaf)
+{
+  NS_ABORT_MSG_IF (nLeaves == 0 || nLeaves > 256, "A leaf-spine needs 1 to 256 leaves");
+  NS_ABORT_MSG_IF (nSpines == 0, "A leaf-spine needs spines");
+  NS_ABORT_MSG_IF (hostsPerLeaf > 64, "A leaf has at most 64 hosts");
+  m_hosts.Create (nLeaves * hostsPerLeaf);
+  m_leaves.Create (nLeaves);
+  m_spines.Create (nSpines);
+
+  for (uint32_t l = 0; l < nLeaves; ++l)
+    {
+      for (uint32_t h = 0; h < hostsPerLeaf; ++h)
+        {
+          m_hostLinks.push_back (hostLink.Install (m_hosts.Get (l * hostsPerLeaf + h), m_leaves.Get (l)));
+        }
+      for (uint32_t s = 0; s < nSpines; ++s)
+        {
+          m_fabricLinks.push_back (fabricLink.Install (m_leaves.Get (l), m_spines.Get (s)));
+        }
+    }
+}
+
+PointToPointLeafSpineHelper::~PointToPointLeafSpineHelper ()
+{
+}
+
+Ptr<Node>
+PointToPointLeafSpineHelper::GetHost (uint32_t i) const
+{
+  return m_hosts.Get (i);
+}
+
+Ptr<Node>
+PointToPointLeafSpineHelper::GetLeaf (uint32_t i) const
+{
+  return m_leaves.Get (i);
+}
+
+Ptr<Node>
+PointToPointLeafSpineHelper::GetSpine (uint32_t i) const
+{
+  return m_spines.Get (i);
+}
+
+NodeContainer
+PointToPointLeafSpineHelper::GetHosts () const
+{
+  return m_hosts;
+}
+
+Ipv4Address
+PointToPointLeafSpineHelper::GetHostIpv4Address (uint32_t i) const
+{
+  return m_hostInterfaces.GetAddress (i);
+}
+
+uint32_t
+PointToPointLeafSpineHelper::HostCount () const
+{
+  return m_hosts.GetN ();
+}
+
+void
+PointToPointLeafSpineHelper::InstallStack (InternetStackHelper stack)
+{
+  stack.Install (m_hosts);
+  stack.Install (m_leaves);
+  stack.Install (m_spines);
+}
+
+void
+PointToPointLeafSpineHelper::AssignIpv4Addresses (Ipv4Address hostNetwork,
+                                                  Ipv4AddressHelper fabricAddress)
+{
+  NS_ABORT_MSG_IF ((hostNetwork.Get () & 0x0000ffff) != 0,
+                   "The hosts of a leaf-spine need a /16 network, not " << hostNetwork);
+  Ipv4AddressHelper hostAddress;
+  for (uint32_t i = 0; i < m_hosts.GetN (); ++i)
+    {
+      uint32_t leaf = i / m_hostsPerLeaf;
+      Ipv4Address network (hostNetwork.Get () | (leaf << 8) | ((i % m_hostsPerLeaf) * 4));
+      hostAddress.SetBase (network, "255.255.255.252");
+      m_hostInterfaces.Add (hostAddress.Assign (m_hostLinks[i]).Get (0));
+    }
+  for (uint32_t i = 0; i < m_fabricLinks.size (); ++i)
+    {
+      fabricAddress.Assign (m_fabricLinks[i]);
+      fabricAddress.NewNetwork ();
+    }
+}
+
+void
+PointToPointLeafSpineHelper::InstallRoutes ()
+{
+  NS_LOG_FUNCTION (this);
+  Ipv4Mask linkMask ("255.255.255.252");
+  Ipv4Mask leafMask ("255.255.255.0");
+  Ipv4Address any = Ipv4Address::GetAny ();
+  Ipv4Mask anyMask = Ipv4Mask::GetZero ();
+  uint32_t nSpines = m_spines.GetN ();
+
+  // hosts: everything through their leaf
+  for (uint32_t i = 0; i < m_hosts.GetN (); ++i)
+    {
+      AddRoute (any, anyMask, m_hostLinks[i].Get (0), m_hostLinks[i].Get (1));
+    }
+
+  // leaves: their hosts, then up through every spine; the spines reach
+  // the hosts of each leaf through it
+  for (uint32_t l = 0; l < m_leaves.GetN (); ++l)
+    {
+      Ptr<Node> leaf = m_leaves.Get (l);
+      Ptr<Ipv4GlobalRouting> routing = GetGlobalRouting (leaf);
+      for (uint32_t h = 0; h < m_hostsPerLeaf; ++h)
+        {
+          uint32_t host = l * m_hostsPerLeaf + h;
+          int32_t interface = leaf->GetObject<Ipv4> ()->GetInterfaceForDevice (m_hostLinks[host].Get (1));
+          routing->AddNetworkRouteTo (GetHostIpv4Address (host).CombineMask (linkMask), linkMask, interface);
+        }
+      for (uint32_t s = 0; s < nSpines; ++s)
+        {
+          const NetDeviceContainer &link = m_fabricLinks[l * nSpines + s];
+          AddRoute (any, anyMask, link.Get (0), link.Get (1));
+          if (m_hostsPerLeaf > 0)
+            {
+              Ipv4Address leafPrefix = GetHostIpv4Address (l * m_hostsPerLeaf).CombineMask (leafMask);
+              AddRoute (leafPrefix, leafMask, link.Get (1), link.Get (0));
+            }
+        }
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,803 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/object-factory.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/channel.h"
+#include "ns3/channel-list.h"
+#include "ns3/point-to-point-net-device.h"
+#include "ns3/point-to-point-channel.h"
+#include "ns3/point-to-point-remote-channel.h"
+#include "ns3/mpi-interface.h"
+#include "ns3/mpi-receiver.h"
+
+#include "topology-partition-helper.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TopologyPartitionHelper");
+
+namespace {
+
+/** Weighted undirected graph. */
+struct Graph
+{
+  std::vector<uint64_t> weight;                                   //!< Vertex weights.
+  std::vector<std::vector<std::pair<uint32_t, uint64_t> > > adj;  //!< Neighbours and edge weights.
+  uint64_t total;                                                 //!< Sum of the vertex weights.
+};
+
+/** Vertex not yet assigned to a coarse vertex. */
+const uint32_t UNMATCHED = 0xffffffff;
+
+/** Coarsening stops at this number of vertices. */
+const uint32_t COARSEST_SIZE = 40;
+
+/**
+ * Build a graph, merging parallel edges and dropping self loops.
+ * \param [in] weight The vertex weights.
+ * \param [in] edges The edges, with their weights.
+ * \return The graph.
+ */
+Graph
+MakeGraph (const std::vector<uint64_t> &weight,
+           const std::map<std::pair<uint32_t, uint32_t>, uint64_t> &edges)
+{
+  Graph g;
+  g.weight = weight;
+  g.adj.resize (weight.size ());
+  g.total = 0;
+  for (uint32_t v = 0; v < weight.size (); ++v)
+    {
+      g.total += weight[v];
+    }
+  for (std::map<std::pair<uint32_t, uint32_t>, uint64_t>::const_iterator i = edges.begin ();
+       i != edges.end (); ++i)
+    {
+      uint32_t a = i->first.first;
+      uint32_t b = i->first.second;
+      if (a != b)
+        {
+          g.adj[a].push_back (std::make_pair (b, i->second));
+          g.adj[b].push_back (std::make_pair (a, i->second));
+        }
+    }
+  return g;
+}
+
+/**
+ * Add weight to the edge between two vertices.
+ * \param [in,out] edges The edges.
+ * \param [in] a One end.
+ * \param [in] b The other end.
+ * \param [in] w The weight to add.
+ */
+void
+AddEdge (std::map<std::pair<uint32_t, uint32_t>, uint64_t> &edges,
+         uint32_t a, uint32_t b, uint64_t w)
+{
+  if (a != b)
+    {
+      edges[std::make_pair (std::min (a, b), std::max (a, b))] += w;
+    }
+}
+
+/**
+ * Merge each vertex with the neighbour it shares its heaviest edge with.
+ * \param [in] g The graph.
+ * \param [in] maxWeight The largest weight of a coarse vertex.
+ * \param [out] coarse The coarse graph.
+ * \param [out] map The coarse vertex of each vertex of g.
+ * \return false if the graph did not shrink enough to be worth it.
+ */
+bool
+Coarsen (const Graph &g, uint64_t maxWeight, Graph &coarse, std::vector<uint32_t> &map)
+{
+  uint32_t n = g.weight.size ();
+  std::vector<uint32_t> order (n);
+  for (uint32_t v = 0; v < n; ++v)
+    {
+      order[v] = v;
+    }
+  // light vertices first, so that the leaves of a star join their hub
+  // before the hub is full.
+  struct ByWeight
+  {
+    const Graph *g;
+    bool operator () (uint32_t a, uint32_t b) const
+    {
+      return g->weight[a] < g->weight[b];
+    }
+  };
+  ByWeight byWeight = { &g };
+  std::stable_sort (order.begin (), order.end (), byWeight);
+
+  map.assign (n, UNMATCHED);
+  std::vector<uint64_t> weight;
+  for (std::vector<uint32_t>::const_iterator i = order.begin (); i != order.end (); ++i)
+    {
+      uint32_t v = *i;
+      if (map[v] != UNMATCHED)
+        {
+          continue;
+        }
+      uint32_t best = v;
+      uint64_t bestEdge = 0;
+      for (std::vector<std::pair<uint32_t, uint64_t> >::const_iterator e = g.adj[v].begin ();
+           e != g.adj[v].end (); ++e)
+        {
+          uint64_t merged = map[e->first] == UNMATCHED
+            ? g.weight[e->first] : weight[map[e->first]];
+          if (e->second > bestEdge && merged + g.weight[v] <= maxWeight)
+            {
+              best = e->first;
+              bestEdge = e->second;
+            }
+        }
+      if (best != v && map[best] != UNMATCHED)
+        {
+          map[v] = map[best];
+          weight[map[v]] += g.weight[v];
+          continue;
+        }
+      map[v] = weight.size ();
+      weight.push_back (g.weight[v]);
+      if (best != v)
+        {
+          map[best] = map[v];
+          weight[map[v]] += g.weight[best];
+        }
+    }
+  if (weight.size () * 10 > n * 9)
+    {
+      return false;
+    }
+
+  std::map<std::pair<uint32_t, uint32_t>, uint64_t> edges;
+  for (uint32_t v = 0; v < n; ++v)
+    {
+      for (std::vector<std::pair<uint32_t, uint64_t> >::const_iterator e = g.adj[v].begin ();
+           e != g.adj[v].end (); ++e)
+        {
+          if (v < e->first)
+            {
+              AddEdge (edges, map[v], map[e->first], e->second);
+            }
+        }
+    }
+  coarse = MakeGraph (weight, edges);
+  return true;
+}
+
+/**
+ * \param [in] g The graph.
+ * \param [in] side The side of each vertex.
+ * \return The weight of the edges joining the two sides.
+ */
+uint64_t
+GetCut (const Graph &g, const std::vector<uint8_t> &side)
+{
+  uint64_t cut = 0;
+  for (uint32_t v = 0; v < g.weight.size (); ++v)
+    {
+      for (std::vector<std::pair<uint32_t, uint64_t> >::const_iterator e = g.adj[v].begin ();
+           e != g.adj[v].end (); ++e)
+        {
+          if (v < e->first && side[v] != side[e->first])
+            {
+              cut += e->second;
+            }
+        }
+    }
+  return cut;
+}
+
+/**
+ * \param [in] g The graph.
+ * \param [in] side The side of each vertex.
+ * \param [in] limit The largest weight of each side.
+ * \return How much the sides exceed their limit.
+ */
+uint64_t
+GetExcess (const Graph &g, const std::vector<uint8_t> &side, const uint64_t limit[2])
+{
+  uint64_t w[2] = { 0, 0 };
+  for (uint32_t v = 0; v < g.weight.size (); ++v)
+    {
+      w[side[v]] += g.weight[v];
+    }
+  return (w[0] > limit[0] ? w[0] - limit[0] : 0) + (w[1] > limit[1] ? w[1] - limit[1] : 0);
+}
+
+/**
+ * Improve a bisection by Fiduccia-Mattheyses passes.
+ * \param [in] g The graph.
+ * \param [in,out] side The side of each vertex.
+ * \param [in] limit The largest weight of each side.
+ */
+void
+Refine (const Graph &g, std::vector<uint8_t> &side, const uint64_t limit[2])
+{
+  uint32_t n = g.weight.size ();
+  for (uint32_t pass = 0; pass < 8; ++pass)
+    {
+      // gain of a vertex: decrease of the cut if it changes side.
+      std::vector<int64_t> gain (n, 0);
+      uint64_t w[2] = { 0, 0 };
+      std::set<std::pair<int64_t, uint32_t> > queue[2];
+      for (uint32_t v = 0; v < n; ++v)
+        {
+          w[side[v]] += g.weight[v];
+          for (std::vector<std::pair<uint32_t, uint64_t> >::const_iterator e = g.adj[v].begin ();
+               e != g.adj[v].end (); ++e)
+            {
+              gain[v] += side[e->first] != side[v] ? (int64_t) e->second : -(int64_t) e->second;
+            }
+          queue[side[v]].insert (std::make_pair (-gain[v], v));
+        }
+      std::vector<bool> locked (n, false);
+      std::vector<uint32_t> moves;
+      int64_t cut = GetCut (g, side);
+      uint64_t excess = (w[0] > limit[0] ? w[0] - limit[0] : 0) + (w[1] > limit[1] ? w[1] - limit[1] : 0);
+      int64_t bestCut = cut;
+      uint64_t bestExcess = excess;
+      uint32_t bestMoves = 0;
+
+      while (moves.size () < n && moves.size () < bestMoves + 50)
+        {
+          // the best vertex of each side, if moving it is allowed.
+          int from = -1;
+          for (int s = 0; s < 2; ++s)
+            {
+              if (queue[s].empty ())
+                {
+                  continue;
+                }
+              uint32_t v = queue[s].begin ()->second;
+              bool fits = w[1 - s] + g.weight[v] <= limit[1 - s];
+              bool relieves = w[s] > limit[s] && w[1 - s] + g.weight[v] < w[s];
+              if (!fits && !relieves)
+                {
+                  continue;
+                }
+              if (from < 0
+                  || gain[v] > gain[queue[from].begin ()->second]
+                  || (gain[v] == gain[queue[from].begin ()->second] && w[s] > w[from]))
+                {
+                  from = s;
+                }
+            }
+          if (from < 0)
+            {
+              break;
+            }
+          uint32_t v = queue[from].begin ()->second;
+          queue[from].erase (queue[from].begin ());
+          locked[v] = true;
+          side[v] = 1 - from;
+          w[from] -= g.weight[v];
+          w[1 - from] += g.weight[v];
+          cut -= gain[v];
+          moves.push_back (v);
+          for (std::vector<std::pair<uint32_t, uint64_t> >::const_iterator e = g.adj[v].begin ();
+               e != g.adj[v].end (); ++e)
+            {
+              uint32_t u = e->first;
+              if (locked[u])
+                {
+                  continue;
+                }
+              queue[side[u]].erase (std::make_pair (-gain[u], u));
+              gain[u] += side[u] == side[v] ? -2 * (int64_t) e->second : 2 * (int64_t) e->second;
+              queue[side[u]].insert (std::make_pair (-gain[u], u));
+            }
+          excess = (w[0] > limit[0] ? w[0] - limit[0] : 0) + (w[1] > limit[1] ? w[1] - limit[1] : 0);
+          if (excess < bestExcess || (excess == bestExcess && cut < bestCut))
+            {
+              bestCut = cut;
+              bestExcess = excess;
+              bestMoves = moves.size ();
+            }
+        }
+      for (uint32_t i = moves.size (); i > bestMoves; --i)
+        {
+          side[moves[i - 1]] = 1 - side[moves[i - 1]];
+        }
+      if (bestMoves == 0)
+        {
+          break;
+        }
+    }
+}
+
+/**
+ * Grow the first side from a seed, taking the vertex most connected to
+ * it each time, until it weighs its target.
+ * \param [in] g The graph.
+ * \param [in] target The target weight of the first side.
+ * \param [in] seed The first vertex.
+ * \return The side of each vertex.
+ */
+std::vector<uint8_t>
+Grow (const Graph &g, uint64_t target, uint32_t seed)
+{
+  uint32_t n = g.weight.size ();
+  std::vector<uint8_t> side (n, 1);
+  std::vector<int64_t> gain (n, 0);
+  std::vector<bool> reached (n, false);
+  for (uint32_t v = 0; v < n; ++v)
+    {
+      for (std::vector<std::pair<uint32_t, uint64_t> >::const_iterator e = g.adj[v].begin ();
+           e != g.adj[v].end (); ++e)
+        {
+          gain[v] -= e->second;
+        }
+    }
+  uint64_t w = 0;
+  uint32_t next = seed;
+  while (true)
+    {
+      if (w > 0 && w + g.weight[next] > target && w + g.weight[next] - target > target - w)
+        {
+          break;
+        }
+      side[next] = 0;
+      w += g.weight[next];
+      for (std::vector<std::pair<uint32_t, uint64_t> >::const_iterator e = g.adj[next].begin ();
+           e != g.adj[next].end (); ++e)
+        {
+          gain[e->first] += 2 * e->second;
+          reached[e->first] = true;
+        }
+      if (w >= target)
+        {
+          break;
+        }
+      // the best neighbour of the region, or any vertex if none is left.
+      uint32_t best = n;
+      for (uint32_t v = 0; v < n; ++v)
+        {
+          if (side[v] == 0)
+            {
+              continue;
+            }
+          if (best == n
+              || (reached[v] && !reached[best])
+              || (reached[v] == reached[best] && gain[v] > gain[best]))
+            {
+              best = v;
+            }
+        }
+      if (best == n)
+        {
+          break;
+        }
+      next = best;
+    }
+  return side;
+}
+
+/**
+ * Multilevel bisection.
+ * \param [in] g The graph.
+ * \param [in] target The target weight of the first side.
+ * \param [in] slack The allowed excess of each side.
+ * \return The side of each vertex.
+ */
+std::vector<uint8_t>
+Bisect (const Graph &g, uint64_t target, uint64_t slack)
+{
+  uint64_t maxVertex = 0;
+  for (uint32_t v = 0; v < g.weight.size (); ++v)
+    {
+      maxVertex = std::max (maxVertex, g.weight[v]);
+    }
+  std::vector<Graph> levels (1, g);
+  std::vector<std::vector<uint32_t> > maps;
+  uint64_t maxWeight = std::max (maxVertex, g.total / COARSEST_SIZE);
+  while (levels.back ().weight.size () > COARSEST_SIZE)
+    {
+      Graph coarse;
+      std::vector<uint32_t> map;
+      if (!Coarsen (levels.back (), maxWeight, coarse, map))
+        {
+          break;
+        }
+      levels.push_back (coarse);
+      maps.push_back (map);
+    }
+
+  uint64_t limit[2] = { target + slack, g.total - target + slack };
+  // coarse vertices are heavy: allow one of them as excess.
+  uint64_t coarseLimit[2] = { limit[0] + maxWeight, limit[1] + maxWeight };
+
+  const Graph &coarsest = levels.back ();
+  uint32_t n = coarsest.weight.size ();
+  std::vector<uint8_t> side;
+  uint64_t bestCut = 0;
+  uint64_t bestExcess = 0;
+  for (uint32_t i = 0; i < std::min (n, 8u); ++i)
+    {
+      std::vector<uint8_t> candidate = Grow (coarsest, target, i * n / std::min (n, 8u));
+      Refine (coarsest, candidate, levels.size () > 1 ? coarseLimit : limit);
+      uint64_t cut = GetCut (coarsest, candidate);
+      uint64_t excess = GetExcess (coarsest, candidate, limit);
+      if (side.empty () || excess < bestExcess || (excess == bestExcess && cut < bestCut))
+        {
+          side = candidate;
+          bestCut = cut;
+          bestExcess = excess;
+        }
+    }
+
+  for (uint32_t level = levels.size () - 1; level > 0; --level)
+    {
+      const std::vector<uint32_t> &map = maps[level - 1];
+      std::vector<uint8_t> fine (map.size ());
+      for (uint32_t v = 0; v < map.size (); ++v)
+        {
+          fine[v] = side[map[v]];
+        }
+      side.swap (fine);
+      Refine (levels[level - 1], side, level > 1 ? coarseLimit : limit);
+    }
+  return side;
+}
+
+/**
+ * Split a graph in k parts by recursive bisection.
+ * \param [in] g The graph.
+ * \param [in] vertices The vertices to split.
+ * \param [in] k The number of parts.
+ * \param [in] first The number of the first part.
+ * \param [in] imbalance The allowed imbalance.
+ * \param [out] part The part of each vertex.
+ */
+void
+RecursiveBisect (const Graph &g, const std::vector<uint32_t> &vertices, uint32_t k,
+                 uint32_t first, double imbalance, std::vector<uint32_t> &part)
+{
+  if (k == 1 || vertices.size () <= 1)
+    {
+      for (std::vector<uint32_t>::const_iterator v = vertices.begin (); v != vertices.end (); ++v)
+        {
+          part[*v] = first;
+        }
+      return;
+    }
+
+  // the subgraph induced by the vertices.
+  std::vector<uint32_t> local (g.weight.size (), UNMATCHED);
+  std::vector<uint64_t> weight;
+  for (uint32_t i = 0; i < vertices.size (); ++i)
+    {
+      local[vertices[i]] = i;
+      weight.push_back (g.weight[vertices[i]]);
+    }
+  std::map<std::pair<uint32_t, uint32_t>, uint64_t> edges;
+  for (uint32_t i = 0; i < vertices.size (); ++i)
+    {
+      const std::vector<std::pair<uint32_t, uint64_t> > &adj = g.adj[vertices[i]];
+      for (std::vector<std::pair<uint32_t, uint64_t> >::const_iterator e = adj.begin (); e != adj.end (); ++e)
+        {
+          if (local[e->first] != UNMATCHED && i < local[e->first])
+            {
+              AddEdge (edges, i, local[e->first], e->second);
+            }
+        }
+    }
+  Graph sub = MakeGraph (weight, edges);
+
+  uint32_t k0 = k / 2;
+  uint64_t target = sub.total * k0 / k;
+  uint64_t slack = (uint64_t) (imbalance * sub.total / k);
+  std::vector<uint8_t> side = Bisect (sub, target, slack);
+
+  std::vector<uint32_t> halves[2];
+  for (uint32_t i = 0; i < vertices.size (); ++i)
+    {
+      halves[side[i]].push_back (vertices[i]);
+    }
+  RecursiveBisect (g, halves[0], k0, first, imbalance, part);
+  RecursiveBisect (g, halves[1], k - k0, first + k0, imbalance, part);
+}
+
+/**
+ * \param [in,out] group The union-find forest.
+ * \param [in] i A node.
+ * \return The root of the tree of i.
+ */
+uint32_t
+FindRoot (std::vector<uint32_t> &group, uint32_t i)
+{
+  while (group[i] != i)
+    {
+      group[i] = group[group[i]];
+      i = group[i];
+    }
+  return i;
+}
+
+} // unnamed namespace
+
+TopologyPartitionHelper::TopologyPartitionHelper ()
+  : m_maxImbalance (0.1),
+    m_nPartitions (0),
+    m_lookahead (Time::Max ()),
+    m_nCutLinks (0)
+{
+}
+
+void
+TopologyPartitionHelper::SetMaxImbalance (double imbalance)
+{
+  NS_LOG_FUNCTION (this << imbalance);
+  m_maxImbalance = imbalance;
+}
+
+void
+TopologyPartitionHelper::Partition (uint32_t nParts)
+{
+  NS_LOG_FUNCTION (this << nParts);
+  NS_ABORT_MSG_IF (nParts == 0, "At least one partition is needed");
+
+  uint32_t nNodes = NodeList::GetNNodes ();
+  std::vector<uint32_t> fixed (nNodes);
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      fixed[i] = i;
+    }
+  m_links.clear ();
+  for (ChannelList::Iterator c = ChannelList::Begin (); c != ChannelList::End (); ++c)
+    {
+      std::vector<uint32_t> nodes;
+      for (uint32_t i = 0; i < (*c)->GetNDevices (); ++i)
+        {
+          Ptr<NetDevice> device = (*c)->GetDevice (i);
+          if (device != 0 && device->GetNode () != 0)
+            {
+              nodes.push_back (device->GetNode ()->GetId ());
+            }
+        }
+      if (nodes.size () < 2)
+        {
+          continue;
+        }
+      Ptr<PointToPointChannel> p2p = DynamicCast<PointToPointChannel> (*c);
+      if (p2p != 0 && nodes.size () == 2)
+        {
+          // the jitter is drawn from one stream for both directions.
+          BooleanValue jitter (false);
+          p2p->GetAttributeFailSafe ("UseJitter", jitter);
+          TimeValue delay;
+          p2p->GetAttribute ("Delay", delay);
+          if (delay.Get ().IsStrictlyPositive () && !jitter.Get ())
+            {
+              Link link;
+              link.a = nodes[0];
+              link.b = nodes[1];
+              link.delay = delay.Get ();
+              link.channel = p2p;
+              m_links.push_back (link);
+              continue;
+            }
+        }
+      for (uint32_t i = 1; i < nodes.size (); ++i)
+        {
+          fixed[FindRoot (fixed, nodes[i])] = FindRoot (fixed, nodes[0]);
+        }
+    }
+
+  std::vector<uint64_t> nodeWeight (nNodes);
+  uint64_t total = 0;
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      nodeWeight[i] = 1 + NodeList::GetNode (i)->GetNDevices ();
+      total += nodeWeight[i];
+    }
+
+  // the candidate lookaheads, largest first; Time::Max () keeps every
+  // link whole and only splits disconnected pieces.
+  std::vector<Time> thresholds;
+  thresholds.push_back (Time::Max ());
+  for (std::vector<Link>::const_iterator l = m_links.begin (); l != m_links.end (); ++l)
+    {
+      thresholds.push_back (l->delay);
+    }
+  std::sort (thresholds.begin (), thresholds.end ());
+  thresholds.erase (std::unique (thresholds.begin (), thresholds.end ()), thresholds.end ());
+  std::reverse (thresholds.begin (), thresholds.end ());
+
+  double bestImbalance = 0;
+  m_partition.assign (nNodes, 0);
+  m_nPartitions = nNodes > 0 ? 1 : 0;
+  for (uint32_t t = 0; t < thresholds.size (); ++t)
+    {
+      bool last = t + 1 == thresholds.size ();
+      std::vector<uint32_t> group = fixed;
+      for (std::vector<Link>::const_iterator l = m_links.begin (); l != m_links.end (); ++l)
+        {
+          if (l->delay < thresholds[t])
+            {
+              group[FindRoot (group, l->a)] = FindRoot (group, l->b);
+            }
+        }
+      std::vector<uint32_t> vertexOfNode (nNodes);
+      std::vector<uint32_t> vertexOfRoot (nNodes, UNMATCHED);
+      std::vector<uint64_t> weight;
+      for (uint32_t i = 0; i < nNodes; ++i)
+        {
+          uint32_t root = FindRoot (group, i);
+          if (vertexOfRoot[root] == UNMATCHED)
+            {
+              vertexOfRoot[root] = weight.size ();
+              weight.push_back (0);
+            }
+          vertexOfNode[i] = vertexOfRoot[root];
+          weight[vertexOfNode[i]] += nodeWeight[i];
+        }
+      if (weight.size () < nParts && !last)
+        {
+          continue;
+        }
+      uint32_t k = std::min<uint32_t> (nParts, weight.size ());
+      if (k <= 1)
+        {
+          continue;
+        }
+
+      std::map<std::pair<uint32_t, uint32_t>, uint64_t> edges;
+      for (std::vector<Link>::const_iterator l = m_links.begin (); l != m_links.end (); ++l)
+        {
+          AddEdge (edges, vertexOfNode[l->a], vertexOfNode[l->b], 1);
+        }
+      Graph g = MakeGraph (weight, edges);
+      std::vector<uint32_t> vertices (weight.size ());
+      for (uint32_t v = 0; v < vertices.size (); ++v)
+        {
+          vertices[v] = v;
+        }
+      std::vector<uint32_t> part (weight.size (), 0);
+      RecursiveBisect (g, vertices, k, 0, m_maxImbalance, part);
+
+      // number the partitions in order of their first node, skipping
+      // the empty ones.
+      std::vector<uint32_t> number (k, UNMATCHED);
+      std::vector<uint64_t> partWeight;
+      std::vector<uint32_t> partition (nNodes);
+      for (uint32_t i = 0; i < nNodes; ++i)
+        {
+          uint32_t p = part[vertexOfNode[i]];
+          if (number[p] == UNMATCHED)
+            {
+              number[p] = partWeight.size ();
+              partWeight.push_back (0);
+            }
+          partition[i] = number[p];
+          partWeight[partition[i]] += nodeWeight[i];
+        }
+      uint64_t heaviest = *std::max_element (partWeight.begin (), partWeight.end ());
+      double imbalance = (double) heaviest * partWeight.size () / total - 1;
+      NS_LOG_LOGIC ("lookahead " << thresholds[t] << ": " << partWeight.size ()
+                    << " partitions, imbalance " << imbalance);
+      if (m_nPartitions <= 1 || imbalance < bestImbalance)
+        {
+          m_partition = partition;
+          m_nPartitions = partWeight.size ();
+          bestImbalance = imbalance;
+        }
+      if (imbalance <= m_maxImbalance && partWeight.size () == k)
+        {
+          break;
+        }
+    }
+
+  m_lookahead = Time::Max ();
+  m_nCutLinks = 0;
+  for (std::vector<Link>::const_iterator l = m_links.begin (); l != m_links.end (); ++l)
+    {
+      if (m_partition[l->a] != m_partition[l->b])
+        {
+          m_lookahead = std::min (m_lookahead, l->delay);
+          m_nCutLinks++;
+        }
+    }
+  NS_LOG_INFO (nNodes << " nodes in " << m_nPartitions << " partitions, "
+               << m_nCutLinks << " cut links, lookahead " << m_lookahead);
+}
+
+uint32_t
+TopologyPartitionHelper::GetNPartitions (void) const
+{
+  return m_nPartitions;
+}
+
+uint32_t
+TopologyPartitionHelper::GetPartition (uint32_t nodeId) const
+{
+  NS_ASSERT (nodeId < m_partition.size ());
+  return m_partition[nodeId];
+}
+
+Time
+TopologyPartitionHelper::GetLookahead (void) const
+{
+  return m_lookahead;
+}
+
+uint32_t
+TopologyPartitionHelper::GetNCutLinks (void) const
+{
+  return m_nCutLinks;
+}
+
+void
+TopologyPartitionHelper::Apply (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t i = 0; i < m_partition.size (); ++i)
+    {
+      NodeList::GetNode (i)->SetAttribute ("SystemId", UintegerValue (m_partition[i]));
+    }
+
+  // the remote channels only work in a distributed simulation; without
+  // MPI, the system ids are kept for the parallel simulators which use
+  // them, and the links stay local
+  if (!MpiInterface::IsEnabled ())
+    {
+      NS_LOG_LOGIC ("MPI is not enabled, the links stay local");
+      return;
+    }
+
+  uint32_t rank = MpiInterface::GetSystemId ();
+  for (std::vector<Link>::iterator l = m_links.begin (); l != m_links.end (); ++l)
+    {
+      if ((m_partition[l->a] == rank && m_partition[l->b] == rank)
+          || DynamicCast<PointToPointRemoteChannel> (l->channel) != 0)
+        {
+          continue;
+        }
+      Ptr<PointToPointChannel> old = DynamicCast<PointToPointChannel> (l->channel);
+      Ptr<PointToPointNetDevice> devA = old->GetPointToPointDevice (0);
+      Ptr<PointToPointNetDevice> devB = old->GetPointToPointDevice (1);
+      ObjectFactory factory ("ns3::PointToPointRemoteChannel");
+      factory.Set ("Delay", TimeValue (l->delay));
+      Ptr<PointToPointRemoteChannel> channel = factory.Create<PointToPointRemoteChannel> ();
+      Ptr<MpiReceiver> mpiRecA = CreateObject<MpiReceiver> ();
+      Ptr<MpiReceiver> mpiRecB = CreateObject<MpiReceiver> ();
+      mpiRecA->SetReceiveCallback (MakeCallback (&PointToPointNetDevice::Receive, devA));
+      mpiRecB->SetReceiveCallback (MakeCallback (&PointToPointNetDevice::Receive, devB));
+      devA->AggregateObject (mpiRecA);
+      devB->AggregateObject (mpiRecB);
+      devA->Attach (channel);
+      devB->Attach (channel);
+      // the old channel still points to the devices: drop it from the
+      // ChannelList, where the new one takes its id
+      ChannelList::Replace (old, channel);
+      l->channel = channel;
+    }
+}
+
+} // namespace ns3
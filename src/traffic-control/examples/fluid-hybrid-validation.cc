@@ -0,0 +1,226 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Compare a dumbbell simulated packet by packet with the same dumbbell
+ * where the elephant flows are replaced by a FluidFlowModel.
+ *
+ *   client ----+                         +---- server
+ *   client ---- SW0 ====== RED ====== SW1 ---- server
+ *   client ----+                         +---- server
+ *
+ * The bottleneck runs RED with the DCTCP/ATP marking configuration of
+ * scratch/atp-test.cc.  nElephants long-lived flows and nMice packet flows
+ * share it.  With --hybrid=0 all the flows are TCP sockets; with
+ * --hybrid=1 the elephants are fluid, and only the mice are simulated
+ * packet by packet, behind the fluid backlog.  The program prints the
+ * goodput of both classes, the mean bottleneck occupancy, the fraction of
+ * marked elephant bytes and the wall clock time of the run.
+ */
+
+#include <iostream>
+#include <vector>
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/traffic-control-module.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("FluidHybridValidation");
+
+uint64_t g_queueSamples = 0;
+double g_queueBytes = 0;
+
+void
+SampleQueue (Ptr<QueueDisc> queue)
+{
+  g_queueBytes += queue->GetNBytes () + queue->GetFluidBacklog ();
+  g_queueSamples++;
+  Simulator::Schedule (MilliSeconds (1), &SampleQueue, queue);
+}
+
+int
+main (int argc, char *argv[])
+{
+  bool hybrid = true;
+  bool useAtp = true;
+  uint32_t nElephants = 8;
+  uint32_t nMice = 2;
+  double duration = 2;
+  std::string dataRate = "10Mbps";
+  std::string delay = "50us";
+  uint32_t packetSize = 512;
+  uint32_t queueSize = 128;
+  uint32_t threshold = 20;
+  std::string step = "20us";
+
+  CommandLine cmd;
+  cmd.AddValue ("hybrid", "<0/1> to simulate the elephants as fluid flows", hybrid);
+  cmd.AddValue ("useAtp", "<0/1> to use ATP instead of DCTCP-style ECN NewReno", useAtp);
+  cmd.AddValue ("nElephants", "Number of long-lived flows", nElephants);
+  cmd.AddValue ("nMice", "Number of flows always simulated as packets", nMice);
+  cmd.AddValue ("duration", "Time the flows send, in seconds", duration);
+  cmd.AddValue ("dataRate", "Rate of every link", dataRate);
+  cmd.AddValue ("delay", "Delay of every link", delay);
+  cmd.AddValue ("step", "Integration step of the fluid model", step);
+  cmd.Parse (argc, argv);
+
+  GlobalValue::Bind ("ChecksumEnabled", BooleanValue (false));
+  Config::SetDefault ("ns3::RedQueueDisc::Mode", StringValue ("QUEUE_MODE_PACKETS"));
+  Config::SetDefault ("ns3::RedQueueDisc::MeanPktSize", UintegerValue (packetSize));
+  Config::SetDefault ("ns3::RedQueueDisc::UseMarkP", BooleanValue (true));
+  Config::SetDefault ("ns3::RedQueueDisc::MarkP", DoubleValue (2.0));
+  Config::SetDefault ("ns3::RedQueueDisc::MinTh", DoubleValue (threshold));
+  Config::SetDefault ("ns3::RedQueueDisc::MaxTh", DoubleValue (threshold));
+  Config::SetDefault ("ns3::RedQueueDisc::QueueLimit", UintegerValue (queueSize));
+  Config::SetDefault ("ns3::RedQueueDisc::UseEcn", BooleanValue (true));
+  Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (packetSize));
+  Config::SetDefault ("ns3::TcpSocket::DelAckCount", UintegerValue (1));
+  Config::SetDefault ("ns3::TcpSocketBase::UseEcn", BooleanValue (true));
+  Config::SetDefault ("ns3::TcpL4Protocol::SocketType", StringValue ("ns3::TcpNewReno"));
+  if (useAtp)
+    {
+      Config::SetDefault ("ns3::TcpL4Protocol::SocketBaseType", TypeIdValue (TypeId::LookupByName ("ns3::AtpSocket")));
+      Config::SetDefault ("ns3::AtpSocket::AtpWeight", DoubleValue (1.0 / 16));
+    }
+
+  uint32_t nPacketFlows = hybrid ? nMice : nMice + nElephants;
+  NodeContainer clients;
+  clients.Create (nPacketFlows);
+  NodeContainer switches;
+  switches.Create (2);
+  NodeContainer server;
+  server.Create (1);
+  InternetStackHelper internet;
+  internet.InstallAll ();
+
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue (dataRate));
+  p2p.SetChannelAttribute ("Delay", StringValue (delay));
+  TrafficControlHelper tchPfifo;
+  uint16_t handle = tchPfifo.SetRootQueueDisc ("ns3::PfifoFastQueueDisc", "Limit", UintegerValue (queueSize));
+  tchPfifo.AddInternalQueues (handle, 3, "ns3::DropTailQueue", "MaxPackets", UintegerValue (queueSize));
+  TrafficControlHelper tchRed;
+  tchRed.SetRootQueueDisc ("ns3::RedQueueDisc", "LinkBandwidth", StringValue (dataRate),
+                           "LinkDelay", StringValue (delay));
+
+  Ipv4AddressHelper ipv4 ("10.1.1.0", "255.255.255.0");
+  for (uint32_t i = 0; i < nPacketFlows; i++)
+    {
+      NetDeviceContainer devs = p2p.Install (clients.Get (i), switches.Get (0));
+      tchPfifo.Install (devs);
+      ipv4.Assign (devs);
+      ipv4.NewNetwork ();
+    }
+  NetDeviceContainer serverDevs = p2p.Install (switches.Get (1), server.Get (0));
+  tchPfifo.Install (serverDevs);
+  Ipv4Address serverAddress = ipv4.Assign (serverDevs).GetAddress (1);
+  ipv4.NewNetwork ();
+  NetDeviceContainer bottleneckDevs = p2p.Install (switches);
+  QueueDiscContainer queueDiscs = tchRed.Install (bottleneckDevs);
+  ipv4.Assign (bottleneckDevs);
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  // One sink per flow, the elephants first
+  Time start = MilliSeconds (20);
+  Time stop = start + Seconds (duration);
+  std::vector<Ptr<PacketSink> > sinks;
+  for (uint32_t i = 0; i < nPacketFlows; i++)
+    {
+      uint16_t port = 50000 + i;
+      PacketSinkHelper sinkHelper ("ns3::TcpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), port));
+      ApplicationContainer sinkApp = sinkHelper.Install (server);
+      sinks.push_back (DynamicCast<PacketSink> (sinkApp.Get (0)));
+      BulkSendHelper source ("ns3::TcpSocketFactory", InetSocketAddress (serverAddress, port));
+      source.SetAttribute ("SendSize", UintegerValue (packetSize));
+      ApplicationContainer sourceApp = source.Install (clients.Get (i));
+      sourceApp.Start (start);
+      sourceApp.Stop (stop);
+    }
+
+  // The fluid elephants cross the bottleneck; their base RTT is the
+  // propagation delay of the three hops, plus the transmission of a
+  // segment on the two other hops and of an ACK on all three.
+  Ptr<FluidFlowModel> fluid;
+  std::vector<uint32_t> fluidFlows;
+  uint32_t wireSize = packetSize + 40 + 2; // TCP/IP and PPP headers
+  uint32_t ackSize = 40 + 2;
+  if (hybrid)
+    {
+      fluid = CreateObject<FluidFlowModel> ();
+      fluid->SetAttribute ("Step", StringValue (step));
+      fluid->SetAttribute ("SegmentSize", UintegerValue (wireSize));
+      fluid->SetAttribute ("InitialCwnd", UintegerValue (1));
+      fluid->SetAttribute ("Weight", DoubleValue (1.0 / 16));
+      uint32_t link = fluid->AddLink (queueDiscs.Get (0), threshold * wireSize, queueSize * wireSize);
+      DataRate rate (dataRate);
+      Time baseRtt = 6 * Time (delay) + 2 * rate.CalculateBytesTxTime (wireSize)
+        + 3 * rate.CalculateBytesTxTime (ackSize);
+      std::vector<uint32_t> path (1, link);
+      for (uint32_t i = 0; i < nElephants; i++)
+        {
+          fluidFlows.push_back (fluid->AddFlow (path, baseRtt, start, stop));
+        }
+    }
+
+  Simulator::Schedule (start, &SampleQueue, queueDiscs.Get (0));
+  Simulator::Stop (stop);
+  SystemWallClockMs clock;
+  clock.Start ();
+  Simulator::Run ();
+  int64_t elapsed = clock.End ();
+
+  // goodput of the elephants and of the mice, in Mbps
+  double elephantBytes = 0;
+  double miceBytes = 0;
+  double markedBytes = 0;
+  for (uint32_t i = 0; i < nPacketFlows; i++)
+    {
+      if (!hybrid && i < nElephants)
+        {
+          elephantBytes += sinks[i]->GetTotalRx ();
+        }
+      else
+        {
+          miceBytes += sinks[i]->GetTotalRx ();
+        }
+    }
+  for (uint32_t i = 0; i < fluidFlows.size (); i++)
+    {
+      elephantBytes += fluid->GetDeliveredBytes (fluidFlows[i]) * packetSize / wireSize;
+      markedBytes += fluid->GetMarkedBytes (fluidFlows[i]);
+    }
+  RedQueueDisc::Stats st = StaticCast<RedQueueDisc> (queueDiscs.Get (0))->GetStats ();
+  double sent = elephantBytes / packetSize + miceBytes / packetSize;
+  double marked = markedBytes / wireSize + st.unforcedMark;
+
+  std::cout << (hybrid ? "hybrid" : "packet") << " mode, "
+            << nElephants << " elephants, " << nMice << " mice" << std::endl;
+  std::cout << "\t elephants " << elephantBytes * 8 / duration / 1e6 << " Mbps" << std::endl;
+  std::cout << "\t mice " << miceBytes * 8 / duration / 1e6 << " Mbps ("
+            << (nMice ? miceBytes * 8 / duration / 1e6 / nMice : 0) << " Mbps per flow)" << std::endl;
+  std::cout << "\t mean queue " << g_queueBytes / std::max<uint64_t> (g_queueSamples, 1) / wireSize
+            << " packets" << std::endl;
+  std::cout << "\t marked " << marked / std::max (sent, 1.0) << " of the segments" << std::endl;
+  std::cout << "\t " << st.unforcedDrop + st.forcedDrop << " packets dropped" << std::endl;
+  std::cout << "\t wall clock " << elapsed << " ms" << std::endl;
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,376 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/net-device.h"
+#include "fluid-flow-model.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FluidFlowModel");
+
+NS_OBJECT_ENSURE_REGISTERED (FluidFlowModel);
+
+TypeId FluidFlowModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FluidFlowModel")
+    .SetParent<Object> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<FluidFlowModel> ()
+    .AddAttribute ("Step",
+                   "The integration step, to be set before adding flows",
+                   TimeValue (MicroSeconds (10)),
+                   MakeTimeAccessor (&FluidFlowModel::m_step),
+                   MakeTimeChecker (NanoSeconds (1)))
+    .AddAttribute ("SegmentSize",
+                   "The segment size of the flows",
+                   UintegerValue (1448),
+                   MakeUintegerAccessor (&FluidFlowModel::m_segmentSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("InitialCwnd",
+                   "The initial window of the flows, in segments",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&FluidFlowModel::m_initialCwnd),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Weight",
+                   "The weight of the marks in α (g)",
+                   DoubleValue (1.0 / 16),
+                   MakeDoubleAccessor (&FluidFlowModel::m_g),
+                   MakeDoubleChecker<double> (0, 1))
+  ;
+  return tid;
+}
+
+FluidFlowModel::FluidFlowModel ()
+  : m_history (2),
+    m_nSteps (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FluidFlowModel::~FluidFlowModel ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+FluidFlowModel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  Simulator::Cancel (m_stepEvent);
+  m_links.clear ();
+  m_flows.clear ();
+  Object::DoDispose ();
+}
+
+uint32_t
+FluidFlowModel::AddLink (Ptr<QueueDisc> qd, uint32_t markThreshold, uint32_t limit)
+{
+  NS_LOG_FUNCTION (this << qd << markThreshold << limit);
+  Ptr<NetDevice> device = qd->GetNetDevice ();
+  NS_ABORT_MSG_UNLESS (device, "The queue disc is not installed on a device");
+  DataRateValue rate;
+  bool ok = device->GetAttributeFailSafe ("DataRate", rate);
+  NS_ABORT_MSG_UNLESS (ok, "The device of the queue disc has no DataRate attribute");
+  uint32_t index = AddLink (rate.Get (), markThreshold, limit);
+  Link &link = m_links[index];
+  link.qd = qd;
+  link.lastReceived = qd->GetTotalReceivedBytes ();
+  link.lastDropped = qd->GetTotalDroppedBytes ();
+  link.lastQueued = qd->GetNBytes ();
+  return index;
+}
+
+uint32_t
+FluidFlowModel::AddLink (DataRate rate, uint32_t markThreshold, uint32_t limit)
+{
+  NS_LOG_FUNCTION (this << rate << markThreshold << limit);
+  NS_ABORT_MSG_IF (rate.GetBitRate () == 0, "A link needs a capacity");
+  Link link;
+  link.capacity = rate.GetBitRate () / 8.0;
+  link.markThreshold = markThreshold;
+  link.limit = limit;
+  link.backlog = 0;
+  link.arrivals = 0;
+  link.lastReceived = 0;
+  link.lastDropped = 0;
+  link.lastQueued = 0;
+  link.transmitting = 0;
+  link.dropped = 0;
+  link.mark.assign (m_history, 0);
+  link.drop.assign (m_history, 0);
+  m_links.push_back (link);
+  return m_links.size () - 1;
+}
+
+uint32_t
+FluidFlowModel::AddFlow (const std::vector<uint32_t> &path, Time baseRtt, Time start, Time stop)
+{
+  NS_LOG_FUNCTION (this << baseRtt << start << stop);
+  NS_ABORT_MSG_IF (path.empty (), "A flow needs a path");
+  NS_ABORT_MSG_UNLESS (baseRtt.IsStrictlyPositive (), "A flow needs a positive RTT");
+
+  double maxRtt = baseRtt.GetSeconds ();
+  for (std::vector<uint32_t>::const_iterator it = path.begin (); it != path.end (); ++it)
+    {
+      NS_ABORT_MSG_UNLESS (*it < m_links.size (), "Unknown link " << *it);
+      maxRtt += m_links[*it].limit / m_links[*it].capacity;
+    }
+  ResizeHistory (maxRtt);
+
+  Flow flow;
+  flow.path = path;
+  flow.baseRtt = baseRtt.GetSeconds ();
+  flow.start = start;
+  flow.stop = stop;
+  flow.cwnd = m_initialCwnd * m_segmentSize;
+  flow.alpha = 1;
+  flow.rate = 0;
+  flow.slowStart = true;
+  flow.delivered = 0;
+  flow.marked = 0;
+  m_flows.push_back (flow);
+
+  if (!m_stepEvent.IsRunning ())
+    {
+      Time delay = std::max (start - Simulator::Now (), Time (0));
+      m_stepEvent = Simulator::Schedule (delay, &FluidFlowModel::DoStep, this);
+    }
+  return m_flows.size () - 1;
+}
+
+void
+FluidFlowModel::ResizeHistory (double rtt)
+{
+  NS_LOG_FUNCTION (this << rtt);
+  uint32_t history = static_cast<uint32_t> (rtt / m_step.GetSeconds ()) + 2;
+  if (history <= m_history)
+    {
+      return;
+    }
+  // keep the signals of the last steps where DoStep will look for them
+  for (std::vector<Link>::iterator link = m_links.begin (); link != m_links.end (); ++link)
+    {
+      std::vector<float> mark (history, 0);
+      std::vector<float> drop (history, 0);
+      for (uint64_t s = m_nSteps - std::min<uint64_t> (m_nSteps, m_history); s < m_nSteps; s++)
+        {
+          mark[s % history] = link->mark[s % m_history];
+          drop[s % history] = link->drop[s % m_history];
+        }
+      link->mark.swap (mark);
+      link->drop.swap (drop);
+    }
+  m_history = history;
+}
+
+double
+FluidFlowModel::GetQueueDelay (const Link &link) const
+{
+  double queued = link.backlog;
+  if (link.qd)
+    {
+      queued += link.qd->GetNBytes ();
+    }
+  return queued / link.capacity;
+}
+
+void
+FluidFlowModel::DoStep (void)
+{
+  NS_LOG_FUNCTION (this);
+  Time now = Simulator::Now ();
+  double dt = m_step.GetSeconds ();
+  uint32_t slot = m_nSteps % m_history;
+  bool active = false;
+
+  // Sending rates
+  for (std::vector<Link>::iterator link = m_links.begin (); link != m_links.end (); ++link)
+    {
+      link->arrivals = 0;
+    }
+  for (std::vector<Flow>::iterator flow = m_flows.begin (); flow != m_flows.end (); ++flow)
+    {
+      flow->rate = 0;
+      if (!flow->stop.IsZero () && now >= flow->stop)
+        {
+          continue;
+        }
+      active = true;
+      if (now < flow->start)
+        {
+          continue;
+        }
+      double rtt = flow->baseRtt;
+      for (std::vector<uint32_t>::const_iterator it = flow->path.begin (); it != flow->path.end (); ++it)
+        {
+          rtt += GetQueueDelay (m_links[*it]);
+        }
+      flow->rate = flow->cwnd / rtt;
+      for (std::vector<uint32_t>::const_iterator it = flow->path.begin (); it != flow->path.end (); ++it)
+        {
+          m_links[*it].arrivals += flow->rate * dt;
+        }
+    }
+
+  // Queues: the packets are transmitted first, the fluid takes the rest
+  for (std::vector<Link>::iterator link = m_links.begin (); link != m_links.end (); ++link)
+    {
+      double packets = 0;
+      if (link->qd)
+        {
+          // bytes handed to the device, which keep the link busy for
+          // their transmission time
+          uint32_t queued = link->qd->GetNBytes ();
+          uint32_t received = link->qd->GetTotalReceivedBytes ();
+          uint32_t dropped = link->qd->GetTotalDroppedBytes ();
+          link->transmitting += (received - link->lastReceived) - (dropped - link->lastDropped)
+            + static_cast<double> (link->lastQueued) - queued;
+          link->lastReceived = received;
+          link->lastDropped = dropped;
+          link->lastQueued = queued;
+          packets = queued;
+        }
+      double capacity = link->capacity * dt;
+      double busy = std::min (link->transmitting, capacity);
+      link->transmitting -= busy;
+      double fluid = link->backlog + link->arrivals;
+      link->backlog = fluid - std::min (fluid, capacity - busy);
+
+      float drop = 0;
+      double room = std::max (link->limit - packets, 0.0);
+      if (link->backlog > room)
+        {
+          double excess = link->backlog - room;
+          link->dropped += static_cast<uint64_t> (excess);
+          drop = link->arrivals > 0 ? std::min (excess / link->arrivals, 1.0) : 0;
+          link->backlog = room;
+        }
+      link->mark[slot] = link->backlog + packets > link->markThreshold ? 1 : 0;
+      link->drop[slot] = drop;
+      active = active || link->backlog > 0;
+
+      if (link->qd)
+        {
+          link->qd->SetFluidBacklog (static_cast<uint32_t> (link->backlog));
+          // the packets wait for the fluid queued in front of them
+          link->qd->SetFluidDelay (Seconds (link->backlog / link->capacity));
+        }
+    }
+
+  // Windows, driven by the signals of one RTT ago
+  for (std::vector<Flow>::iterator flow = m_flows.begin (); flow != m_flows.end (); ++flow)
+    {
+      if (flow->rate == 0)
+        {
+          continue;
+        }
+      double rtt = flow->cwnd / flow->rate;
+      uint32_t delay = std::min (static_cast<uint32_t> (rtt / dt + 0.5), m_history - 1);
+      uint32_t past = (m_nSteps + m_history - delay) % m_history;
+      double notMarked = 1;
+      double notDropped = 1;
+      for (std::vector<uint32_t>::const_iterator it = flow->path.begin (); it != flow->path.end (); ++it)
+        {
+          notMarked *= 1 - m_links[*it].mark[past];
+          notDropped *= 1 - m_links[*it].drop[past];
+        }
+      double p = 1 - notMarked;
+      double d = 1 - notDropped;
+
+      flow->alpha += m_g / rtt * (p - flow->alpha) * dt;
+      if (p > 0 || d > 0)
+        {
+          flow->slowStart = false;
+        }
+      if (flow->slowStart)
+        {
+          flow->cwnd *= std::pow (2.0, dt / rtt);
+        }
+      else
+        {
+          flow->cwnd += (m_segmentSize / rtt
+                         - flow->cwnd * flow->alpha / (2 * rtt) * p
+                         - flow->cwnd / 2 * flow->rate * d / m_segmentSize) * dt;
+        }
+      flow->cwnd = std::max (flow->cwnd, 2.0 * m_segmentSize);
+      flow->delivered += flow->rate * (1 - d) * dt;
+      flow->marked += flow->rate * p * dt;
+    }
+
+  m_nSteps++;
+  if (active)
+    {
+      m_stepEvent = Simulator::Schedule (m_step, &FluidFlowModel::DoStep, this);
+    }
+}
+
+DataRate
+FluidFlowModel::GetRate (uint32_t flow) const
+{
+  NS_ASSERT (flow < m_flows.size ());
+  return DataRate (static_cast<uint64_t> (m_flows[flow].rate * 8));
+}
+
+uint32_t
+FluidFlowModel::GetCwnd (uint32_t flow) const
+{
+  NS_ASSERT (flow < m_flows.size ());
+  return static_cast<uint32_t> (m_flows[flow].cwnd);
+}
+
+double
+FluidFlowModel::GetAlpha (uint32_t flow) const
+{
+  NS_ASSERT (flow < m_flows.size ());
+  return m_flows[flow].alpha;
+}
+
+uint64_t
+FluidFlowModel::GetDeliveredBytes (uint32_t flow) const
+{
+  NS_ASSERT (flow < m_flows.size ());
+  return static_cast<uint64_t> (m_flows[flow].delivered);
+}
+
+uint64_t
+FluidFlowModel::GetMarkedBytes (uint32_t flow) const
+{
+  NS_ASSERT (flow < m_flows.size ());
+  return static_cast<uint64_t> (m_flows[flow].marked);
+}
+
+uint32_t
+FluidFlowModel::GetBacklog (uint32_t link) const
+{
+  NS_ASSERT (link < m_links.size ());
+  return static_cast<uint32_t> (m_links[link].backlog);
+}
+
+uint64_t
+FluidFlowModel::GetDroppedBytes (uint32_t link) const
+{
+  NS_ASSERT (link < m_links.size ());
+  return m_links[link].dropped;
+}
+
+} // namespace ns3
@@ -0,0 +1,223 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLUID_FLOW_MODEL_H
+#define FLUID_FLOW_MODEL_H
+
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
+#include "ns3/event-id.h"
+#include "ns3/queue-disc.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup traffic-control
+ *
+ * \brief Flow-level model of long-lived DCTCP/ATP flows
+ *
+ * Each flow is a rate process x = W / R instead of a sequence of packets.
+ * Every Step, the windows follow the DCTCP fluid model (Alizadeh et al.,
+ * "Analysis of DCTCP", SIGMETRICS 2011):
+ *
+ *   dα/dt = g / R (p(t - R) - α)
+ *   dW/dt = MSS / R - W α / (2 R) p(t - R) - W / 2 x d(t - R) / MSS
+ *
+ * where p is the fraction of time the queues of the path were above their
+ * marking threshold and d the fraction of the fluid dropped when they were
+ * full.  A flow is in slow start (its window doubles every R) until it
+ * receives its first mark or drop.  AtpSocket updates α exactly like
+ * DCTCP, so the same model applies to ATP flows.
+ *
+ * The links are fed by the fluid flows and, when a link is built on a queue
+ * disc, by the packets going through that queue disc.  The fluid and the
+ * packets share the link: the packets are transmitted at the link rate and
+ * the fluid is served with the capacity they leave.  The model couples the
+ * two levels by
+ * - setting the fluid backlog of the queue disc (QueueDisc::SetFluidBacklog),
+ *   which RedQueueDisc counts in its occupancy, so that packets are marked
+ *   and dropped as if the fluid was queued in front of them;
+ * - setting the time to drain the fluid backlog (QueueDisc::SetFluidDelay),
+ *   for which the queue disc holds the packets it enqueues, so that they
+ *   wait for the fluid queued in front of them as in a FIFO.  Only the
+ *   packets going through the queue disc are delayed: the channel, and the
+ *   packets sent in the other direction, are left alone.
+ *
+ * The links of a path all see the sending rate of the flow: a bottleneck
+ * does not smooth the traffic it forwards to the next links.
+ */
+class FluidFlowModel : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief FluidFlowModel Constructor
+   */
+  FluidFlowModel ();
+
+  virtual ~FluidFlowModel ();
+
+  /**
+   * \brief Add a link carrying packets through a queue disc
+   *
+   * The capacity of the link is the DataRate attribute of the device the
+   * queue disc is installed on.
+   *
+   * \param qd the queue disc
+   * \param markThreshold the occupancy above which the fluid is marked, in bytes
+   * \param limit the size of the buffer, in bytes
+   * \return the index of the link
+   */
+  uint32_t AddLink (Ptr<QueueDisc> qd, uint32_t markThreshold, uint32_t limit);
+
+  /**
+   * \brief Add a link carrying only fluid flows
+   * \param rate the capacity of the link
+   * \param markThreshold the occupancy above which the fluid is marked, in bytes
+   * \param limit the size of the buffer, in bytes
+   * \return the index of the link
+   */
+  uint32_t AddLink (DataRate rate, uint32_t markThreshold, uint32_t limit);
+
+  /**
+   * \brief Add a flow
+   * \param path the indices of the links the flow crosses
+   * \param baseRtt the round trip time of the flow with empty queues
+   * \param start the time the flow starts sending
+   * \param stop the time the flow stops sending, zero to never stop
+   * \return the index of the flow
+   */
+  uint32_t AddFlow (const std::vector<uint32_t> &path, Time baseRtt, Time start, Time stop);
+
+  /**
+   * \param flow the index of the flow
+   * \return the sending rate of the flow
+   */
+  DataRate GetRate (uint32_t flow) const;
+
+  /**
+   * \param flow the index of the flow
+   * \return the congestion window of the flow, in bytes
+   */
+  uint32_t GetCwnd (uint32_t flow) const;
+
+  /**
+   * \param flow the index of the flow
+   * \return the DCTCP α of the flow
+   */
+  double GetAlpha (uint32_t flow) const;
+
+  /**
+   * \param flow the index of the flow
+   * \return the bytes delivered by the flow
+   */
+  uint64_t GetDeliveredBytes (uint32_t flow) const;
+
+  /**
+   * \param flow the index of the flow
+   * \return the bytes of the flow which were marked
+   */
+  uint64_t GetMarkedBytes (uint32_t flow) const;
+
+  /**
+   * \param link the index of the link
+   * \return the fluid backlog of the link, in bytes
+   */
+  uint32_t GetBacklog (uint32_t link) const;
+
+  /**
+   * \param link the index of the link
+   * \return the bytes of fluid dropped by the link
+   */
+  uint64_t GetDroppedBytes (uint32_t link) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /// A link, with the congestion signals of the last steps
+  struct Link
+  {
+    Ptr<QueueDisc> qd;          //!< Queue disc of the packets, or 0
+    double capacity;            //!< Capacity, in bytes/s
+    double markThreshold;       //!< Marking threshold, in bytes
+    double limit;               //!< Buffer size, in bytes
+    double backlog;             //!< Fluid backlog, in bytes
+    double arrivals;            //!< Fluid arrivals during the step, in bytes
+    uint32_t lastReceived;      //!< Bytes received by the queue disc at the last step
+    uint32_t lastDropped;       //!< Bytes dropped by the queue disc at the last step
+    uint32_t lastQueued;        //!< Bytes in the queue disc at the last step
+    double transmitting;        //!< Packet bytes left to transmit
+    uint64_t dropped;           //!< Fluid dropped, in bytes
+    std::vector<float> mark;    //!< Marking fraction of the last steps
+    std::vector<float> drop;    //!< Dropping fraction of the last steps
+  };
+
+  /// A flow
+  struct Flow
+  {
+    std::vector<uint32_t> path; //!< Links crossed
+    double baseRtt;             //!< RTT without queueing, in seconds
+    Time start;                 //!< Start time
+    Time stop;                  //!< Stop time, zero for never
+    double cwnd;                //!< Window, in bytes
+    double alpha;               //!< DCTCP α
+    double rate;                //!< Sending rate, in bytes/s
+    bool slowStart;             //!< True until the first congestion signal
+    double delivered;           //!< Bytes delivered
+    double marked;              //!< Bytes marked
+  };
+
+  /**
+   * \brief Advance the links and the flows by one step
+   */
+  void DoStep (void);
+
+  /**
+   * \brief Make the history of the links long enough for the flows
+   * \param rtt the largest RTT a flow can experience, in seconds
+   */
+  void ResizeHistory (double rtt);
+
+  /**
+   * \param link the link
+   * \return the queueing delay of the link, in seconds
+   */
+  double GetQueueDelay (const Link &link) const;
+
+  std::vector<Link> m_links;    //!< Links
+  std::vector<Flow> m_flows;    //!< Flows
+  uint32_t m_history;           //!< Number of steps kept in the link history
+  uint64_t m_nSteps;            //!< Steps done
+  EventId m_stepEvent;          //!< Next step
+
+  // ** Variables supplied by user
+  Time m_step;                  //!< Integration step
+  uint32_t m_segmentSize;       //!< Segment size of the flows
+  uint32_t m_initialCwnd;       //!< Initial window, in segments
+  double m_g;                   //!< DCTCP weight
+};
+
+} // namespace ns3
+
+#endif /* FLUID_FLOW_MODEL_H */
@@ -25,7 +25,10 @@
 #include "ns3/packet.h"
 #include "ns3/socket.h"
 #include "ns3/unused.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
 #include "queue-disc.h"
+#include <algorithm>
 
 namespace ns3 {
 
@@ -35,7 +38,8 @@ QueueDiscItem::QueueDiscItem (Ptr<Packet> p, const Address& addr, uint16_t proto
   : QueueItem (p),
     m_address (addr),
     m_protocol (protocol),
-    m_txq (0)
+    m_txq (0),
+    m_ready (0)
 {
 }
 
@@ -68,6 +72,18 @@ QueueDiscItem::SetTxQueueIndex (uint8_t txq)
   m_txq = txq;
 }
 
+Time
+QueueDiscItem::GetReadyTime (void) const
+{
+  return m_ready;
+}
+
+void
+QueueDiscItem::SetReadyTime (Time ready)
+{
+  m_ready = ready;
+}
+
 void
 QueueDiscItem::Print (std::ostream& os) const
 {
@@ -78,6 +94,12 @@ QueueDiscItem::Print (std::ostream& os) const
   ;
 }
 
+bool
+QueueDiscItem::MarkSegment (uint32_t segment)
+{
+  return Mark ();
+}
+
 
 NS_OBJECT_ENSURE_REGISTERED (QueueDiscClass);
 
@@ -181,7 +203,11 @@ QueueDisc::QueueDisc ()
      m_nTotalDroppedBytes (0),
      m_nTotalRequeuedPackets (0),
      m_nTotalRequeuedBytes (0),
-     m_running (false)
+     m_fluidBacklog (0),
+     m_fluidDelay (0),
+     m_fluidReady (0),
+     m_running (false),
+     m_sharedBufferPort (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -195,7 +221,10 @@ QueueDisc::DoDispose (void)
   m_classes.clear ();
   m_device = 0;
   m_devQueueIface = 0;
-  m_requeued = 0;
+  m_requeued.clear ();
+  m_batch.clear ();
+  m_sharedBuffer = 0;
+  Simulator::Cancel (m_fluidWake);
   Object::DoDispose ();
 }
 
@@ -210,6 +239,19 @@ QueueDisc::DoInitialize (void)
       m_devQueueIface = m_device->GetObject<NetDeviceQueueInterface> ();
     }
 
+  // The root queue disc of a device draws from the buffer shared by the
+  // ports of the node, if any. A queue disc which does not keep packet
+  // counters (wake mode WAKE_CHILD) cannot be accounted
+  if (m_device && m_device->GetNode () && GetWakeMode () == WAKE_ROOT)
+    {
+      m_sharedBuffer = m_device->GetNode ()->GetObject<SharedBuffer> ();
+      if (m_sharedBuffer)
+        {
+          m_sharedBufferPort = m_sharedBuffer->AddPort ();
+          UpdateSharedBuffer ();
+        }
+    }
+
   // Check the configuration and initialize the parameters of this queue disc
   bool ok = CheckConfig ();
   NS_ASSERT_MSG (ok, "The queue disc configuration is not correct");
@@ -282,6 +324,39 @@ QueueDisc:: GetTotalRequeuedBytes (void) const
   return m_nTotalRequeuedBytes;
 }
 
+void
+QueueDisc::SetFluidBacklog (uint32_t bytes)
+{
+  NS_LOG_FUNCTION (this << bytes);
+  m_fluidBacklog = bytes;
+  UpdateSharedBuffer ();
+}
+
+uint32_t
+QueueDisc::GetFluidBacklog (void) const
+{
+  return m_fluidBacklog;
+}
+
+void
+QueueDisc::SetFluidDelay (Time delay)
+{
+  NS_LOG_FUNCTION (this << delay);
+  m_fluidDelay = delay;
+}
+
+Time
+QueueDisc::GetFluidDelay (void) const
+{
+  return m_fluidDelay;
+}
+
+Ptr<SharedBuffer>
+QueueDisc::GetSharedBuffer (void) const
+{
+  return m_sharedBuffer;
+}
+
 void
 QueueDisc::SetNetDevice (Ptr<NetDevice> device)
 {
@@ -420,14 +495,14 @@ QueueDisc::Drop (Ptr<QueueItem> item)
       return;
     }
 
-  NS_ASSERT_MSG (m_nPackets >= 1u, "No packet in the queue disc, cannot drop");
+  NS_ASSERT_MSG (m_nPackets >= item->GetSegmentCount (), "No packet in the queue disc, cannot drop");
   NS_ASSERT_MSG (m_nBytes >= item->GetPacketSize (), "The size of the packet that"
                  << " is reported to be dropped is greater than the amount of bytes"
                  << "stored in the queue disc");
 
-  m_nPackets--;
+  m_nPackets -= item->GetSegmentCount ();
   m_nBytes -= item->GetPacketSize ();
-  m_nTotalDroppedPackets++;
+  m_nTotalDroppedPackets += item->GetSegmentCount ();
   m_nTotalDroppedBytes += item->GetPacketSize ();
 
   NS_LOG_LOGIC ("m_traceDrop (p)");
@@ -452,15 +527,32 @@ QueueDisc::Enqueue (Ptr<QueueDiscItem> item)
 {
   NS_LOG_FUNCTION (this << item);
 
-  m_nPackets++;
+  m_nPackets += item->GetSegmentCount ();
   m_nBytes += item->GetPacketSize ();
-  m_nTotalReceivedPackets++;
+  m_nTotalReceivedPackets += item->GetSegmentCount ();
   m_nTotalReceivedBytes += item->GetPacketSize ();
 
   NS_LOG_LOGIC ("m_traceEnqueue (p)");
   m_traceEnqueue (item);
 
-  return DoEnqueue (item);
+  if (m_sharedBuffer && !m_sharedBuffer->Admit (m_sharedBufferPort, item->GetPacketSize ()))
+    {
+      NS_LOG_LOGIC ("Not admitted by the shared buffer");
+      Drop (item);
+      return false;
+    }
+
+  if (m_fluidDelay.IsStrictlyPositive ())
+    {
+      // the packet waits for the fluid queued in front of it, and for the
+      // packets enqueued before, whose wait may have been longer
+      m_fluidReady = std::max (m_fluidReady, Simulator::Now () + m_fluidDelay);
+      item->SetReadyTime (m_fluidReady);
+    }
+
+  bool retval = DoEnqueue (item);
+  UpdateSharedBuffer ();
+  return retval;
 }
 
 Ptr<QueueDiscItem>
@@ -473,12 +565,14 @@ QueueDisc::Dequeue (void)
 
   if (item != 0)
     {
-      m_nPackets--;
+      m_nPackets -= item->GetSegmentCount ();
       m_nBytes -= item->GetPacketSize ();
 
       NS_LOG_LOGIC ("m_traceDequeue (p)");
       m_traceDequeue (item);
     }
+  // items may have been dropped as well
+  UpdateSharedBuffer ();
 
   return item;
 }
@@ -498,10 +592,9 @@ QueueDisc::Run (void)
   if (RunBegin ())
     {
       uint32_t quota = m_quota;
-      while (Restart ())
+      while (Restart (quota))
         {
-          quota -= 1;
-          if (quota <= 0)
+          if (quota == 0)
             {
               /// \todo netif_schedule (q);
               break;
@@ -532,17 +625,58 @@ QueueDisc::RunEnd (void)
 }
 
 bool
-QueueDisc::Restart (void)
+QueueDisc::Restart (uint32_t &quota)
 {
-  NS_LOG_FUNCTION (this);
-  Ptr<QueueDiscItem> item = DequeuePacket();
-  if (item == 0)
+  NS_LOG_FUNCTION (this << quota);
+  uint32_t budget = 1;
+  if (m_devQueueIface->GetNTxQueues () == 1)
+    {
+      budget = std::max<uint32_t> (std::min (quota, m_devQueueIface->GetTxBudget (0)), 1);
+    }
+
+  // Do not ask an empty queue disc for more packets: some queue discs (e.g.,
+  // RED) treat a dequeue from an empty queue as the start of an idle period
+  m_batch.clear ();
+  do
+    {
+      Ptr<QueueDiscItem> item = DequeuePacket ();
+      if (item == 0)
+        {
+          break;
+        }
+      m_batch.push_back (item);
+    }
+  while (m_batch.size () < budget && GetNPackets () > 0);
+  if (m_batch.empty ())
     {
       NS_LOG_LOGIC ("No packet to send");
       return false;
     }
+  NS_LOG_LOGIC ("Dequeued a batch of " << m_batch.size () << " packets");
 
-  return Transmit (item);
+  bool more = false;
+  for (uint32_t i = 0; i < m_batch.size (); i++)
+    {
+      // The budget does not allow the device queue to be stopped before the
+      // last packet of the batch, unless the device misreports it. In such a
+      // case, requeue the packets left, preserving their order
+      if (m_devQueueIface->GetTxQueue (m_batch[i]->GetTxQueueIndex ())->IsStopped ())
+        {
+          for (uint32_t j = m_batch.size (); j-- > i; )
+            {
+              Requeue (m_batch[j]);
+            }
+          more = false;
+          break;
+        }
+      more = Transmit (m_batch[i]);
+      if (quota > 0)
+        {
+          quota--;
+        }
+    }
+  m_batch.clear ();
+  return more;
 }
 
 Ptr<QueueDiscItem>
@@ -553,18 +687,19 @@ QueueDisc::DequeuePacket ()
   Ptr<QueueDiscItem> item;
 
   // First check if there is a requeued packet
-  if (m_requeued != 0)
+  if (!m_requeued.empty ())
     {
         // If the queue where the requeued packet is destined to is not stopped, return
         // the requeued packet; otherwise, return an empty packet.
         // If the device does not support flow control, the device queue is never stopped
-        if (!m_devQueueIface->GetTxQueue (m_requeued->GetTxQueueIndex ())->IsStopped ())
+        if (!m_devQueueIface->GetTxQueue (m_requeued.front ()->GetTxQueueIndex ())->IsStopped ())
           {
-            item = m_requeued;
-            m_requeued = 0;
+            item = m_requeued.front ();
+            m_requeued.pop_front ();
 
-            m_nPackets--;
+            m_nPackets -= item->GetSegmentCount ();
             m_nBytes -= item->GetPacketSize ();
+            UpdateSharedBuffer ();
 
             NS_LOG_LOGIC ("m_traceDequeue (p)");
             m_traceDequeue (item);
@@ -579,13 +714,30 @@ QueueDisc::DequeuePacket ()
       // is not stopped.
       if (m_devQueueIface->GetNTxQueues ()>1 || !m_devQueueIface->GetTxQueue (0)->IsStopped ())
         {
+          // Packets held behind the fluid backlog are released when it is
+          // drained. The ready times do not decrease, so nothing is held once
+          // the latest one has passed
+          if (m_fluidReady > Simulator::Now ())
+            {
+              Ptr<const QueueDiscItem> head = Peek ();
+              if (head != 0 && head->GetReadyTime () > Simulator::Now ())
+                {
+                  NS_LOG_LOGIC ("Head packet held by the fluid backlog until " << head->GetReadyTime ());
+                  if (!m_fluidWake.IsRunning ())
+                    {
+                      m_fluidWake = Simulator::Schedule (head->GetReadyTime () - Simulator::Now (),
+                                                         &QueueDisc::Run, this);
+                    }
+                  return item;
+                }
+            }
           item = Dequeue ();
           // If the item is not null, add the header to the packet.
           if (item != 0)
             {
               item->AddHeader ();
             }
-          // Here, Linux tries bulk dequeues
+          // Linux tries bulk dequeues here; Restart does it instead
         }
     }
   return item;
@@ -595,13 +747,14 @@ void
 QueueDisc::Requeue (Ptr<QueueDiscItem> item)
 {
   NS_LOG_FUNCTION (this << item);
-  m_requeued = item;
+  m_requeued.push_front (item);
   /// \todo netif_schedule (q);
 
-  m_nPackets++;       // it's still part of the queue
+  m_nPackets += item->GetSegmentCount (); // it's still part of the queue
   m_nBytes += item->GetPacketSize ();
-  m_nTotalRequeuedPackets++;
+  m_nTotalRequeuedPackets += item->GetSegmentCount ();
   m_nTotalRequeuedBytes += item->GetPacketSize ();
+  UpdateSharedBuffer ();
 
   NS_LOG_LOGIC ("m_traceRequeue (p)");
   m_traceRequeue (item);
@@ -654,4 +807,13 @@ QueueDisc::Transmit (Ptr<QueueDiscItem> item)
   return true;
 }
 
+void
+QueueDisc::UpdateSharedBuffer (void)
+{
+  if (m_sharedBuffer)
+    {
+      m_sharedBuffer->SetPortBytes (m_sharedBufferPort, m_nBytes + m_fluidBacklog);
+    }
+}
+
 } // namespace ns3
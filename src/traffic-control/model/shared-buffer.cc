@@ -0,0 +1,142 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/trace-source-accessor.h"
+#include "shared-buffer.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SharedBuffer");
+
+NS_OBJECT_ENSURE_REGISTERED (SharedBuffer);
+
+TypeId SharedBuffer::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SharedBuffer")
+    .SetParent<Object> ()
+    .SetGroupName ("TrafficControl")
+    .AddConstructor<SharedBuffer> ()
+    .AddAttribute ("BufferSize",
+                   "The size of the buffer shared by the ports, in bytes",
+                   UintegerValue (4 * 1024 * 1024),
+                   MakeUintegerAccessor (&SharedBuffer::m_size),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Alpha",
+                   "A port may hold up to Alpha times the free buffer",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&SharedBuffer::m_alpha),
+                   MakeDoubleChecker<double> (0))
+    .AddTraceSource ("Occupancy",
+                     "Number of bytes held by all the ports",
+                     MakeTraceSourceAccessor (&SharedBuffer::m_occupancy),
+                     "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("PortOccupancy",
+                     "The number of bytes held by a port changed",
+                     MakeTraceSourceAccessor (&SharedBuffer::m_portOccupancyTrace),
+                     "ns3::SharedBuffer::PortOccupancyTracedCallback")
+  ;
+  return tid;
+}
+
+SharedBuffer::SharedBuffer ()
+  : m_occupancy (0),
+    m_nAdmissionDrops (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+SharedBuffer::~SharedBuffer ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t
+SharedBuffer::AddPort (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_ports.push_back (0);
+  return m_ports.size () - 1;
+}
+
+uint32_t
+SharedBuffer::GetNPorts (void) const
+{
+  return m_ports.size ();
+}
+
+bool
+SharedBuffer::Admit (uint32_t port, uint32_t bytes)
+{
+  NS_LOG_FUNCTION (this << port << bytes);
+  NS_ASSERT (port < m_ports.size ());
+  uint32_t held = m_ports[port] + bytes;
+  if (m_occupancy + bytes > m_size || held > GetThreshold ())
+    {
+      NS_LOG_LOGIC ("Port " << port << " would hold " << held << " bytes, threshold "
+                    << GetThreshold () << ", occupancy " << m_occupancy);
+      m_nAdmissionDrops++;
+      return false;
+    }
+  return true;
+}
+
+void
+SharedBuffer::SetPortBytes (uint32_t port, uint32_t bytes)
+{
+  NS_ASSERT (port < m_ports.size ());
+  if (m_ports[port] == bytes)
+    {
+      return;
+    }
+  m_occupancy = m_occupancy - m_ports[port] + bytes;
+  m_ports[port] = bytes;
+  m_portOccupancyTrace (port, bytes);
+}
+
+uint32_t
+SharedBuffer::GetPortBytes (uint32_t port) const
+{
+  NS_ASSERT (port < m_ports.size ());
+  return m_ports[port];
+}
+
+uint32_t
+SharedBuffer::GetOccupancy (void) const
+{
+  return m_occupancy;
+}
+
+uint32_t
+SharedBuffer::GetThreshold (void) const
+{
+  if (m_occupancy >= m_size)
+    {
+      return 0;
+    }
+  double threshold = m_alpha * (m_size - m_occupancy);
+  return threshold < m_size ? uint32_t (threshold) : m_size;
+}
+
+uint32_t
+SharedBuffer::GetNAdmissionDrops (void) const
+{
+  return m_nAdmissionDrops;
+}
+
+} // namespace ns3
@@ -0,0 +1,328 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/dctcp-step-mark-queue-disc.h"
+#include "ns3/uinteger.h"
+#include "ns3/string.h"
+#include "ns3/simulator.h"
+#include "ns3/segmentation-tag.h"
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup traffic-control-test
+ *
+ * \brief Queue disc item recording whether it has been marked
+ */
+class StepMarkTestItem : public QueueDiscItem {
+public:
+  /**
+   * Constructor
+   *
+   * \param p the packet
+   * \param ecnCapable whether the packet can be marked
+   */
+  StepMarkTestItem (Ptr<Packet> p, bool ecnCapable);
+  virtual ~StepMarkTestItem ();
+  virtual void AddHeader (void);
+  virtual bool Mark (void);
+  virtual bool MarkSegment (uint32_t segment);
+  /**
+   * \return true if the item has been marked
+   */
+  bool IsMarked (void) const;
+  /**
+   * \return the wire segments marked, in the order of the marks
+   */
+  std::vector<uint32_t> GetMarkedSegments (void) const;
+
+private:
+  StepMarkTestItem ();
+  StepMarkTestItem (const StepMarkTestItem &);
+  StepMarkTestItem &operator = (const StepMarkTestItem &);
+  bool m_ecnCapable;    //!< Whether the packet can be marked
+  bool m_marked;        //!< Whether the packet has been marked
+  std::vector<uint32_t> m_markedSegments; //!< Wire segments marked
+};
+
+StepMarkTestItem::StepMarkTestItem (Ptr<Packet> p, bool ecnCapable)
+  : QueueDiscItem (p, Address (), 0),
+    m_ecnCapable (ecnCapable),
+    m_marked (false)
+{
+}
+
+StepMarkTestItem::~StepMarkTestItem ()
+{
+}
+
+void
+StepMarkTestItem::AddHeader (void)
+{
+}
+
+bool
+StepMarkTestItem::Mark (void)
+{
+  m_marked = m_ecnCapable;
+  return m_ecnCapable;
+}
+
+bool
+StepMarkTestItem::MarkSegment (uint32_t segment)
+{
+  if (m_ecnCapable)
+    {
+      m_markedSegments.push_back (segment);
+    }
+  return m_ecnCapable;
+}
+
+bool
+StepMarkTestItem::IsMarked (void) const
+{
+  return m_marked;
+}
+
+std::vector<uint32_t>
+StepMarkTestItem::GetMarkedSegments (void) const
+{
+  return m_markedSegments;
+}
+
+/**
+ * \ingroup traffic-control-test
+ *
+ * \brief Check the marks and drops of DctcpStepMarkQueueDisc
+ */
+class DctcpStepMarkQueueDiscTestCase : public TestCase
+{
+public:
+  DctcpStepMarkQueueDiscTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Run the test in the given mode
+   *
+   * \param mode the queue disc mode
+   */
+  void RunStepMarkTest (StringValue mode);
+};
+
+DctcpStepMarkQueueDiscTestCase::DctcpStepMarkQueueDiscTestCase ()
+  : TestCase ("Sanity check on the step marking queue disc")
+{
+}
+
+void
+DctcpStepMarkQueueDiscTestCase::RunStepMarkTest (StringValue mode)
+{
+  uint32_t pktSize = 500;
+  Ptr<DctcpStepMarkQueueDisc> queue = CreateObject<DctcpStepMarkQueueDisc> ();
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("Mode", mode), true,
+                         "Verify that we can actually set the attribute Mode");
+  // 1 for packets; pktSize for bytes
+  uint32_t modeSize = queue->GetMode () == Queue::QUEUE_MODE_BYTES ? pktSize : 1;
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("MarkThreshold", UintegerValue (4 * modeSize)), true,
+                         "Verify that we can actually set the attribute MarkThreshold");
+  NS_TEST_EXPECT_MSG_EQ (queue->SetAttributeFailSafe ("QueueLimit", UintegerValue (8 * modeSize)), true,
+                         "Verify that we can actually set the attribute QueueLimit");
+  queue->Initialize ();
+
+  // the first four packets find less than four packets in the queue
+  std::vector<Ptr<StepMarkTestItem> > items;
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      items.push_back (Create<StepMarkTestItem> (Create<Packet> (pktSize), true));
+      NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (items.back ()), true, "Packet " << i << " should be accepted");
+      NS_TEST_EXPECT_MSG_EQ (items.back ()->IsMarked (), (i >= 4), "Packet " << i << " wrongly marked");
+    }
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 8 * modeSize, "There should be eight packets in there");
+  NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (Create<StepMarkTestItem> (Create<Packet> (pktSize), true)), false,
+                         "The queue is full");
+
+  // a packet that cannot be marked is dropped above the threshold
+  queue->Dequeue ();
+  queue->Dequeue ();
+  queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (Create<StepMarkTestItem> (Create<Packet> (pktSize), false)), false,
+                         "A packet that cannot be marked should be dropped");
+  queue->Dequeue ();
+  queue->Dequeue ();
+  Ptr<StepMarkTestItem> item = Create<StepMarkTestItem> (Create<Packet> (pktSize), false);
+  NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (item), true, "Packets are accepted below the threshold");
+  NS_TEST_EXPECT_MSG_EQ (item->IsMarked (), false, "Packets are not marked below the threshold");
+
+  DctcpStepMarkQueueDisc::Stats st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.marks, 4, "There should be four marks");
+  NS_TEST_EXPECT_MSG_EQ (st.unmarkableDrops, 1, "There should be one drop of an unmarkable packet");
+  NS_TEST_EXPECT_MSG_EQ (st.qLimDrop, 1, "There should be one drop due to queue full");
+
+  // the backlog of the fluid flows counts as well
+  queue->Dequeue ();
+  queue->Dequeue ();
+  queue->SetFluidBacklog (2 * pktSize);
+  item = Create<StepMarkTestItem> (Create<Packet> (pktSize), true);
+  NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (item), true, "Packet should be accepted");
+  NS_TEST_EXPECT_MSG_EQ (item->IsMarked (), true, "The fluid backlog should trigger the mark");
+}
+
+void
+DctcpStepMarkQueueDiscTestCase::DoRun (void)
+{
+  RunStepMarkTest (StringValue ("QUEUE_MODE_PACKETS"));
+  RunStepMarkTest (StringValue ("QUEUE_MODE_BYTES"));
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ *
+ * \brief Check that DctcpStepMarkQueueDisc counts and marks a
+ * super-segment as its wire segments
+ */
+class DctcpStepMarkSuperSegmentTestCase : public TestCase
+{
+public:
+  DctcpStepMarkSuperSegmentTestCase ();
+  virtual void DoRun (void);
+private:
+  /**
+   * Run the test in the given mode
+   *
+   * \param mode the queue disc mode
+   */
+  void RunSuperSegmentTest (StringValue mode);
+};
+
+DctcpStepMarkSuperSegmentTestCase::DctcpStepMarkSuperSegmentTestCase ()
+  : TestCase ("Super-segments are counted and marked per wire segment")
+{
+}
+
+void
+DctcpStepMarkSuperSegmentTestCase::RunSuperSegmentTest (StringValue mode)
+{
+  uint32_t pktSize = 500;
+  Ptr<DctcpStepMarkQueueDisc> queue = CreateObject<DctcpStepMarkQueueDisc> ();
+  queue->SetAttribute ("Mode", mode);
+  uint32_t modeSize = queue->GetMode () == Queue::QUEUE_MODE_BYTES ? pktSize : 1;
+  queue->SetAttribute ("MarkThreshold", UintegerValue (4 * modeSize));
+  queue->SetAttribute ("QueueLimit", UintegerValue (8 * modeSize));
+  queue->Initialize ();
+
+  queue->Enqueue (Create<StepMarkTestItem> (Create<Packet> (pktSize), true));
+  queue->Enqueue (Create<StepMarkTestItem> (Create<Packet> (pktSize), true));
+
+  // the wire segments 2 and 3 find four packets or more in the queue
+  SegmentationTag::Enable ();
+  Ptr<Packet> p = Create<Packet> (4 * pktSize);
+  p->AddPacketTag (SegmentationTag (pktSize, 4 * pktSize));
+  Ptr<StepMarkTestItem> item = Create<StepMarkTestItem> (p, true);
+  NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (item), true, "The super-segment should be accepted");
+  std::vector<uint32_t> marks = item->GetMarkedSegments ();
+  NS_TEST_EXPECT_MSG_EQ (marks.size (), 2, "Two wire segments should be marked");
+  NS_TEST_EXPECT_MSG_EQ ((marks.size () == 2 && marks[0] == 2 && marks[1] == 3), true,
+                         "The wire segments 2 and 3 should be marked");
+  NS_TEST_EXPECT_MSG_EQ (item->IsMarked (), false, "The super-segment is marked per wire segment");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetQueueSize (), 6 * modeSize, "There should be six packets in there");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 6, "The queue disc counts six packets");
+
+  // four more wire segments would exceed the limit
+  p = Create<Packet> (4 * pktSize);
+  p->AddPacketTag (SegmentationTag (pktSize, 4 * pktSize));
+  NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (Create<StepMarkTestItem> (p, true)), false, "The queue is full");
+
+  DctcpStepMarkQueueDisc::Stats st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.marks, 2, "There should be two marks");
+  NS_TEST_EXPECT_MSG_EQ (st.qLimDrop, 1, "There should be one drop due to queue full");
+
+  queue->Dequeue ();
+  queue->Dequeue ();
+  NS_TEST_EXPECT_MSG_EQ (queue->Dequeue (), item, "The super-segment should be dequeued third");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 0, "The queue disc should be empty");
+}
+
+void
+DctcpStepMarkSuperSegmentTestCase::DoRun (void)
+{
+  RunSuperSegmentTest (StringValue ("QUEUE_MODE_PACKETS"));
+  RunSuperSegmentTest (StringValue ("QUEUE_MODE_BYTES"));
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup traffic-control-test
+ *
+ * \brief Check that the fluid backlog counts in packets of the mean size,
+ * not of the size of the packet arriving
+ */
+class DctcpStepMarkFluidPacketsTestCase : public TestCase
+{
+public:
+  DctcpStepMarkFluidPacketsTestCase ();
+  virtual void DoRun (void);
+};
+
+DctcpStepMarkFluidPacketsTestCase::DctcpStepMarkFluidPacketsTestCase ()
+  : TestCase ("The fluid backlog counts in packets of the mean size")
+{
+}
+
+void
+DctcpStepMarkFluidPacketsTestCase::DoRun (void)
+{
+  Ptr<DctcpStepMarkQueueDisc> queue = CreateObject<DctcpStepMarkQueueDisc> ();
+  queue->SetAttribute ("Mode", StringValue ("QUEUE_MODE_PACKETS"));
+  queue->SetAttribute ("MarkThreshold", UintegerValue (4));
+  queue->SetAttribute ("QueueLimit", UintegerValue (8));
+  queue->SetAttribute ("MeanPktSize", UintegerValue (1000));
+  queue->Initialize ();
+
+  queue->Enqueue (Create<StepMarkTestItem> (Create<Packet> (1000), true));
+  queue->Enqueue (Create<StepMarkTestItem> (Create<Packet> (1000), true));
+  // one packet of the mean size: three packets, below the threshold
+  queue->SetFluidBacklog (1000);
+
+  // a 54-byte ACK would see the backlog as 18 packets
+  Ptr<StepMarkTestItem> ack = Create<StepMarkTestItem> (Create<Packet> (54), false);
+  NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (ack), true, "A small packet below the threshold should be accepted");
+  NS_TEST_EXPECT_MSG_EQ (ack->IsMarked (), false, "A small packet below the threshold should not be marked");
+
+  // the fourth packet finds four packets: marked whatever its size
+  Ptr<StepMarkTestItem> large = Create<StepMarkTestItem> (Create<Packet> (9000), true);
+  NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (large), true, "Packet should be accepted");
+  NS_TEST_EXPECT_MSG_EQ (large->IsMarked (), true, "A large packet above the threshold should be marked");
+
+  DctcpStepMarkQueueDisc::Stats st = queue->GetStats ();
+  NS_TEST_EXPECT_MSG_EQ (st.unmarkableDrops, 0, "No packet should be dropped as unmarkable");
+  NS_TEST_EXPECT_MSG_EQ (st.qLimDrop, 0, "No packet should be dropped for the limit");
+  Simulator::Destroy ();
+}
+
+static class DctcpStepMarkQueueDiscTestSuite : public TestSuite
+{
+public:
+  DctcpStepMarkQueueDiscTestSuite ()
+    : TestSuite ("dctcp-step-mark-queue-disc", UNIT)
+  {
+    AddTestCase (new DctcpStepMarkQueueDiscTestCase (), TestCase::QUICK);
+    AddTestCase (new DctcpStepMarkSuperSegmentTestCase (), TestCase::QUICK);
+    AddTestCase (new DctcpStepMarkFluidPacketsTestCase (), TestCase::QUICK);
+  }
+} g_dctcpStepMarkQueueDiscTestSuite;